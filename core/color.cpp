@@ -1,24 +1,115 @@
 // Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
 
 #include "color.hpp"
+#include "packed.hpp"
 #include "precompiled.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 namespace ionengine::core
 {
-    auto Color::srgb() -> Color&
+    namespace internal
     {
-        for (size_t const i : std::views::iota(0u, 3u))
+        inline auto srgb_to_linear(float const color) -> float
+        {
+            if (color <= 0.04045f)
+            {
+                return color / 12.92f;
+            }
+            else
+            {
+                return std::pow((color + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+
+        inline auto linear_to_srgb(float const color) -> float
         {
-            float color = (&r)[i];
             if (color < 0.0031308f)
             {
-                color = color * 12.92f;
+                return color * 12.92f;
             }
             else
             {
-                color = 1.055f * std::powf(color, 1.0f / 2.4f) - 0.05499995f;
+                return 1.055f * std::pow(color, 1.0f / 2.4f) - 0.055f;
             }
         }
+
+        uint32_t constexpr ColorTableSize = 4096;
+
+        using ColorTable = std::array<float, ColorTableSize + 1>;
+
+        inline auto make_color_table(std::function<double(double)> const& function) -> ColorTable
+        {
+            ColorTable table;
+            for (uint32_t const i : std::views::iota(0u, ColorTableSize + 1))
+            {
+                double const value = static_cast<double>(i) / ColorTableSize;
+                table[i] = static_cast<float>(function(value));
+            }
+            return table;
+        }
+
+        inline auto color_table_lookup(ColorTable const& table, float const color) -> float
+        {
+            float const position = std::clamp(color, 0.0f, 1.0f) * ColorTableSize;
+            uint32_t const index = std::min(static_cast<uint32_t>(position), ColorTableSize - 1);
+            float const fraction = position - static_cast<float>(index);
+            return table[index] + (table[index + 1] - table[index]) * fraction;
+        }
+
+        auto srgb_to_linear_table() -> ColorTable const&
+        {
+            static ColorTable const table = make_color_table([](double const value) -> double {
+                return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+            });
+            return table;
+        }
+
+        auto linear_to_srgb_table() -> ColorTable const&
+        {
+            static ColorTable const table = make_color_table([](double const value) -> double {
+                return value < 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+            });
+            return table;
+        }
+
+        auto srgb8_to_linear_table() -> std::array<float, 256> const&
+        {
+            static std::array<float, 256> const table = [] {
+                std::array<float, 256> table;
+                for (uint32_t const i : std::views::iota(0u, 256u))
+                {
+                    double const value = i / 255.0;
+                    table[i] =
+                        static_cast<float>(value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+                }
+                return table;
+            }();
+            return table;
+        }
+
+        inline auto apply_color_table(ColorTable const& table, std::span<Color const> const source,
+                                      std::span<Color> const dest) -> void
+        {
+            assert(source.size() == dest.size() && "source and dest should be equal size");
+
+            for (size_t const i : std::views::iota(0u, source.size()))
+            {
+                Color const color = source[i];
+                dest[i] = Color(color_table_lookup(table, color.r), color_table_lookup(table, color.g),
+                                color_table_lookup(table, color.b), color.a);
+            }
+        }
+    } // namespace internal
+
+    auto Color::srgb() -> Color&
+    {
+        for (size_t const i : std::views::iota(0u, 3u))
+        {
+            (&r)[i] = internal::linear_to_srgb((&r)[i]);
+        }
         return *this;
     }
 
@@ -26,16 +117,103 @@ namespace ionengine::core
     {
         for (size_t const i : std::views::iota(0u, 3u))
         {
-            float color = (&r)[i];
-            if (color <= 0.040448643f)
-            {
-                color = color / 12.92f;
-            }
-            else
-            {
-                color = std::powf((color + 0.055f) / 1.055f, 2.4f);
-            }
+            (&r)[i] = internal::srgb_to_linear((&r)[i]);
         }
         return *this;
     }
-} // namespace ionengine::core
\ No newline at end of file
+
+    auto srgb_to_linear(std::span<Color const> const source, std::span<Color> const dest) -> void
+    {
+        internal::apply_color_table(internal::srgb_to_linear_table(), source, dest);
+    }
+
+    auto linear_to_srgb(std::span<Color const> const source, std::span<Color> const dest) -> void
+    {
+        internal::apply_color_table(internal::linear_to_srgb_table(), source, dest);
+    }
+
+    auto srgb8_to_linear(std::span<uint8_t const> const source, std::span<Color> const dest) -> void
+    {
+        assert(source.size() == dest.size() * 4 && "source should contain 4 bytes per dest color");
+
+        auto const& table = internal::srgb8_to_linear_table();
+        for (size_t const i : std::views::iota(0u, dest.size()))
+        {
+            uint8_t const* pixel = source.data() + i * 4;
+            dest[i] = Color(table[pixel[0]], table[pixel[1]], table[pixel[2]], pixel[3] / 255.0f);
+        }
+    }
+
+    auto premultiply_alpha(std::span<Color const> const source, std::span<Color> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128 const alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+        __m128 const one = _mm_set1_ps(1.0f);
+
+        for (; i < source.size(); ++i)
+        {
+            __m128 const color = _mm_loadu_ps(source[i].data());
+            __m128 const alpha = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+            // Multiply RGB by alpha and keep alpha itself by multiplying it by one
+            __m128 const factor = _mm_or_ps(_mm_and_ps(alphaMask, one), _mm_andnot_ps(alphaMask, alpha));
+            _mm_storeu_ps(&dest[i].r, _mm_mul_ps(color, factor));
+        }
+#endif
+        for (; i < source.size(); ++i)
+        {
+            Color const color = source[i];
+            dest[i] = Color(color.r * color.a, color.g * color.a, color.b * color.a, color.a);
+        }
+    }
+
+    auto rgba8_to_float(std::span<uint8_t const> const source, std::span<Color> const dest) -> void
+    {
+        assert(source.size() == dest.size() * 4 && "source should contain 4 bytes per dest color");
+
+        unpack_unorm8(source, std::span<float>(reinterpret_cast<float*>(dest.data()), dest.size() * 4));
+    }
+
+    auto float_to_rgba8(std::span<Color const> const source, std::span<uint8_t> const dest) -> void
+    {
+        assert(source.size() * 4 == dest.size() && "dest should contain 4 bytes per source color");
+
+        pack_unorm8(std::span<float const>(reinterpret_cast<float const*>(source.data()), source.size() * 4), dest);
+    }
+
+    auto swizzle_bgra(std::span<uint8_t const> const source, std::span<uint8_t> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        assert(source.size() % 4 == 0 && "source should contain 4 bytes per pixel");
+
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i const keepMask = _mm_set1_epi32(static_cast<int32_t>(0xff00ff00));
+        __m128i const lowMask = _mm_set1_epi32(0x000000ff);
+        __m128i const highMask = _mm_set1_epi32(0x00ff0000);
+
+        for (; i + 16 <= source.size(); i += 16)
+        {
+            __m128i const pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source.data() + i));
+            __m128i const swapped =
+                _mm_or_si128(_mm_and_si128(pixels, keepMask),
+                             _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), lowMask),
+                                          _mm_and_si128(_mm_slli_epi32(pixels, 16), highMask)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest.data() + i), swapped);
+        }
+#endif
+        for (; i < source.size(); i += 4)
+        {
+            uint8_t const r = source[i];
+            uint8_t const g = source[i + 1];
+            uint8_t const b = source[i + 2];
+            uint8_t const a = source[i + 3];
+            dest[i] = b;
+            dest[i + 1] = g;
+            dest[i + 2] = r;
+            dest[i + 3] = a;
+        }
+    }
+} // namespace ionengine::core
@@ -62,6 +62,44 @@ namespace ionengine::core
             return std::make_tuple(r, g, b, a) == std::make_tuple(other.r, other.g, other.b, other.a);
         }
     };
+
+    /*!
+        \brief Convert sRGB encoded colors to linear. Alpha is copied as is
+        \details Uses a 4096 entry table with linear interpolation, max absolute error is 1.2e-7 in [0, 1]. Input is
+        clamped to [0, 1]
+        \param[in] source Input colors
+        \param[out] dest Output colors, must be the same size as source. May be the same span as source
+    */
+    auto srgb_to_linear(std::span<Color const> const source, std::span<Color> const dest) -> void;
+
+    /*!
+        \brief Convert linear colors to sRGB encoding. Alpha is copied as is
+        \details Uses a 4096 entry table with linear interpolation, max absolute error is 1.7e-5 in [0, 1] that is well
+        below 8-bit quantization step. Input is clamped to [0, 1]
+        \param[in] source Input colors
+        \param[out] dest Output colors, must be the same size as source. May be the same span as source
+    */
+    auto linear_to_srgb(std::span<Color const> const source, std::span<Color> const dest) -> void;
+
+    /*!
+        \brief Convert sRGB encoded RGBA8 pixels to linear colors using an exact 256 entry table
+        \param[in] source Input pixels, 4 bytes per pixel
+        \param[out] dest Output colors, size must be source size / 4
+    */
+    auto srgb8_to_linear(std::span<uint8_t const> const source, std::span<Color> const dest) -> void;
+
+    auto premultiply_alpha(std::span<Color const> const source, std::span<Color> const dest) -> void;
+
+    auto rgba8_to_float(std::span<uint8_t const> const source, std::span<Color> const dest) -> void;
+
+    auto float_to_rgba8(std::span<Color const> const source, std::span<uint8_t> const dest) -> void;
+
+    /*!
+        \brief Swap R and B channels of 4 byte pixels (RGBA <-> BGRA)
+        \param[in] source Input pixels
+        \param[out] dest Output pixels, must be the same size as source. May be the same span as source
+    */
+    auto swizzle_bgra(std::span<uint8_t const> const source, std::span<uint8_t> const dest) -> void;
 } // namespace ionengine::core
 
 template <>
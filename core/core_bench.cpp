@@ -0,0 +1,232 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#include "core/color.hpp"
+#include "core/serialize.hpp"
+#include "core/small_vector.hpp"
+#include "precompiled.h"
+#include <benchmark/benchmark.h>
+
+using namespace ionengine;
+
+std::atomic<size_t> allocationCount = 0;
+
+auto operator new(size_t const size) -> void*
+{
+    ++allocationCount;
+    if (void* ptr = std::malloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* ptr) noexcept -> void
+{
+    std::free(ptr);
+}
+
+auto operator delete(void* ptr, size_t const size) noexcept -> void
+{
+    std::free(ptr);
+}
+
+auto operator new(size_t const size, std::align_val_t const alignment) -> void*
+{
+    ++allocationCount;
+    size_t const align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* ptr, std::align_val_t const alignment) noexcept -> void
+{
+    std::free(ptr);
+}
+
+auto operator delete(void* ptr, size_t const size, std::align_val_t const alignment) noexcept -> void
+{
+    std::free(ptr);
+}
+
+struct BenchBufferData
+{
+    uint64_t offset;
+    size_t size;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(offset, "offset");
+        archive.property(size, "size");
+    }
+};
+
+struct BenchData
+{
+    std::string name;
+    std::vector<BenchBufferData> buffers;
+    std::vector<std::string> names;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(name, "name");
+        archive.property(buffers, "buffers");
+        archive.property(names, "names");
+    }
+};
+
+struct BenchFile
+{
+    uint32_t magic;
+    BenchData data;
+    std::vector<uint8_t> blob;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(magic);
+        archive.template with<core::serialize_ojson, core::serialize_ijson>(data);
+        archive.property(blob);
+    }
+};
+
+auto makeBenchFile() -> BenchFile
+{
+    BenchFile file{.magic = 1, .data = {.name = "BenchData"}, .blob = std::vector<uint8_t>(64 * 1024, 0x1)};
+    for (uint32_t const i : std::views::iota(0u, 64u))
+    {
+        file.data.buffers.emplace_back(BenchBufferData{.offset = i * 1024ull, .size = 1024});
+        file.data.names.emplace_back("Surface_" + std::to_string(i));
+    }
+    return file;
+}
+
+auto makeBenchBuffer() -> std::vector<uint8_t>
+{
+    auto stream = core::serialize<core::serialize_oarchive, std::basic_stringstream<uint8_t>>(makeBenchFile()).value();
+    return std::vector<uint8_t>(std::istreambuf_iterator<uint8_t>(stream.rdbuf()), {});
+}
+
+static auto Deserialize_Archive_Valid(benchmark::State& state) -> void
+{
+    std::vector<uint8_t> buffer = makeBenchBuffer();
+
+    for (auto _ : state)
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), buffer.size()));
+        auto result = core::deserialize<core::serialize_iarchive, BenchFile>(stream);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+static auto Deserialize_Archive_Truncated(benchmark::State& state) -> void
+{
+    std::vector<uint8_t> buffer = makeBenchBuffer();
+    buffer.resize(buffer.size() / 2);
+
+    for (auto _ : state)
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), buffer.size()));
+        auto result = core::deserialize<core::serialize_iarchive, BenchFile>(stream);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+static auto Deserialize_Archive_CorruptedCount(benchmark::State& state) -> void
+{
+    std::vector<uint8_t> buffer = makeBenchBuffer();
+
+    // Break the size of the nested json blob that follows the magic
+    size_t const corruptedSize = std::numeric_limits<size_t>::max() / 2;
+    std::memcpy(buffer.data() + sizeof(uint32_t), &corruptedSize, sizeof(size_t));
+
+    for (auto _ : state)
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), buffer.size()));
+        auto result = core::deserialize<core::serialize_iarchive, BenchFile>(stream);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+static auto Deserialize_JSON_Valid(benchmark::State& state) -> void
+{
+    auto stream = core::serialize<core::serialize_ojson, std::basic_stringstream<uint8_t>>(makeBenchFile().data).value();
+    std::vector<uint8_t> buffer(std::istreambuf_iterator<uint8_t>(stream.rdbuf()), {});
+
+    for (auto _ : state)
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), buffer.size()));
+        auto result = core::deserialize<core::serialize_ijson, BenchData>(stream);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+static auto Deserialize_JSON_Corrupted(benchmark::State& state) -> void
+{
+    auto stream = core::serialize<core::serialize_ojson, std::basic_stringstream<uint8_t>>(makeBenchFile().data).value();
+    std::vector<uint8_t> buffer(std::istreambuf_iterator<uint8_t>(stream.rdbuf()), {});
+
+    // Break the last string value
+    std::string_view const json(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+    buffer[json.rfind("\"Surface_")] = '0';
+
+    for (auto _ : state)
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), buffer.size()));
+        auto result = core::deserialize<core::serialize_ijson, BenchData>(stream);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+struct BenchColorInfo
+{
+    uint32_t format;
+    core::Color clearColor;
+};
+
+// Builds render pass color lists the way a frame graph does every frame
+template <typename Container>
+static auto Container_FramePasses(benchmark::State& state) -> void
+{
+    uint32_t constexpr PassCount = 16;
+    uint32_t const colorCount = static_cast<uint32_t>(state.range(0));
+
+    size_t const allocationsBefore = allocationCount;
+    for (auto _ : state)
+    {
+        for (uint32_t const i : std::views::iota(0u, PassCount))
+        {
+            Container colors;
+            for (uint32_t const j : std::views::iota(0u, colorCount))
+            {
+                colors.emplace_back(BenchColorInfo{.format = i + j, .clearColor = core::Color(0.0f, 0.0f, 0.0f, 1.0f)});
+            }
+            benchmark::DoNotOptimize(colors.data());
+        }
+    }
+    state.counters["AllocsPerFrame"] = benchmark::Counter(static_cast<double>(allocationCount - allocationsBefore),
+                                                          benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(Deserialize_Archive_Valid);
+BENCHMARK(Deserialize_Archive_Truncated);
+BENCHMARK(Deserialize_Archive_CorruptedCount);
+BENCHMARK(Deserialize_JSON_Valid);
+BENCHMARK(Deserialize_JSON_Corrupted);
+BENCHMARK_TEMPLATE(Container_FramePasses, std::vector<BenchColorInfo>)->Arg(1)->Arg(4)->Arg(8);
+BENCHMARK_TEMPLATE(Container_FramePasses, core::small_vector<BenchColorInfo, 4>)->Arg(1)->Arg(4)->Arg(8);
+BENCHMARK_TEMPLATE(Container_FramePasses, core::static_vector<BenchColorInfo, 8>)->Arg(1)->Arg(4)->Arg(8);
+
+auto main(int32_t argc, char** argv) -> int32_t
+{
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
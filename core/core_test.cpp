@@ -1,8 +1,11 @@
 // Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
 
 #include "core/base64.hpp"
+#include "core/color.hpp"
 #include "core/event.hpp"
+#include "core/packed.hpp"
 #include "core/serialize.hpp"
+#include "core/small_vector.hpp"
 #include "precompiled.h"
 #include <gtest/gtest.h>
 
@@ -98,6 +101,38 @@ struct DataFile
     }
 };
 
+struct PmrData
+{
+    std::pmr::string name;
+    std::pmr::vector<std::pmr::string> names;
+    std::pmr::unordered_map<std::pmr::string, uint32_t> indices;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(name, "name");
+        archive.property(names, "names");
+        archive.property(indices, "indices");
+    }
+};
+
+struct PmrDataFile
+{
+    std::pmr::string testString;
+    std::pmr::vector<uint32_t> testInts;
+    PmrData data;
+    std::pmr::vector<uint8_t> blob;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(testString);
+        archive.property(testInts);
+        archive.template with<core::serialize_ojson, core::serialize_ijson>(data);
+        archive.property(blob);
+    }
+};
+
 TEST(Core, Serialize_JSON_Test)
 {
     auto internalData = std::make_unique<InternalData>();
@@ -203,6 +238,80 @@ TEST(Core, Serialize_Archive_Test)
     ASSERT_EQ(deserializedObject.data.testOptFloat, dataFile.data.testOptFloat);
 }
 
+TEST(Core, Serialize_Corrupted_Test)
+{
+    DataFile dataFile{.magic = 2,
+                      .testFloat = 1.2f,
+                      .testString = "Hello world!",
+                      .testStrings = {"string1", "string2"},
+                      .testInts = {5, 3, 4},
+                      .data = {.testInt = 4,
+                               .internalData = {"Hello world!", 2},
+                               .testEnum = TestEnum::Second,
+                               .internalDataPtr = std::make_unique<InternalData>("Hello world!", 3)}};
+
+    auto bufferObject = core::serialize<core::serialize_oarchive, std::basic_stringstream<uint8_t>>(dataFile).value();
+    std::vector<uint8_t> buffer(std::istreambuf_iterator<uint8_t>(bufferObject.rdbuf()), {});
+
+    // Every truncated prefix should be rejected
+    for (size_t const i : std::views::iota(0u, buffer.size()))
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(buffer.data(), i));
+        auto deserializedObject = core::deserialize<core::serialize_iarchive, DataFile>(stream);
+        ASSERT_FALSE(deserializedObject.has_value());
+    }
+
+    // Element count of testStrings is far larger than the input
+    std::vector<uint8_t> corruptedBuffer = buffer;
+    size_t const corruptedCount = std::numeric_limits<size_t>::max() / 2;
+    size_t const countOffset = sizeof(uint32_t) + sizeof(float) + dataFile.testString.size() + 1;
+    std::memcpy(corruptedBuffer.data() + countOffset, &corruptedCount, sizeof(size_t));
+    {
+        std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(corruptedBuffer.data(), corruptedBuffer.size()));
+        auto deserializedObject = core::deserialize<core::serialize_iarchive, DataFile>(stream);
+        ASSERT_FALSE(deserializedObject.has_value());
+    }
+
+    std::string invalidJson = "{\"testString\": 5, \"testInt\": 2}";
+    std::basic_ispanstream<uint8_t> jsonStream(
+        std::span<uint8_t>(reinterpret_cast<uint8_t*>(invalidJson.data()), invalidJson.size()));
+    ASSERT_FALSE((core::deserialize<core::serialize_ijson, InternalData>(jsonStream).has_value()));
+
+    std::string brokenJson = "{\"testString\": \"Hello";
+    std::basic_ispanstream<uint8_t> brokenStream(
+        std::span<uint8_t>(reinterpret_cast<uint8_t*>(brokenJson.data()), brokenJson.size()));
+    ASSERT_FALSE((core::deserialize<core::serialize_ijson, InternalData>(brokenStream).has_value()));
+}
+
+TEST(Core, Serialize_MemoryResource_Test)
+{
+    PmrDataFile dataFile{.testString = "Hello world! This string does not fit in SSO buffer",
+                         .testInts = {1, 2, 3},
+                         .data = {.name = "Data", .names = {"name1", "name2"}, .indices = {{"first", 1}}},
+                         .blob = std::pmr::vector<uint8_t>(1024, 0x1)};
+
+    auto bufferObject = core::serialize<core::serialize_oarchive, std::basic_stringstream<uint8_t>>(dataFile).value();
+
+    std::array<uint8_t, 16 * 1024> arenaBuffer;
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size(),
+                                              std::pmr::null_memory_resource());
+
+    // Any container that is not bound to the arena would fail to allocate
+    std::pmr::memory_resource* defaultResource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    auto deserializedObject = core::deserialize<core::serialize_iarchive, PmrDataFile>(bufferObject, &arena);
+    std::pmr::set_default_resource(defaultResource);
+
+    ASSERT_TRUE(deserializedObject.has_value());
+    ASSERT_EQ(deserializedObject->testString, dataFile.testString);
+    ASSERT_EQ(deserializedObject->testInts, dataFile.testInts);
+    ASSERT_EQ(deserializedObject->data.name, dataFile.data.name);
+    ASSERT_EQ(deserializedObject->data.names, dataFile.data.names);
+    ASSERT_EQ(deserializedObject->data.indices, dataFile.data.indices);
+    ASSERT_EQ(deserializedObject->blob, dataFile.blob);
+    ASSERT_EQ(deserializedObject->blob.get_allocator().resource(), &arena);
+    ASSERT_EQ(deserializedObject->data.names[0].get_allocator().resource(), &arena);
+}
+
 TEST(Core, Serialize_Enum_Test)
 {
     auto buffer = core::serialize<core::serialize_oenum, std::ostringstream>(TestEnum::Second).value();
@@ -237,6 +346,296 @@ TEST(Core, Event_Test)
     testEvent(testValue);
 }
 
+TEST(Core, PackedHalf_Test)
+{
+    std::vector<float> const source{0.0f, 1.0f, -2.5f, 0.333f, 65504.0f, 1e-6f, -0.0f, 1024.5f, 3.14159f, 100000.0f};
+    std::vector<core::Half> packed(source.size());
+    std::vector<float> unpacked(source.size());
+
+    core::pack_half(source, packed);
+    core::unpack_half(packed, unpacked);
+
+    for (size_t const i : std::views::iota(0u, source.size()))
+    {
+        ASSERT_EQ(packed[i], core::float_to_half(source[i]));
+    }
+
+    ASSERT_EQ(unpacked[0], 0.0f);
+    ASSERT_EQ(unpacked[1], 1.0f);
+    ASSERT_EQ(unpacked[2], -2.5f);
+    ASSERT_NEAR(unpacked[3], 0.333f, 1e-3f);
+    ASSERT_EQ(unpacked[4], 65504.0f);
+    ASSERT_NEAR(unpacked[5], 1e-6f, 1e-7f);
+    ASSERT_TRUE(std::isinf(unpacked[9]));
+
+    std::vector<core::Vec3f> const positions{core::Vec3f(1.0f, 2.0f, 3.0f), core::Vec3f(-0.5f, 0.25f, 8.0f)};
+    std::vector<core::Vec3h> packedPositions(positions.size());
+    std::vector<core::Vec3f> unpackedPositions(positions.size());
+
+    core::pack_half(positions, packedPositions);
+    core::unpack_half(packedPositions, unpackedPositions);
+
+    ASSERT_EQ(unpackedPositions, positions);
+}
+
+TEST(Core, PackedHalfKernels_Test)
+{
+    // Batches go through F16C when the CPU has it, the scalar conversions are the reference for every value
+    std::vector<core::Half> halfs(65536);
+    for (uint32_t const i : std::views::iota(0u, 65536u))
+    {
+        halfs[i] = core::Half{static_cast<uint16_t>(i)};
+    }
+
+    std::vector<float> floats(halfs.size());
+    core::unpack_half(halfs, floats);
+
+    for (uint32_t const i : std::views::iota(0u, 65536u))
+    {
+        float const expected = core::half_to_float(halfs[i]);
+        if (std::isnan(expected))
+        {
+            ASSERT_TRUE(std::isnan(floats[i]));
+            continue;
+        }
+        ASSERT_EQ(std::bit_cast<uint32_t>(floats[i]), std::bit_cast<uint32_t>(expected));
+    }
+
+    // Covers denormals, rounding ties and overflow of the other direction
+    floats.clear();
+    for (uint64_t bits = 0; bits <= 0xffffffff; bits += 4093)
+    {
+        float const value = std::bit_cast<float>(static_cast<uint32_t>(bits));
+        if (!std::isnan(value))
+        {
+            floats.emplace_back(value);
+        }
+    }
+    floats.insert(floats.end(), {0.5f * 0x1p-24f, 1.5f * 0x1p-24f, 65519.0f, 65520.0f, 1.0f + 0x1p-11f});
+
+    halfs.resize(floats.size());
+    core::pack_half(floats, halfs);
+
+    for (size_t const i : std::views::iota(size_t{0}, floats.size()))
+    {
+        ASSERT_EQ(halfs[i], core::float_to_half(floats[i])) << "value " << floats[i] << ", F16C "
+                                                             << core::is_f16c_supported();
+    }
+}
+
+TEST(Core, PackedNormalized_Test)
+{
+    std::vector<float> const source{-2.0f, -1.0f, -0.5f, 0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 0.75f, -0.75f};
+
+    std::vector<int8_t> snorm8(source.size());
+    core::pack_snorm8(source, snorm8);
+    ASSERT_EQ(snorm8[0], -127);
+    ASSERT_EQ(snorm8[3], 0);
+    ASSERT_EQ(snorm8[6], 127);
+    ASSERT_EQ(snorm8[7], 127);
+
+    std::vector<uint8_t> unorm8(source.size());
+    core::pack_unorm8(source, unorm8);
+    ASSERT_EQ(unorm8[0], 0);
+    ASSERT_EQ(unorm8[6], 255);
+    ASSERT_EQ(unorm8[9], 0);
+
+    std::vector<uint16_t> unorm16(source.size());
+    std::vector<float> unpacked(source.size());
+    core::pack_unorm16(source, unorm16);
+    core::unpack_unorm16(unorm16, unpacked);
+    ASSERT_EQ(unorm16[6], 65535);
+    ASSERT_NEAR(unpacked[4], 0.25f, 1.0f / 65535.0f);
+    ASSERT_NEAR(unpacked[8], 0.75f, 1.0f / 65535.0f);
+
+    std::vector<int16_t> snorm16(source.size());
+    core::pack_snorm16(source, snorm16);
+    core::unpack_snorm16(snorm16, unpacked);
+    ASSERT_EQ(unpacked[0], -1.0f);
+    ASSERT_NEAR(unpacked[2], -0.5f, 1.0f / 32767.0f);
+    ASSERT_NEAR(unpacked[9], -0.75f, 1.0f / 32767.0f);
+
+    std::vector<core::Vec4f> const colors{core::Vec4f(0.0f, 0.5f, 1.0f, 1.0f)};
+    std::vector<core::Unorm1010102> packedColors(colors.size());
+    std::vector<core::Vec4f> unpackedColors(colors.size());
+    core::pack_unorm1010102(colors, packedColors);
+    core::unpack_unorm1010102(packedColors, unpackedColors);
+    ASSERT_NEAR(unpackedColors[0].y, 0.5f, 1.0f / 1023.0f);
+    ASSERT_EQ(unpackedColors[0].w, 1.0f);
+}
+
+TEST(Core, PackedOctahedral_Test)
+{
+    std::vector<core::Vec3f> const normals{core::Vec3f(0.0f, 0.0f, 1.0f), core::Vec3f(0.0f, 0.0f, -1.0f),
+                                           core::Vec3f(1.0f, 0.0f, 0.0f), core::Vec3f(0.0f, -1.0f, 0.0f),
+                                           core::Vec3f(0.577f, -0.577f, -0.577f).normalize()};
+    std::vector<core::OctNormal> packed(normals.size());
+    std::vector<core::Vec3f> unpacked(normals.size());
+
+    core::pack_octahedral(normals, packed);
+    core::unpack_octahedral(packed, unpacked);
+
+    for (size_t const i : std::views::iota(0u, normals.size()))
+    {
+        ASSERT_NEAR(unpacked[i].x, normals[i].x, 1e-3f);
+        ASSERT_NEAR(unpacked[i].y, normals[i].y, 1e-3f);
+        ASSERT_NEAR(unpacked[i].z, normals[i].z, 1e-3f);
+    }
+}
+
+TEST(Core, ColorBatch_Test)
+{
+    std::vector<uint8_t> const pixels{0, 64, 128, 255, 255, 188, 10, 128, 12, 34, 56, 78, 90, 120, 200, 0, 1, 2, 3, 4};
+    std::vector<core::Color> colors(pixels.size() / 4);
+
+    core::rgba8_to_float(pixels, colors);
+    ASSERT_EQ(colors[0], core::Color(0.0f, 64 / 255.0f, 128 / 255.0f, 1.0f));
+
+    std::vector<uint8_t> roundtrip(pixels.size());
+    core::float_to_rgba8(colors, roundtrip);
+    ASSERT_EQ(roundtrip, pixels);
+
+    std::vector<core::Color> linearColors(colors.size());
+    core::srgb_to_linear(colors, linearColors);
+    std::vector<core::Color> linearPixels(colors.size());
+    core::srgb8_to_linear(pixels, linearPixels);
+
+    for (size_t const i : std::views::iota(0u, colors.size()))
+    {
+        core::Color expected = colors[i];
+        expected.rgb();
+        ASSERT_NEAR(linearColors[i].r, expected.r, 1e-6f);
+        ASSERT_NEAR(linearColors[i].g, expected.g, 1e-6f);
+        ASSERT_NEAR(linearColors[i].b, expected.b, 1e-6f);
+        ASSERT_NEAR(linearPixels[i].g, expected.g, 1e-6f);
+        ASSERT_EQ(linearColors[i].a, colors[i].a);
+    }
+
+    core::linear_to_srgb(linearColors, linearColors);
+    for (size_t const i : std::views::iota(0u, colors.size()))
+    {
+        ASSERT_NEAR(linearColors[i].r, colors[i].r, 2e-5f);
+        ASSERT_NEAR(linearColors[i].b, colors[i].b, 2e-5f);
+    }
+
+    core::premultiply_alpha(colors, colors);
+    ASSERT_NEAR(colors[1].r, 128 / 255.0f, 1e-6f);
+    ASSERT_EQ(colors[3].a, 0.0f);
+    ASSERT_EQ(colors[3].b, 0.0f);
+
+    std::vector<uint8_t> swizzled(pixels.size());
+    core::swizzle_bgra(pixels, swizzled);
+    ASSERT_EQ(swizzled[0], 128);
+    ASSERT_EQ(swizzled[2], 0);
+    ASSERT_EQ(swizzled[16], 3);
+    ASSERT_EQ(swizzled[19], 4);
+    core::swizzle_bgra(swizzled, swizzled);
+    ASSERT_EQ(swizzled, pixels);
+}
+
+TEST(Core, SmallVector_Test)
+{
+    core::small_vector<std::string, 4> strings = {"first", "second"};
+    ASSERT_TRUE(strings.is_inline());
+    ASSERT_EQ(strings.capacity(), 4);
+
+    strings.emplace_back("third");
+    strings.insert(strings.begin(), "zero");
+    ASSERT_TRUE(strings.is_inline());
+
+    // Grows to the heap and keeps the element referenced by the argument alive
+    strings.push_back(strings[0]);
+    ASSERT_FALSE(strings.is_inline());
+    ASSERT_EQ(strings.size(), 5);
+    ASSERT_EQ(strings.front(), "zero");
+    ASSERT_EQ(strings.back(), "zero");
+
+    strings.erase(strings.begin() + 1, strings.begin() + 3);
+    ASSERT_EQ(strings, (core::small_vector<std::string, 4>{"zero", "third", "zero"}));
+
+    strings.shrink_to_fit();
+    ASSERT_TRUE(strings.is_inline());
+
+    core::small_vector<std::string, 4> moved = std::move(strings);
+    ASSERT_TRUE(strings.empty());
+    ASSERT_EQ(moved.size(), 3);
+
+    core::small_vector<uint32_t, 2> values(8, 7);
+    core::small_vector<uint32_t, 2> heapMoved = std::move(values);
+    ASSERT_TRUE(values.is_inline());
+    ASSERT_FALSE(heapMoved.is_inline());
+    ASSERT_EQ(std::ranges::count(heapMoved, 7), 8);
+
+    std::span<uint32_t const> const span = heapMoved;
+    ASSERT_EQ(span.size(), 8);
+    ASSERT_EQ(span.data(), heapMoved.data());
+}
+
+TEST(Core, StaticVector_Test)
+{
+    core::static_vector<uint32_t, 4> values = {1, 2, 3};
+    values.insert(values.begin() + 1, 5);
+    ASSERT_EQ(values, (core::static_vector<uint32_t, 4>{1, 5, 2, 3}));
+    ASSERT_EQ(values.max_size(), 4);
+
+    ASSERT_THROW(values.push_back(4), std::bad_alloc);
+    ASSERT_THROW(values.at(4), std::out_of_range);
+    ASSERT_EQ(values.size(), 4);
+
+    values.resize(2);
+    ASSERT_EQ(values, (core::static_vector<uint32_t, 4>{1, 5}));
+    ASSERT_TRUE(values < (core::static_vector<uint32_t, 4>{1, 6}));
+}
+
+struct SmallVectorData
+{
+    core::small_vector<std::string, 2> names;
+    core::static_vector<uint32_t, 4> indices;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(names, "names");
+        archive.property(indices, "indices");
+    }
+};
+
+struct SmallVectorFile
+{
+    core::small_vector<std::string, 2> names;
+    core::static_vector<uint32_t, 4> indices;
+    SmallVectorData data;
+
+    template <typename Archive>
+    auto operator()(Archive& archive)
+    {
+        archive.property(names);
+        archive.property(indices);
+        archive.template with<core::serialize_ojson, core::serialize_ijson>(data);
+    }
+};
+
+TEST(Core, Serialize_SmallVector_Test)
+{
+    SmallVectorFile file{.names = {"name1", "name2", "name3"},
+                         .indices = {1, 2, 3, 4},
+                         .data = {.names = {"name4"}, .indices = {5, 6}}};
+
+    auto bufferObject = core::serialize<core::serialize_oarchive, std::basic_stringstream<uint8_t>>(file).value();
+    auto deserializedObject = core::deserialize<core::serialize_iarchive, SmallVectorFile>(bufferObject);
+    ASSERT_TRUE(deserializedObject.has_value());
+    ASSERT_EQ(deserializedObject->names, file.names);
+    ASSERT_EQ(deserializedObject->indices, file.indices);
+    ASSERT_EQ(deserializedObject->data.names, file.data.names);
+    ASSERT_EQ(deserializedObject->data.indices, file.data.indices);
+
+    // Capacity of static_vector is exceeded
+    std::string const json = R"({"names":[],"indices":[1,2,3,4,5]})";
+    std::basic_ispanstream<uint8_t> stream(
+        std::span<uint8_t>(reinterpret_cast<uint8_t*>(const_cast<char*>(json.data())), json.size()));
+    ASSERT_FALSE((core::deserialize<core::serialize_ijson, SmallVectorData>(stream).has_value()));
+}
+
 auto main(int32_t argc, char** argv) -> int32_t
 {
     testing::InitGoogleTest(&argc, argv);
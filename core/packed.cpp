@@ -0,0 +1,414 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#include "packed.hpp"
+#include "precompiled.h"
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IONENGINE_CORE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// F16C kernels are compiled for every x86 target and called only when the CPU reports the extension
+#if defined(_MSC_VER) && !defined(__clang__)
+#define IONENGINE_CORE_TARGET_F16C
+#else
+#define IONENGINE_CORE_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace ionengine::core
+{
+    auto float_to_half(float const value) -> Half
+    {
+        uint32_t const bits = std::bit_cast<uint32_t>(value);
+        uint32_t const sign = (bits >> 16) & 0x8000;
+        uint32_t const absolute = bits & 0x7fffffff;
+
+        // NaN and Inf
+        if (absolute >= 0x7f800000)
+        {
+            return Half{static_cast<uint16_t>(sign | 0x7c00 | (absolute > 0x7f800000 ? 0x200 : 0))};
+        }
+
+        // Overflow to Inf
+        if (absolute >= 0x477ff000)
+        {
+            return Half{static_cast<uint16_t>(sign | 0x7c00)};
+        }
+
+        // Denormals and zero
+        if (absolute < 0x38800000)
+        {
+            float const denormal = std::bit_cast<float>(absolute) + 0.5f;
+            return Half{static_cast<uint16_t>(sign | (std::bit_cast<uint32_t>(denormal) - 0x3f000000))};
+        }
+
+        // Round to nearest even
+        uint32_t const mantissaOdd = (absolute >> 13) & 1;
+        uint32_t const rounded = absolute + 0xc8000fff + mantissaOdd;
+        return Half{static_cast<uint16_t>(sign | (rounded >> 13))};
+    }
+
+    auto half_to_float(Half const value) -> float
+    {
+        uint32_t const sign = static_cast<uint32_t>(value.bits & 0x8000) << 16;
+        uint32_t const exponent = (value.bits >> 10) & 0x1f;
+        uint32_t const mantissa = value.bits & 0x3ff;
+
+        if (exponent == 0)
+        {
+            // Denormals and zero are exact in float
+            float const denormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(denormal));
+        }
+        else if (exponent == 0x1f)
+        {
+            return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+        }
+        else
+        {
+            return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+        }
+    }
+
+    namespace internal
+    {
+#if defined(IONENGINE_CORE_X86)
+        inline auto detect_f16c() -> bool
+        {
+#if defined(_MSC_VER)
+            int32_t info[4];
+            ::__cpuid(info, 1);
+            // 256-bit registers are usable only when the OS saves the AVX state
+            bool const isOsxsave = info[2] & (1 << 27);
+            bool const isAvx = info[2] & (1 << 28);
+            bool const isF16c = info[2] & (1 << 29);
+            return isOsxsave && isAvx && isF16c && (::_xgetbv(0) & 0x6) == 0x6;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+        }
+
+        IONENGINE_CORE_TARGET_F16C auto pack_half_f16c(float const* source, Half* dest, size_t const count)
+            -> size_t
+        {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 const values = _mm256_loadu_ps(source + i);
+                __m128i const halfs = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), halfs);
+            }
+            return i;
+        }
+
+        IONENGINE_CORE_TARGET_F16C auto unpack_half_f16c(Half const* source, float* dest, size_t const count)
+            -> size_t
+        {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m128i const halfs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+                _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(halfs));
+            }
+            return i;
+        }
+#endif
+    } // namespace internal
+
+    auto is_f16c_supported() -> bool
+    {
+#if defined(IONENGINE_CORE_X86)
+        static bool const isSupported = internal::detect_f16c();
+        return isSupported;
+#else
+        return false;
+#endif
+    }
+
+    auto pack_half(std::span<float const> const source, std::span<Half> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        size_t i = 0;
+#if defined(IONENGINE_CORE_X86)
+        if (is_f16c_supported())
+        {
+            i = internal::pack_half_f16c(source.data(), dest.data(), source.size());
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 4 <= source.size(); i += 4)
+        {
+            float16x4_t const halfs = vcvt_f16_f32(vld1q_f32(source.data() + i));
+            vst1_u16(reinterpret_cast<uint16_t*>(dest.data() + i), vreinterpret_u16_f16(halfs));
+        }
+#endif
+        for (; i < source.size(); ++i)
+        {
+            dest[i] = float_to_half(source[i]);
+        }
+    }
+
+    auto unpack_half(std::span<Half const> const source, std::span<float> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        size_t i = 0;
+#if defined(IONENGINE_CORE_X86)
+        if (is_f16c_supported())
+        {
+            i = internal::unpack_half_f16c(source.data(), dest.data(), source.size());
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 4 <= source.size(); i += 4)
+        {
+            float16x4_t const halfs = vreinterpret_f16_u16(vld1_u16(reinterpret_cast<uint16_t const*>(source.data() + i)));
+            vst1q_f32(dest.data() + i, vcvt_f32_f16(halfs));
+        }
+#endif
+        for (; i < source.size(); ++i)
+        {
+            dest[i] = half_to_float(source[i]);
+        }
+    }
+
+    namespace internal
+    {
+        template <typename Type>
+        inline auto pack_normalized(float const value) -> Type
+        {
+            if constexpr (std::is_signed_v<Type>)
+            {
+                float const scale = static_cast<float>(std::numeric_limits<Type>::max());
+                return static_cast<Type>(std::nearbyint(std::clamp(value, -1.0f, 1.0f) * scale));
+            }
+            else
+            {
+                float const scale = static_cast<float>(std::numeric_limits<Type>::max());
+                return static_cast<Type>(std::nearbyint(std::clamp(value, 0.0f, 1.0f) * scale));
+            }
+        }
+
+        template <typename Type>
+        inline auto unpack_normalized(Type const value) -> float
+        {
+            float const scale = 1.0f / static_cast<float>(std::numeric_limits<Type>::max());
+            if constexpr (std::is_signed_v<Type>)
+            {
+                // Both -MAX and MIN map to -1.0 as in D3D/Vulkan conversion rules
+                return std::max(static_cast<float>(value) * scale, -1.0f);
+            }
+            else
+            {
+                return static_cast<float>(value) * scale;
+            }
+        }
+
+#if defined(__SSE2__) || defined(_M_X64)
+        template <typename Type>
+        inline auto pack_normalized_sse(float const* source, Type* dest, size_t const count) -> size_t
+        {
+            float const scale = static_cast<float>(std::numeric_limits<Type>::max());
+            __m128 const minValue = _mm_set1_ps(std::is_signed_v<Type> ? -1.0f : 0.0f);
+            __m128 const maxValue = _mm_set1_ps(1.0f);
+            __m128 const scaleValue = _mm_set1_ps(scale);
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m128 const low = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), minValue), maxValue),
+                                              scaleValue);
+                __m128 const high = _mm_mul_ps(
+                    _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), minValue), maxValue), scaleValue);
+
+                // Rounding mode of MXCSR is nearest even by default
+                __m128i const lowInt = _mm_cvtps_epi32(low);
+                __m128i const highInt = _mm_cvtps_epi32(high);
+
+                if constexpr (std::is_same_v<Type, int16_t>)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packs_epi32(lowInt, highInt));
+                }
+                else if constexpr (std::is_same_v<Type, int8_t>)
+                {
+                    __m128i const packed = _mm_packs_epi16(_mm_packs_epi32(lowInt, highInt), _mm_setzero_si128());
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i), packed);
+                }
+                else if constexpr (std::is_same_v<Type, uint8_t>)
+                {
+                    __m128i const packed = _mm_packus_epi16(_mm_packs_epi32(lowInt, highInt), _mm_setzero_si128());
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + i), packed);
+                }
+                else
+                {
+                    // SSE2 has no unsigned 32 -> 16 saturation, values are already clamped to [0, 65535]
+                    __m128i const bias = _mm_set1_epi32(0x8000);
+                    __m128i const packed =
+                        _mm_packs_epi32(_mm_sub_epi32(lowInt, bias), _mm_sub_epi32(highInt, bias));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                                     _mm_xor_si128(packed, _mm_set1_epi16(static_cast<int16_t>(0x8000))));
+                }
+            }
+            return i;
+        }
+#endif
+
+        template <typename Type>
+        inline auto pack_normalized_batch(std::span<float const> const source, std::span<Type> const dest) -> void
+        {
+            assert(source.size() == dest.size() && "source and dest should be equal size");
+
+            size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            i = pack_normalized_sse(source.data(), dest.data(), source.size());
+#endif
+            for (; i < source.size(); ++i)
+            {
+                dest[i] = pack_normalized<Type>(source[i]);
+            }
+        }
+
+        template <typename Type>
+        inline auto unpack_normalized_batch(std::span<Type const> const source, std::span<float> const dest) -> void
+        {
+            assert(source.size() == dest.size() && "source and dest should be equal size");
+
+            // Simple enough for the compiler to vectorize on its own
+            for (size_t const i : std::views::iota(0u, source.size()))
+            {
+                dest[i] = unpack_normalized<Type>(source[i]);
+            }
+        }
+
+        inline auto sign_not_zero(float const value) -> float
+        {
+            return value >= 0.0f ? 1.0f : -1.0f;
+        }
+    } // namespace internal
+
+    auto pack_snorm8(std::span<float const> const source, std::span<int8_t> const dest) -> void
+    {
+        internal::pack_normalized_batch<int8_t>(source, dest);
+    }
+
+    auto unpack_snorm8(std::span<int8_t const> const source, std::span<float> const dest) -> void
+    {
+        internal::unpack_normalized_batch<int8_t>(source, dest);
+    }
+
+    auto pack_unorm8(std::span<float const> const source, std::span<uint8_t> const dest) -> void
+    {
+        internal::pack_normalized_batch<uint8_t>(source, dest);
+    }
+
+    auto unpack_unorm8(std::span<uint8_t const> const source, std::span<float> const dest) -> void
+    {
+        internal::unpack_normalized_batch<uint8_t>(source, dest);
+    }
+
+    auto pack_snorm16(std::span<float const> const source, std::span<int16_t> const dest) -> void
+    {
+        internal::pack_normalized_batch<int16_t>(source, dest);
+    }
+
+    auto unpack_snorm16(std::span<int16_t const> const source, std::span<float> const dest) -> void
+    {
+        internal::unpack_normalized_batch<int16_t>(source, dest);
+    }
+
+    auto pack_unorm16(std::span<float const> const source, std::span<uint16_t> const dest) -> void
+    {
+        internal::pack_normalized_batch<uint16_t>(source, dest);
+    }
+
+    auto unpack_unorm16(std::span<uint16_t const> const source, std::span<float> const dest) -> void
+    {
+        internal::unpack_normalized_batch<uint16_t>(source, dest);
+    }
+
+    auto pack_unorm1010102(std::span<Vec4f const> const source, std::span<Unorm1010102> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        for (size_t const i : std::views::iota(0u, source.size()))
+        {
+            auto const& value = source[i];
+
+            uint32_t const x = static_cast<uint32_t>(std::nearbyint(std::clamp(value.x, 0.0f, 1.0f) * 1023.0f));
+            uint32_t const y = static_cast<uint32_t>(std::nearbyint(std::clamp(value.y, 0.0f, 1.0f) * 1023.0f));
+            uint32_t const z = static_cast<uint32_t>(std::nearbyint(std::clamp(value.z, 0.0f, 1.0f) * 1023.0f));
+            uint32_t const w = static_cast<uint32_t>(std::nearbyint(std::clamp(value.w, 0.0f, 1.0f) * 3.0f));
+
+            dest[i].bits = x | (y << 10) | (z << 20) | (w << 30);
+        }
+    }
+
+    auto unpack_unorm1010102(std::span<Unorm1010102 const> const source, std::span<Vec4f> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        for (size_t const i : std::views::iota(0u, source.size()))
+        {
+            uint32_t const bits = source[i].bits;
+
+            dest[i] = Vec4f(static_cast<float>(bits & 0x3ff) / 1023.0f, static_cast<float>((bits >> 10) & 0x3ff) / 1023.0f,
+                            static_cast<float>((bits >> 20) & 0x3ff) / 1023.0f,
+                            static_cast<float>(bits >> 30) / 3.0f);
+        }
+    }
+
+    auto pack_octahedral(std::span<Vec3f const> const source, std::span<OctNormal> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        for (size_t const i : std::views::iota(0u, source.size()))
+        {
+            auto const& normal = source[i];
+
+            float const inverse = 1.0f / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+            float x = normal.x * inverse;
+            float y = normal.y * inverse;
+
+            // Fold lower hemisphere over the diagonals
+            if (normal.z < 0.0f)
+            {
+                float const foldedX = (1.0f - std::abs(y)) * internal::sign_not_zero(x);
+                float const foldedY = (1.0f - std::abs(x)) * internal::sign_not_zero(y);
+                x = foldedX;
+                y = foldedY;
+            }
+
+            dest[i] = OctNormal{internal::pack_normalized<int16_t>(x), internal::pack_normalized<int16_t>(y)};
+        }
+    }
+
+    auto unpack_octahedral(std::span<OctNormal const> const source, std::span<Vec3f> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+
+        for (size_t const i : std::views::iota(0u, source.size()))
+        {
+            float x = internal::unpack_normalized<int16_t>(source[i].x);
+            float y = internal::unpack_normalized<int16_t>(source[i].y);
+            float const z = 1.0f - std::abs(x) - std::abs(y);
+
+            if (z < 0.0f)
+            {
+                float const foldedX = (1.0f - std::abs(y)) * internal::sign_not_zero(x);
+                float const foldedY = (1.0f - std::abs(x)) * internal::sign_not_zero(y);
+                x = foldedX;
+                y = foldedY;
+            }
+
+            dest[i] = Vec3f(x, y, z).normalize();
+        }
+    }
+} // namespace ionengine::core
@@ -0,0 +1,206 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "core/vector.hpp"
+
+namespace ionengine::core
+{
+    /*!
+        \brief IEEE 754 binary16 value stored as raw bits
+    */
+    struct Half
+    {
+        uint16_t bits;
+
+        auto operator==(Half const& other) const -> bool
+        {
+            return bits == other.bits;
+        }
+    };
+
+    struct Vec2h
+    {
+        Half x;
+        Half y;
+    };
+
+    struct Vec3h
+    {
+        Half x;
+        Half y;
+        Half z;
+    };
+
+    struct Vec4h
+    {
+        Half x;
+        Half y;
+        Half z;
+        Half w;
+    };
+
+    struct Snorm8x4
+    {
+        int8_t x;
+        int8_t y;
+        int8_t z;
+        int8_t w;
+    };
+
+    struct Unorm8x4
+    {
+        uint8_t x;
+        uint8_t y;
+        uint8_t z;
+        uint8_t w;
+    };
+
+    struct Snorm16x2
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    struct Unorm16x2
+    {
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct Snorm16x4
+    {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+        int16_t w;
+    };
+
+    struct Unorm16x4
+    {
+        uint16_t x;
+        uint16_t y;
+        uint16_t z;
+        uint16_t w;
+    };
+
+    /*!
+        \brief Unsigned normalized 10:10:10:2 value (x in the low bits, w in the high bits)
+    */
+    struct Unorm1010102
+    {
+        uint32_t bits;
+    };
+
+    /*!
+        \brief Unit normal encoded with octahedral mapping into two snorm16 components
+    */
+    struct OctNormal
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    static_assert(sizeof(Vec3h) == 6 && sizeof(Vec4h) == 8 && sizeof(Unorm1010102) == 4 && sizeof(OctNormal) == 4);
+
+    auto float_to_half(float const value) -> Half;
+
+    auto half_to_float(Half const value) -> float;
+
+    /*!
+        \brief Whether half conversions use F16C on this CPU. Detected once at runtime, so builds without -mf16c
+        use it as well
+    */
+    auto is_f16c_supported() -> bool;
+
+    /*!
+        \brief Convert floats to half floats. Uses F16C or NEON when the CPU supports it
+        \param[in] source Input floats
+        \param[out] dest Output halfs, must be the same size as source
+    */
+    auto pack_half(std::span<float const> const source, std::span<Half> const dest) -> void;
+
+    /*!
+        \brief Convert half floats to floats. Uses F16C or NEON when the CPU supports it
+        \param[in] source Input halfs
+        \param[out] dest Output floats, must be the same size as source
+    */
+    auto unpack_half(std::span<Half const> const source, std::span<float> const dest) -> void;
+
+    /*!
+        \brief Convert floats in range [-1, 1] to snorm8. Values outside are clamped
+    */
+    auto pack_snorm8(std::span<float const> const source, std::span<int8_t> const dest) -> void;
+
+    auto unpack_snorm8(std::span<int8_t const> const source, std::span<float> const dest) -> void;
+
+    /*!
+        \brief Convert floats in range [0, 1] to unorm8. Values outside are clamped
+    */
+    auto pack_unorm8(std::span<float const> const source, std::span<uint8_t> const dest) -> void;
+
+    auto unpack_unorm8(std::span<uint8_t const> const source, std::span<float> const dest) -> void;
+
+    auto pack_snorm16(std::span<float const> const source, std::span<int16_t> const dest) -> void;
+
+    auto unpack_snorm16(std::span<int16_t const> const source, std::span<float> const dest) -> void;
+
+    auto pack_unorm16(std::span<float const> const source, std::span<uint16_t> const dest) -> void;
+
+    auto unpack_unorm16(std::span<uint16_t const> const source, std::span<float> const dest) -> void;
+
+    auto pack_unorm1010102(std::span<Vec4f const> const source, std::span<Unorm1010102> const dest) -> void;
+
+    auto unpack_unorm1010102(std::span<Unorm1010102 const> const source, std::span<Vec4f> const dest) -> void;
+
+    /*!
+        \brief Encode unit normals with octahedral mapping
+        \param[in] source Input normals, expected to be normalized
+        \param[out] dest Output encoded normals, must be the same size as source
+    */
+    auto pack_octahedral(std::span<Vec3f const> const source, std::span<OctNormal> const dest) -> void;
+
+    auto unpack_octahedral(std::span<OctNormal const> const source, std::span<Vec3f> const dest) -> void;
+
+    inline auto pack_half(std::span<Vec2f const> const source, std::span<Vec2h> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        pack_half(std::span<float const>(reinterpret_cast<float const*>(source.data()), source.size() * 2),
+                  std::span<Half>(reinterpret_cast<Half*>(dest.data()), dest.size() * 2));
+    }
+
+    inline auto pack_half(std::span<Vec3f const> const source, std::span<Vec3h> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        pack_half(std::span<float const>(reinterpret_cast<float const*>(source.data()), source.size() * 3),
+                  std::span<Half>(reinterpret_cast<Half*>(dest.data()), dest.size() * 3));
+    }
+
+    inline auto pack_half(std::span<Vec4f const> const source, std::span<Vec4h> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        pack_half(std::span<float const>(reinterpret_cast<float const*>(source.data()), source.size() * 4),
+                  std::span<Half>(reinterpret_cast<Half*>(dest.data()), dest.size() * 4));
+    }
+
+    inline auto unpack_half(std::span<Vec2h const> const source, std::span<Vec2f> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        unpack_half(std::span<Half const>(reinterpret_cast<Half const*>(source.data()), source.size() * 2),
+                    std::span<float>(reinterpret_cast<float*>(dest.data()), dest.size() * 2));
+    }
+
+    inline auto unpack_half(std::span<Vec3h const> const source, std::span<Vec3f> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        unpack_half(std::span<Half const>(reinterpret_cast<Half const*>(source.data()), source.size() * 3),
+                    std::span<float>(reinterpret_cast<float*>(dest.data()), dest.size() * 3));
+    }
+
+    inline auto unpack_half(std::span<Vec4h const> const source, std::span<Vec4f> const dest) -> void
+    {
+        assert(source.size() == dest.size() && "source and dest should be equal size");
+        unpack_half(std::span<Half const>(reinterpret_cast<Half const*>(source.data()), source.size() * 4),
+                    std::span<float>(reinterpret_cast<float*>(dest.data()), dest.size() * 4));
+    }
+} // namespace ionengine::core
@@ -86,7 +86,7 @@ namespace ionengine::core
             add_ref();
         }
 
-        template <typename Derived, typename DerivedDeleter = BaseDeleter<Derived>>
+        template <typename Derived, typename DerivedDeleter = base_deleter<Derived>>
         ref_ptr(ref_ptr<Derived, DerivedDeleter> other) : _ptr(static_cast<Type*>(other._ptr))
         {
             add_ref();
@@ -103,7 +103,7 @@ namespace ionengine::core
             return *this;
         }
 
-        template <typename Derived, typename DerivedDeleter = BaseDeleter<Derived>>
+        template <typename Derived, typename DerivedDeleter = base_deleter<Derived>>
         auto operator=(ref_ptr<Derived, DerivedDeleter> other) -> ref_ptr&
         {
             copy_ref(static_cast<Type*>(other._ptr));
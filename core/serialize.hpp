@@ -4,6 +4,7 @@
 
 #include "core/base64.hpp"
 #include "core/error.hpp"
+#include "core/small_vector.hpp"
 #include <simdjson.h>
 
 namespace ionengine::core
@@ -11,16 +12,35 @@ namespace ionengine::core
     /*!
         \brief Deserialize object with class
         \param[in] target Object that will deserialized
+        \param[in] resource Memory resource that pmr containers of the object will use
         \return Deserialized object or error
     */
     template <typename Archive, typename Type, typename Target>
-    auto deserialize(Target const& target) -> std::expected<Type, error>
+    auto deserialize(Target const& target, std::pmr::memory_resource* resource) -> std::expected<Type, error>
     {
         try
         {
             Type object{};
-            Archive archive(const_cast<Target&>(target));
+            Archive archive = [&]() {
+                if constexpr (std::is_constructible_v<Archive, Target&, std::pmr::memory_resource*>)
+                {
+                    return Archive(const_cast<Target&>(target), resource);
+                }
+                else
+                {
+                    return Archive(const_cast<Target&>(target));
+                }
+            }();
             archive(object);
+
+            // Input archives report malformed data without throwing
+            if constexpr (requires { archive.last_error(); })
+            {
+                if (archive.last_error().has_value())
+                {
+                    return std::unexpected(std::move(archive.last_error().value()));
+                }
+            }
             return object;
         }
         catch (std::exception e)
@@ -29,6 +49,17 @@ namespace ionengine::core
         }
     }
 
+    /*!
+        \brief Deserialize object with class
+        \param[in] target Object that will deserialized
+        \return Deserialized object or error
+    */
+    template <typename Archive, typename Type, typename Target>
+    auto deserialize(Target const& target) -> std::expected<Type, error>
+    {
+        return deserialize<Archive, Type, Target>(target, std::pmr::get_default_resource());
+    }
+
     /*!
         \brief Serialize object with class
         \param[in] object Object that will serialized
@@ -185,8 +216,18 @@ namespace ionengine::core
         {
         };
 
-        template <typename T, typename A>
-        struct is_std_unordered_map<std::unordered_map<T, A>> : std::true_type
+        template <typename K, typename T, typename H, typename E, typename A>
+        struct is_std_unordered_map<std::unordered_map<K, T, H, E, A>> : std::true_type
+        {
+        };
+
+        template <typename>
+        struct is_std_string : std::false_type
+        {
+        };
+
+        template <typename A>
+        struct is_std_string<std::basic_string<char, std::char_traits<char>, A>> : std::true_type
         {
         };
 
@@ -200,14 +241,57 @@ namespace ionengine::core
         {
         };
 
+        template <typename>
+        struct is_small_vector : std::false_type
+        {
+        };
+
+        template <typename T, size_t N>
+        struct is_small_vector<small_vector<T, N>> : std::true_type
+        {
+        };
+
+        template <typename T, size_t N>
+        struct is_small_vector<static_vector<T, N>> : std::true_type
+        {
+        };
+
+        template <typename Type>
+        struct is_vector : std::disjunction<is_std_vector<Type>, is_small_vector<Type>>
+        {
+        };
+
+        /*!
+            \brief Rebind an empty pmr container to the memory resource of an archive
+            \param[in|out] element Container that will be recreated if it uses another resource
+            \param[in] resource Memory resource of the archive
+        */
         template <typename Type>
-        auto from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element) -> void;
+        auto assign_memory_resource(Type& element, std::pmr::memory_resource* resource) -> void
+        {
+            if constexpr (requires {
+                              requires std::is_same_v<typename Type::allocator_type,
+                                                      std::pmr::polymorphic_allocator<typename Type::value_type>>;
+                          })
+            {
+                // Assignment never propagates polymorphic allocators, so the container is created again
+                if (element.get_allocator().resource() != resource)
+                {
+                    std::destroy_at(&element);
+                    std::construct_at(&element, typename Type::allocator_type(resource));
+                }
+            }
+        }
+
+        template <typename Type>
+        auto from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element)
+            -> std::expected<void, error>;
 
         template <typename Type>
         auto to_json(serialize_ojson& output, std::string_view const json_name, Type const& element) -> void;
 
         template <typename Type>
-        auto from_binary(serialize_iarchive& input, Type& element) -> void;
+        auto from_binary(serialize_iarchive& input, Type& element) -> std::expected<void, error>;
 
         template <typename Type>
         auto to_binary(serialize_oarchive& output, Type const& element) -> void;
@@ -216,19 +300,48 @@ namespace ionengine::core
     class serialize_ijson
     {
         template <typename Type>
-        friend auto internal::from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element) -> void;
+        friend auto internal::from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element)
+            -> std::expected<void, error>;
 
       public:
-        serialize_ijson(std::basic_istream<uint8_t>& stream) : _stream(&stream)
+        serialize_ijson(std::basic_istream<uint8_t>& stream,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _stream(&stream), _resource(resource)
         {
-            _json_data = std::string(std::istreambuf_iterator<uint8_t>(stream.rdbuf()), {});
-            _document = _parser.iterate(_json_data, _json_data.size() + simdjson::SIMDJSON_PADDING);
+            _json_data = simdjson::padded_string(std::string(std::istreambuf_iterator<uint8_t>(stream.rdbuf()), {}));
+
+            auto result = _parser.iterate(_json_data).get(_document);
+            if (result != simdjson::SUCCESS)
+            {
+                _error.emplace(simdjson::error_message(result));
+            }
         }
 
         template <typename Type>
         auto property(Type& element, std::string_view const json_name) -> void
         {
-            internal::from_json(*this, _document[json_name], element);
+            if (_error.has_value())
+            {
+                return;
+            }
+
+            simdjson::ondemand::value value;
+            auto result = _document[json_name].get(value);
+            if (result != simdjson::SUCCESS)
+            {
+                // Missing optional fields are left empty
+                if (!(internal::is_std_optional<Type>::value && result == simdjson::NO_SUCH_FIELD))
+                {
+                    _error.emplace("Field is not found: " + std::string(json_name));
+                }
+                return;
+            }
+
+            auto from_result = internal::from_json(*this, value, element);
+            if (!from_result.has_value())
+            {
+                _error.emplace(std::move(from_result.error()));
+            }
         }
 
         template <typename Type>
@@ -240,16 +353,30 @@ namespace ionengine::core
         template <typename Type>
         auto operator()(Type& object) -> size_t
         {
-            object(*this);
+            if (!_error.has_value())
+            {
+                object(*this);
+            }
             return _stream->tellg();
         }
 
+        /*!
+            \brief Get the first error that stopped reading
+            \return Error or empty value if the input was read successfully
+        */
+        auto last_error() -> std::optional<error>&
+        {
+            return _error;
+        }
+
       private:
-        std::string _json_data;
+        simdjson::padded_string _json_data;
         simdjson::ondemand::parser _parser;
-        simdjson::ondemand::document_stream::iterator::value_type _document;
+        simdjson::ondemand::document _document;
         std::basic_istream<uint8_t>* _stream;
+        std::pmr::memory_resource* _resource;
         std::unordered_map<std::string, uint32_t> _enum_fields;
+        std::optional<error> _error;
     };
 
     class serialize_ojson
@@ -297,47 +424,185 @@ namespace ionengine::core
     class serialize_iarchive
     {
         template <typename Type>
-        friend auto internal::from_binary(serialize_iarchive& input, Type& element) -> void;
+        friend auto internal::from_binary(serialize_iarchive& input, Type& element) -> std::expected<void, error>;
 
       public:
-        serialize_iarchive(std::basic_istream<uint8_t>& stream) : _stream(&stream)
+        serialize_iarchive(std::basic_istream<uint8_t>& stream,
+                           std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _stream(&stream), _resource(resource), _remaining(std::numeric_limits<size_t>::max())
         {
             if (stream.fail())
             {
-                throw std::out_of_range("Input stream is failed");
+                _error.emplace("Input stream is failed");
+                return;
+            }
+
+            // Know the input size up front to reject truncated data before reading it
+            auto const position = stream.tellg();
+            if (position != std::streampos(-1))
+            {
+                stream.seekg(0, std::ios::end);
+                auto const end = stream.tellg();
+                stream.seekg(position);
+                _remaining = static_cast<size_t>(end - position);
             }
         }
 
         template <typename Type>
         auto property(Type& element) -> void
         {
-            internal::from_binary(*this, element);
+            if (_error.has_value())
+            {
+                return;
+            }
+
+            auto result = internal::from_binary(*this, element);
+            if (!result.has_value())
+            {
+                _error.emplace(std::move(result.error()));
+            }
         }
 
         template <typename OutputArchive, typename InputArchive, typename Type>
         auto with(Type& element) -> void
         {
+            if (_error.has_value())
+            {
+                return;
+            }
+
             size_t buffer_size;
-            _stream->read(reinterpret_cast<uint8_t*>(&buffer_size), sizeof(size_t));
+            auto result = read(reinterpret_cast<uint8_t*>(&buffer_size), sizeof(size_t));
+            if (!result.has_value())
+            {
+                _error.emplace(std::move(result.error()));
+                return;
+            }
 
-            std::vector<uint8_t> buffer(buffer_size);
-            _stream->read(buffer.data(), buffer_size);
+            std::vector<uint8_t> buffer;
+            result = read_vector(buffer, buffer_size);
+            if (!result.has_value())
+            {
+                _error.emplace(std::move(result.error()));
+                return;
+            }
 
-            std::basic_ispanstream<uint8_t> sstream(
-                std::span<uint8_t>(const_cast<uint8_t*>(buffer.data()), buffer.size()), std::ios::binary);
-            InputArchive archive(sstream);
+            std::basic_ispanstream<uint8_t> sstream(std::span<uint8_t>(buffer.data(), buffer.size()),
+                                                    std::ios::binary);
+            InputArchive archive(sstream, _resource);
             archive(element);
+
+            if constexpr (requires { archive.last_error(); })
+            {
+                if (archive.last_error().has_value())
+                {
+                    _error.emplace(std::move(archive.last_error().value()));
+                }
+            }
         }
 
         template <typename Type>
         auto operator()(Type const& object) -> size_t
         {
-            const_cast<Type&>(object)(*this);
+            if (!_error.has_value())
+            {
+                const_cast<Type&>(object)(*this);
+            }
             return _stream->tellg();
         }
 
+        /*!
+            \brief Get the first error that stopped reading
+            \return Error or empty value if the input was read successfully
+        */
+        auto last_error() -> std::optional<error>&
+        {
+            return _error;
+        }
+
       private:
         std::basic_istream<uint8_t>* _stream;
+        std::pmr::memory_resource* _resource;
+        size_t _remaining;
+        std::optional<error> _error;
+
+        auto read(uint8_t* data, size_t const size) -> std::expected<void, error>
+        {
+            if (size > _remaining)
+            {
+                return std::unexpected(error("Buffer is out of range"));
+            }
+
+            _stream->read(data, size);
+            if (static_cast<size_t>(_stream->gcount()) != size)
+            {
+                return std::unexpected(error("Input stream is truncated"));
+            }
+
+            _remaining -= size;
+            return {};
+        }
+
+        template <typename Vector>
+        auto read_vector(Vector& element, size_t const num_elements) -> std::expected<void, error>
+        {
+            using Type = typename Vector::value_type;
+
+            if (num_elements > element.max_size())
+            {
+                return std::unexpected(error("Array is too large"));
+            }
+
+            // Every element takes at least one byte, so a larger count is corrupted data
+            if (num_elements > _remaining ||
+                (std::is_arithmetic_v<Type> && num_elements > _remaining / sizeof(Type)))
+            {
+                return std::unexpected(error("Buffer is out of range"));
+            }
+
+            element.resize(num_elements);
+            if constexpr (std::is_arithmetic_v<Type>)
+            {
+                return read(reinterpret_cast<uint8_t*>(element.data()), num_elements * sizeof(Type));
+            }
+            else
+            {
+                for (size_t const i : std::views::iota(0u, num_elements))
+                {
+                    auto result = internal::from_binary(*this, element[i]);
+                    if (!result.has_value())
+                    {
+                        return result;
+                    }
+                }
+                return {};
+            }
+        }
+
+        template <typename Allocator>
+        auto read_string(std::basic_string<char, std::char_traits<char>, Allocator>& element)
+            -> std::expected<void, error>
+        {
+            auto buffer = _stream->rdbuf();
+
+            element.clear();
+            while (_remaining > 0)
+            {
+                auto const value = buffer->sbumpc();
+                if (value == std::char_traits<uint8_t>::eof())
+                {
+                    break;
+                }
+
+                --_remaining;
+                if (static_cast<char>(value) == '\0')
+                {
+                    return {};
+                }
+                element.push_back(static_cast<char>(value));
+            }
+            return std::unexpected(error("Buffer is out of range"));
+        }
     };
 
     class serialize_oarchive
@@ -383,15 +648,16 @@ namespace ionengine::core
     namespace internal
     {
         template <typename Type>
-        auto from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element) -> void
+        auto from_json(serialize_ijson& input, simdjson::ondemand::value it, Type& element)
+            -> std::expected<void, error>
         {
             if constexpr (std::is_integral_v<Type> && !std::is_same_v<Type, bool>)
             {
                 int64_t value;
-                auto error = it.get_int64().get(value);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_int64().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not an integral type");
+                    return std::unexpected(error("Field is not an integral type"));
                 }
 
                 element = value;
@@ -399,10 +665,10 @@ namespace ionengine::core
             else if constexpr (std::is_integral_v<Type> && std::is_same_v<Type, bool>)
             {
                 bool value;
-                auto error = it.get_bool().get(value);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_bool().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not a bool type");
+                    return std::unexpected(error("Field is not a bool type"));
                 }
 
                 element = value;
@@ -410,25 +676,25 @@ namespace ionengine::core
             else if constexpr (std::is_floating_point_v<Type>)
             {
                 simdjson::ondemand::number value;
-                auto error = it.get_number().get(value);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_number().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not a float type");
+                    return std::unexpected(error("Field is not a float type"));
                 }
 
                 element = static_cast<Type>(value.get_double());
             }
-            else if constexpr (std::is_same_v<Type,
-                                              std::basic_string<char, std::char_traits<char>, std::allocator<char>>>)
+            else if constexpr (is_std_string<Type>::value)
             {
                 std::string_view value;
-                auto error = it.get_string().get(value);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_string().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not a string type");
+                    return std::unexpected(error("Field is not a string type"));
                 }
 
-                element = std::string(value);
+                assign_memory_resource(element, input._resource);
+                element.assign(value.begin(), value.end());
             }
             else if constexpr (std::is_scoped_enum_v<Type>)
             {
@@ -436,53 +702,81 @@ namespace ionengine::core
                 object(input);
 
                 std::string_view value;
-                auto error = it.get_string().get(value);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_string().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not an enum type");
+                    return std::unexpected(error("Field is not an enum type"));
                 }
 
                 auto result = input._enum_fields.find(std::string(value));
                 if (result == input._enum_fields.end())
                 {
-                    throw std::invalid_argument("Enum type is not found");
+                    return std::unexpected(error("Enum type is not found"));
                 }
 
                 element = static_cast<Type>(result->second);
             }
-            else if constexpr (is_std_vector<Type>::value)
+            else if constexpr (is_vector<Type>::value)
             {
+                assign_memory_resource(element, input._resource);
+
                 if constexpr (std::is_same_v<typename Type::value_type, uint8_t>)
                 {
                     std::string_view value;
-                    auto error = it.get_string().get(value);
-                    if (error != simdjson::SUCCESS)
+                    auto error_code = it.get_string().get(value);
+                    if (error_code != simdjson::SUCCESS)
                     {
-                        throw std::invalid_argument("Field is not a string type");
+                        return std::unexpected(error("Field is not a string type"));
                     }
 
-                    auto result = Base64::decode(value);
+                    auto result = Base64().decode(value);
                     if (!result.has_value())
                     {
-                        throw std::invalid_argument("Field is not a base64 string");
+                        return std::unexpected(error("Field is not a base64 string"));
                     }
-                    element = std::move(result.value());
+
+                    if (result.value().size() > element.max_size())
+                    {
+                        return std::unexpected(error("Array is too large"));
+                    }
+                    element.assign(result.value().begin(), result.value().end());
                 }
                 else
                 {
                     simdjson::ondemand::array elements;
-                    auto error = it.get_array().get(elements);
-                    if (error != simdjson::SUCCESS)
+                    auto error_code = it.get_array().get(elements);
+                    if (error_code != simdjson::SUCCESS)
+                    {
+                        return std::unexpected(error("Field is not an array"));
+                    }
+
+                    size_t num_elements;
+                    error_code = elements.count_elements().get(num_elements);
+                    if (error_code != simdjson::SUCCESS)
                     {
-                        throw std::invalid_argument("Field is not an array");
+                        return std::unexpected(error("Field is not an array"));
                     }
 
-                    element.resize(elements.count_elements());
+                    if (num_elements > element.max_size())
+                    {
+                        return std::unexpected(error("Array is too large"));
+                    }
+                    element.resize(num_elements);
 
                     uint32_t i = 0;
                     for (auto e : elements)
                     {
-                        from_json(input, e.value(), element[i]);
+                        simdjson::ondemand::value value;
+                        if (e.get(value) != simdjson::SUCCESS)
+                        {
+                            return std::unexpected(error("Array element is not valid"));
+                        }
+
+                        auto result = from_json(input, value, element[i]);
+                        if (!result.has_value())
+                        {
+                            return result;
+                        }
                         ++i;
                     }
                 }
@@ -490,10 +784,10 @@ namespace ionengine::core
             else if constexpr (is_std_array<Type>::value)
             {
                 simdjson::ondemand::array elements;
-                auto error = it.get_array().get(elements);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_array().get(elements);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not an array");
+                    return std::unexpected(error("Field is not an array"));
                 }
 
                 auto constexpr arraySize = std::tuple_size<Type>::value;
@@ -501,100 +795,147 @@ namespace ionengine::core
                 uint32_t i = 0;
                 for (auto e : elements)
                 {
-                    if (i > arraySize)
+                    if (i >= arraySize)
                     {
-                        throw std::out_of_range("Array is out of range");
+                        return std::unexpected(error("Array is out of range"));
+                    }
+
+                    simdjson::ondemand::value value;
+                    if (e.get(value) != simdjson::SUCCESS)
+                    {
+                        return std::unexpected(error("Array element is not valid"));
+                    }
+
+                    auto result = from_json(input, value, element[i]);
+                    if (!result.has_value())
+                    {
+                        return result;
                     }
-                    from_json(input, e.value(), element[i]);
                     ++i;
                 }
             }
             else if constexpr (is_std_unique_ptr<Type>::value)
             {
                 element = std::make_unique<typename Type::element_type>();
-                from_json(input, it, *element);
+                return from_json(input, it, *element);
             }
             else if constexpr (is_std_unordered_map<Type>::value)
             {
+                assign_memory_resource(element, input._resource);
+
                 simdjson::ondemand::object elements;
-                auto error = it.get_object().get(elements);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_object().get(elements);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not an object type");
+                    return std::unexpected(error("Field is not an object type"));
                 }
 
                 for (auto e : elements)
                 {
+                    simdjson::ondemand::field field;
+                    error_code = std::move(e).get(field);
+                    if (error_code != simdjson::SUCCESS)
+                    {
+                        return std::unexpected(error("Field is not valid"));
+                    }
+
                     std::string_view key;
-                    error = e.unescaped_key().get(key);
-                    if (error != simdjson::SUCCESS)
+                    error_code = field.unescaped_key().get(key);
+                    if (error_code != simdjson::SUCCESS)
                     {
-                        throw std::invalid_argument("Field is not a key");
+                        return std::unexpected(error("Field is not a key"));
                     }
 
                     typename Type::mapped_type inserted_value;
-                    from_json(input, e.value(), inserted_value);
+                    auto result = from_json(input, field.value(), inserted_value);
+                    if (!result.has_value())
+                    {
+                        return result;
+                    }
 
                     if constexpr (std::is_integral_v<typename Type::key_type>)
                     {
-                        element[static_cast<typename Type::key_type>(std::stoi(std::string(key)))] =
-                            std::move(inserted_value);
+                        typename Type::key_type integral_key;
+                        auto [ptr, ec] = std::from_chars(key.data(), key.data() + key.size(), integral_key);
+                        if (ec != std::errc())
+                        {
+                            return std::unexpected(error("Key is not an integral type"));
+                        }
+
+                        element[integral_key] = std::move(inserted_value);
                     }
                     else if constexpr (std::is_scoped_enum_v<typename Type::key_type>)
                     {
                         serializable_enum<typename Type::key_type> object;
                         object(input);
 
-                        auto result = input._enum_fields.find(std::string(key));
-                        if (result == input._enum_fields.end())
+                        auto enum_result = input._enum_fields.find(std::string(key));
+                        if (enum_result == input._enum_fields.end())
                         {
-                            throw std::invalid_argument("Enum type is not found");
+                            return std::unexpected(error("Enum type is not found"));
                         }
 
-                        element[static_cast<Type::key_type>(result->second)] = std::move(inserted_value);
+                        element[static_cast<Type::key_type>(enum_result->second)] = std::move(inserted_value);
                     }
                     else
                     {
-                        element[std::string(key)] = std::move(inserted_value);
+                        element[typename Type::key_type(key)] = std::move(inserted_value);
                     }
                 }
             }
             else if constexpr (is_std_optional<Type>::value)
             {
-                if (!it.is_null())
+                bool is_null;
+                auto error_code = it.is_null().get(is_null);
+                if (error_code != simdjson::SUCCESS)
+                {
+                    return std::unexpected(error("Field is not valid"));
+                }
+
+                if (!is_null)
                 {
                     typename Type::value_type inserted_value;
-                    from_json(input, it, inserted_value);
+                    auto result = from_json(input, it, inserted_value);
+                    if (!result.has_value())
+                    {
+                        return result;
+                    }
                     element = std::move(inserted_value);
                 }
             }
             else
             {
                 simdjson::ondemand::object object;
-                auto error = it.get_object().get(object);
-                if (error != simdjson::SUCCESS)
+                auto error_code = it.get_object().get(object);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not an object type");
+                    return std::unexpected(error("Field is not an object type"));
                 }
 
                 std::string_view value;
-                error = object.raw_json().get(value);
-                if (error != simdjson::SUCCESS)
+                error_code = object.raw_json().get(value);
+                if (error_code != simdjson::SUCCESS)
                 {
-                    throw std::invalid_argument("Field is not a nested json");
+                    return std::unexpected(error("Field is not a nested json"));
                 }
 
                 std::basic_spanstream<uint8_t> sstream(
                     std::span<uint8_t>(reinterpret_cast<uint8_t*>(const_cast<char*>(value.data())), value.size()));
-                serialize_ijson archive(sstream);
+                serialize_ijson archive(sstream, input._resource);
                 archive(element);
+
+                if (archive.last_error().has_value())
+                {
+                    return std::unexpected(std::move(archive.last_error().value()));
+                }
             }
+            return {};
         }
 
         template <typename Type>
         auto to_json(serialize_ojson& output, std::string_view const json_name, Type const& element) -> void
         {
-            if constexpr (is_std_vector<Type>::value)
+            if constexpr (is_vector<Type>::value)
             {
                 if (!json_name.empty())
                 {
@@ -603,7 +944,7 @@ namespace ionengine::core
 
                 if constexpr (std::is_same_v<typename Type::value_type, uint8_t>)
                 {
-                    std::string const encoded_string = base64_encode(element);
+                    std::string const encoded_string = Base64().encode(element);
                     output._json_chunk << "\"" << encoded_string << "\"";
                 }
                 else
@@ -723,8 +1064,7 @@ namespace ionengine::core
                 {
                     output._json_chunk << std::boolalpha << element;
                 }
-                else if constexpr (std::is_same_v<
-                                       Type, std::basic_string<char, std::char_traits<char>, std::allocator<char>>>)
+                else if constexpr (is_std_string<Type>::value)
                 {
                     output._json_chunk << "\"" << element << "\"";
                 }
@@ -758,77 +1098,69 @@ namespace ionengine::core
         }
 
         template <typename Type>
-        auto from_binary(serialize_iarchive& input, Type& element) -> void
+        auto from_binary(serialize_iarchive& input, Type& element) -> std::expected<void, error>
         {
             if constexpr (std::is_integral_v<Type> || std::is_floating_point_v<Type>)
             {
-                input._stream->read(reinterpret_cast<uint8_t*>(&element), sizeof(Type));
+                return input.read(reinterpret_cast<uint8_t*>(&element), sizeof(Type));
             }
-            else if constexpr (std::is_same_v<Type,
-                                              std::basic_string<char, std::char_traits<char>, std::allocator<char>>>)
+            else if constexpr (is_std_string<Type>::value)
             {
-                std::vector<uint8_t> buffer;
-                uint8_t value = 0x1;
-                while (static_cast<char>(value) != '\0')
-                {
-                    if (input._stream->eof())
-                    {
-                        throw std::out_of_range("Buffer is out of range");
-                    }
-                    input._stream->read(&value, 1);
-                    if (static_cast<char>(value) != '\0')
-                    {
-                        buffer.emplace_back(value);
-                    }
-                }
-
-                element = std::string(reinterpret_cast<char*>(buffer.data()), buffer.size());
+                assign_memory_resource(element, input._resource);
+                return input.read_string(element);
             }
-            else if constexpr (is_std_vector<Type>::value)
+            else if constexpr (is_vector<Type>::value)
             {
                 size_t num_elements = 0;
-                input._stream->read(reinterpret_cast<uint8_t*>(&num_elements), sizeof(size_t));
-                element.resize(num_elements);
-                if constexpr (std::is_same_v<typename Type::value_type, uint8_t>)
-                {
-                    input._stream->read(element.data(), element.size());
-                }
-                else
+                auto result = input.read(reinterpret_cast<uint8_t*>(&num_elements), sizeof(size_t));
+                if (!result.has_value())
                 {
-                    for (size_t const i : std::views::iota(0u, element.size()))
-                    {
-                        from_binary(input, element[i]);
-                    }
+                    return result;
                 }
+
+                assign_memory_resource(element, input._resource);
+                return input.read_vector(element, num_elements);
             }
             else if constexpr (is_std_array<Type>::value)
             {
                 for (size_t const i : std::views::iota(0u, element.size()))
                 {
-                    from_binary(input, element[i]);
+                    auto result = from_binary(input, element[i]);
+                    if (!result.has_value())
+                    {
+                        return result;
+                    }
                 }
+                return {};
             }
             else if constexpr (std::is_scoped_enum_v<Type>)
             {
-                input._stream->read(reinterpret_cast<uint8_t*>(&element), sizeof(typename std::underlying_type_t<Type>));
+                return input.read(reinterpret_cast<uint8_t*>(&element), sizeof(typename std::underlying_type_t<Type>));
             }
             else
             {
-                serialize_iarchive archive(*input._stream);
-                archive(element);
+                // Nested objects are read by the same archive to keep bounds tracking
+                element(input);
+
+                if (input._error.has_value())
+                {
+                    return std::unexpected(input._error.value());
+                }
+                return {};
             }
         }
 
         template <typename Type>
         auto to_binary(serialize_oarchive& output, Type const& element) -> void
         {
-            if constexpr (is_std_vector<Type>::value)
+            if constexpr (is_vector<Type>::value)
             {
                 size_t const num_elements = element.size();
                 output._stream->write(reinterpret_cast<uint8_t const*>(&num_elements), sizeof(size_t));
-                if constexpr (std::is_same_v<typename Type::value_type, uint8_t>)
+                if constexpr (std::is_arithmetic_v<typename Type::value_type>)
                 {
-                    output._stream->write(element.data(), element.size());
+                    output._stream->write(reinterpret_cast<uint8_t const*>(element.data()),
+                                          element.size() * sizeof(typename Type::value_type));
                 }
                 else
                 {
@@ -851,8 +1183,7 @@ namespace ionengine::core
                 {
                     output._stream->write(reinterpret_cast<uint8_t const*>(&element), sizeof(Type));
                 }
-                else if constexpr (std::is_same_v<
-                                       Type, std::basic_string<char, std::char_traits<char>, std::allocator<char>>>)
+                else if constexpr (is_std_string<Type>::value)
                 {
                     output._stream->write(reinterpret_cast<uint8_t const*>(element.data()), element.size());
                     char end_of_string = '\0';
@@ -0,0 +1,650 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+namespace ionengine::core
+{
+    namespace internal
+    {
+        /*!
+            \brief Contiguous container that keeps up to Capacity elements in inline storage
+            \details When Growable is set the elements move to the heap once the inline storage is exhausted,
+            otherwise the container throws std::bad_alloc like std::inplace_vector
+        */
+        template <typename Type, size_t Capacity, bool Growable>
+        class inline_vector
+        {
+            static_assert(Capacity > 0, "inline capacity should be greater than zero");
+
+          public:
+            using value_type = Type;
+            using size_type = size_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = Type&;
+            using const_reference = Type const&;
+            using pointer = Type*;
+            using const_pointer = Type const*;
+            using iterator = Type*;
+            using const_iterator = Type const*;
+            using reverse_iterator = std::reverse_iterator<iterator>;
+            using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+            inline_vector() noexcept : _data(inline_data()), _size(0), _capacity(Capacity)
+            {
+            }
+
+            explicit inline_vector(size_type const count) : inline_vector()
+            {
+                resize(count);
+            }
+
+            inline_vector(size_type const count, Type const& value) : inline_vector()
+            {
+                assign(count, value);
+            }
+
+            template <std::input_iterator InputIt>
+            inline_vector(InputIt first, InputIt last) : inline_vector()
+            {
+                assign(first, last);
+            }
+
+            inline_vector(std::initializer_list<Type> init) : inline_vector()
+            {
+                assign(init.begin(), init.end());
+            }
+
+            inline_vector(inline_vector const& other) : inline_vector()
+            {
+                assign(other.begin(), other.end());
+            }
+
+            inline_vector(inline_vector&& other) noexcept(std::is_nothrow_move_constructible_v<Type>)
+                : inline_vector()
+            {
+                move_from(other);
+            }
+
+            ~inline_vector()
+            {
+                clear();
+                release();
+            }
+
+            auto operator=(inline_vector const& other) -> inline_vector&
+            {
+                if (this != &other)
+                {
+                    assign(other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            auto operator=(inline_vector&& other) noexcept(std::is_nothrow_move_constructible_v<Type>)
+                -> inline_vector&
+            {
+                if (this != &other)
+                {
+                    clear();
+                    release();
+                    move_from(other);
+                }
+                return *this;
+            }
+
+            auto operator=(std::initializer_list<Type> init) -> inline_vector&
+            {
+                assign(init.begin(), init.end());
+                return *this;
+            }
+
+            auto assign(size_type const count, Type const& value) -> void
+            {
+                clear();
+                reserve(count);
+                std::uninitialized_fill_n(_data, count, value);
+                _size = count;
+            }
+
+            template <std::input_iterator InputIt>
+            auto assign(InputIt first, InputIt last) -> void
+            {
+                clear();
+                if constexpr (std::forward_iterator<InputIt>)
+                {
+                    size_type const count = static_cast<size_type>(std::distance(first, last));
+                    reserve(count);
+                    std::uninitialized_copy(first, last, _data);
+                    _size = count;
+                }
+                else
+                {
+                    for (; first != last; ++first)
+                    {
+                        emplace_back(*first);
+                    }
+                }
+            }
+
+            auto assign(std::initializer_list<Type> init) -> void
+            {
+                assign(init.begin(), init.end());
+            }
+
+            auto at(size_type const pos) -> reference
+            {
+                if (pos >= _size)
+                {
+                    throw std::out_of_range("Position is out of range");
+                }
+                return _data[pos];
+            }
+
+            auto at(size_type const pos) const -> const_reference
+            {
+                if (pos >= _size)
+                {
+                    throw std::out_of_range("Position is out of range");
+                }
+                return _data[pos];
+            }
+
+            auto operator[](size_type const pos) -> reference
+            {
+                assert(pos < _size && "position is out of range");
+                return _data[pos];
+            }
+
+            auto operator[](size_type const pos) const -> const_reference
+            {
+                assert(pos < _size && "position is out of range");
+                return _data[pos];
+            }
+
+            auto front() -> reference
+            {
+                assert(_size > 0 && "container is empty");
+                return _data[0];
+            }
+
+            auto front() const -> const_reference
+            {
+                assert(_size > 0 && "container is empty");
+                return _data[0];
+            }
+
+            auto back() -> reference
+            {
+                assert(_size > 0 && "container is empty");
+                return _data[_size - 1];
+            }
+
+            auto back() const -> const_reference
+            {
+                assert(_size > 0 && "container is empty");
+                return _data[_size - 1];
+            }
+
+            auto data() noexcept -> pointer
+            {
+                return _data;
+            }
+
+            auto data() const noexcept -> const_pointer
+            {
+                return _data;
+            }
+
+            auto begin() noexcept -> iterator
+            {
+                return _data;
+            }
+
+            auto begin() const noexcept -> const_iterator
+            {
+                return _data;
+            }
+
+            auto cbegin() const noexcept -> const_iterator
+            {
+                return _data;
+            }
+
+            auto end() noexcept -> iterator
+            {
+                return _data + _size;
+            }
+
+            auto end() const noexcept -> const_iterator
+            {
+                return _data + _size;
+            }
+
+            auto cend() const noexcept -> const_iterator
+            {
+                return _data + _size;
+            }
+
+            auto rbegin() noexcept -> reverse_iterator
+            {
+                return reverse_iterator(end());
+            }
+
+            auto rbegin() const noexcept -> const_reverse_iterator
+            {
+                return const_reverse_iterator(end());
+            }
+
+            auto crbegin() const noexcept -> const_reverse_iterator
+            {
+                return const_reverse_iterator(end());
+            }
+
+            auto rend() noexcept -> reverse_iterator
+            {
+                return reverse_iterator(begin());
+            }
+
+            auto rend() const noexcept -> const_reverse_iterator
+            {
+                return const_reverse_iterator(begin());
+            }
+
+            auto crend() const noexcept -> const_reverse_iterator
+            {
+                return const_reverse_iterator(begin());
+            }
+
+            auto empty() const noexcept -> bool
+            {
+                return _size == 0;
+            }
+
+            auto size() const noexcept -> size_type
+            {
+                return _size;
+            }
+
+            auto max_size() const noexcept -> size_type
+            {
+                if constexpr (Growable)
+                {
+                    return std::numeric_limits<difference_type>::max() / sizeof(Type);
+                }
+                else
+                {
+                    return Capacity;
+                }
+            }
+
+            auto capacity() const noexcept -> size_type
+            {
+                return _capacity;
+            }
+
+            /*!
+                \brief Check that the elements are stored in the inline storage
+                \return Returns true when no heap allocation is held by the container
+            */
+            auto is_inline() const noexcept -> bool
+            {
+                return _data == inline_data();
+            }
+
+            auto reserve(size_type const new_capacity) -> void
+            {
+                if (new_capacity <= _capacity)
+                {
+                    return;
+                }
+
+                if constexpr (Growable)
+                {
+                    reallocate(new_capacity);
+                }
+                else
+                {
+                    throw std::bad_alloc();
+                }
+            }
+
+            auto shrink_to_fit() -> void
+            {
+                if (is_inline() || _size == _capacity)
+                {
+                    return;
+                }
+
+                if (_size <= Capacity)
+                {
+                    Type* heap_data = _data;
+                    size_type const heap_capacity = _capacity;
+
+                    std::uninitialized_move_n(heap_data, _size, inline_data());
+                    std::destroy_n(heap_data, _size);
+                    _data = inline_data();
+                    _capacity = Capacity;
+                    deallocate(heap_data, heap_capacity);
+                }
+                else
+                {
+                    reallocate(_size);
+                }
+            }
+
+            auto clear() noexcept -> void
+            {
+                std::destroy_n(_data, _size);
+                _size = 0;
+            }
+
+            auto insert(const_iterator pos, Type const& value) -> iterator
+            {
+                return emplace(pos, value);
+            }
+
+            auto insert(const_iterator pos, Type&& value) -> iterator
+            {
+                return emplace(pos, std::move(value));
+            }
+
+            auto insert(const_iterator pos, size_type const count, Type const& value) -> iterator
+            {
+                size_type const index = static_cast<size_type>(pos - cbegin());
+                size_type const old_size = _size;
+
+                // Value can reference an element of the container
+                Type const copy = value;
+                reserve(grow_capacity(_size + count));
+                std::uninitialized_fill_n(end(), count, copy);
+                _size += count;
+                std::rotate(begin() + index, begin() + old_size, end());
+                return begin() + index;
+            }
+
+            template <std::input_iterator InputIt>
+            auto insert(const_iterator pos, InputIt first, InputIt last) -> iterator
+            {
+                size_type const index = static_cast<size_type>(pos - cbegin());
+                size_type const old_size = _size;
+
+                if constexpr (std::forward_iterator<InputIt>)
+                {
+                    reserve(grow_capacity(_size + static_cast<size_type>(std::distance(first, last))));
+                }
+
+                for (; first != last; ++first)
+                {
+                    emplace_back(*first);
+                }
+                std::rotate(begin() + index, begin() + old_size, end());
+                return begin() + index;
+            }
+
+            auto insert(const_iterator pos, std::initializer_list<Type> init) -> iterator
+            {
+                return insert(pos, init.begin(), init.end());
+            }
+
+            template <typename... Args>
+            auto emplace(const_iterator pos, Args&&... args) -> iterator
+            {
+                size_type const index = static_cast<size_type>(pos - cbegin());
+                if (index == _size)
+                {
+                    emplace_back(std::forward<Args>(args)...);
+                    return begin() + index;
+                }
+
+                // Arguments can reference an element of the container that is about to be shifted
+                Type value(std::forward<Args>(args)...);
+                reserve(grow_capacity(_size + 1));
+                std::construct_at(end(), std::move(back()));
+                ++_size;
+                std::move_backward(begin() + index, end() - 2, end() - 1);
+                _data[index] = std::move(value);
+                return begin() + index;
+            }
+
+            auto erase(const_iterator pos) -> iterator
+            {
+                return erase(pos, pos + 1);
+            }
+
+            auto erase(const_iterator first, const_iterator last) -> iterator
+            {
+                iterator it = begin() + (first - cbegin());
+                if (first != last)
+                {
+                    size_type const count = static_cast<size_type>(last - first);
+                    iterator const new_end = std::move(it + count, end(), it);
+                    std::destroy(new_end, end());
+                    _size -= count;
+                }
+                return it;
+            }
+
+            auto push_back(Type const& value) -> void
+            {
+                emplace_back(value);
+            }
+
+            auto push_back(Type&& value) -> void
+            {
+                emplace_back(std::move(value));
+            }
+
+            template <typename... Args>
+            auto emplace_back(Args&&... args) -> reference
+            {
+                if (_size == _capacity)
+                {
+                    if constexpr (Growable)
+                    {
+                        return reallocate_emplace_back(std::forward<Args>(args)...);
+                    }
+                    else
+                    {
+                        throw std::bad_alloc();
+                    }
+                }
+
+                std::construct_at(_data + _size, std::forward<Args>(args)...);
+                ++_size;
+                return back();
+            }
+
+            auto pop_back() -> void
+            {
+                assert(_size > 0 && "container is empty");
+                --_size;
+                std::destroy_at(_data + _size);
+            }
+
+            auto resize(size_type const count) -> void
+            {
+                if (count < _size)
+                {
+                    std::destroy(begin() + count, end());
+                }
+                else
+                {
+                    reserve(count);
+                    std::uninitialized_value_construct_n(end(), count - _size);
+                }
+                _size = count;
+            }
+
+            auto resize(size_type const count, Type const& value) -> void
+            {
+                if (count < _size)
+                {
+                    std::destroy(begin() + count, end());
+                }
+                else
+                {
+                    Type const copy = value;
+                    reserve(count);
+                    std::uninitialized_fill_n(end(), count - _size, copy);
+                }
+                _size = count;
+            }
+
+            auto swap(inline_vector& other) -> void
+            {
+                inline_vector temp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(temp);
+            }
+
+            friend auto operator==(inline_vector const& lhs, inline_vector const& rhs) -> bool
+            {
+                return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+            }
+
+            friend auto operator<=>(inline_vector const& lhs, inline_vector const& rhs)
+                requires std::three_way_comparable<Type>
+            {
+                return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+            }
+
+          private:
+            Type* _data;
+            size_type _size;
+            size_type _capacity;
+            alignas(Type) std::byte _storage[Capacity * sizeof(Type)];
+
+            auto inline_data() noexcept -> Type*
+            {
+                return reinterpret_cast<Type*>(_storage);
+            }
+
+            auto inline_data() const noexcept -> Type const*
+            {
+                return reinterpret_cast<Type const*>(_storage);
+            }
+
+            auto grow_capacity(size_type const required) const -> size_type
+            {
+                if (required <= _capacity)
+                {
+                    return _capacity;
+                }
+                return std::max(required, _capacity * 2);
+            }
+
+            static auto allocate(size_type const capacity) -> Type*
+            {
+                return static_cast<Type*>(::operator new(capacity * sizeof(Type), std::align_val_t(alignof(Type))));
+            }
+
+            static auto deallocate(Type* data, size_type const capacity) -> void
+            {
+                ::operator delete(data, capacity * sizeof(Type), std::align_val_t(alignof(Type)));
+            }
+
+            auto reallocate(size_type const new_capacity) -> void
+            {
+                Type* new_data = allocate(new_capacity);
+                try
+                {
+                    std::uninitialized_move_n(_data, _size, new_data);
+                }
+                catch (...)
+                {
+                    deallocate(new_data, new_capacity);
+                    throw;
+                }
+
+                std::destroy_n(_data, _size);
+                release();
+                _data = new_data;
+                _capacity = new_capacity;
+            }
+
+            template <typename... Args>
+            auto reallocate_emplace_back(Args&&... args) -> reference
+            {
+                size_type const new_capacity = grow_capacity(_size + 1);
+                Type* new_data = allocate(new_capacity);
+                try
+                {
+                    // New element is constructed first because arguments can reference the old elements
+                    std::construct_at(new_data + _size, std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    deallocate(new_data, new_capacity);
+                    throw;
+                }
+
+                try
+                {
+                    std::uninitialized_move_n(_data, _size, new_data);
+                }
+                catch (...)
+                {
+                    std::destroy_at(new_data + _size);
+                    deallocate(new_data, new_capacity);
+                    throw;
+                }
+
+                std::destroy_n(_data, _size);
+                release();
+                _data = new_data;
+                _capacity = new_capacity;
+                ++_size;
+                return back();
+            }
+
+            auto release() noexcept -> void
+            {
+                if (!is_inline())
+                {
+                    deallocate(_data, _capacity);
+                    _data = inline_data();
+                    _capacity = Capacity;
+                }
+            }
+
+            auto move_from(inline_vector& other) -> void
+            {
+                if (other.is_inline())
+                {
+                    std::uninitialized_move_n(other._data, other._size, _data);
+                    _size = other._size;
+                    other.clear();
+                }
+                else
+                {
+                    _data = other._data;
+                    _size = other._size;
+                    _capacity = other._capacity;
+                    other._data = other.inline_data();
+                    other._size = 0;
+                    other._capacity = Capacity;
+                }
+            }
+        };
+    } // namespace internal
+
+    /*!
+        \brief Vector that keeps up to Capacity elements inline and falls back to the heap when it grows further
+    */
+    template <typename Type, size_t Capacity>
+    class small_vector : public internal::inline_vector<Type, Capacity, true>
+    {
+      public:
+        using internal::inline_vector<Type, Capacity, true>::inline_vector;
+    };
+
+    /*!
+        \brief Vector with a fixed capacity that never allocates. Growing past Capacity throws std::bad_alloc
+    */
+    template <typename Type, size_t Capacity>
+    class static_vector : public internal::inline_vector<Type, Capacity, false>
+    {
+      public:
+        using internal::inline_vector<Type, Capacity, false>::inline_vector;
+    };
+} // namespace ionengine::core
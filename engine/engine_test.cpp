@@ -0,0 +1,97 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#include "graphics/buffer_pool.hpp"
+#include "graphics/graphics_pipeline.hpp"
+#include "graphics/texture_pool.hpp"
+#include "precompiled.h"
+#include <gtest/gtest.h>
+
+using namespace ionengine;
+
+TEST(Graphics, TexturePoolReset_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto texturePool = core::make_ref<TexturePool>(rhi);
+
+    rhi::TextureCreateInfo const textureCreateInfo{
+        .width = 64,
+        .height = 64,
+        .depth = 1,
+        .mipLevels = 1,
+        .format = rhi::Format::RGBA8_UNORM,
+        .dimension = rhi::TextureDimension::_2D,
+        .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::RenderTarget};
+    auto const firstAllocation = texturePool->allocate(textureCreateInfo);
+    ASSERT_TRUE(firstAllocation.has_value());
+
+    // A frame that never returned its texture gets it back on reset, and the texture is kept for the next frame
+    texturePool->reset();
+    auto const secondAllocation = texturePool->allocate(textureCreateInfo);
+    ASSERT_TRUE(secondAllocation.has_value());
+    ASSERT_EQ(firstAllocation->getTexture(), secondAllocation->getTexture());
+
+    auto const thirdAllocation = texturePool->allocate(textureCreateInfo);
+    ASSERT_TRUE(thirdAllocation.has_value());
+    ASSERT_NE(secondAllocation->getTexture(), thirdAllocation->getTexture());
+}
+
+TEST(Graphics, PipelineFramePools_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    std::vector<rhi::Buffer*> frameBuffers;
+    GraphicsPipelineBuilder builder;
+    builder.addAttachment(InternalAttachmentCreateInfo::RenderTarget2D("Color", AttachmentAbsoluteSize{64, 64},
+                                                                       rhi::Format::RGBA8_UNORM));
+    builder.addSubpass(
+        SubpassCreateInfo{.name = "Base",
+                          .colors = {SubpassColorInfo{.name = "Color",
+                                                      .loadOp = rhi::RenderPassLoadOp::Clear,
+                                                      .storeOp = rhi::RenderPassStoreOp::Store,
+                                                      .clearColor = core::Color(0.0f, 0.0f, 0.0f, 1.0f)}}},
+        [&](GraphicsContext& context) -> void {
+            frameBuffers.emplace_back(context.getConstantBufferPool().allocate(256).get().get());
+        });
+    auto graphicsPipeline = builder.build();
+
+    uint32_t constexpr FramesInFlight = 2;
+    std::vector<core::ref_ptr<TexturePool>> texturePools;
+    std::vector<core::ref_ptr<BufferPool>> constantBufferPools;
+    for (uint32_t i = 0; i < FramesInFlight; ++i)
+    {
+        texturePools.emplace_back(core::make_ref<TexturePool>(rhi));
+        constantBufferPools.emplace_back(core::make_ref<BufferPool>(rhi, rhi::BufferUsage::ConstantBuffer));
+    }
+
+    ASSERT_FALSE(graphicsPipeline->getPassTimingsFrame().has_value());
+
+    for (uint64_t const frameCount : std::views::iota(0u, 6u))
+    {
+        uint32_t const frameIndex = frameCount % FramesInFlight;
+        texturePools[frameIndex]->reset();
+        constantBufferPools[frameIndex]->reset();
+
+        graphicsPipeline->execute(*rhi, *texturePools[frameIndex], *constantBufferPools[frameIndex], frameCount)
+            .wait();
+    }
+
+    // Every frame slot reuses the constant buffer of its previous frame and the slots never share one
+    ASSERT_EQ(frameBuffers.size(), 6);
+    ASSERT_NE(frameBuffers[0], frameBuffers[1]);
+    for (uint32_t const i : std::views::iota(FramesInFlight, 6u))
+    {
+        ASSERT_EQ(frameBuffers[i], frameBuffers[i - FramesInFlight]);
+    }
+
+    // Timings are read back a few frames late and keep the frame count they were measured in
+    auto const passTimingsFrame = graphicsPipeline->getPassTimingsFrame();
+    ASSERT_TRUE(passTimingsFrame.has_value());
+    ASSERT_LT(passTimingsFrame.value(), 5);
+    ASSERT_EQ(graphicsPipeline->getPassTimings().size(), 1);
+}
+
+auto main(int32_t argc, char** argv) -> int32_t
+{
+    testing::InitGoogleTest(&argc, argv);
+    return ::RUN_ALL_TESTS();
+}
\ No newline at end of file
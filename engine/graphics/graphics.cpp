@@ -6,7 +6,8 @@
 namespace ionengine
 {
     Graphics::Graphics(core::ref_ptr<platform::App> app, EngineEnvironment& environment, ModuleOptions const& options)
-        : _environment(environment), _shadersPath(options.shadersPath), frameIndex(0), _app(app)
+        : _environment(environment), _shadersPath(options.shadersPath), frameIndex(0), _app(app), _frameStats{},
+          _frameTimes{}
     {
         _app->windowStateChanged += [this](platform::WindowEvent const& event) -> void {
             if (event.type == platform::WindowEventType::Resize)
@@ -16,14 +17,20 @@ namespace ionengine
         };
         _app->windowUpdated += [this]() -> void { this->onWindowUpdated(); };
 
-        rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = options.stagingBufferSize, .numBuffering = 2};
+        uint32_t const framesInFlight = options.framesInFlight > 0 ? options.framesInFlight : DefaultFramesInFlight;
+
+        rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = options.stagingBufferSize,
+                                               .numBuffering = framesInFlight,
+                                               .pipelineCachePath = options.pipelineCachePath};
         rhi::SwapchainCreateInfo const swapchainCreateInfo{.window = app->getWindowHandle(),
                                                            .instance = app->getInstanceHandle()};
         _rhi = rhi::RHI::create(rhiCreateInfo, swapchainCreateInfo);
 
-        for (uint32_t const i : std::views::iota(0u, 2u))
+        for (uint32_t i = 0; i < framesInFlight; ++i)
         {
-            FrameData frameData{.frameBufferPool = core::make_ref<TexturePool>(_rhi)};
+            FrameData frameData{
+                .frameBufferPool = core::make_ref<TexturePool>(_rhi),
+                .constantBufferPool = core::make_ref<BufferPool>(_rhi, rhi::BufferUsage::ConstantBuffer)};
             _frames.emplace_back(std::move(frameData));
         }
 
@@ -42,18 +49,68 @@ namespace ionengine
             return;
         }
 
+        // Back buffers can be recreated only when no frame in flight renders to them
+        this->waitForFrames();
         _rhi->getSwapchain()->resizeBackBuffers(event.size.width, event.size.height);
     }
 
     auto Graphics::onWindowUpdated() -> void
     {
+        auto const beginTime = std::chrono::steady_clock::now();
+        if (_lastFrameTime.has_value())
+        {
+            _frameStats.frameTime =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(beginTime - _lastFrameTime.value()).count();
+            _frameTimes[(_frameStats.frameCount - 1) % FrameTimeHistorySize] = _frameStats.frameTime;
+        }
+        _lastFrameTime = beginTime;
+
+        // The CPU waits only when it is a full set of frames ahead, the data of this frame is free again after it
+        FrameData& frameData = _frames[frameIndex];
+        frameData.presentResult.wait();
+        _frameStats.waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - beginTime)
+                                   .count();
+        frameData.frameBufferPool->reset();
+        frameData.constantBufferPool->reset();
+
         _curGraphicsPipeline->bindAttachment("Ext_Swapchain", _rhi->getSwapchain()->getBackBuffer());
+        _curGraphicsPipeline->execute(*_rhi, *frameData.frameBufferPool, *frameData.constantBufferPool,
+                                      _frameStats.frameCount);
+        frameData.presentResult = _rhi->getSwapchain()->presentBackBuffer();
+
+        // Timings are paired with the time of the frame they were measured in, which is known once the next began
+        auto const gpuFrameCount = _curGraphicsPipeline->getPassTimingsFrame();
+        if (gpuFrameCount.has_value() && gpuFrameCount.value() < _frameStats.frameCount &&
+            _frameStats.frameCount - gpuFrameCount.value() <= FrameTimeHistorySize)
+        {
+            uint64_t gpuTime = 0;
+            for (auto const& passTiming : _curGraphicsPipeline->getPassTimings())
+            {
+                gpuTime += passTiming.gpuTime;
+            }
+            uint64_t const frameTime = _frameTimes[gpuFrameCount.value() % FrameTimeHistorySize];
+
+            _frameStats.gpuFrameCount = gpuFrameCount.value();
+            _frameStats.gpuTime = gpuTime;
+            _frameStats.gpuIdleTime = frameTime > gpuTime ? frameTime - gpuTime : 0;
+        }
+        _frameStats.frameCount++;
 
-        _curGraphicsPipeline->execute(*_rhi, *_frames[frameIndex].frameBufferPool);
+        frameIndex = (frameIndex + 1) % static_cast<uint32_t>(_frames.size());
+    }
 
-        auto presentResult = _rhi->getSwapchain()->presentBackBuffer();
+    auto Graphics::waitForFrames() -> void
+    {
+        for (auto const& frameData : _frames)
+        {
+            frameData.presentResult.wait();
+        }
+    }
 
-        presentResult.wait();
+    auto Graphics::getFrameStats() const -> FrameStats
+    {
+        return _frameStats;
     }
 
     auto Graphics::initialize() -> void
@@ -63,4 +120,9 @@ namespace ionengine
             // auto shader = core::make_ref<Shader>();
         }
     }
+
+    auto Graphics::shutdown() -> void
+    {
+        this->waitForFrames();
+    }
 } // namespace ionengine
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "buffer_pool.hpp"
 #include "engine_environment.hpp"
 #include "graphics_pipeline.hpp"
 #include "iengine_module.hpp"
@@ -12,19 +13,49 @@
 
 namespace ionengine
 {
+    /*!
+        \brief Timings of the latest frame, in nanoseconds
+    */
+    struct FrameStats
+    {
+        uint64_t frameCount;
+        // Time between the starts of the latest two frames
+        uint64_t frameTime;
+        // Time the CPU was blocked until the GPU had finished the frame that used the same resources
+        uint64_t waitTime;
+        // Frame the GPU timings were measured in, they are read back a few frames late
+        uint64_t gpuFrameCount;
+        // Sum of the pass timings of that frame
+        uint64_t gpuTime;
+        // Part of the frame time of that frame the GPU was not busy with the passes
+        uint64_t gpuIdleTime;
+    };
+
     class Graphics : public IEngineModule
     {
         struct FrameData
         {
             core::ref_ptr<TexturePool> frameBufferPool;
+            core::ref_ptr<BufferPool> constantBufferPool;
+            // Completes when the GPU has finished the frame last recorded with this data
+            rhi::Future<void> presentResult;
         };
 
       public:
+        // Frames the CPU can record before it waits for the GPU, used when the options leave it at zero
+        static uint32_t constexpr DefaultFramesInFlight = 2;
+
+        // Frame times kept to pair them with the pass timings read back later
+        static uint32_t constexpr FrameTimeHistorySize = 16;
+
         struct ModuleOptions
         {
             std::filesystem::path shadersPath;
             size_t stagingBufferSize;
+            std::filesystem::path pipelineCachePath;
             core::ref_ptr<GraphicsPipeline> graphicsPipeline;
+            // Frames recorded ahead of the GPU, one waits for every frame and more add a frame of latency each
+            uint32_t framesInFlight;
         };
 
         Graphics(core::ref_ptr<platform::App> app, EngineEnvironment& environment, ModuleOptions const& options);
@@ -33,15 +64,15 @@ namespace ionengine
 
         auto initialize() -> void override;
 
-        auto shutdown() -> void override
-        {
-        }
+        auto shutdown() -> void override;
 
         auto getPriority() const -> uint16_t override
         {
             return std::to_underlying(EngineModulePriority::Core) + 10;
         }
 
+        auto getFrameStats() const -> FrameStats;
+
       private:
         EngineEnvironment& _environment;
         core::ref_ptr<platform::App> _app;
@@ -50,6 +81,11 @@ namespace ionengine
         std::filesystem::path _shadersPath;
         std::vector<FrameData> _frames;
         uint32_t frameIndex;
+        std::optional<std::chrono::steady_clock::time_point> _lastFrameTime;
+        FrameStats _frameStats;
+        std::array<uint64_t, FrameTimeHistorySize> _frameTimes;
+
+        auto waitForFrames() -> void;
 
         auto onWindowResized(platform::WindowEvent const& event) -> void;
 
@@ -8,8 +8,9 @@
 namespace ionengine
 {
     GraphicsContext::GraphicsContext(core::ref_ptr<Subpass> subpass,
-                                     std::unordered_map<std::string, rhi::Texture*>& boundAttachments)
-        : _subpass(subpass), _boundAttachments(boundAttachments)
+                                     std::unordered_map<std::string, rhi::Texture*>& boundAttachments,
+                                     BufferPool& constantBufferPool)
+        : _subpass(subpass), _boundAttachments(boundAttachments), _constantBufferPool(constantBufferPool)
     {
     }
 
@@ -31,12 +32,17 @@ namespace ionengine
         return nullptr;
     }
 
+    auto GraphicsContext::getConstantBufferPool() const -> BufferPool&
+    {
+        return _constantBufferPool;
+    }
+
     GraphicsPipeline::GraphicsPipeline(
-        std::vector<core::ref_ptr<Subpass>> const& subpasses,
+        std::vector<core::ref_ptr<Subpass>> const& subpasses, std::vector<ExecutePassHandler> const& executeHandlers,
         std::unordered_map<std::string, core::ref_ptr<Attachment>> const& attachments,
         std::unordered_map<std::string, std::vector<rhi::ResourceState>> const& attachmentTransitions)
-        : _subpasses(subpasses), _attachments(attachments), _attachmentTransitions(attachmentTransitions),
-          _renderWidth(800), _renderHeight(600)
+        : _subpasses(subpasses), _executeHandlers(executeHandlers), _attachments(attachments),
+          _attachmentTransitions(attachmentTransitions), _renderWidth(800), _renderHeight(600), _timingIndex(0)
     {
     }
 
@@ -53,10 +59,19 @@ namespace ionengine
         }
     }
 
-    auto GraphicsPipeline::execute(rhi::RHI& rhi, TexturePool& texturePool) -> rhi::Future<void>
+    auto GraphicsPipeline::execute(rhi::RHI& rhi, TexturePool& texturePool, BufferPool& constantBufferPool,
+                                   uint64_t const frameCount) -> rhi::Future<void>
     {
+        bool const isTimed = this->readPassTimings(rhi);
+        rhi::Query* timingQuery = _timingQueries[_timingIndex].query.get();
+
         for (uint32_t const i : std::views::iota(0u, _subpasses.size()))
         {
+            if (isTimed)
+            {
+                rhi.getGraphicsContext()->beginQuery(timingQuery, i);
+            }
+
             _colorTextures.clear();
             rhi::Texture* depthStencilTexture = nullptr;
 
@@ -150,9 +165,18 @@ namespace ionengine
 
             subpass->beginPass(rhi.getGraphicsContext(), _colorTextures, depthStencilTexture);
 
-            // Execture Handler
+            if (_executeHandlers[i])
+            {
+                GraphicsContext context(subpass, _boundAttachments, constantBufferPool);
+                _executeHandlers[i](context);
+            }
 
             subpass->endPass(rhi.getGraphicsContext());
+
+            if (isTimed)
+            {
+                rhi.getGraphicsContext()->endQuery(timingQuery, i);
+            }
         }
 
         uint32_t const lastSubpassIndex = static_cast<uint32_t>(_subpasses.size() - 1);
@@ -184,6 +208,14 @@ namespace ionengine
             }
         }
 
+        if (isTimed)
+        {
+            rhi.getGraphicsContext()->resolveQuery(timingQuery);
+            _timingQueries[_timingIndex].isRecorded = true;
+            _timingQueries[_timingIndex].frameCount = frameCount;
+            _timingIndex = (_timingIndex + 1) % TimingQueryCount;
+        }
+
         auto executeResult = rhi.getGraphicsContext()->execute();
 
         _boundAttachments.clear();
@@ -233,6 +265,7 @@ namespace ionengine
         }
 
         _subpasses.emplace_back(subpass);
+        _executeHandlers.emplace_back(std::move(executeHandler));
         _subpassNames.emplace(createInfo.name);
         return *this;
     }
@@ -288,7 +321,7 @@ namespace ionengine
                 previousSubpassIndex = resourceInfo.subpassIndex;
             }
         }
-        return core::make_ref<GraphicsPipeline>(_subpasses, _attachments, attachmentTransitions);
+        return core::make_ref<GraphicsPipeline>(_subpasses, _executeHandlers, _attachments, attachmentTransitions);
     }
 
     auto GraphicsPipelineBuilder::addAttachment(AttachmentCreateInfo const& createInfo) -> GraphicsPipelineBuilder&
@@ -342,4 +375,53 @@ namespace ionengine
     auto GraphicsPipeline::setRenderSize(uint32_t const width, uint32_t const height) -> void
     {
     }
+
+    auto GraphicsPipeline::getPassTimings() const -> std::span<PassTiming const>
+    {
+        return _passTimings;
+    }
+
+    auto GraphicsPipeline::getPassTimingsFrame() const -> std::optional<uint64_t>
+    {
+        return _passTimingsFrame;
+    }
+
+    auto GraphicsPipeline::readPassTimings(rhi::RHI& rhi) -> bool
+    {
+        if (_subpasses.empty())
+        {
+            return false;
+        }
+
+        if (!_timingQueries[0].query)
+        {
+            rhi::QueryCreateInfo const queryCreateInfo{.queryType = rhi::QueryType::Timestamp,
+                                                       .count = static_cast<uint32_t>(_subpasses.size())};
+            for (auto& timingQuery : _timingQueries)
+            {
+                timingQuery = {.query = rhi.createQuery(queryCreateInfo), .isRecorded = false, .frameCount = 0};
+            }
+        }
+
+        // The next query of the ring is the oldest one, when the GPU is still behind it the frame is not timed
+        auto& timingQuery = _timingQueries[_timingIndex];
+        if (!timingQuery.query->getResult())
+        {
+            return false;
+        }
+
+        if (timingQuery.isRecorded)
+        {
+            std::span<uint64_t const> const elapsedTimes = timingQuery.query->getElapsedTimes();
+
+            _passTimings.resize(_subpasses.size());
+            for (uint32_t const i : std::views::iota(0u, _subpasses.size()))
+            {
+                _passTimings[i] = PassTiming{.name = _subpasses[i]->getName(), .gpuTime = elapsedTimes[i]};
+            }
+            _passTimingsFrame = timingQuery.frameCount;
+            timingQuery.isRecorded = false;
+        }
+        return true;
+    }
 } // namespace ionengine
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "attachment.hpp"
+#include "buffer_pool.hpp"
 #include "core/ref_ptr.hpp"
 #include "subpass.hpp"
 #include "texture_pool.hpp"
@@ -13,34 +14,74 @@ namespace ionengine
     {
       public:
         GraphicsContext(core::ref_ptr<Subpass> subpass,
-                        std::unordered_map<std::string, rhi::Texture*>& boundAttachments);
+                        std::unordered_map<std::string, rhi::Texture*>& boundAttachments,
+                        BufferPool& constantBufferPool);
 
         auto getTextureByName(std::string_view const attachmentName) const -> rhi::Texture*;
 
         auto getTextureFromColors(uint32_t const colorIndex) const -> rhi::Texture*;
 
+        // Constant buffers of the frame being recorded, they are reused once the GPU has finished that frame
+        auto getConstantBufferPool() const -> BufferPool&;
+
       private:
         core::ref_ptr<Subpass> _subpass;
         std::unordered_map<std::string, rhi::Texture*>& _boundAttachments;
+        BufferPool& _constantBufferPool;
     };
 
-    using ExecutePassHandler = std::function<void()>;
+    using ExecutePassHandler = std::function<void(GraphicsContext&)>;
+
+    struct PassTiming
+    {
+        std::string name;
+        uint64_t gpuTime; // In nanoseconds
+    };
 
     class GraphicsPipeline : public core::ref_counted_object
     {
       public:
         GraphicsPipeline(std::vector<core::ref_ptr<Subpass>> const& subpasses,
+                         std::vector<ExecutePassHandler> const& executeHandlers,
                          std::unordered_map<std::string, core::ref_ptr<Attachment>> const& attachments,
                          std::unordered_map<std::string, std::vector<rhi::ResourceState>> const& attachmentTransitions);
 
         auto bindAttachment(std::string_view const attachmentName, rhi::Texture* texture) -> void;
 
-        auto execute(rhi::RHI& rhi, TexturePool& texturePool) -> rhi::Future<void>;
+        /*!
+            \brief Records the subpasses of a frame and submits them
+            \details Textures of the internal attachments come from the texture pool and the subpass handlers
+            allocate their constant buffers from the buffer pool. Both pools must stay untouched until the GPU has
+            finished the frame. The frame count tags the pass timings measured in this frame
+        */
+        auto execute(rhi::RHI& rhi, TexturePool& texturePool, BufferPool& constantBufferPool,
+                     uint64_t const frameCount) -> rhi::Future<void>;
 
         auto setRenderSize(uint32_t const width, uint32_t const height) -> void;
 
+        /*!
+            \brief Returns the GPU time of each subpass from the latest frame whose results are ready
+            \details Results are read back a few frames late without waiting for the GPU, the span is empty until
+            the first of them is ready
+        */
+        auto getPassTimings() const -> std::span<PassTiming const>;
+
+        // Frame count passed to the execution the pass timings were measured in, empty until they are ready
+        auto getPassTimingsFrame() const -> std::optional<uint64_t>;
+
       private:
+        // Frames that can be timed before the results of the oldest one are read back
+        static uint32_t constexpr TimingQueryCount = 3;
+
+        struct TimingQuery
+        {
+            core::ref_ptr<rhi::Query> query;
+            bool isRecorded;
+            uint64_t frameCount;
+        };
+
         std::vector<core::ref_ptr<Subpass>> _subpasses;
+        std::vector<ExecutePassHandler> _executeHandlers;
         std::unordered_map<std::string, core::ref_ptr<Attachment>> _attachments;
         std::unordered_map<std::string, rhi::Texture*> _boundAttachments;
         std::unordered_map<std::string, std::vector<rhi::ResourceState>> _attachmentTransitions;
@@ -49,7 +90,14 @@ namespace ionengine
         uint32_t _renderWidth;
         uint32_t _renderHeight;
 
-        std::vector<rhi::Texture*> _colorTextures;
+        core::static_vector<rhi::Texture*, rhi::MaxColorAttachments> _colorTextures;
+
+        std::array<TimingQuery, TimingQueryCount> _timingQueries;
+        uint32_t _timingIndex;
+        std::vector<PassTiming> _passTimings;
+        std::optional<uint64_t> _passTimingsFrame;
+
+        auto readPassTimings(rhi::RHI& rhi) -> bool;
 
         auto tryAttachmentSubpassBarrier(rhi::RHI& rhi, Attachment& attachment, std::string_view const attachmentName,
                                          uint32_t const subpassIndex, rhi::Texture* texture) -> uint32_t;
@@ -75,6 +123,7 @@ namespace ionengine
 
       private:
         std::vector<core::ref_ptr<Subpass>> _subpasses;
+        std::vector<ExecutePassHandler> _executeHandlers;
         std::unordered_map<std::string, core::ref_ptr<Attachment>> _attachments;
         std::unordered_set<std::string> _subpassNames;
         std::unordered_map<std::string, std::vector<SubpassAttachmentInfo>> _subpassAttachments;
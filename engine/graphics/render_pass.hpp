@@ -33,19 +33,19 @@ namespace ionengine
 
         virtual auto execute(RenderContext const& context) -> void = 0;
 
-        auto getColors() const -> std::vector<rhi::RenderPassColorInfo> const&;
+        auto getColors() const -> std::span<rhi::RenderPassColorInfo const>;
 
         auto getHash() const -> uint64_t;
 
-        auto getInputs() const -> std::vector<RenderPassInputInfo> const&;
+        auto getInputs() const -> std::span<RenderPassInputInfo const>;
 
         std::unordered_map<RenderGroup, RenderQueue>* renderGroups;
 
       protected:
         auto initializeRenderPass() -> void;
 
-        std::vector<rhi::RenderPassColorInfo> colors;
-        std::vector<RenderPassInputInfo> inputs;
+        core::static_vector<rhi::RenderPassColorInfo, rhi::MaxColorAttachments> colors;
+        core::small_vector<RenderPassInputInfo, 4> inputs;
         std::optional<rhi::RenderPassDepthStencilInfo> depthStencil;
 
       private:
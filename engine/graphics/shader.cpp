@@ -36,7 +36,7 @@ namespace ionengine
             default:
                 throw std::invalid_argument("unknown VertexFormat for passed argument");
         }
-    }
+    }*/
 
     auto FXFillMode_to_RHIFillMode(asset::fx::FillMode const fillMode) -> rhi::FillMode
     {
@@ -66,7 +66,75 @@ namespace ionengine
         }
     }
 
-    Shader::Shader(rhi::RHI& RHI, asset::ShaderFile const& shaderFile)
+    auto FXBlend_to_RHIBlendColorInfo(std::string_view const blend) -> rhi::BlendColorInfo const&
+    {
+        if (blend.compare("Mixed") == 0)
+        {
+            return rhi::BlendColorInfo::Mixed();
+        }
+        else if (blend.compare("Add") == 0)
+        {
+            return rhi::BlendColorInfo::Add();
+        }
+        else if (blend.compare("AlphaBlend") == 0)
+        {
+            return rhi::BlendColorInfo::AlphaBlend();
+        }
+        else
+        {
+            return rhi::BlendColorInfo::Opaque();
+        }
+    }
+
+    auto prewarmShaderPermutations(rhi::RHI& RHI, asset::fx::ShaderData const& shaderData,
+                                   std::unordered_map<uint32_t, core::ref_ptr<rhi::Shader>> const& permutationShaders,
+                                   std::span<rhi::Format const> const renderTargetFormats,
+                                   rhi::Format const depthStencilFormat) -> void
+    {
+        std::vector<rhi::PipelinePrewarmInfo> prewarmInfos;
+        for (auto const& [permutationKey, permutationData] : shaderData.permutations)
+        {
+            auto permutationShader = permutationShaders.find(permutationKey);
+            if (permutationShader == permutationShaders.end())
+            {
+                continue;
+            }
+
+            rhi::PipelinePrewarmInfo prewarmInfo{
+                .shader = permutationShader->second.get(),
+                .rasterizer = {.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back},
+                .blendColor = FXBlend_to_RHIBlendColorInfo(shaderData.header.blend),
+                .renderTargetFormats = renderTargetFormats,
+                .depthStencilFormat = depthStencilFormat};
+
+            // Only the pixel stage carries the output state
+            for (uint32_t const stageIndex : permutationData.stages)
+            {
+                auto const& stageData = shaderData.stages[stageIndex];
+                if (!stageData.output.has_value())
+                {
+                    continue;
+                }
+
+                auto const& outputData = stageData.output.value();
+                prewarmInfo.rasterizer = {.fillMode = FXFillMode_to_RHIFillMode(outputData.fillMode),
+                                          .cullMode = FXCullMode_to_RHICullMode(outputData.cullMode)};
+                if (depthStencilFormat != rhi::Format::Unknown)
+                {
+                    // Passes test depth with LessEqual
+                    prewarmInfo.depthStencil = rhi::DepthStencilStageInfo{.depthFunc = rhi::CompareOp::LessEqual,
+                                                                          .depthWrite = outputData.depthWrite,
+                                                                          .stencilWrite = outputData.stencilWrite};
+                }
+            }
+
+            prewarmInfos.emplace_back(std::move(prewarmInfo));
+        }
+
+        RHI.prewarmPipelines(prewarmInfos);
+    }
+
+    /*Shader::Shader(rhi::RHI& RHI, asset::ShaderFile const& shaderFile)
     {
         std::string shaderFormat;
         switch (shaderFile.shaderFormat)
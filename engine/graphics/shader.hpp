@@ -13,6 +13,15 @@ namespace ionengine
         size_t size;
     };
 
+    /*! \brief Queues the pipelines of every permutation of an .fx shader for background compilation
+        \details permutationShaders holds the RHI shaders created for the permutation keys of the shader data,
+        permutations without one are skipped
+    */
+    auto prewarmShaderPermutations(rhi::RHI& RHI, asset::fx::ShaderData const& shaderData,
+                                   std::unordered_map<uint32_t, core::ref_ptr<rhi::Shader>> const& permutationShaders,
+                                   std::span<rhi::Format const> const renderTargetFormats,
+                                   rhi::Format const depthStencilFormat) -> void;
+
     class ShaderVariant : public core::ref_counted_object
     {
       public:
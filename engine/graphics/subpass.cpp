@@ -6,7 +6,8 @@
 namespace ionengine
 {
     Subpass::Subpass(SubpassCreateInfo const& createInfo)
-        : _inputs(createInfo.inputs), _colors(createInfo.colors), _depthStencil(createInfo.depthStencil)
+        : _name(createInfo.name), _inputs(createInfo.inputs), _colors(createInfo.colors),
+          _depthStencil(createInfo.depthStencil)
     {
         for (auto const& color : createInfo.colors)
         {
@@ -55,6 +56,11 @@ namespace ionengine
         context->endRenderPass();
     }
 
+    auto Subpass::getName() const -> std::string const&
+    {
+        return _name;
+    }
+
     auto Subpass::getInputs() const -> std::span<SubpassInputInfo const>
     {
         return _inputs;
@@ -4,6 +4,7 @@
 
 #include "core/color.hpp"
 #include "core/ref_ptr.hpp"
+#include "core/small_vector.hpp"
 #include "rhi/rhi.hpp"
 
 namespace ionengine
@@ -35,8 +36,8 @@ namespace ionengine
     struct SubpassCreateInfo
     {
         std::string name;
-        std::vector<SubpassInputInfo> inputs;
-        std::vector<SubpassColorInfo> colors;
+        core::small_vector<SubpassInputInfo, 4> inputs;
+        core::static_vector<SubpassColorInfo, rhi::MaxColorAttachments> colors;
         std::optional<SubpassDepthStencilInfo> depthStencil;
     };
 
@@ -50,6 +51,8 @@ namespace ionengine
 
         auto endPass(rhi::GraphicsContext* context) -> void;
 
+        auto getName() const -> std::string const&;
+
         auto getInputs() const -> std::span<SubpassInputInfo const>;
 
         auto getColors() const -> std::span<SubpassColorInfo const>;
@@ -57,10 +60,11 @@ namespace ionengine
         auto getDepthStencil() const -> std::optional<SubpassDepthStencilInfo> const&;
 
       private:
-        std::vector<SubpassInputInfo> _inputs;
-        std::vector<SubpassColorInfo> _colors;
+        std::string _name;
+        core::small_vector<SubpassInputInfo, 4> _inputs;
+        core::static_vector<SubpassColorInfo, rhi::MaxColorAttachments> _colors;
         std::optional<SubpassDepthStencilInfo> _depthStencil;
-        std::vector<rhi::RenderPassColorInfo> _rhiColors;
+        core::static_vector<rhi::RenderPassColorInfo, rhi::MaxColorAttachments> _rhiColors;
         std::optional<rhi::RenderPassDepthStencilInfo> _rhiDepthStencil;
     };
 } // namespace ionengine
\ No newline at end of file
@@ -140,7 +140,15 @@ namespace ionengine
 
     auto TexturePool::reset() -> void
     {
-        _buckets.clear();
-        _dirtyEntries.clear();
+        std::lock_guard lock(_mutex);
+
+        for (auto& [_, bucket] : _buckets)
+        {
+            for (auto& bucketEntry : bucket.entries)
+            {
+                bucketEntry.used = false;
+            }
+            bucket.current = 0;
+        }
     }
 } // namespace ionengine
\ No newline at end of file
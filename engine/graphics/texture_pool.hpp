@@ -109,6 +109,7 @@ namespace ionengine
 
         auto compact() -> void;
 
+        // Returns every texture to the pool and keeps it for the next frame, the GPU must have finished using them
         auto reset() -> void;
 
       private:
@@ -45,6 +45,9 @@ namespace ionengine::internal
             core::Vec4f color;
         };
 
+        // Colours are converted where they are read, multiplying instead of dividing each channel
+        float constexpr colourScale = 1.0f / 255.0f;
+
         std::vector<uint8_t> vertexData(sizeof(Vertex) * numVertices);
         {
             std::basic_ospanstream<uint8_t> stream(vertexData);
@@ -52,9 +55,9 @@ namespace ionengine::internal
             {
                 Vertex vertex{.position = core::Vec2f(vertices[i].position.x, vertices[i].position.y),
                               .uv = core::Vec2f(vertices[i].tex_coord.x, vertices[i].tex_coord.y),
-                              .color =
-                                  core::Vec4f(vertices[i].colour.red / 255.0f, vertices[i].colour.green / 255.0f,
-                                              vertices[i].colour.blue / 255.0f, vertices[i].colour.alpha / 255.0f)};
+                              .color = core::Vec4f(
+                                  vertices[i].colour.red * colourScale, vertices[i].colour.green * colourScale,
+                                  vertices[i].colour.blue * colourScale, vertices[i].colour.alpha * colourScale)};
                 stream.write(reinterpret_cast<uint8_t*>(&vertex), sizeof(Vertex));
             }
         }
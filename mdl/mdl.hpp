@@ -59,7 +59,7 @@ namespace ionengine::asset
         struct VertexLayoutElementData
         {
             VertexFormat format;
-            std::string semantic;
+            std::pmr::string semantic;
 
             template <typename Archive>
             auto operator()(Archive& archive)
@@ -71,7 +71,7 @@ namespace ionengine::asset
 
         struct VertexLayoutData
         {
-            std::vector<VertexLayoutElementData> elements;
+            std::pmr::vector<VertexLayoutElementData> elements;
             uint32_t size;
 
             template <typename Archive>
@@ -87,8 +87,8 @@ namespace ionengine::asset
             uint32_t materialCount;
             uint32_t buffer;
             VertexLayoutData vertexLayout;
-            std::vector<SurfaceData> surfaces;
-            std::vector<BufferData> buffers;
+            std::pmr::vector<SurfaceData> surfaces;
+            std::pmr::vector<BufferData> buffers;
 
             template <typename Archive>
             auto operator()(Archive& archive)
@@ -106,7 +106,7 @@ namespace ionengine::asset
     {
         std::array<uint8_t, mdl::Magic.size()> magic;
         mdl::ModelData modelData;
-        std::vector<uint8_t> modelBlob;
+        std::pmr::vector<uint8_t> modelBlob;
 
         template <typename Archive>
         auto operator()(Archive& archive)
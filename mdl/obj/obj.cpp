@@ -23,8 +23,8 @@ namespace ionengine::asset
         std::vector<Vertex> vertices;
         std::vector<uint32_t> indices;
 
-        std::vector<mdl::SurfaceData> modelSurfaces;
-        std::vector<mdl::BufferData> modelBuffers;
+        std::pmr::vector<mdl::SurfaceData> modelSurfaces;
+        std::pmr::vector<mdl::BufferData> modelBuffers;
         std::basic_stringstream<uint8_t> modelBlob;
 
         for (auto const& shape : shapes)
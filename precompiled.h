@@ -2,8 +2,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <barrier>
 #include <cassert>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <format>
@@ -14,6 +19,7 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 #include <mutex>
 #include <numbers>
@@ -28,8 +34,10 @@
 #include <spanstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
 #include <set>
@@ -0,0 +1,90 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "rhi.hpp"
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Counters shared by the contexts of a device, contexts created by the user are counted as well
+    */
+    struct BarrierCounters
+    {
+        std::atomic<uint64_t> barrierCount{0};
+        std::atomic<uint64_t> flushCount{0};
+
+        auto getStats() const -> BarrierStats
+        {
+            return BarrierStats{.barrierCount = barrierCount.load(std::memory_order_relaxed),
+                                .flushCount = flushCount.load(std::memory_order_relaxed)};
+        }
+    };
+
+    /*!
+        \brief Collects barriers of a context until a command that depends on them is recorded
+        \details The barriers of a batch are handed to the backend at once and all of them start from the state
+        before the batch, so a resource is transitioned at most once per batch. A context should flush the batch
+        before adding a resource that is already in it
+    */
+    template <typename BufferBarrier, typename ImageBarrier>
+    class BarrierBatcher
+    {
+      public:
+        BarrierBatcher(BarrierCounters& counters) : counters(&counters)
+        {
+        }
+
+        auto addBufferBarrier(void const* resource, BufferBarrier const& barrier) -> void
+        {
+            resources.emplace_back(resource);
+            bufferBarriers.emplace_back(barrier);
+        }
+
+        auto addImageBarrier(void const* resource, ImageBarrier const& barrier) -> void
+        {
+            resources.emplace_back(resource);
+            imageBarriers.emplace_back(barrier);
+        }
+
+        // Batches hold a few barriers, so a linear search is cheaper than keeping a set
+        auto contains(void const* resource) const -> bool
+        {
+            return std::find(resources.begin(), resources.end(), resource) != resources.end();
+        }
+
+        auto empty() const -> bool
+        {
+            return resources.empty();
+        }
+
+        /*!
+            \brief Hands the pending barriers to the function and clears the batch
+            \details The function is called with spans of buffer and image barriers, and only if the batch is not
+            empty. Capacity is kept to avoid allocations
+        */
+        template <typename Function>
+        auto flush(Function&& function) -> void
+        {
+            if (resources.empty())
+            {
+                return;
+            }
+
+            function(std::span<BufferBarrier const>(bufferBarriers), std::span<ImageBarrier const>(imageBarriers));
+
+            counters->barrierCount.fetch_add(resources.size(), std::memory_order_relaxed);
+            counters->flushCount.fetch_add(1, std::memory_order_relaxed);
+
+            resources.clear();
+            bufferBarriers.clear();
+            imageBarriers.clear();
+        }
+
+      private:
+        BarrierCounters* counters;
+        std::vector<void const*> resources;
+        std::vector<BufferBarrier> bufferBarriers;
+        std::vector<ImageBarrier> imageBarriers;
+    };
+} // namespace ionengine::rhi
@@ -0,0 +1,239 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Buddy allocator of the ranges of a single page
+        \details The page is split in halves down to the minimum block size, and a request takes the smallest block
+        that fits it. Free blocks of each level are kept as set bits of 64-bit words, and a freed block is merged
+        with its buddy while the buddy is free too. Offsets are aligned to the size of their block
+    */
+    class BuddyAllocator
+    {
+      public:
+        struct Block
+        {
+            uint64_t offset;
+            uint32_t level;
+        };
+
+        BuddyAllocator(uint64_t const pageSize, uint64_t const minBlockSize)
+            : pageSize(pageSize), minBlockSize(minBlockSize),
+              levelCount(static_cast<uint32_t>(std::countr_zero(pageSize / minBlockSize)) + 1), freeSize(pageSize)
+        {
+            assert(std::has_single_bit(pageSize) && std::has_single_bit(minBlockSize) && minBlockSize <= pageSize &&
+                   "page and block sizes should be powers of two");
+
+            freeBlocks.resize(levelCount);
+            for (uint32_t const i : std::views::iota(0u, levelCount))
+            {
+                freeBlocks[i].resize(((uint64_t(1) << i) + 63) / 64, 0);
+            }
+            freeBlocks[0][0] = 1;
+        }
+
+        auto allocate(uint64_t const size) -> std::optional<Block>
+        {
+            if (size > pageSize)
+            {
+                return std::nullopt;
+            }
+
+            uint32_t const level = this->getLevel(size);
+
+            // The smallest free block that fits is split until it has the requested size, right halves stay free
+            for (uint32_t i = level + 1; i-- > 0;)
+            {
+                std::optional<uint64_t> const freeIndex = this->findFreeBlock(i);
+                if (!freeIndex.has_value())
+                {
+                    continue;
+                }
+
+                uint64_t index = freeIndex.value();
+                this->setFree(i, index, false);
+                for (uint32_t const j : std::views::iota(i, level))
+                {
+                    index *= 2;
+                    this->setFree(j + 1, index + 1, true);
+                }
+
+                freeSize -= this->getBlockSize(level);
+                return Block{.offset = index * this->getBlockSize(level), .level = level};
+            }
+            return std::nullopt;
+        }
+
+        auto deallocate(Block const& block) -> void
+        {
+            freeSize += this->getBlockSize(block.level);
+
+            uint32_t level = block.level;
+            uint64_t index = block.offset / this->getBlockSize(level);
+            while (level > 0 && this->isFree(level, index ^ 1))
+            {
+                this->setFree(level, index ^ 1, false);
+                index /= 2;
+                level--;
+            }
+            this->setFree(level, index, true);
+        }
+
+        auto getFreeSize() const -> uint64_t
+        {
+            return freeSize;
+        }
+
+        auto getPageSize() const -> uint64_t
+        {
+            return pageSize;
+        }
+
+      private:
+        uint64_t pageSize;
+        uint64_t minBlockSize;
+        uint32_t levelCount;
+        uint64_t freeSize;
+        std::vector<std::vector<uint64_t>> freeBlocks;
+
+        auto getBlockSize(uint32_t const level) const -> uint64_t
+        {
+            return pageSize >> level;
+        }
+
+        auto getLevel(uint64_t const size) const -> uint32_t
+        {
+            uint64_t const blockSize = std::bit_ceil(std::max(size, minBlockSize));
+            return static_cast<uint32_t>(std::countr_zero(pageSize) - std::countr_zero(blockSize));
+        }
+
+        auto findFreeBlock(uint32_t const level) const -> std::optional<uint64_t>
+        {
+            auto const& words = freeBlocks[level];
+            for (size_t const i : std::views::iota(size_t{0}, words.size()))
+            {
+                if (words[i] != 0)
+                {
+                    return i * 64 + std::countr_zero(words[i]);
+                }
+            }
+            return std::nullopt;
+        }
+
+        auto isFree(uint32_t const level, uint64_t const index) const -> bool
+        {
+            return (freeBlocks[level][index / 64] >> (index % 64)) & 1;
+        }
+
+        auto setFree(uint32_t const level, uint64_t const index, bool const isFree) -> void
+        {
+            if (isFree)
+            {
+                freeBlocks[level][index / 64] |= uint64_t(1) << (index % 64);
+            }
+            else
+            {
+                freeBlocks[level][index / 64] &= ~(uint64_t(1) << (index % 64));
+            }
+        }
+    };
+
+    /*!
+        \brief Places small buffers in shared pages, each of them split with its own buddy allocator
+        \details The page type is the backend buffer with its memory, created by the function passed to allocate
+        when every page is full. Pages are kept until the allocator is destroyed, so buffers created and released
+        every frame do not create device objects. Safe to use from several threads
+    */
+    template <typename Page>
+    class BufferSubAllocator
+    {
+      public:
+        struct Allocation
+        {
+            Page* page;
+            uint32_t pageIndex;
+            BuddyAllocator::Block block;
+        };
+
+        BufferSubAllocator(uint64_t const pageSize, uint64_t const minBlockSize)
+            : pageSize(pageSize), minBlockSize(minBlockSize), allocatedCount(0)
+        {
+        }
+
+        BufferSubAllocator(BufferSubAllocator const&) = delete;
+
+        auto operator=(BufferSubAllocator const&) -> BufferSubAllocator& = delete;
+
+        template <typename CreatePage>
+        auto allocate(uint64_t const size, CreatePage&& createPage) -> Allocation
+        {
+            assert(size <= pageSize && "size is greater than the page size");
+
+            std::lock_guard lock(mutex);
+
+            for (uint32_t const i : std::views::iota(0u, static_cast<uint32_t>(pages.size())))
+            {
+                if (auto block = pages[i]->allocator.allocate(size))
+                {
+                    allocatedCount++;
+                    return Allocation{.page = &pages[i]->page, .pageIndex = i, .block = block.value()};
+                }
+            }
+
+            pages.emplace_back(std::make_unique<PageEntry>(createPage(), BuddyAllocator(pageSize, minBlockSize)));
+            allocatedCount++;
+            return Allocation{.page = &pages.back()->page,
+                              .pageIndex = static_cast<uint32_t>(pages.size() - 1),
+                              .block = pages.back()->allocator.allocate(size).value()};
+        }
+
+        auto deallocate(Allocation const& allocation) -> void
+        {
+            std::lock_guard lock(mutex);
+
+            pages[allocation.pageIndex]->allocator.deallocate(allocation.block);
+            allocatedCount--;
+        }
+
+        // Calls the function with every page, e.g. to destroy them with the allocator
+        template <typename Function>
+        auto forEachPage(Function&& function) -> void
+        {
+            std::lock_guard lock(mutex);
+
+            for (auto const& entry : pages)
+            {
+                function(entry->page);
+            }
+        }
+
+        auto getPageCount() const -> size_t
+        {
+            std::lock_guard lock(mutex);
+            return pages.size();
+        }
+
+        // Number of ranges handed out and not deallocated yet
+        auto getAllocatedCount() const -> size_t
+        {
+            std::lock_guard lock(mutex);
+            return allocatedCount;
+        }
+
+      private:
+        struct PageEntry
+        {
+            Page page;
+            BuddyAllocator allocator;
+        };
+
+        mutable std::mutex mutex;
+        uint64_t pageSize;
+        uint64_t minBlockSize;
+        // Entries are not moved when pages are added, so allocations keep pointers to them
+        std::vector<std::unique_ptr<PageEntry>> pages;
+        size_t allocatedCount;
+    };
+} // namespace ionengine::rhi
@@ -0,0 +1,263 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Hands out slots of a bindless descriptor heap
+        \details Free slots are kept as set bits of 64-bit words, and a summary bitmap marks the words that still
+        have a free slot, so a slot is found with two count-trailing-zeros. The bitmap starts at the initial capacity
+        and doubles up to the maximum one. Threads keep small caches of reserved slots, picked by the thread id, and
+        lock the bitmap only to refill or flush them
+    */
+    class DescriptorSlotAllocator
+    {
+      public:
+        // Slots a thread cache reserves from the bitmap at once
+        static uint32_t constexpr CacheBatchSize = 32;
+        static uint32_t constexpr CacheCount = 16;
+
+        DescriptorSlotAllocator(uint32_t const initialCapacity, uint32_t const maxCapacity)
+            : capacity(0), maxCapacity(maxCapacity), summaryHint(0), allocatedCount(0),
+              // Small heaps would end up reserved by the caches of a few threads
+              batchSize(std::min(CacheBatchSize, maxCapacity / (CacheCount * 4)))
+        {
+            assert(initialCapacity <= maxCapacity && "initial capacity is greater than the maximum one");
+            this->grow(std::max(initialCapacity, std::min(maxCapacity, 64u)));
+        }
+
+        DescriptorSlotAllocator(DescriptorSlotAllocator const&) = delete;
+
+        auto operator=(DescriptorSlotAllocator const&) -> DescriptorSlotAllocator& = delete;
+
+        auto allocate() -> std::optional<uint32_t>
+        {
+            uint32_t slot;
+            if (this->allocate(std::span<uint32_t>(&slot, 1)))
+            {
+                return slot;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+
+        /*! \brief Allocates a slot for each element of the span
+            \return False when the heap has not enough free slots, nothing is allocated then
+        */
+        auto allocate(std::span<uint32_t> const slots) -> bool
+        {
+            if (this->tryAllocate(slots))
+            {
+                return true;
+            }
+
+            // The missing slots may be sitting in the caches of other threads
+            this->flushCaches();
+            return this->tryAllocate(slots);
+        }
+
+        auto deallocate(uint32_t const slot) -> void
+        {
+            this->deallocate(std::span<uint32_t const>(&slot, 1));
+        }
+
+        auto deallocate(std::span<uint32_t const> const slots) -> void
+        {
+            allocatedCount.fetch_sub(static_cast<uint32_t>(slots.size()), std::memory_order_relaxed);
+
+            if (batchSize == 0)
+            {
+                std::lock_guard lock(mutex);
+                this->releaseSlots(slots);
+                return;
+            }
+
+            Cache& cache = this->getCache();
+            std::lock_guard cacheLock(cache.mutex);
+
+            size_t const cachedCount = std::min<size_t>(slots.size(), batchSize * 2 - cache.count);
+            std::copy_n(slots.begin(), cachedCount, cache.slots.begin() + cache.count);
+            cache.count += static_cast<uint32_t>(cachedCount);
+
+            if (cache.count == batchSize * 2)
+            {
+                std::lock_guard lock(mutex);
+                this->releaseSlots(slots.subspan(cachedCount));
+
+                // Keep the most recently freed half, which is the most likely to be in the cache memory
+                this->releaseSlots(std::span<uint32_t const>(cache.slots.data(), batchSize));
+                std::copy_n(cache.slots.begin() + batchSize, cache.count - batchSize, cache.slots.begin());
+                cache.count -= batchSize;
+            }
+        }
+
+        auto getCapacity() const -> uint32_t
+        {
+            std::lock_guard lock(mutex);
+            return capacity;
+        }
+
+        auto getMaxCapacity() const -> uint32_t
+        {
+            return maxCapacity;
+        }
+
+        // Number of slots handed out and not deallocated yet
+        auto getAllocatedCount() const -> uint32_t
+        {
+            return allocatedCount.load(std::memory_order_relaxed);
+        }
+
+      private:
+        // Aligned to a cache line so threads working with neighbouring caches do not slow each other down
+        struct alignas(64) Cache
+        {
+            std::mutex mutex;
+            uint32_t count{0};
+            std::array<uint32_t, CacheBatchSize * 2> slots;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<uint64_t> words;
+        std::vector<uint64_t> summary;
+        uint32_t capacity;
+        uint32_t maxCapacity;
+        // No summary word before this one has a free slot
+        uint32_t summaryHint;
+        std::atomic<uint32_t> allocatedCount;
+        uint32_t batchSize;
+        std::array<Cache, CacheCount> caches;
+
+        auto getCache() -> Cache&
+        {
+            thread_local size_t const threadHash = std::hash<std::thread::id>()(std::this_thread::get_id());
+            return caches[threadHash & (CacheCount - 1)];
+        }
+
+        auto tryAllocate(std::span<uint32_t> const slots) -> bool
+        {
+            size_t count = 0;
+
+            if (batchSize > 0)
+            {
+                Cache& cache = this->getCache();
+                std::lock_guard cacheLock(cache.mutex);
+
+                if (cache.count < slots.size() && slots.size() <= batchSize)
+                {
+                    std::lock_guard lock(mutex);
+                    cache.count +=
+                        this->acquireSlots(std::span<uint32_t>(cache.slots.data() + cache.count, batchSize));
+                }
+
+                count = std::min<size_t>(slots.size(), cache.count);
+                std::copy_n(cache.slots.begin() + (cache.count - count), count, slots.begin());
+                cache.count -= static_cast<uint32_t>(count);
+            }
+
+            if (count < slots.size())
+            {
+                std::lock_guard lock(mutex);
+                count += this->acquireSlots(slots.subspan(count));
+
+                if (count < slots.size())
+                {
+                    this->releaseSlots(slots.first(count));
+                    return false;
+                }
+            }
+
+            allocatedCount.fetch_add(static_cast<uint32_t>(slots.size()), std::memory_order_relaxed);
+            return true;
+        }
+
+        auto flushCaches() -> void
+        {
+            for (auto& cache : caches)
+            {
+                std::lock_guard cacheLock(cache.mutex);
+                std::lock_guard lock(mutex);
+                this->releaseSlots(std::span<uint32_t const>(cache.slots.data(), cache.count));
+                cache.count = 0;
+            }
+        }
+
+        // Takes up to slots.size() free slots out of the bitmap, lowest first. The mutex should be locked
+        auto acquireSlots(std::span<uint32_t> const slots) -> size_t
+        {
+            size_t count = 0;
+
+            while (count < slots.size())
+            {
+                while (summaryHint < summary.size() && summary[summaryHint] == 0)
+                {
+                    summaryHint++;
+                }
+
+                if (summaryHint == summary.size())
+                {
+                    if (capacity == maxCapacity)
+                    {
+                        break;
+                    }
+
+                    this->grow(std::min(maxCapacity, capacity * 2));
+                    continue;
+                }
+
+                uint32_t const wordIndex = summaryHint * 64 + std::countr_zero(summary[summaryHint]);
+                uint64_t& word = words[wordIndex];
+
+                while (word != 0 && count < slots.size())
+                {
+                    slots[count++] = wordIndex * 64 + std::countr_zero(word);
+                    word &= word - 1;
+                }
+
+                if (word == 0)
+                {
+                    summary[summaryHint] &= ~(uint64_t(1) << (wordIndex % 64));
+                }
+            }
+
+            return count;
+        }
+
+        // The mutex should be locked
+        auto releaseSlots(std::span<uint32_t const> const slots) -> void
+        {
+            for (uint32_t const slot : slots)
+            {
+                assert(slot < capacity && "slot does not belong to the allocator");
+                assert((words[slot / 64] & (uint64_t(1) << (slot % 64))) == 0 && "slot is already free");
+
+                words[slot / 64] |= uint64_t(1) << (slot % 64);
+                summary[slot / 4096] |= uint64_t(1) << (slot / 64 % 64);
+                summaryHint = std::min(summaryHint, slot / 4096);
+            }
+        }
+
+        auto grow(uint32_t const newCapacity) -> void
+        {
+            words.resize((newCapacity + 63) / 64, 0);
+            summary.resize((words.size() + 63) / 64, 0);
+
+            for (uint32_t slot = capacity; slot < newCapacity;)
+            {
+                // Mark the whole rest of a word at once where possible
+                uint32_t const bitCount = std::min(64 - slot % 64, newCapacity - slot);
+                uint64_t const mask = (bitCount == 64 ? ~uint64_t(0) : (uint64_t(1) << bitCount) - 1) << (slot % 64);
+
+                words[slot / 64] |= mask;
+                summary[slot / 4096] |= uint64_t(1) << (slot / 64 % 64);
+                slot += bitCount;
+            }
+
+            summaryHint = std::min(summaryHint, capacity / 4096);
+            capacity = newCapacity;
+        }
+    };
+} // namespace ionengine::rhi
@@ -320,6 +320,8 @@ namespace ionengine::rhi
                 return D3D12_RESOURCE_STATE_COPY_SOURCE;
             case ResourceState::CopyDest:
                 return D3D12_RESOURCE_STATE_COPY_DEST;
+            case ResourceState::IndirectArgument:
+                return D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
             default:
                 throw std::invalid_argument("unknown D3D12_RESOURCE_STATES for passed argument");
         }
@@ -372,15 +374,18 @@ namespace ionengine::rhi
         return offset;
     }
 
-    DescriptorAllocator::DescriptorAllocator(ID3D12Device1* device) : device(device)
+    DescriptorAllocator::DescriptorAllocator(ID3D12Device1* device, RHICreateInfo const& createInfo) : device(device)
     {
         std::array<D3D12_DESCRIPTOR_HEAP_TYPE, 4> const heapTypes{
             D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
             D3D12_DESCRIPTOR_HEAP_TYPE_DSV};
-        std::array<uint32_t, 4> const descriptorLimits{std::to_underlying(DescriptorAllocatorLimits::RTV),
-                                                       std::to_underlying(DescriptorAllocatorLimits::CBV_SRV_UAV),
-                                                       std::to_underlying(DescriptorAllocatorLimits::Sampler),
-                                                       std::to_underlying(DescriptorAllocatorLimits::DSV)};
+        std::array<uint32_t, 4> const descriptorLimits{
+            std::to_underlying(DescriptorAllocatorLimits::RTV),
+            createInfo.descriptorHeapSize > 0 ? createInfo.descriptorHeapSize
+                                              : std::to_underlying(DescriptorAllocatorLimits::CBV_SRV_UAV),
+            createInfo.samplerHeapSize > 0 ? createInfo.samplerHeapSize
+                                           : std::to_underlying(DescriptorAllocatorLimits::Sampler),
+            std::to_underlying(DescriptorAllocatorLimits::DSV)};
 
         for (uint32_t const i : std::views::iota(0u, 4u))
         {
@@ -395,14 +400,12 @@ namespace ionengine::rhi
             throwIfFailed(device->CreateDescriptorHeap(&descriptorHeapDesc, __uuidof(ID3D12DescriptorHeap),
                                                        descriptorHeap.put_void()));
 
-            std::vector<uint8_t> free(descriptorLimits[i]);
-            std::fill(free.begin(), free.end(), 0x0);
-
             auto allocations = std::unique_ptr<DescriptorAllocation[]>(new DescriptorAllocation[descriptorLimits[i]]);
 
+            // The heap is created at its full size, only the slot bitmap grows with the use
             Chunk chunk{.heap = descriptorHeap,
-                        .free = std::move(free),
-                        .size = descriptorLimits[i],
+                        .slots = std::make_unique<DescriptorSlotAllocator>(std::min(descriptorLimits[i], 4096u),
+                                                                           descriptorLimits[i]),
                         .incrementSize = device->GetDescriptorHandleIncrementSize(heapTypes[i]),
                         .allocations = std::move(allocations)};
             chunks.emplace(heapTypes[i], std::move(chunk));
@@ -412,66 +415,54 @@ namespace ionengine::rhi
     auto DescriptorAllocator::allocate(D3D12_DESCRIPTOR_HEAP_TYPE const heapType, DescriptorAllocation** allocation)
         -> HRESULT
     {
-        std::lock_guard lock(mutex);
+        Chunk& chunk = chunks.at(heapType);
 
-        Chunk& chunk = chunks[heapType];
-        if (1 > chunk.size - chunk.offset)
+        auto slot = chunk.slots->allocate();
+        if (!slot.has_value())
         {
             return E_OUTOFMEMORY;
         }
 
-        bool success = false;
-        uint32_t allocOffset = 0;
-
-        for (uint32_t const i : std::views::iota(chunk.offset, chunk.size))
-        {
-            if (chunk.free[i] == 0x1)
-            {
-                continue;
-            }
-            else
-            {
-                allocOffset = i;
-                success = true;
-                break;
-            }
-        }
+        chunk.allocations[slot.value()].initialize(this, chunk.heap.get(), heapType, chunk.incrementSize,
+                                                   slot.value());
 
-        if (success)
-        {
-            chunk.free[allocOffset] = 0x1;
-            chunk.offset = allocOffset + 1;
+        (*allocation) = &chunk.allocations[slot.value()];
+        return S_OK;
+    }
 
-            chunk.allocations[allocOffset].initialize(this, chunk.heap.get(), heapType, chunk.incrementSize,
-                                                      allocOffset);
+    auto DescriptorAllocator::allocate(D3D12_DESCRIPTOR_HEAP_TYPE const heapType,
+                                       std::span<DescriptorAllocation*> const allocations) -> HRESULT
+    {
+        Chunk& chunk = chunks.at(heapType);
 
-            (*allocation) = &chunk.allocations[allocOffset];
-            return S_OK;
-        }
-        else
+        std::vector<uint32_t> slots(allocations.size());
+        if (!chunk.slots->allocate(slots))
         {
             return E_OUTOFMEMORY;
         }
+
+        for (size_t const i : std::views::iota(size_t{0}, allocations.size()))
+        {
+            chunk.allocations[slots[i]].initialize(this, chunk.heap.get(), heapType, chunk.incrementSize, slots[i]);
+            allocations[i] = &chunk.allocations[slots[i]];
+        }
+        return S_OK;
     }
 
     auto DescriptorAllocator::deallocate(DescriptorAllocation* allocation) -> void
     {
-        std::lock_guard lock(mutex);
-
-        Chunk& chunk = chunks[allocation->heapType];
-        chunk.free[allocation->offset] = 0x0;
-        chunk.offset = std::min(chunk.offset, allocation->offset);
+        chunks.at(allocation->heapType).slots->deallocate(allocation->offset);
     }
 
     auto DescriptorAllocator::getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE const heapType) -> ID3D12DescriptorHeap*
     {
-        return chunks[heapType].heap.get();
+        return chunks.at(heapType).heap.get();
     }
 
     DX12Buffer::DX12Buffer(ID3D12Device1* device, D3D12MA::Allocator* memoryAllocator,
                            DescriptorAllocator* descriptorAllocator, BufferCreateInfo const& createInfo)
-        : memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator), size(createInfo.size),
-          flags(createInfo.flags)
+        : memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator), mappedBytes(nullptr),
+          size(createInfo.size), flags(createInfo.flags)
     {
         D3D12_RESOURCE_DESC resourceDesc{.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
                                          .Height = 1,
@@ -504,6 +495,10 @@ namespace ionengine::rhi
             initialState = D3D12_RESOURCE_STATE_COPY_DEST;
             heapType = D3D12_HEAP_TYPE_READBACK;
         }
+        if (flags & BufferUsage::UnorderedAccess)
+        {
+            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        }
 
         D3D12MA::ALLOCATION_DESC const maAllocationDesc{.HeapType = heapType};
         throwIfFailed(memoryAllocator->CreateResource(&maAllocationDesc, &resourceDesc, initialState, nullptr,
@@ -511,6 +506,17 @@ namespace ionengine::rhi
                                                       resource.put_void()));
         resource->SetName(L"Buffer");
 
+        // Upload and readback heaps are mapped for the whole life of the resource
+        if (flags & BufferUsage::MapWrite)
+        {
+            D3D12_RANGE const range{.Begin = 0, .End = 0};
+            throwIfFailed(resource->Map(0, &range, reinterpret_cast<void**>(&mappedBytes)));
+        }
+        else if (flags & BufferUsage::MapRead)
+        {
+            throwIfFailed(resource->Map(0, nullptr, reinterpret_cast<void**>(&mappedBytes)));
+        }
+
         if (flags & BufferUsage::ConstantBuffer)
         {
             assert(descriptorAllocator && "to create a buffer with views, you need to pass the allocator descriptor");
@@ -563,32 +569,18 @@ namespace ionengine::rhi
         }
     }
 
-    auto DX12Buffer::mapMemory() -> uint8_t*
+    auto DX12Buffer::getMappedPointer() -> uint8_t*
     {
-        uint8_t* mappedBytes;
-        if (flags & BufferUsage::MapWrite)
-        {
-            throwIfFailed(resource->Map(0, nullptr, reinterpret_cast<void**>(&mappedBytes)));
-        }
-        else
-        {
-            D3D12_RANGE const range{.Begin = 0, .End = size};
-            throwIfFailed(resource->Map(0, &range, reinterpret_cast<void**>(&mappedBytes)));
-        }
         return mappedBytes;
     }
 
-    auto DX12Buffer::unmapMemory() -> void
+    auto DX12Buffer::flushMappedRange(uint64_t const offset, size_t const size) -> void
+    {
+        // Upload and readback heaps are host coherent
+    }
+
+    auto DX12Buffer::invalidateMappedRange(uint64_t const offset, size_t const size) -> void
     {
-        if (flags & BufferUsage::MapWrite)
-        {
-            D3D12_RANGE const range{.Begin = 0, .End = size};
-            resource->Unmap(0, &range);
-        }
-        else if (flags & BufferUsage::MapRead)
-        {
-            resource->Unmap(0, nullptr);
-        }
     }
 
     auto DX12Buffer::getSize() const -> size_t
@@ -824,6 +816,156 @@ namespace ionengine::rhi
         return descriptorAllocation->getOffset();
     }
 
+    DX12Query::DX12Query(ID3D12Device4* device, D3D12MA::Allocator* memoryAllocator,
+                         bool const isCopyQueueTimestampSupported, QueryCreateInfo const& createInfo)
+        : queryType(createInfo.queryType), count(createInfo.count), timestampFrequency(0), isPending(false),
+          fence(nullptr), fenceValue(0)
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+        if (queryType == QueryType::Timestamp)
+        {
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+            queryHeapDesc.Count = count * 2;
+            resultSize = sizeof(uint64_t) * count * 2;
+            elapsedTimes.resize(count, 0);
+        }
+        else
+        {
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+            queryHeapDesc.Count = count;
+            resultSize = sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS) * count;
+            statistics.resize(count, PipelineStatistics{});
+        }
+        throwIfFailed(device->CreateQueryHeap(&queryHeapDesc, __uuidof(ID3D12QueryHeap), queryHeap.put_void()));
+
+        if (queryType == QueryType::Timestamp && isCopyQueueTimestampSupported)
+        {
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP;
+            throwIfFailed(
+                device->CreateQueryHeap(&queryHeapDesc, __uuidof(ID3D12QueryHeap), copyQueryHeap.put_void()));
+        }
+
+        D3D12_RESOURCE_DESC const resourceDesc{.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+                                               .Width = resultSize,
+                                               .Height = 1,
+                                               .DepthOrArraySize = 1,
+                                               .MipLevels = 1,
+                                               .Format = DXGI_FORMAT_UNKNOWN,
+                                               .SampleDesc = {.Count = 1},
+                                               .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR};
+
+        D3D12MA::ALLOCATION_DESC const maAllocationDesc{.HeapType = D3D12_HEAP_TYPE_READBACK};
+        throwIfFailed(memoryAllocator->CreateResource(&maAllocationDesc, &resourceDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+                                                      nullptr, memoryAllocation.put(), __uuidof(ID3D12Resource),
+                                                      resource.put_void()));
+        resource->SetName(L"Query");
+    }
+
+    auto DX12Query::getQueryType() const -> QueryType
+    {
+        return queryType;
+    }
+
+    auto DX12Query::getCount() const -> uint32_t
+    {
+        return count;
+    }
+
+    auto DX12Query::getResult() const -> bool
+    {
+        return !isPending && (!fence || fence->GetCompletedValue() >= fenceValue);
+    }
+
+    auto DX12Query::getElapsedTimes() -> std::span<uint64_t const>
+    {
+        if (queryType != QueryType::Timestamp)
+        {
+            return {};
+        }
+
+        if (this->getResult() && fence)
+        {
+            D3D12_RANGE const range{.Begin = 0, .End = resultSize};
+            uint64_t* timestamps;
+            throwIfFailed(resource->Map(0, &range, reinterpret_cast<void**>(&timestamps)));
+
+            for (uint32_t const i : std::views::iota(0u, count))
+            {
+                uint64_t const ticks = timestamps[i * 2 + 1] - timestamps[i * 2];
+                elapsedTimes[i] = static_cast<uint64_t>(static_cast<double>(ticks) * 1'000'000'000.0 /
+                                                        static_cast<double>(timestampFrequency));
+            }
+
+            D3D12_RANGE const writtenRange{.Begin = 0, .End = 0};
+            resource->Unmap(0, &writtenRange);
+            fence = nullptr;
+        }
+        return elapsedTimes;
+    }
+
+    auto DX12Query::getPipelineStatistics() -> std::span<PipelineStatistics const>
+    {
+        if (queryType != QueryType::PipelineStatistics)
+        {
+            return {};
+        }
+
+        if (this->getResult() && fence)
+        {
+            D3D12_RANGE const range{.Begin = 0, .End = resultSize};
+            D3D12_QUERY_DATA_PIPELINE_STATISTICS* queryData;
+            throwIfFailed(resource->Map(0, &range, reinterpret_cast<void**>(&queryData)));
+
+            for (uint32_t const i : std::views::iota(0u, count))
+            {
+                statistics[i] = PipelineStatistics{.inputVertices = queryData[i].IAVertices,
+                                                   .inputPrimitives = queryData[i].IAPrimitives,
+                                                   .vertexShaderInvocations = queryData[i].VSInvocations,
+                                                   .rasterizedPrimitives = queryData[i].CPrimitives,
+                                                   .pixelShaderInvocations = queryData[i].PSInvocations,
+                                                   .computeShaderInvocations = queryData[i].CSInvocations};
+            }
+
+            D3D12_RANGE const writtenRange{.Begin = 0, .End = 0};
+            resource->Unmap(0, &writtenRange);
+            fence = nullptr;
+        }
+        return statistics;
+    }
+
+    auto DX12Query::getQueryHeap(D3D12_COMMAND_LIST_TYPE const commandListType) -> ID3D12QueryHeap*
+    {
+        if (commandListType == D3D12_COMMAND_LIST_TYPE_COPY)
+        {
+            return copyQueryHeap.get();
+        }
+        else
+        {
+            return queryHeap.get();
+        }
+    }
+
+    auto DX12Query::resolve(ID3D12GraphicsCommandList4* commandList, D3D12_COMMAND_LIST_TYPE const commandListType,
+                            uint64_t const timestampFrequency) -> void
+    {
+        D3D12_QUERY_TYPE const resolveType =
+            queryType == QueryType::Timestamp ? D3D12_QUERY_TYPE_TIMESTAMP : D3D12_QUERY_TYPE_PIPELINE_STATISTICS;
+        uint32_t const queryCount = queryType == QueryType::Timestamp ? count * 2 : count;
+
+        commandList->ResolveQueryData(this->getQueryHeap(commandListType), resolveType, 0, queryCount, resource.get(),
+                                      0);
+
+        this->timestampFrequency = timestampFrequency;
+        isPending = true;
+    }
+
+    auto DX12Query::markSubmitted(ID3D12Fence* fence, uint64_t const fenceValue) -> void
+    {
+        this->fence = fence;
+        this->fenceValue = fenceValue;
+        isPending = false;
+    }
+
     DX12VertexInput::DX12VertexInput(std::span<VertexDeclarationInfo const> const vertexDeclarations)
     {
         uint32_t offset = 0;
@@ -945,8 +1087,36 @@ namespace ionengine::rhi
                        std::optional<DepthStencilStageInfo> const depthStencil,
                        std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> const& renderTargetFormats,
                        DXGI_FORMAT const depthStencilFormat, ID3DBlob* blob)
-        : rootSignature(rootSignature)
+        : rootSignature(rootSignature), inputSize(0)
     {
+        if (shader->getShaderType() == ShaderType::Compute)
+        {
+            D3D12_COMPUTE_PIPELINE_STATE_DESC computePipelineStateDesc{
+                .pRootSignature = rootSignature,
+                .CS = shader->getStages().at(DX12ShaderStageType::Compute).shaderByteCode};
+
+            if (blob)
+            {
+                computePipelineStateDesc.CachedPSO.pCachedBlob = blob->GetBufferPointer();
+                computePipelineStateDesc.CachedPSO.CachedBlobSizeInBytes = blob->GetBufferSize();
+            }
+
+            HRESULT result = device->CreateComputePipelineState(
+                &computePipelineStateDesc, __uuidof(ID3D12PipelineState), pipelineState.put_void());
+            if (result == D3D12_ERROR_ADAPTER_NOT_FOUND | result == D3D12_ERROR_DRIVER_VERSION_MISMATCH |
+                result == E_INVALIDARG)
+            {
+                computePipelineStateDesc.CachedPSO = {};
+                throwIfFailed(device->CreateComputePipelineState(
+                    &computePipelineStateDesc, __uuidof(ID3D12PipelineState), pipelineState.put_void()));
+            }
+            else
+            {
+                throwIfFailed(result);
+            }
+            return;
+        }
+
         D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDesc{.pRootSignature = rootSignature};
 
         for (auto const& [stage, stageData] : shader->getStages())
@@ -970,6 +1140,9 @@ namespace ionengine::rhi
                     graphicsPipelineStateDesc.PS = stageData.shaderByteCode;
                     break;
                 }
+                default: {
+                    break;
+                }
             }
         }
 
@@ -1096,37 +1269,43 @@ namespace ionengine::rhi
                             std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> const& renderTargetFormats,
                             DXGI_FORMAT const depthStencilFormat) -> core::ref_ptr<Pipeline>
     {
-        Entry const entry{.shaderHash = shader->getHash(),
-                          .rasterizer = rasterizer,
-                          .blendColor = blendColor,
-                          .depthStencil = depthStencil,
-                          .renderTargetFormats = renderTargetFormats,
-                          .depthStencilFormat = depthStencilFormat};
+        PipelineKey const key =
+            PipelineKey::create(shader->getHash(), rasterizer, blendColor, depthStencil,
+                                std::span<DXGI_FORMAT const>(renderTargetFormats), depthStencilFormat);
 
-        std::unique_lock lock(mutex);
-        auto result = entries.find(entry);
-        if (result != entries.end())
+        if (auto result = entries.find(key))
         {
-            return result->second;
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return std::move(result.value());
         }
-        else
-        {
-            lock.unlock();
-            auto pipeline = core::make_ref<Pipeline>(device, rootSignature.get(), shader, rasterizer, blendColor,
-                                                     depthStencil, renderTargetFormats, depthStencilFormat, nullptr);
 
-            lock.lock();
-            entries.emplace(entry, pipeline);
-            return pipeline;
-        }
+        auto const beginTime = std::chrono::steady_clock::now();
+        auto pipeline = core::make_ref<Pipeline>(device, rootSignature.get(), shader, rasterizer, blendColor,
+                                                 depthStencil, renderTargetFormats, depthStencilFormat, nullptr);
+        auto const creationDuration = std::chrono::steady_clock::now() - beginTime;
+
+        misses.fetch_add(1, std::memory_order_relaxed);
+        creationTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(creationDuration).count(),
+                               std::memory_order_relaxed);
+
+        // Another thread may have created the same pipeline meanwhile, the first one stays
+        return entries.emplace(key, pipeline);
     }
 
     auto PipelineCache::reset() -> void
     {
-        std::lock_guard lock(mutex);
         entries.clear();
     }
 
+    auto PipelineCache::getStats() const -> PipelineCacheStats
+    {
+        return PipelineCacheStats{.hits = hits.load(std::memory_order_relaxed),
+                                  .misses = misses.load(std::memory_order_relaxed),
+                                  .driverCacheHits = 0,
+                                  .creationTime = creationTime.load(std::memory_order_relaxed),
+                                  .loadedSize = 0};
+    }
+
     DX12FutureImpl::DX12FutureImpl(ID3D12CommandQueue* queue, ID3D12Fence* fence, HANDLE fenceEvent,
                                    uint64_t const fenceValue)
         : queue(queue), fence(fence), fenceEvent(fenceEvent), fenceValue(fenceValue)
@@ -1154,10 +1333,32 @@ namespace ionengine::rhi
         {
             throwIfFailed(copyContext->getCommandQueue()->Wait(fence, fenceValue));
         }
+        else if (auto computeContext = dynamic_cast<DX12ComputeContext*>(context))
+        {
+            throwIfFailed(computeContext->getCommandQueue()->Wait(fence, fenceValue));
+        }
+    }
+
+    auto DX12DeviceContext_flushBarriers(ID3D12GraphicsCommandList4* commandList, DX12BarrierBatcher& barrierBatcher)
+        -> void
+    {
+        barrierBatcher.flush([&](std::span<D3D12_RESOURCE_BARRIER const> const bufferBarriers,
+                                 std::span<D3D12_RESOURCE_BARRIER const> const textureBarriers) {
+            // Buffers and textures are collected apart, a batch of only one of them is still a single call
+            if (!bufferBarriers.empty())
+            {
+                commandList->ResourceBarrier(static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data());
+            }
+            if (!textureBarriers.empty())
+            {
+                commandList->ResourceBarrier(static_cast<uint32_t>(textureBarriers.size()), textureBarriers.data());
+            }
+        });
     }
 
-    auto DX12DeviceContext_barrier(ID3D12GraphicsCommandList4* commandList, Buffer* destBuffer,
-                                   ResourceState const beforeState, ResourceState const afterState) -> void
+    auto DX12DeviceContext_barrier(ID3D12GraphicsCommandList4* commandList, DX12BarrierBatcher& barrierBatcher,
+                                   Buffer* destBuffer, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
     {
         auto dxDestBuffer = dynamic_cast<DX12Buffer*>(destBuffer);
 
@@ -1169,11 +1370,17 @@ namespace ionengine::rhi
                 .StateBefore = ResourceState_to_D3D12_RESOURCE_STATES(beforeState),
                 .StateAfter = ResourceState_to_D3D12_RESOURCE_STATES(afterState),
             }};
-        commandList->ResourceBarrier(1, &resourceBarrier);
+
+        if (barrierBatcher.contains(destBuffer))
+        {
+            DX12DeviceContext_flushBarriers(commandList, barrierBatcher);
+        }
+        barrierBatcher.addBufferBarrier(destBuffer, resourceBarrier);
     }
 
-    auto DX12DeviceContext_barrier(ID3D12GraphicsCommandList4* commandList, Texture* destTexture,
-                                   ResourceState const beforeState, ResourceState const afterState) -> void
+    auto DX12DeviceContext_barrier(ID3D12GraphicsCommandList4* commandList, DX12BarrierBatcher& barrierBatcher,
+                                   Texture* destTexture, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
     {
         auto dxDestTexture = dynamic_cast<DX12Texture*>(destTexture);
 
@@ -1185,15 +1392,83 @@ namespace ionengine::rhi
                 .StateBefore = ResourceState_to_D3D12_RESOURCE_STATES(beforeState),
                 .StateAfter = ResourceState_to_D3D12_RESOURCE_STATES(afterState),
             }};
-        commandList->ResourceBarrier(1, &resourceBarrier);
+
+        if (barrierBatcher.contains(destTexture))
+        {
+            DX12DeviceContext_flushBarriers(commandList, barrierBatcher);
+        }
+        barrierBatcher.addImageBarrier(destTexture, resourceBarrier);
+    }
+
+    auto DX12DeviceContext_beginQuery(ID3D12GraphicsCommandList4* commandList,
+                                      D3D12_COMMAND_LIST_TYPE const commandListType, Query* query,
+                                      uint32_t const index) -> void
+    {
+        auto dxQuery = static_cast<DX12Query*>(query);
+        assert(index < query->getCount() && "query index is out of range");
+
+        ID3D12QueryHeap* queryHeap = dxQuery->getQueryHeap(commandListType);
+        if (!queryHeap)
+        {
+            throw std::runtime_error("queue does not support timestamps");
+        }
+
+        // Timestamps are written at once, so a region starts with one of them instead of a begin
+        if (query->getQueryType() == QueryType::Timestamp)
+        {
+            commandList->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, index * 2);
+        }
+        else
+        {
+            commandList->BeginQuery(queryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, index);
+        }
+    }
+
+    auto DX12DeviceContext_endQuery(ID3D12GraphicsCommandList4* commandList,
+                                    D3D12_COMMAND_LIST_TYPE const commandListType, Query* query,
+                                    uint32_t const index) -> void
+    {
+        auto dxQuery = static_cast<DX12Query*>(query);
+        assert(index < query->getCount() && "query index is out of range");
+
+        if (query->getQueryType() == QueryType::Timestamp)
+        {
+            commandList->EndQuery(dxQuery->getQueryHeap(commandListType), D3D12_QUERY_TYPE_TIMESTAMP, index * 2 + 1);
+        }
+        else
+        {
+            commandList->EndQuery(dxQuery->getQueryHeap(commandListType), D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
+                                  index);
+        }
+    }
+
+    auto DX12DeviceContext_resolveQuery(ID3D12GraphicsCommandList4* commandList,
+                                        D3D12_COMMAND_LIST_TYPE const commandListType, DeviceQueueData& deviceQueue,
+                                        std::vector<core::ref_ptr<DX12Query>>& resolvedQueries, Query* query) -> void
+    {
+        auto dxQuery = static_cast<DX12Query*>(query);
+        dxQuery->resolve(commandList, commandListType, deviceQueue.timestampFrequency);
+        resolvedQueries.emplace_back(dxQuery);
+    }
+
+    auto DX12DeviceContext_submitQueries(DeviceQueueData& deviceQueue, uint64_t const fenceValue,
+                                         std::vector<core::ref_ptr<DX12Query>>& resolvedQueries) -> void
+    {
+        for (auto const& query : resolvedQueries)
+        {
+            query->markSubmitted(deviceQueue.fence.get(), fenceValue);
+        }
+        resolvedQueries.clear();
     }
 
     DX12GraphicsContext::DX12GraphicsContext(ID3D12Device4* device, PipelineCache* pipelineCache,
                                              DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue,
-                                             HANDLE fenceEvent, uint32_t& curGraphicsContext)
+                                             HANDLE fenceEvent, BarrierCounters& barrierCounters,
+                                             StateCounters& stateCounters, uint32_t* curGraphicsContext)
         : device(device), pipelineCache(pipelineCache), descriptorAllocator(descriptorAllocator),
-          deviceQueue(&deviceQueue), fenceEvent(fenceEvent), curGraphicsContext(&curGraphicsContext),
-          isCommandListOpened(false), currentPipeline(nullptr)
+          deviceQueue(&deviceQueue), fenceEvent(fenceEvent), curGraphicsContext(curGraphicsContext),
+          barrierBatcher(barrierCounters), stateCache(stateCounters), isCommandListOpened(false), lastFenceValue(0),
+          currentPipeline(nullptr)
     {
         throwIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator),
                                                      commandAllocator.put_void()));
@@ -1201,6 +1476,27 @@ namespace ionengine::rhi
         throwIfFailed(device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE,
                                                  __uuidof(ID3D12GraphicsCommandList4), commandList.put_void()));
 
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC const indirectArgumentDesc{.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW};
+            D3D12_COMMAND_SIGNATURE_DESC const commandSignatureDesc{.ByteStride = sizeof(DrawIndirectArguments),
+                                                                    .NumArgumentDescs = 1,
+                                                                    .pArgumentDescs = &indirectArgumentDesc};
+            throwIfFailed(device->CreateCommandSignature(&commandSignatureDesc, nullptr,
+                                                         __uuidof(ID3D12CommandSignature),
+                                                         drawCommandSignature.put_void()));
+        }
+
+        {
+            D3D12_INDIRECT_ARGUMENT_DESC const indirectArgumentDesc{.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED};
+            D3D12_COMMAND_SIGNATURE_DESC const commandSignatureDesc{
+                .ByteStride = sizeof(DrawIndexedIndirectArguments),
+                .NumArgumentDescs = 1,
+                .pArgumentDescs = &indirectArgumentDesc};
+            throwIfFailed(device->CreateCommandSignature(&commandSignatureDesc, nullptr,
+                                                         __uuidof(ID3D12CommandSignature),
+                                                         drawIndexedCommandSignature.put_void()));
+        }
+
         bindingData.resize(sizeof(uint32_t) * 4 * 16);
     }
 
@@ -1217,6 +1513,12 @@ namespace ionengine::rhi
             return;
         }
 
+        // The allocator can be reset only after the queue has executed the commands recorded before
+        if (deviceQueue->fence->GetCompletedValue() < lastFenceValue)
+        {
+            throwIfFailed(deviceQueue->fence->SetEventOnCompletion(lastFenceValue, nullptr));
+        }
+
         throwIfFailed(commandAllocator->Reset());
         throwIfFailed(commandList->Reset(commandAllocator.get(), nullptr));
 
@@ -1232,10 +1534,15 @@ namespace ionengine::rhi
     auto DX12GraphicsContext::setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
                                                          BlendColorInfo const& blendColor,
                                                          std::optional<DepthStencilStageInfo> const depthStencil)
-        -> void
+        -> bool
     {
         this->tryResetCommandList();
 
+        if (!stateCache.setPipeline(shader, rasterizer, blendColor, depthStencil))
+        {
+            return true;
+        }
+
         auto dxShader = dynamic_cast<DX12Shader*>(shader);
 
         auto pipeline =
@@ -1244,16 +1551,34 @@ namespace ionengine::rhi
         if (!currentPipeline)
         {
             commandList->SetGraphicsRootSignature(pipeline->getRootSignature());
+            // Setting the root signature clears the root constants
+            stateCache.invalidateBindings();
+        }
+        else if (currentPipeline->getInputSize() != pipeline->getInputSize())
+        {
+            // The vertex buffer view has the stride of the previous pipeline
+            stateCache.invalidateVertexBuffer();
         }
 
         commandList->SetPipelineState(pipeline->getPipelineState());
         commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
         currentPipeline = pipeline;
+        return true;
+    }
+
+    auto DX12GraphicsContext::setFallbackShader(Shader* shader) -> void
+    {
+        // Pipelines are always compiled on the calling thread, the fallback is never drawn with
     }
 
     auto DX12GraphicsContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
     {
+        if (!stateCache.setDescriptor(index, descriptor))
+        {
+            return;
+        }
+
         std::memcpy(bindingData.data() + index * sizeof(uint32_t) * 4, &descriptor, sizeof(uint32_t));
     }
 
@@ -1261,6 +1586,10 @@ namespace ionengine::rhi
                                               std::optional<RenderPassDepthStencilInfo> depthStencil) -> void
     {
         this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        auto const previousRenderTargetFormats = renderTargetFormats;
+        DXGI_FORMAT const previousDepthStencilFormat = depthStencilFormat;
 
         renderTargetFormats.fill(DXGI_FORMAT_UNKNOWN);
         depthStencilFormat = DXGI_FORMAT_UNKNOWN;
@@ -1286,6 +1615,17 @@ namespace ionengine::rhi
                 dxTargetTexture->getDescriptor(TextureUsage::RenderTarget)->getCPUHandle();
         }
 
+        if (depthStencil.has_value())
+        {
+            depthStencilFormat = Format_to_DXGI_FORMAT(depthStencil.value().texture->getFormat());
+        }
+
+        // Pipelines are created for the formats, so the cached one can't be kept for other ones
+        if (renderTargetFormats != previousRenderTargetFormats || depthStencilFormat != previousDepthStencilFormat)
+        {
+            stateCache.invalidatePipeline();
+        }
+
         if (depthStencil.has_value())
         {
             auto depthStencilValue = depthStencil.value();
@@ -1341,6 +1681,11 @@ namespace ionengine::rhi
     {
         this->tryResetCommandList();
 
+        if (!stateCache.setVertexBuffer(buffer, offset, size))
+        {
+            return;
+        }
+
         auto dxBuffer = dynamic_cast<DX12Buffer*>(buffer);
 
         D3D12_VERTEX_BUFFER_VIEW const vertexBufferView{.BufferLocation =
@@ -1355,6 +1700,11 @@ namespace ionengine::rhi
     {
         this->tryResetCommandList();
 
+        if (!stateCache.setIndexBuffer(buffer, offset, size, format))
+        {
+            return;
+        }
+
         auto dxBuffer = dynamic_cast<DX12Buffer*>(buffer);
 
         D3D12_INDEX_BUFFER_VIEW const indexBufferView{.BufferLocation =
@@ -1366,21 +1716,80 @@ namespace ionengine::rhi
 
     auto DX12GraphicsContext::drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void
     {
-        commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
         commandList->DrawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
     }
 
     auto DX12GraphicsContext::draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void
     {
-        commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
         commandList->DrawInstanced(vertexCount, instanceCount, 0, 0);
     }
 
+    static_assert(sizeof(DrawIndirectArguments) == sizeof(D3D12_DRAW_ARGUMENTS));
+    static_assert(sizeof(DrawIndexedIndirectArguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+
+    auto DX12GraphicsContext::drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void
+    {
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
+        commandList->ExecuteIndirect(drawCommandSignature.get(), drawCount,
+                                     static_cast<DX12Buffer*>(buffer)->getResource(), offset, nullptr, 0);
+    }
+
+    auto DX12GraphicsContext::drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount)
+        -> void
+    {
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
+        commandList->ExecuteIndirect(drawIndexedCommandSignature.get(), drawCount,
+                                     static_cast<DX12Buffer*>(buffer)->getResource(), offset, nullptr, 0);
+    }
+
+    auto DX12GraphicsContext::drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                                uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
+        commandList->ExecuteIndirect(drawCommandSignature.get(), maxDrawCount,
+                                     static_cast<DX12Buffer*>(buffer)->getResource(), offset,
+                                     static_cast<DX12Buffer*>(countBuffer)->getResource(), countOffset);
+    }
+
+    auto DX12GraphicsContext::drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                                       uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        if (stateCache.takeDirtyBindings())
+        {
+            commandList->SetGraphicsRoot32BitConstants(0, 16, bindingData.data(), 0);
+        }
+        commandList->ExecuteIndirect(drawIndexedCommandSignature.get(), maxDrawCount,
+                                     static_cast<DX12Buffer*>(buffer)->getResource(), offset,
+                                     static_cast<DX12Buffer*>(countBuffer)->getResource(), countOffset);
+    }
+
     auto DX12GraphicsContext::setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
         -> void
     {
         this->tryResetCommandList();
 
+        if (!stateCache.setViewport(x, y, width, height))
+        {
+            return;
+        }
+
         D3D12_VIEWPORT const viewport{.TopLeftX = static_cast<float>(x),
                                       .TopLeftY = static_cast<float>(y),
                                       .Width = static_cast<float>(width),
@@ -1395,6 +1804,11 @@ namespace ionengine::rhi
     {
         this->tryResetCommandList();
 
+        if (!stateCache.setScissor(left, top, right, bottom))
+        {
+            return;
+        }
+
         D3D12_RECT const rect{.left = static_cast<LONG>(left),
                               .top = static_cast<LONG>(top),
                               .right = static_cast<LONG>(right),
@@ -1402,12 +1816,17 @@ namespace ionengine::rhi
         commandList->RSSetScissorRects(1, &rect);
     }
 
+    auto DX12GraphicsContext::submitDraws(std::span<DrawPacket const> const packets) -> void
+    {
+        recordDrawPackets(*this, packets);
+    }
+
     auto DX12GraphicsContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
                                       ResourceState const afterState) -> void
     {
         this->tryResetCommandList();
 
-        DX12DeviceContext_barrier(commandList.get(), destBuffer, beforeState, afterState);
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destBuffer, beforeState, afterState);
     }
 
     auto DX12GraphicsContext::barrier(Texture* destTexture, ResourceState const beforeState,
@@ -1415,11 +1834,237 @@ namespace ionengine::rhi
     {
         this->tryResetCommandList();
 
-        DX12DeviceContext_barrier(commandList.get(), destTexture, beforeState, afterState);
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destTexture, beforeState, afterState);
+    }
+
+    auto DX12GraphicsContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_beginQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_DIRECT, query, index);
+    }
+
+    auto DX12GraphicsContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_endQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_DIRECT, query, index);
+    }
+
+    auto DX12GraphicsContext::resolveQuery(Query* query) -> void
+    {
+        this->tryResetCommandList();
+
+        DX12DeviceContext_resolveQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_DIRECT, *deviceQueue,
+                                       resolvedQueries, query);
     }
 
     auto DX12GraphicsContext::execute() -> Future<void>
     {
+        std::array<ID3D12CommandList*, 1> const commandLists{this->close()};
+        deviceQueue->queue->ExecuteCommandLists(static_cast<uint32_t>(commandLists.size()), commandLists.data());
+
+        deviceQueue->fenceValue++;
+        throwIfFailed(deviceQueue->queue->Signal(deviceQueue->fence.get(), deviceQueue->fenceValue));
+        this->markSubmitted(deviceQueue->fenceValue);
+
+        if (curGraphicsContext)
+        {
+            (*curGraphicsContext)++;
+        }
+
+        auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
+                                                           fenceEvent, deviceQueue->fenceValue);
+        return Future<void>(std::move(futureImpl));
+    }
+
+    auto DX12GraphicsContext::getCommandQueue() const -> ID3D12CommandQueue*
+    {
+        return deviceQueue->queue.get();
+    }
+
+    auto DX12GraphicsContext::close() -> ID3D12CommandList*
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        throwIfFailed(commandList->Close());
+        isCommandListOpened = false;
+        stateCache.reset();
+        return commandList.get();
+    }
+
+    auto DX12GraphicsContext::markSubmitted(uint64_t const fenceValue) -> void
+    {
+        lastFenceValue = fenceValue;
+        DX12DeviceContext_submitQueries(*deviceQueue, fenceValue, resolvedQueries);
+    }
+
+    DX12ComputeContext::DX12ComputeContext(ID3D12Device4* device, PipelineCache* pipelineCache,
+                                           DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue,
+                                           HANDLE fenceEvent, BarrierCounters& barrierCounters)
+        : device(device), pipelineCache(pipelineCache), descriptorAllocator(descriptorAllocator),
+          deviceQueue(&deviceQueue), fenceEvent(fenceEvent), barrierBatcher(barrierCounters),
+          isCommandListOpened(false), lastFenceValue(0), currentPipeline(nullptr)
+    {
+        throwIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, __uuidof(ID3D12CommandAllocator),
+                                                     commandAllocator.put_void()));
+
+        throwIfFailed(device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, D3D12_COMMAND_LIST_FLAG_NONE,
+                                                 __uuidof(ID3D12GraphicsCommandList4), commandList.put_void()));
+
+        D3D12_INDIRECT_ARGUMENT_DESC const indirectArgumentDesc{.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH};
+        D3D12_COMMAND_SIGNATURE_DESC const commandSignatureDesc{.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS),
+                                                                .NumArgumentDescs = 1,
+                                                                .pArgumentDescs = &indirectArgumentDesc};
+        throwIfFailed(device->CreateCommandSignature(&commandSignatureDesc, nullptr, __uuidof(ID3D12CommandSignature),
+                                                     dispatchCommandSignature.put_void()));
+
+        bindingData.resize(sizeof(uint32_t) * 4 * 16);
+    }
+
+    DX12ComputeContext::~DX12ComputeContext()
+    {
+        deviceQueue->fence->SetEventOnCompletion(deviceQueue->fenceValue, fenceEvent);
+        ::WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
+    }
+
+    auto DX12ComputeContext::tryResetCommandList() -> void
+    {
+        if (isCommandListOpened)
+        {
+            return;
+        }
+
+        if (deviceQueue->fence->GetCompletedValue() < lastFenceValue)
+        {
+            throwIfFailed(deviceQueue->fence->SetEventOnCompletion(lastFenceValue, nullptr));
+        }
+
+        throwIfFailed(commandAllocator->Reset());
+        throwIfFailed(commandList->Reset(commandAllocator.get(), nullptr));
+
+        std::array<ID3D12DescriptorHeap*, 2> const descriptorHeaps{
+            descriptorAllocator->getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
+            descriptorAllocator->getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)};
+        commandList->SetDescriptorHeaps(static_cast<uint32_t>(descriptorHeaps.size()), descriptorHeaps.data());
+
+        isCommandListOpened = true;
+        currentPipeline = nullptr;
+    }
+
+    auto DX12ComputeContext::setComputePipelineOptions(Shader* shader) -> bool
+    {
+        this->tryResetCommandList();
+
+        auto dxShader = dynamic_cast<DX12Shader*>(shader);
+        assert(dxShader->getShaderType() == ShaderType::Compute && "shader should be a compute one");
+
+        std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> renderTargetFormats;
+        renderTargetFormats.fill(DXGI_FORMAT_UNKNOWN);
+        auto pipeline = pipelineCache->get(dxShader, RasterizerStageInfo{}, BlendColorInfo::Opaque(), std::nullopt,
+                                           renderTargetFormats, DXGI_FORMAT_UNKNOWN);
+
+        if (!currentPipeline)
+        {
+            commandList->SetComputeRootSignature(pipeline->getRootSignature());
+        }
+
+        commandList->SetPipelineState(pipeline->getPipelineState());
+
+        currentPipeline = pipeline;
+        return true;
+    }
+
+    auto DX12ComputeContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    {
+        std::memcpy(bindingData.data() + index * sizeof(uint32_t) * 4, &descriptor, sizeof(uint32_t));
+    }
+
+    auto DX12ComputeContext::dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                                      uint32_t const threadGroupCountZ) -> void
+    {
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+        commandList->SetComputeRoot32BitConstants(0, 16, bindingData.data(), 0);
+        commandList->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+    }
+
+    auto DX12ComputeContext::dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void
+    {
+        auto dxBuffer = static_cast<DX12Buffer*>(buffer);
+
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+        commandList->SetComputeRoot32BitConstants(0, 16, bindingData.data(), 0);
+        commandList->ExecuteIndirect(dispatchCommandSignature.get(), 1, dxBuffer->getResource(), offset, nullptr, 0);
+    }
+
+    auto DX12ComputeContext::uavBarrier(Buffer* destBuffer) -> void
+    {
+        this->uavBarrier(static_cast<DX12Buffer*>(destBuffer)->getResource());
+    }
+
+    auto DX12ComputeContext::uavBarrier(Texture* destTexture) -> void
+    {
+        this->uavBarrier(static_cast<DX12Texture*>(destTexture)->getResource());
+    }
+
+    auto DX12ComputeContext::uavBarrier(ID3D12Resource* resource) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        D3D12_RESOURCE_BARRIER const resourceBarrier{.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
+                                                     .UAV = {.pResource = resource}};
+        commandList->ResourceBarrier(1, &resourceBarrier);
+    }
+
+    auto DX12ComputeContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
+                                     ResourceState const afterState) -> void
+    {
+        this->tryResetCommandList();
+
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destBuffer, beforeState, afterState);
+    }
+
+    auto DX12ComputeContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                     ResourceState const afterState) -> void
+    {
+        this->tryResetCommandList();
+
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destTexture, beforeState, afterState);
+    }
+
+    auto DX12ComputeContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_beginQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COMPUTE, query, index);
+    }
+
+    auto DX12ComputeContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_endQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COMPUTE, query, index);
+    }
+
+    auto DX12ComputeContext::resolveQuery(Query* query) -> void
+    {
+        this->tryResetCommandList();
+
+        DX12DeviceContext_resolveQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COMPUTE, *deviceQueue,
+                                       resolvedQueries, query);
+    }
+
+    auto DX12ComputeContext::execute() -> Future<void>
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
         throwIfFailed(commandList->Close());
         isCommandListOpened = false;
 
@@ -1428,15 +2073,15 @@ namespace ionengine::rhi
 
         deviceQueue->fenceValue++;
         throwIfFailed(deviceQueue->queue->Signal(deviceQueue->fence.get(), deviceQueue->fenceValue));
-
-        (*curGraphicsContext)++;
+        lastFenceValue = deviceQueue->fenceValue;
+        DX12DeviceContext_submitQueries(*deviceQueue, deviceQueue->fenceValue, resolvedQueries);
 
         auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
                                                            fenceEvent, deviceQueue->fenceValue);
         return Future<void>(std::move(futureImpl));
     }
 
-    auto DX12GraphicsContext::getCommandQueue() const -> ID3D12CommandQueue*
+    auto DX12ComputeContext::getCommandQueue() const -> ID3D12CommandQueue*
     {
         return deviceQueue->queue.get();
     }
@@ -1479,10 +2124,13 @@ namespace ionengine::rhi
     }
 
     DX12CopyContext::DX12CopyContext(ID3D12Device4* device, D3D12MA::Allocator* memoryAllocator,
-                                     DeviceQueueData& deviceQueue, HANDLE fenceEvent,
+                                     DeviceQueueData& deviceQueue, HANDLE fenceEvent, BarrierCounters& barrierCounters,
                                      RHICreateInfo const& rhiCreateInfo, uint32_t& curCopyContext)
-        : device(device), deviceQueue(&deviceQueue), fenceEvent(fenceEvent), curCopyContext(&curCopyContext),
-          isCommandListOpened(false)
+        : device(device), memoryAllocator(memoryAllocator), deviceQueue(&deviceQueue), fenceEvent(fenceEvent),
+          curCopyContext(&curCopyContext), barrierBatcher(barrierCounters), isCommandListOpened(false),
+          lastFenceValue(0), stats{},
+          readbackBufferSize(rhiCreateInfo.readbackBufferSize > 0 ? rhiCreateInfo.readbackBufferSize
+                                                                  : ReadbackRing::DefaultBufferSize)
     {
         throwIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, __uuidof(ID3D12CommandAllocator),
                                                      commandAllocator.put_void()));
@@ -1490,19 +2138,9 @@ namespace ionengine::rhi
         throwIfFailed(device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_COPY, D3D12_COMMAND_LIST_FLAG_NONE,
                                                  __uuidof(ID3D12GraphicsCommandList4), commandList.put_void()));
 
-        {
-            BufferCreateInfo const bufferCreateInfo{.size = rhiCreateInfo.stagingBufferSize,
-                                                    .flags = (BufferUsageFlags)(BufferUsage::MapWrite)};
-            writeStagingBuffer = {.buffer =
-                                      core::make_ref<DX12Buffer>(device, memoryAllocator, nullptr, bufferCreateInfo)};
-        }
-
-        {
-            BufferCreateInfo const bufferCreateInfo{.size = rhiCreateInfo.stagingBufferSize,
-                                                    .flags = (BufferUsageFlags)(BufferUsage::MapRead)};
-            readStagingBuffer = {.buffer =
-                                     core::make_ref<DX12Buffer>(device, memoryAllocator, nullptr, bufferCreateInfo)};
-        }
+        BufferCreateInfo const bufferCreateInfo{.size = rhiCreateInfo.stagingBufferSize,
+                                                .flags = (BufferUsageFlags)(BufferUsage::MapWrite)};
+        writeStagingBuffer = {.buffer = core::make_ref<DX12Buffer>(device, memoryAllocator, nullptr, bufferCreateInfo)};
     }
 
     DX12CopyContext::~DX12CopyContext()
@@ -1518,6 +2156,19 @@ namespace ionengine::rhi
             return;
         }
 
+        // The allocator and the staging buffer are reused only after the queue has executed the previous copies
+        if (deviceQueue->fence->GetCompletedValue() < lastFenceValue)
+        {
+            auto const beginTime = std::chrono::steady_clock::now();
+
+            throwIfFailed(deviceQueue->fence->SetEventOnCompletion(lastFenceValue, fenceEvent));
+            ::WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
+
+            auto const waitDuration = std::chrono::steady_clock::now() - beginTime;
+            stats.stagingWaitCount++;
+            stats.stagingWaitTime += std::chrono::duration_cast<std::chrono::nanoseconds>(waitDuration).count();
+        }
+
         throwIfFailed(commandAllocator->Reset());
         throwIfFailed(commandList->Reset(commandAllocator.get(), nullptr));
 
@@ -1536,12 +2187,8 @@ namespace ionengine::rhi
                 throw std::runtime_error("not enough memory to perform the operation");
             }
 
-            uint8_t* mappedBytes = dxDestBuffer->mapMemory();
-            {
-                std::basic_ospanstream<uint8_t> oss(std::span<uint8_t>(mappedBytes + offset, dxDestBuffer->getSize()));
-                oss.write(dataBytes.data(), dataBytes.size());
-            }
-            dxDestBuffer->unmapMemory();
+            std::memcpy(dxDestBuffer->getMappedPointer() + offset, dataBytes.data(), dataBytes.size());
+            stats.uploadedBytes += dataBytes.size();
 
             auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
                                                                fenceEvent, deviceQueue->fenceValue);
@@ -1554,16 +2201,16 @@ namespace ionengine::rhi
             // Check for overflow staging buffer
             if (writeStagingBuffer.buffer->getSize() - writeStagingBuffer.offset < dataBytes.size())
             {
-                auto executeResult = this->execute();
-                // Wait until command buffer ends work
-                executeResult.wait();
+                // Recording continues in a new command list once the device has copied from the staging buffer
+                this->execute();
+                this->tryResetCommandList();
             }
 
             uint32_t const resourceAlignmentMask = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1;
 
             uint64_t const startWriteOffset = writeStagingBuffer.offset;
 
-            uint8_t* mappedBytes = writeStagingBuffer.buffer->mapMemory();
+            uint8_t* mappedBytes = writeStagingBuffer.buffer->getMappedPointer();
             {
                 std::basic_ospanstream<uint8_t> oss(
                     std::span<uint8_t>(mappedBytes, writeStagingBuffer.buffer->getSize()));
@@ -1573,10 +2220,11 @@ namespace ionengine::rhi
                 uint64_t const offset = oss.tellp();
                 writeStagingBuffer.offset = (offset + resourceAlignmentMask) & ~resourceAlignmentMask;
             }
-            writeStagingBuffer.buffer->unmapMemory();
 
+            DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
             commandList->CopyBufferRegion(dxDestBuffer->getResource(), offset, writeStagingBuffer.buffer->getResource(),
                                           startWriteOffset, dataBytes.size());
+            stats.uploadedBytes += dataBytes.size();
 
             auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
                                                                fenceEvent, deviceQueue->fenceValue + 1);
@@ -1599,9 +2247,8 @@ namespace ionengine::rhi
         // Check for overflow staging buffer
         if (writeStagingBuffer.buffer->getSize() - writeStagingBuffer.offset < totalBytes)
         {
-            auto executeResult = this->execute();
-            // Wait until command buffer ends work
-            executeResult.wait();
+            this->execute();
+            this->tryResetCommandList();
         }
 
         size_t rowBytes = 0;
@@ -1614,7 +2261,7 @@ namespace ionengine::rhi
 
         uint64_t const startWriteOffset = writeStagingBuffer.offset;
 
-        uint8_t* mappedBytes = writeStagingBuffer.buffer->mapMemory();
+        uint8_t* mappedBytes = writeStagingBuffer.buffer->getMappedPointer();
         {
             std::basic_ospanstream<uint8_t> oss(std::span<uint8_t>(mappedBytes, writeStagingBuffer.buffer->getSize()));
             oss.seekp(startWriteOffset);
@@ -1631,7 +2278,6 @@ namespace ionengine::rhi
             uint64_t const offset = oss.tellp();
             writeStagingBuffer.offset = (offset + resourceAlignmentMask) & ~resourceAlignmentMask;
         }
-        writeStagingBuffer.buffer->unmapMemory();
 
         D3D12_TEXTURE_COPY_LOCATION const sourceCopyLocation{.pResource = writeStagingBuffer.buffer->getResource(),
                                                              .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
@@ -1639,7 +2285,9 @@ namespace ionengine::rhi
         D3D12_TEXTURE_COPY_LOCATION const destCopyLocation{.pResource = dxDestTexture->getResource(),
                                                            .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
                                                            .SubresourceIndex = resourceIndex};
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
         commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &sourceCopyLocation, nullptr);
+        stats.uploadedBytes += rowBytes * rowCount;
 
         auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
                                                            fenceEvent, deviceQueue->fenceValue + 1);
@@ -1711,86 +2359,110 @@ namespace ionengine::rhi
 
         auto futureImpl = std::make_unique<DX12FutureImpl>(queue, fence, fenceEvent, *fenceValue);
         return Future<Texture>(dest, std::move(futureImpl));
-    }
+    }*/
 
-    auto DX12CopyContext::readBuffer(core::ref_ptr<Buffer> dest, uint8_t* dataBytes) -> size_t
+    auto DX12CopyContext::allocateReadbackMemory(size_t const size, size_t const alignment) -> uint64_t
     {
-        commandList->CopyBufferRegion(dynamic_cast<DX12Buffer*>(readStagingBuffer.buffer.get())->getResource(), 0,
-                                      dynamic_cast<DX12Buffer*>(dest.get())->getResource(), 0, dest->getSize());
+        if (!readbackRing)
+        {
+            BufferCreateInfo const bufferCreateInfo{.size = readbackBufferSize,
+                                                    .flags = (BufferUsageFlags)(BufferUsage::MapRead)};
+            // Released with the last result, which should happen before the RHI is destroyed
+            readbackRing = core::make_ref<ReadbackRing>(
+                core::make_ref<DX12Buffer>(device, memoryAllocator, nullptr, bufferCreateInfo));
+        }
 
-        // Execute immediately and wait
-        Future<Query> result = this->execute();
-        result.wait();
+        // Copies are recorded into the open command list, which is signaled with the next value
+        uint64_t const fenceValue = deviceQueue->fenceValue + 1;
+        uint64_t const completedValue = deviceQueue->fence->GetCompletedValue();
 
-        this->reset();
+        auto readbackOffset = readbackRing->allocate(size, alignment, fenceValue, completedValue);
+        if (!readbackOffset.has_value() && completedValue < deviceQueue->fenceValue)
+        {
+            // Released ranges can still be waiting for the copies into them
+            throwIfFailed(deviceQueue->fence->SetEventOnCompletion(deviceQueue->fenceValue, fenceEvent));
+            ::WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
 
-        size_t readBytes = 0;
-        uint8_t* mappedBytes = readStagingBuffer.buffer->mapMemory();
+            readbackOffset = readbackRing->allocate(size, alignment, fenceValue, deviceQueue->fenceValue);
+        }
+
+        if (!readbackOffset.has_value())
         {
-            std::basic_ispanstream<uint8_t> stream(std::span<uint8_t>(mappedBytes, readStagingBuffer.buffer->getSize()),
-                                                   std::ios::binary);
-            stream.read(dataBytes, dest->getSize());
-            readBytes = stream.gcount();
+            throw std::runtime_error("not enough readback memory to perform the operation");
         }
-        readStagingBuffer.buffer->unmapMemory();
-        return readBytes;
+        return readbackOffset.value();
     }
 
-    auto DX12CopyContext::readTexture(core::ref_ptr<Texture> dest, uint32_t const mipLevel, uint8_t* dataBytes)
-        -> size_t
+    auto DX12CopyContext::readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+        -> Future<ReadbackData>
     {
-        size_t rowBytes = 0;
-        uint32_t rowCount = 0;
-        size_t totalBytes = 0;
+        auto dxSourceBuffer = static_cast<DX12Buffer*>(buffer.get());
 
-        uint32_t const resourceAlignmentMask = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1;
-
-        auto resourceDesc = dynamic_cast<DX12Texture*>(dest.get())->getResource()->GetDesc();
-
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
-        device->GetCopyableFootprints(&resourceDesc, mipLevel, 1, 0, &footprint, nullptr, nullptr, &totalBytes);
+        if (!(dxSourceBuffer->getFlags() & BufferUsage::CopySource))
+        {
+            throw std::invalid_argument("buffer should be created with BufferUsage::CopySource");
+        }
+        if (size == 0 || offset > dxSourceBuffer->getSize() || dxSourceBuffer->getSize() - offset < size)
+        {
+            throw std::invalid_argument("range is out of the buffer");
+        }
 
-        D3D12_TEXTURE_COPY_LOCATION sourceCopyLocation{.pResource =
-                                                           dynamic_cast<DX12Texture*>(dest.get())->getResource(),
-                                                       .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-                                                       .SubresourceIndex = mipLevel};
-        D3D12_TEXTURE_COPY_LOCATION destCopyLocation{
-            .pResource = dynamic_cast<DX12Buffer*>(readStagingBuffer.buffer.get())->getResource(),
-            .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-            .PlacedFootprint = 0};
-        commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &sourceCopyLocation, nullptr);
+        this->tryResetCommandList();
+        uint64_t const readbackOffset = this->allocateReadbackMemory(size, 4);
 
-        // Execute immediately and wait
-        Future<Query> result = this->execute();
-        result.wait();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+        commandList->CopyBufferRegion(static_cast<DX12Buffer*>(readbackRing->getBuffer())->getResource(),
+                                      readbackOffset, dxSourceBuffer->getResource(), offset, size);
+        stats.readbackBytes += size;
 
-        this->reset();
+        auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
+                                                           fenceEvent, deviceQueue->fenceValue + 1);
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, readbackOffset, size, size),
+                                    std::move(futureImpl));
+    }
 
-        size_t readBytes = 0;
-        uint8_t* mappedBytes = readStagingBuffer.buffer->mapMemory();
+    auto DX12CopyContext::readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+        -> Future<ReadbackData>
+    {
+        if (!(texture->getFlags() & TextureUsage::CopySource))
         {
-            std::basic_ispanstream<uint8_t> stream(
-                std::span<uint8_t>(mappedBytes + readStagingBuffer.offset, readStagingBuffer.buffer->getSize()),
-                std::ios::binary);
+            throw std::invalid_argument("texture should be created with TextureUsage::CopySource");
+        }
 
-            this->getSurfaceData(dest->getFormat(), footprint.Footprint.Width, footprint.Footprint.Height, rowBytes,
-                                 rowCount);
+        auto dxSourceTexture = static_cast<DX12Texture*>(texture.get());
+        D3D12_RESOURCE_DESC const resourceDesc = dxSourceTexture->getResource()->GetDesc();
 
-            for (uint32_t const i : std::views::iota(0u, rowCount))
-            {
-                stream.read(dataBytes + rowBytes * i, rowBytes);
-                stream.seekg(footprint.Footprint.RowPitch - rowBytes, std::ios::cur);
+        uint64_t totalBytes = 0;
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint{};
+        device->GetCopyableFootprints(&resourceDesc, resourceIndex, 1, 0, &footprint, nullptr, nullptr, &totalBytes);
 
-                readBytes += rowBytes;
-            }
-        }
-        readStagingBuffer.buffer->unmapMemory();
-        return readBytes;
-    }*/
+        this->tryResetCommandList();
+        // Rows are placed by the row pitch alignment of the copy, the start by the placement alignment
+        footprint.Offset = this->allocateReadbackMemory(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        // Textures in the common state are promoted to a copy source on the copy queue
+        D3D12_TEXTURE_COPY_LOCATION const sourceCopyLocation{.pResource = dxSourceTexture->getResource(),
+                                                             .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
+                                                             .SubresourceIndex = resourceIndex};
+        D3D12_TEXTURE_COPY_LOCATION const destCopyLocation{
+            .pResource = static_cast<DX12Buffer*>(readbackRing->getBuffer())->getResource(),
+            .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
+            .PlacedFootprint = footprint};
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+        commandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &sourceCopyLocation, nullptr);
+        stats.readbackBytes += totalBytes;
+
+        auto futureImpl = std::make_unique<DX12FutureImpl>(deviceQueue->queue.get(), deviceQueue->fence.get(),
+                                                           fenceEvent, deviceQueue->fenceValue + 1);
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, footprint.Offset, totalBytes,
+                                                                  footprint.Footprint.RowPitch),
+                                    std::move(futureImpl));
+    }
 
     auto DX12CopyContext::execute() -> Future<void>
     {
         writeStagingBuffer.offset = 0;
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
 
         throwIfFailed(commandList->Close());
         isCommandListOpened = false;
@@ -1800,6 +2472,9 @@ namespace ionengine::rhi
 
         deviceQueue->fenceValue++;
         throwIfFailed(deviceQueue->queue->Signal(deviceQueue->fence.get(), deviceQueue->fenceValue));
+        lastFenceValue = deviceQueue->fenceValue;
+        DX12DeviceContext_submitQueries(*deviceQueue, deviceQueue->fenceValue, resolvedQueries);
+        stats.submissionCount++;
 
         (*curCopyContext)++;
 
@@ -1808,12 +2483,41 @@ namespace ionengine::rhi
         return Future<void>(std::move(futureImpl));
     }
 
+    auto DX12CopyContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        if (query->getQueryType() == QueryType::PipelineStatistics)
+        {
+            throw std::invalid_argument("pipeline statistics are not supported by copy contexts");
+        }
+
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_beginQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COPY, query, index);
+    }
+
+    auto DX12CopyContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryResetCommandList();
+        DX12DeviceContext_flushBarriers(commandList.get(), barrierBatcher);
+
+        DX12DeviceContext_endQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COPY, query, index);
+    }
+
+    auto DX12CopyContext::resolveQuery(Query* query) -> void
+    {
+        this->tryResetCommandList();
+
+        DX12DeviceContext_resolveQuery(commandList.get(), D3D12_COMMAND_LIST_TYPE_COPY, *deviceQueue, resolvedQueries,
+                                       query);
+    }
+
     auto DX12CopyContext::barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
         -> void
     {
         this->tryResetCommandList();
 
-        DX12DeviceContext_barrier(commandList.get(), destBuffer, beforeState, afterState);
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destBuffer, beforeState, afterState);
     }
 
     auto DX12CopyContext::barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
@@ -1821,7 +2525,7 @@ namespace ionengine::rhi
     {
         this->tryResetCommandList();
 
-        DX12DeviceContext_barrier(commandList.get(), destTexture, beforeState, afterState);
+        DX12DeviceContext_barrier(commandList.get(), barrierBatcher, destTexture, beforeState, afterState);
     }
 
     auto DX12CopyContext::getCommandQueue() const -> ID3D12CommandQueue*
@@ -1829,11 +2533,21 @@ namespace ionengine::rhi
         return deviceQueue->queue.get();
     }
 
+    auto DX12CopyContext::getStats() const -> UploadStats
+    {
+        return stats;
+    }
+
     DX12Swapchain::DX12Swapchain(IDXGIFactory4* factory, ID3D12Device4* device,
                                  DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue,
                                  HANDLE fenceEvent, SwapchainCreateInfo const& createInfo)
         : device(device), descriptorAllocator(descriptorAllocator), deviceQueue(&deviceQueue), fenceEvent(fenceEvent)
     {
+        if (createInfo.mode == SwapchainMode::Headless)
+        {
+            throw std::invalid_argument("headless swapchain is supported by the Vulkan and null backends only");
+        }
+
         RECT rect{};
         ::GetClientRect(reinterpret_cast<HWND>(createInfo.window), &rect);
 
@@ -1956,7 +2670,12 @@ namespace ionengine::rhi
         this->createDeviceQueue(D3D12_COMMAND_LIST_TYPE_COPY, copyQueue);
         this->createDeviceQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE, computeQueue);
 
-        descriptorAllocator = std::make_unique<DescriptorAllocator>(device.get());
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 featureOptions{};
+        throwIfFailed(
+            device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &featureOptions, sizeof(featureOptions)));
+        isCopyQueueTimestampSupported = featureOptions.CopyQueueTimestampQueriesSupported;
+
+        descriptorAllocator = std::make_unique<DescriptorAllocator>(device.get(), rhiCreateInfo);
 
         D3D12MA::ALLOCATOR_DESC const memoryAllocatorDesc{.pDevice = device.get(), .pAdapter = adapter.get()};
         throwIfFailed(D3D12MA::CreateAllocator(&memoryAllocatorDesc, memoryAllocator.put()));
@@ -1968,12 +2687,18 @@ namespace ionengine::rhi
             FrameContextData frameContextData{
                 .graphicsContext =
                     std::make_unique<DX12GraphicsContext>(device.get(), pipelineCache.get(), descriptorAllocator.get(),
-                                                          graphicsQueue, fenceEvent.get(), curGraphicsContext),
-                .copyContext = std::make_unique<DX12CopyContext>(device.get(), memoryAllocator.get(), copyQueue,
-                                                                 fenceEvent.get(), rhiCreateInfo, curCopyContext)};
+                                                          graphicsQueue, fenceEvent.get(), barrierCounters,
+                                                          stateCounters, &curGraphicsContext),
+                .copyContext =
+                    std::make_unique<DX12CopyContext>(device.get(), memoryAllocator.get(), copyQueue, fenceEvent.get(),
+                                                      barrierCounters, rhiCreateInfo, curCopyContext)};
             frameContexts.emplace_back(std::move(frameContextData));
         }
 
+        computeContext = std::make_unique<DX12ComputeContext>(device.get(), pipelineCache.get(),
+                                                              descriptorAllocator.get(), computeQueue,
+                                                              fenceEvent.get(), barrierCounters);
+
         if (swapchainCreateInfo.has_value())
         {
             swapchain = std::make_unique<DX12Swapchain>(factory.get(), device.get(), descriptorAllocator.get(),
@@ -2001,6 +2726,12 @@ namespace ionengine::rhi
         return core::make_ref<DX12Sampler>(device.get(), descriptorAllocator.get(), createInfo);
     }
 
+    auto DX12RHI::createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query>
+    {
+        return core::make_ref<DX12Query>(device.get(), memoryAllocator.get(), isCopyQueueTimestampSupported,
+                                         createInfo);
+    }
+
     auto DX12RHI::getSwapchain() -> Swapchain*
     {
         return swapchain.get();
@@ -2012,12 +2743,96 @@ namespace ionengine::rhi
         return frameContexts[curGraphicsContext].graphicsContext.get();
     }
 
+    auto DX12RHI::createGraphicsContext() -> std::unique_ptr<GraphicsContext>
+    {
+        return std::make_unique<DX12GraphicsContext>(device.get(), pipelineCache.get(), descriptorAllocator.get(),
+                                                     graphicsQueue, fenceEvent.get(), barrierCounters, stateCounters,
+                                                     nullptr);
+    }
+
+    auto DX12RHI::submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void>
+    {
+        std::vector<ID3D12CommandList*> commandLists;
+        for (auto const context : contexts)
+        {
+            commandLists.emplace_back(static_cast<DX12GraphicsContext*>(context)->close());
+        }
+
+        // One call keeps the command lists in the order of the contexts
+        graphicsQueue.queue->ExecuteCommandLists(static_cast<uint32_t>(commandLists.size()), commandLists.data());
+
+        graphicsQueue.fenceValue++;
+        throwIfFailed(graphicsQueue.queue->Signal(graphicsQueue.fence.get(), graphicsQueue.fenceValue));
+
+        for (auto const context : contexts)
+        {
+            static_cast<DX12GraphicsContext*>(context)->markSubmitted(graphicsQueue.fenceValue);
+        }
+
+        auto futureImpl = std::make_unique<DX12FutureImpl>(graphicsQueue.queue.get(), graphicsQueue.fence.get(),
+                                                           fenceEvent.get(), graphicsQueue.fenceValue);
+        return Future<void>(std::move(futureImpl));
+    }
+
     auto DX12RHI::getCopyContext() -> CopyContext*
     {
         curCopyContext = curCopyContext % frameContexts.size();
         return frameContexts[curCopyContext].copyContext.get();
     }
 
+    auto DX12RHI::getComputeContext() -> ComputeContext*
+    {
+        return computeContext.get();
+    }
+
+    auto DX12RHI::prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void
+    {
+        for (auto const& pipeline : pipelines)
+        {
+            std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> renderTargetFormats;
+            renderTargetFormats.fill(DXGI_FORMAT_UNKNOWN);
+            for (uint32_t const i : std::views::iota(0u, pipeline.renderTargetFormats.size()))
+            {
+                renderTargetFormats[i] = Format_to_DXGI_FORMAT(pipeline.renderTargetFormats[i]);
+            }
+
+            pipelineCache->get(dynamic_cast<DX12Shader*>(pipeline.shader), pipeline.rasterizer, pipeline.blendColor,
+                               pipeline.depthStencil, renderTargetFormats,
+                               Format_to_DXGI_FORMAT(pipeline.depthStencilFormat));
+        }
+    }
+
+    auto DX12RHI::getPipelineCacheStats() const -> PipelineCacheStats
+    {
+        return pipelineCache->getStats();
+    }
+
+    auto DX12RHI::getUploadStats() const -> UploadStats
+    {
+        // D3D12 needs no ownership transfers and queues only wait on fences, so handoffs are not tracked
+        UploadStats uploadStats{};
+        for (auto const& frameContext : frameContexts)
+        {
+            UploadStats const contextStats = frameContext.copyContext->getStats();
+            uploadStats.uploadedBytes += contextStats.uploadedBytes;
+            uploadStats.submissionCount += contextStats.submissionCount;
+            uploadStats.stagingWaitCount += contextStats.stagingWaitCount;
+            uploadStats.stagingWaitTime += contextStats.stagingWaitTime;
+            uploadStats.readbackBytes += contextStats.readbackBytes;
+        }
+        return uploadStats;
+    }
+
+    auto DX12RHI::getBarrierStats() const -> BarrierStats
+    {
+        return barrierCounters.getStats();
+    }
+
+    auto DX12RHI::getStateStats() const -> StateStats
+    {
+        return stateCounters.getStats();
+    }
+
     auto DX12RHI::getName() const -> std::string const&
     {
         return rhiName;
@@ -2032,5 +2847,11 @@ namespace ionengine::rhi
         throwIfFailed(
             device->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence), deviceQueue.fence.put_void()));
         deviceQueue.fenceValue = deviceQueue.fence->GetCompletedValue();
+
+        // Copy queues fail the call when the device does not support timestamps on them
+        if (FAILED(deviceQueue.queue->GetTimestampFrequency(&deviceQueue.timestampFrequency)))
+        {
+            deviceQueue.timestampFrequency = 0;
+        }
     }
 } // namespace ionengine::rhi
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #pragma once
 
+#include "../barrier_batcher.hpp"
+#include "../descriptor_allocator.hpp"
+#include "../state_cache.hpp"
+#include "../pipeline_cache.hpp"
+#include "../readback_ring.hpp"
 #include "../rhi.hpp"
 #include <xxhash.h>
 #define NOMINMAX
@@ -48,6 +53,7 @@ namespace ionengine::rhi
         std::atomic<uint32_t> refCount;
     };
 
+    // Heap sizes, shader visible ones are used when RHICreateInfo leaves them as zero
     enum class DescriptorAllocatorLimits : uint32_t
     {
         RTV = 128,
@@ -59,24 +65,27 @@ namespace ionengine::rhi
     class DescriptorAllocator
     {
       public:
-        DescriptorAllocator(ID3D12Device1* device);
+        DescriptorAllocator(ID3D12Device1* device, RHICreateInfo const& createInfo);
 
         auto allocate(D3D12_DESCRIPTOR_HEAP_TYPE const heapType, DescriptorAllocation** allocation) -> HRESULT;
 
+        /*! \brief Allocates descriptors for the whole span at once
+            \details Either every allocation succeeds or none of them is made
+        */
+        auto allocate(D3D12_DESCRIPTOR_HEAP_TYPE const heapType, std::span<DescriptorAllocation*> const allocations)
+            -> HRESULT;
+
         auto deallocate(DescriptorAllocation* allocation) -> void;
 
         auto getDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE const heapType) -> ID3D12DescriptorHeap*;
 
       private:
-        std::mutex mutex;
         ID3D12Device1* device;
 
         struct Chunk
         {
             winrt::com_ptr<ID3D12DescriptorHeap> heap;
-            std::vector<uint8_t> free;
-            uint32_t offset;
-            uint32_t size;
+            std::unique_ptr<DescriptorSlotAllocator> slots;
             uint32_t incrementSize;
             std::unique_ptr<DescriptorAllocation[]> allocations;
         };
@@ -94,11 +103,13 @@ namespace ionengine::rhi
 
         auto getFlags() const -> BufferUsageFlags override;
 
-        auto mapMemory() -> uint8_t*;
+        auto getDescriptorOffset(BufferUsage const usage) const -> uint32_t override;
 
-        auto unmapMemory() -> void;
+        auto getMappedPointer() -> uint8_t* override;
 
-        auto getDescriptorOffset(BufferUsage const usage) const -> uint32_t override;
+        auto flushMappedRange(uint64_t const offset, size_t const size) -> void override;
+
+        auto invalidateMappedRange(uint64_t const offset, size_t const size) -> void override;
 
         auto getResource() -> ID3D12Resource*;
 
@@ -110,6 +121,7 @@ namespace ionengine::rhi
         winrt::com_ptr<ID3D12Resource> resource;
         winrt::com_ptr<D3D12MA::Allocation> memoryAllocation;
         std::unordered_map<BufferUsage, winrt::com_ptr<DescriptorAllocation>> descriptorAllocations;
+        uint8_t* mappedBytes;
         size_t size;
         BufferUsageFlags flags;
     };
@@ -243,48 +255,6 @@ namespace ionengine::rhi
     class PipelineCache
     {
       public:
-        struct Entry
-        {
-            uint64_t shaderHash;
-            RasterizerStageInfo rasterizer;
-            BlendColorInfo blendColor;
-            std::optional<DepthStencilStageInfo> depthStencil;
-            std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> renderTargetFormats;
-            DXGI_FORMAT depthStencilFormat;
-
-            auto operator==(Entry const& other) const -> bool
-            {
-                return std::make_tuple(shaderHash, rasterizer, blendColor,
-                                       depthStencil.value_or(DepthStencilStageInfo::Default()), renderTargetFormats,
-                                       depthStencilFormat) ==
-                       std::make_tuple(other.shaderHash, other.rasterizer, other.blendColor,
-                                       other.depthStencil.value_or(DepthStencilStageInfo::Default()),
-                                       other.renderTargetFormats, other.depthStencilFormat);
-            }
-        };
-
-        struct EntryHasher
-        {
-            auto operator()(const Entry& other) const -> std::size_t
-            {
-                auto depthStencil = other.depthStencil.value_or(DepthStencilStageInfo::Default());
-                return other.shaderHash ^ ::XXH64(&other.rasterizer.fillMode, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.rasterizer.cullMode, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendDst, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendDstAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendEnable, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendOp, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendOpAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendSrc, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendSrcAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.depthFunc, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.depthWrite, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.stencilWrite, sizeof(uint32_t), 0) ^
-                       ::XXH64(other.renderTargetFormats.data(), other.renderTargetFormats.size(), 0) ^
-                       ::XXH64(&other.depthStencilFormat, sizeof(DXGI_FORMAT), 0);
-            }
-        };
-
         PipelineCache(ID3D12Device4* device, RHICreateInfo const& rhiCreateInfo);
 
         auto get(DX12Shader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
@@ -294,11 +264,15 @@ namespace ionengine::rhi
 
         auto reset() -> void;
 
+        auto getStats() const -> PipelineCacheStats;
+
       private:
-        std::mutex mutex;
         ID3D12Device4* device;
         winrt::com_ptr<ID3D12RootSignature> rootSignature;
-        std::unordered_map<Entry, core::ref_ptr<Pipeline>, EntryHasher> entries;
+        ShardedPipelineMap<core::ref_ptr<Pipeline>> entries;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> creationTime{0};
     };
 
     struct DeviceQueueData
@@ -306,20 +280,74 @@ namespace ionengine::rhi
         winrt::com_ptr<ID3D12CommandQueue> queue;
         winrt::com_ptr<ID3D12Fence> fence;
         uint64_t fenceValue;
+        // Timestamp ticks per second, zero when the queue can't write timestamps
+        uint64_t timestampFrequency;
     };
 
+    /*!
+        \brief Query heap with a readback buffer the results are resolved to
+        \details Timestamps written on the copy queue need a heap of their own, which is created when the device
+        supports them
+    */
+    class DX12Query final : public Query
+    {
+      public:
+        DX12Query(ID3D12Device4* device, D3D12MA::Allocator* memoryAllocator, bool const isCopyQueueTimestampSupported,
+                  QueryCreateInfo const& createInfo);
+
+        auto getQueryType() const -> QueryType override;
+
+        auto getCount() const -> uint32_t override;
+
+        auto getResult() const -> bool override;
+
+        auto getElapsedTimes() -> std::span<uint64_t const> override;
+
+        auto getPipelineStatistics() -> std::span<PipelineStatistics const> override;
+
+        // Returns nullptr when the queries can't be written by command lists of the type
+        auto getQueryHeap(D3D12_COMMAND_LIST_TYPE const commandListType) -> ID3D12QueryHeap*;
+
+        auto resolve(ID3D12GraphicsCommandList4* commandList, D3D12_COMMAND_LIST_TYPE const commandListType,
+                     uint64_t const timestampFrequency) -> void;
+
+        // The results are written once the fence reaches the value
+        auto markSubmitted(ID3D12Fence* fence, uint64_t const fenceValue) -> void;
+
+      private:
+        winrt::com_ptr<ID3D12QueryHeap> queryHeap;
+        winrt::com_ptr<ID3D12QueryHeap> copyQueryHeap;
+        winrt::com_ptr<ID3D12Resource> resource;
+        winrt::com_ptr<D3D12MA::Allocation> memoryAllocation;
+        QueryType queryType;
+        uint32_t count;
+        size_t resultSize;
+        uint64_t timestampFrequency;
+        // Resolved but not submitted yet
+        bool isPending;
+        ID3D12Fence* fence;
+        uint64_t fenceValue;
+        std::vector<uint64_t> elapsedTimes;
+        std::vector<PipelineStatistics> statistics;
+    };
+
+    using DX12BarrierBatcher = BarrierBatcher<D3D12_RESOURCE_BARRIER, D3D12_RESOURCE_BARRIER>;
+
     class DX12GraphicsContext final : public GraphicsContext
     {
       public:
         DX12GraphicsContext(ID3D12Device4* device, PipelineCache* pipelineCache,
                             DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue, HANDLE fenceEvent,
-                            uint32_t& curGraphicsContext);
+                            BarrierCounters& barrierCounters, StateCounters& stateCounters,
+                            uint32_t* curGraphicsContext);
 
         ~DX12GraphicsContext();
 
         auto setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
                                         BlendColorInfo const& blendColor,
-                                        std::optional<DepthStencilStageInfo> const depthStencil) -> void override;
+                                        std::optional<DepthStencilStageInfo> const depthStencil) -> bool override;
+
+        auto setFallbackShader(Shader* shader) -> void override;
 
         auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
 
@@ -337,22 +365,50 @@ namespace ionengine::rhi
 
         auto draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void override;
 
+        auto drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer, uint64_t const countOffset,
+                               uint32_t const maxDrawCount) -> void override;
+
+        auto drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                      uint64_t const countOffset, uint32_t const maxDrawCount) -> void override;
+
         auto setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
             -> void override;
 
         auto setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
             -> void override;
 
+        auto submitDraws(std::span<DrawPacket const> const packets) -> void override;
+
         auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
         auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
         auto execute() -> Future<void> override;
 
         auto getCommandQueue() const -> ID3D12CommandQueue*;
 
+        /*!
+            \brief Closes the recording and returns the command list to execute
+        */
+        auto close() -> ID3D12CommandList*;
+
+        /*!
+            \brief Keeps the command allocator until the queue reaches the fence value of its submission
+        */
+        auto markSubmitted(uint64_t const fenceValue) -> void;
+
       private:
         ID3D12Device4* device;
         PipelineCache* pipelineCache;
@@ -362,20 +418,88 @@ namespace ionengine::rhi
         uint32_t* curGraphicsContext;
         winrt::com_ptr<ID3D12CommandAllocator> commandAllocator;
         winrt::com_ptr<ID3D12GraphicsCommandList4> commandList;
+        DX12BarrierBatcher barrierBatcher;
+        GraphicsStateCache stateCache;
+        // Queries resolved by the command list being recorded
+        std::vector<core::ref_ptr<DX12Query>> resolvedQueries;
         bool isCommandListOpened;
+        uint64_t lastFenceValue;
         core::ref_ptr<Pipeline> currentPipeline;
         std::array<DXGI_FORMAT, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> renderTargetFormats;
         DXGI_FORMAT depthStencilFormat;
         std::vector<uint8_t> bindingData;
+        winrt::com_ptr<ID3D12CommandSignature> drawCommandSignature;
+        winrt::com_ptr<ID3D12CommandSignature> drawIndexedCommandSignature;
+
+        auto tryResetCommandList() -> void;
+    };
+
+    class DX12ComputeContext final : public ComputeContext
+    {
+      public:
+        DX12ComputeContext(ID3D12Device4* device, PipelineCache* pipelineCache,
+                           DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue, HANDLE fenceEvent,
+                           BarrierCounters& barrierCounters);
+
+        ~DX12ComputeContext();
+
+        auto setComputePipelineOptions(Shader* shader) -> bool override;
+
+        auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
+
+        auto dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                      uint32_t const threadGroupCountZ) -> void override;
+
+        auto dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void override;
+
+        auto uavBarrier(Buffer* destBuffer) -> void override;
+
+        auto uavBarrier(Texture* destTexture) -> void override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
+        auto execute() -> Future<void> override;
+
+        auto getCommandQueue() const -> ID3D12CommandQueue*;
+
+      private:
+        ID3D12Device4* device;
+        PipelineCache* pipelineCache;
+        DescriptorAllocator* descriptorAllocator;
+        DeviceQueueData* deviceQueue;
+        HANDLE fenceEvent;
+        winrt::com_ptr<ID3D12CommandAllocator> commandAllocator;
+        winrt::com_ptr<ID3D12GraphicsCommandList4> commandList;
+        winrt::com_ptr<ID3D12CommandSignature> dispatchCommandSignature;
+        DX12BarrierBatcher barrierBatcher;
+        // Queries resolved by the command list being recorded
+        std::vector<core::ref_ptr<DX12Query>> resolvedQueries;
+        bool isCommandListOpened;
+        uint64_t lastFenceValue;
+        core::ref_ptr<Pipeline> currentPipeline;
+        std::vector<uint8_t> bindingData;
 
         auto tryResetCommandList() -> void;
+
+        auto uavBarrier(ID3D12Resource* resource) -> void;
     };
 
     class DX12CopyContext final : public CopyContext
     {
       public:
         DX12CopyContext(ID3D12Device4* device, D3D12MA::Allocator* memoryAllocator, DeviceQueueData& deviceQueue,
-                        HANDLE fenceEvent, RHICreateInfo const& rhiCreateInfo, uint32_t& curCopyContext);
+                        HANDLE fenceEvent, BarrierCounters& barrierCounters, RHICreateInfo const& rhiCreateInfo,
+                        uint32_t& curCopyContext);
 
         ~DX12CopyContext();
 
@@ -385,24 +509,44 @@ namespace ionengine::rhi
         auto updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
                            std::span<uint8_t const> const dataBytes) -> Future<Texture> override;
 
+        auto readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+            -> Future<ReadbackData> override;
+
+        auto readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+            -> Future<ReadbackData> override;
+
         auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
         auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
         auto execute() -> Future<void> override;
 
         auto getCommandQueue() const -> ID3D12CommandQueue*;
 
+        auto getStats() const -> UploadStats;
+
       private:
         ID3D12Device4* device;
+        D3D12MA::Allocator* memoryAllocator;
         DeviceQueueData* deviceQueue;
         HANDLE fenceEvent;
         uint32_t* curCopyContext;
         winrt::com_ptr<ID3D12CommandAllocator> commandAllocator;
         winrt::com_ptr<ID3D12GraphicsCommandList4> commandList;
+        DX12BarrierBatcher barrierBatcher;
+        // Queries resolved by the command list being recorded
+        std::vector<core::ref_ptr<DX12Query>> resolvedQueries;
         bool isCommandListOpened;
+        uint64_t lastFenceValue;
+        UploadStats stats;
 
         struct StagingBufferData
         {
@@ -410,13 +554,18 @@ namespace ionengine::rhi
             uint64_t offset;
         };
 
-        StagingBufferData readStagingBuffer;
         StagingBufferData writeStagingBuffer;
 
+        size_t readbackBufferSize;
+        // Created by the first readback
+        core::ref_ptr<ReadbackRing> readbackRing;
+
         auto getSurfaceData(DXGI_FORMAT const format, uint32_t const width, uint32_t const height, size_t& rowBytes,
                             uint32_t& rowCount) -> void;
 
         auto tryResetCommandList() -> void;
+
+        auto allocateReadbackMemory(size_t const size, size_t const alignment) -> uint64_t;
     };
 
     class DX12FutureImpl final : public FutureImpl
@@ -488,12 +637,30 @@ namespace ionengine::rhi
 
         auto createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler> override;
 
+        auto createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query> override;
+
         [[nodiscard]] auto getSwapchain() -> Swapchain* override;
 
         [[nodiscard]] auto getGraphicsContext() -> GraphicsContext* override;
 
+        auto createGraphicsContext() -> std::unique_ptr<GraphicsContext> override;
+
+        auto submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void> override;
+
         [[nodiscard]] auto getCopyContext() -> CopyContext* override;
 
+        [[nodiscard]] auto getComputeContext() -> ComputeContext* override;
+
+        auto prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void override;
+
+        auto getPipelineCacheStats() const -> PipelineCacheStats override;
+
+        auto getUploadStats() const -> UploadStats override;
+
+        auto getBarrierStats() const -> BarrierStats override;
+
+        auto getStateStats() const -> StateStats override;
+
         auto getName() const -> std::string const& override;
 
       private:
@@ -511,6 +678,9 @@ namespace ionengine::rhi
         DeviceQueueData graphicsQueue;
         DeviceQueueData copyQueue;
         DeviceQueueData computeQueue;
+        BarrierCounters barrierCounters;
+        StateCounters stateCounters;
+        bool isCopyQueueTimestampSupported;
 
         std::unique_ptr<DescriptorAllocator> descriptorAllocator;
         std::unique_ptr<PipelineCache> pipelineCache;
@@ -525,6 +695,8 @@ namespace ionengine::rhi
         uint32_t curGraphicsContext;
         uint32_t curCopyContext;
 
+        std::unique_ptr<DX12ComputeContext> computeContext;
+
         std::unique_ptr<DX12Swapchain> swapchain;
 
         auto createDeviceQueue(D3D12_COMMAND_LIST_TYPE const commandListType, DeviceQueueData& deviceQueue) -> void;
@@ -0,0 +1,981 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#include "null.hpp"
+#include "precompiled.h"
+
+namespace ionengine::rhi
+{
+    NullCommandStream::NullCommandStream()
+    {
+        commandCounts.fill(0);
+    }
+
+    auto NullCommandStream::record(NullCommandType const commandType, void const* resource,
+                                   std::array<uint64_t, 4> const& arguments) -> void
+    {
+        commands.emplace_back(NullCommand{.commandType = commandType, .resource = resource, .arguments = arguments});
+        commandCounts[static_cast<size_t>(commandType)]++;
+    }
+
+    auto NullCommandStream::submit() -> void
+    {
+        std::swap(commands, submittedCommands);
+        commands.clear();
+    }
+
+    auto NullCommandStream::getCommands() const -> std::span<NullCommand const>
+    {
+        return commands;
+    }
+
+    auto NullCommandStream::getSubmittedCommands() const -> std::span<NullCommand const>
+    {
+        return submittedCommands;
+    }
+
+    auto NullCommandStream::getCommandCount(NullCommandType const commandType) const -> uint64_t
+    {
+        return commandCounts[static_cast<size_t>(commandType)];
+    }
+
+    auto NullCommandStream::getTotalCommandCount() const -> uint64_t
+    {
+        return std::accumulate(commandCounts.begin(), commandCounts.end(), uint64_t(0));
+    }
+
+    auto NullCommandStream::resetCounters() -> void
+    {
+        commandCounts.fill(0);
+    }
+
+    NullBuffer::NullBuffer(uint32_t const descriptorOffset, BufferCreateInfo const& createInfo)
+        : size(createInfo.size), flags(createInfo.flags), descriptorOffset(descriptorOffset)
+    {
+        // Mappable buffers hold their storage from the start, like the mapped memory of other backends
+        if (flags & BufferUsage::MapWrite || flags & BufferUsage::MapRead)
+        {
+            data.resize(size);
+        }
+    }
+
+    auto NullBuffer::getSize() const -> size_t
+    {
+        return size;
+    }
+
+    auto NullBuffer::getFlags() const -> BufferUsageFlags
+    {
+        return flags;
+    }
+
+    auto NullBuffer::getDescriptorOffset(BufferUsage const) const -> uint32_t
+    {
+        return descriptorOffset;
+    }
+
+    auto NullBuffer::getMappedPointer() -> uint8_t*
+    {
+        return data.empty() ? nullptr : data.data();
+    }
+
+    auto NullBuffer::flushMappedRange(uint64_t const offset, size_t const size) -> void
+    {
+        assert(offset + size <= data.size() && "range is out of the mapped memory");
+    }
+
+    auto NullBuffer::invalidateMappedRange(uint64_t const offset, size_t const size) -> void
+    {
+        assert(offset + size <= data.size() && "range is out of the mapped memory");
+    }
+
+    auto NullBuffer::getData() -> std::span<uint8_t>
+    {
+        if (data.empty())
+        {
+            data.resize(size);
+        }
+        return data;
+    }
+
+    NullTexture::NullTexture(uint32_t const descriptorOffset, TextureCreateInfo const& createInfo)
+        : width(createInfo.width), height(createInfo.height), depth(createInfo.depth),
+          mipLevels(createInfo.mipLevels), format(createInfo.format), dimension(createInfo.dimension),
+          flags(createInfo.flags), descriptorOffset(descriptorOffset)
+    {
+    }
+
+    auto NullTexture::getWidth() const -> uint32_t
+    {
+        return width;
+    }
+
+    auto NullTexture::getHeight() const -> uint32_t
+    {
+        return height;
+    }
+
+    auto NullTexture::getDepth() const -> uint32_t
+    {
+        return depth;
+    }
+
+    auto NullTexture::getMipLevels() const -> uint32_t
+    {
+        return mipLevels;
+    }
+
+    auto NullTexture::getFormat() const -> Format
+    {
+        return format;
+    }
+
+    auto NullTexture::getFlags() const -> TextureUsageFlags
+    {
+        return flags;
+    }
+
+    auto NullTexture::getDescriptorOffset(TextureUsage const) const -> uint32_t
+    {
+        return descriptorOffset;
+    }
+
+    NullSampler::NullSampler(uint32_t const descriptorOffset, SamplerCreateInfo const&)
+        : descriptorOffset(descriptorOffset)
+    {
+    }
+
+    auto NullSampler::getDescriptorOffset() const -> uint32_t
+    {
+        return descriptorOffset;
+    }
+
+    NullShader::NullShader(ShaderCreateInfo const& createInfo) : shaderType(createInfo.shaderType)
+    {
+    }
+
+    auto NullShader::getShaderType() const -> ShaderType
+    {
+        return shaderType;
+    }
+
+    NullQuery::NullQuery(QueryCreateInfo const& createInfo)
+        : queryType(createInfo.queryType), count(createInfo.count), isPending(false)
+    {
+        if (queryType == QueryType::Timestamp)
+        {
+            timestamps.resize(count * 2, 0);
+        }
+        else
+        {
+            statistics.resize(count, PipelineStatistics{});
+        }
+    }
+
+    auto NullQuery::getQueryType() const -> QueryType
+    {
+        return queryType;
+    }
+
+    auto NullQuery::getCount() const -> uint32_t
+    {
+        return count;
+    }
+
+    auto NullQuery::getResult() const -> bool
+    {
+        return !isPending;
+    }
+
+    auto NullQuery::getElapsedTimes() -> std::span<uint64_t const>
+    {
+        return elapsedTimes;
+    }
+
+    auto NullQuery::getPipelineStatistics() -> std::span<PipelineStatistics const>
+    {
+        return statistics;
+    }
+
+    auto NullQuery::writeTimestamp(uint32_t const timestampIndex, uint64_t const timestamp) -> void
+    {
+        if (queryType == QueryType::Timestamp)
+        {
+            timestamps[timestampIndex] = timestamp;
+        }
+    }
+
+    auto NullQuery::resolve() -> void
+    {
+        if (queryType == QueryType::Timestamp)
+        {
+            pendingTimes.resize(count);
+            for (uint32_t const i : std::views::iota(0u, count))
+            {
+                pendingTimes[i] = timestamps[i * 2 + 1] - timestamps[i * 2];
+            }
+        }
+        isPending = true;
+    }
+
+    auto NullQuery::markSubmitted() -> void
+    {
+        if (isPending)
+        {
+            std::swap(pendingTimes, elapsedTimes);
+            isPending = false;
+        }
+    }
+
+    NullFutureImpl::NullFutureImpl(uint64_t const fenceValue) : fenceValue(fenceValue)
+    {
+    }
+
+    auto NullFutureImpl::getResult() const -> bool
+    {
+        return true;
+    }
+
+    auto NullFutureImpl::wait() -> void
+    {
+    }
+
+    auto NullFutureImpl::waitOnContext(IDeviceContext* context) -> void
+    {
+        // Nothing runs asynchronously, the wait is only recorded to check the order of queues
+        if (auto graphicsContext = dynamic_cast<NullGraphicsContext*>(context))
+        {
+            graphicsContext->getCommandStream().record(NullCommandType::Wait, nullptr, {fenceValue});
+        }
+        else if (auto computeContext = dynamic_cast<NullComputeContext*>(context))
+        {
+            computeContext->getCommandStream().record(NullCommandType::Wait, nullptr, {fenceValue});
+        }
+        else if (auto copyContext = dynamic_cast<NullCopyContext*>(context))
+        {
+            copyContext->getCommandStream().record(NullCommandType::Wait, nullptr, {fenceValue});
+        }
+    }
+
+    auto NullDeviceContext_flushBarriers(NullBarrierBatcher& barrierBatcher, NullCommandStream& commandStream) -> void
+    {
+        barrierBatcher.flush(
+            [&](std::span<NullCommand const> const bufferBarriers, std::span<NullCommand const> const imageBarriers) {
+                for (auto const& command : bufferBarriers)
+                {
+                    commandStream.record(command.commandType, command.resource, command.arguments);
+                }
+                for (auto const& command : imageBarriers)
+                {
+                    commandStream.record(command.commandType, command.resource, command.arguments);
+                }
+            });
+    }
+
+    auto NullDeviceContext_barrier(NullBarrierBatcher& barrierBatcher, NullCommandStream& commandStream,
+                                   Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+        -> void
+    {
+        if (barrierBatcher.contains(destBuffer))
+        {
+            NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        }
+
+        NullCommand const command{.commandType = NullCommandType::Barrier,
+                                  .resource = destBuffer,
+                                  .arguments = {static_cast<uint64_t>(beforeState), static_cast<uint64_t>(afterState)}};
+        barrierBatcher.addBufferBarrier(destBuffer, command);
+    }
+
+    auto NullDeviceContext_barrier(NullBarrierBatcher& barrierBatcher, NullCommandStream& commandStream,
+                                   Texture* destTexture, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
+    {
+        if (barrierBatcher.contains(destTexture))
+        {
+            NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        }
+
+        NullCommand const command{.commandType = NullCommandType::Barrier,
+                                  .resource = destTexture,
+                                  .arguments = {static_cast<uint64_t>(beforeState), static_cast<uint64_t>(afterState)}};
+        barrierBatcher.addImageBarrier(destTexture, command);
+    }
+
+    auto NullDeviceContext_beginQuery(NullCommandStream& commandStream, Query* query, uint32_t const index) -> void
+    {
+        assert(index < query->getCount() && "query index is out of range");
+
+        commandStream.record(NullCommandType::BeginQuery, query, {index});
+        static_cast<NullQuery*>(query)->writeTimestamp(index * 2, commandStream.getTotalCommandCount());
+    }
+
+    auto NullDeviceContext_endQuery(NullCommandStream& commandStream, Query* query, uint32_t const index) -> void
+    {
+        assert(index < query->getCount() && "query index is out of range");
+
+        commandStream.record(NullCommandType::EndQuery, query, {index});
+        static_cast<NullQuery*>(query)->writeTimestamp(index * 2 + 1, commandStream.getTotalCommandCount());
+    }
+
+    auto NullDeviceContext_resolveQuery(NullCommandStream& commandStream,
+                                        std::vector<core::ref_ptr<NullQuery>>& resolvedQueries, Query* query) -> void
+    {
+        auto nullQuery = static_cast<NullQuery*>(query);
+
+        commandStream.record(NullCommandType::ResolveQuery, nullQuery, {nullQuery->getCount()});
+        nullQuery->resolve();
+        resolvedQueries.emplace_back(nullQuery);
+    }
+
+    // Results of the queries become readable, the submission completes as soon as it is made
+    auto NullDeviceContext_submitQueries(std::vector<core::ref_ptr<NullQuery>>& resolvedQueries) -> void
+    {
+        for (auto const& query : resolvedQueries)
+        {
+            query->markSubmitted();
+        }
+        resolvedQueries.clear();
+    }
+
+    NullGraphicsContext::NullGraphicsContext(uint64_t& fenceValue, BarrierCounters& barrierCounters,
+                                             StateCounters& stateCounters)
+        : fenceValue(&fenceValue), barrierBatcher(barrierCounters), stateCache(stateCounters), isRenderPassOpened(false)
+    {
+    }
+
+    auto NullGraphicsContext::setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
+                                                         BlendColorInfo const& blendColor,
+                                                         std::optional<DepthStencilStageInfo> const depthStencil)
+        -> bool
+    {
+        assert(shader && "shader should be valid");
+
+        if (!stateCache.setPipeline(shader, rasterizer, blendColor, depthStencil))
+        {
+            return true;
+        }
+
+        commandStream.record(NullCommandType::SetGraphicsPipelineOptions, shader,
+                             {static_cast<uint64_t>(rasterizer.fillMode), static_cast<uint64_t>(rasterizer.cullMode),
+                              blendColor.blendEnable, depthStencil.has_value()});
+        return true;
+    }
+
+    auto NullGraphicsContext::setFallbackShader(Shader*) -> void
+    {
+        // Pipelines are always ready, the fallback is never drawn with
+    }
+
+    auto NullGraphicsContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    {
+        if (!stateCache.setDescriptor(index, descriptor))
+        {
+            return;
+        }
+
+        commandStream.record(NullCommandType::BindDescriptor, nullptr, {index, descriptor});
+    }
+
+    auto NullGraphicsContext::beginRenderPass(std::span<RenderPassColorInfo const> const colors,
+                                              std::optional<RenderPassDepthStencilInfo> depthStencil) -> void
+    {
+        assert(!isRenderPassOpened && "render pass is already opened");
+        assert(colors.size() <= MaxColorAttachments && "too many color attachments");
+
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+
+        isRenderPassOpened = true;
+        commandStream.record(NullCommandType::BeginRenderPass,
+                             depthStencil.has_value() ? depthStencil.value().texture : nullptr,
+                             {colors.size(), depthStencil.has_value()});
+    }
+
+    auto NullGraphicsContext::endRenderPass() -> void
+    {
+        assert(isRenderPassOpened && "render pass is not opened");
+
+        isRenderPassOpened = false;
+        commandStream.record(NullCommandType::EndRenderPass);
+    }
+
+    auto NullGraphicsContext::bindVertexBuffer(Buffer* buffer, uint64_t const offset, size_t const size) -> void
+    {
+        if (!stateCache.setVertexBuffer(buffer, offset, size))
+        {
+            return;
+        }
+
+        commandStream.record(NullCommandType::BindVertexBuffer, buffer, {offset, size});
+    }
+
+    auto NullGraphicsContext::bindIndexBuffer(Buffer* buffer, uint64_t const offset, size_t const size,
+                                              Format const format) -> void
+    {
+        if (!stateCache.setIndexBuffer(buffer, offset, size, format))
+        {
+            return;
+        }
+
+        commandStream.record(NullCommandType::BindIndexBuffer, buffer, {offset, size, static_cast<uint64_t>(format)});
+    }
+
+    auto NullGraphicsContext::drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+
+        commandStream.record(NullCommandType::DrawIndexed, nullptr, {indexCount, instanceCount});
+    }
+
+    auto NullGraphicsContext::draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+
+        commandStream.record(NullCommandType::Draw, nullptr, {vertexCount, instanceCount});
+    }
+
+    auto NullGraphicsContext::drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+        assert(offset + sizeof(DrawIndirectArguments) * drawCount <= buffer->getSize() &&
+               "arguments are out of the buffer");
+
+        commandStream.record(NullCommandType::DrawIndirect, buffer, {offset, drawCount});
+    }
+
+    auto NullGraphicsContext::drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount)
+        -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+        assert(offset + sizeof(DrawIndexedIndirectArguments) * drawCount <= buffer->getSize() &&
+               "arguments are out of the buffer");
+
+        commandStream.record(NullCommandType::DrawIndexedIndirect, buffer, {offset, drawCount});
+    }
+
+    auto NullGraphicsContext::drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                                uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+        assert(offset + sizeof(DrawIndirectArguments) * maxDrawCount <= buffer->getSize() &&
+               "arguments are out of the buffer");
+        assert(countOffset + sizeof(uint32_t) <= countBuffer->getSize() && "count is out of the buffer");
+
+        commandStream.record(NullCommandType::DrawIndirectCount, buffer, {offset, countOffset, maxDrawCount});
+    }
+
+    auto NullGraphicsContext::drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                                       uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        assert(isRenderPassOpened && "draw is called outside of render pass");
+        assert(offset + sizeof(DrawIndexedIndirectArguments) * maxDrawCount <= buffer->getSize() &&
+               "arguments are out of the buffer");
+        assert(countOffset + sizeof(uint32_t) <= countBuffer->getSize() && "count is out of the buffer");
+
+        commandStream.record(NullCommandType::DrawIndexedIndirectCount, buffer, {offset, countOffset, maxDrawCount});
+    }
+
+    auto NullGraphicsContext::setViewport(int32_t const x, int32_t const y, uint32_t const width,
+                                          uint32_t const height) -> void
+    {
+        if (!stateCache.setViewport(x, y, width, height))
+        {
+            return;
+        }
+
+        commandStream.record(NullCommandType::SetViewport, nullptr,
+                             {static_cast<uint64_t>(x), static_cast<uint64_t>(y), width, height});
+    }
+
+    auto NullGraphicsContext::setScissor(int32_t const left, int32_t const top, int32_t const right,
+                                         int32_t const bottom) -> void
+    {
+        if (!stateCache.setScissor(left, top, right, bottom))
+        {
+            return;
+        }
+
+        commandStream.record(NullCommandType::SetScissor, nullptr,
+                             {static_cast<uint64_t>(left), static_cast<uint64_t>(top), static_cast<uint64_t>(right),
+                              static_cast<uint64_t>(bottom)});
+    }
+
+    auto NullGraphicsContext::submitDraws(std::span<DrawPacket const> const packets) -> void
+    {
+        recordDrawPackets(*this, packets);
+    }
+
+    auto NullGraphicsContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
+                                      ResourceState const afterState) -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destBuffer, beforeState, afterState);
+    }
+
+    auto NullGraphicsContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                      ResourceState const afterState) -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destTexture, beforeState, afterState);
+    }
+
+    auto NullGraphicsContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        NullDeviceContext_beginQuery(commandStream, query, index);
+    }
+
+    auto NullGraphicsContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        NullDeviceContext_endQuery(commandStream, query, index);
+    }
+
+    auto NullGraphicsContext::resolveQuery(Query* query) -> void
+    {
+        assert(!isRenderPassOpened && "query is resolved inside of render pass");
+
+        NullDeviceContext_resolveQuery(commandStream, resolvedQueries, query);
+    }
+
+    auto NullGraphicsContext::execute() -> Future<void>
+    {
+        assert(!isRenderPassOpened && "render pass is not closed before execute");
+
+        (*fenceValue)++;
+        this->submit(*fenceValue);
+
+        return Future<void>(std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullGraphicsContext::getCommandStream() -> NullCommandStream&
+    {
+        return commandStream;
+    }
+
+    auto NullGraphicsContext::submit(uint64_t const fenceValue) -> void
+    {
+        assert(!isRenderPassOpened && "render pass is not closed before submit");
+
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::Execute, nullptr, {fenceValue});
+        commandStream.submit();
+        NullDeviceContext_submitQueries(resolvedQueries);
+        stateCache.reset();
+    }
+
+    NullComputeContext::NullComputeContext(uint64_t& fenceValue, BarrierCounters& barrierCounters)
+        : fenceValue(&fenceValue), barrierBatcher(barrierCounters)
+    {
+    }
+
+    auto NullComputeContext::setComputePipelineOptions(Shader* shader) -> bool
+    {
+        assert(shader && shader->getShaderType() == ShaderType::Compute && "shader should be a compute one");
+
+        commandStream.record(NullCommandType::SetComputePipelineOptions, shader);
+        return true;
+    }
+
+    auto NullComputeContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    {
+        commandStream.record(NullCommandType::BindDescriptor, nullptr, {index, descriptor});
+    }
+
+    auto NullComputeContext::dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                                      uint32_t const threadGroupCountZ) -> void
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::Dispatch, nullptr,
+                             {threadGroupCountX, threadGroupCountY, threadGroupCountZ});
+    }
+
+    auto NullComputeContext::dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void
+    {
+        assert(offset + sizeof(uint32_t) * 3 <= buffer->getSize() && "arguments are out of the buffer");
+
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::DispatchIndirect, buffer, {offset});
+    }
+
+    auto NullComputeContext::uavBarrier(Buffer* destBuffer) -> void
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::UAVBarrier, destBuffer);
+    }
+
+    auto NullComputeContext::uavBarrier(Texture* destTexture) -> void
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::UAVBarrier, destTexture);
+    }
+
+    auto NullComputeContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
+                                     ResourceState const afterState) -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destBuffer, beforeState, afterState);
+    }
+
+    auto NullComputeContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                     ResourceState const afterState) -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destTexture, beforeState, afterState);
+    }
+
+    auto NullComputeContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        NullDeviceContext_beginQuery(commandStream, query, index);
+    }
+
+    auto NullComputeContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        NullDeviceContext_endQuery(commandStream, query, index);
+    }
+
+    auto NullComputeContext::resolveQuery(Query* query) -> void
+    {
+        NullDeviceContext_resolveQuery(commandStream, resolvedQueries, query);
+    }
+
+    auto NullComputeContext::execute() -> Future<void>
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+
+        (*fenceValue)++;
+        commandStream.record(NullCommandType::Execute, nullptr, {*fenceValue});
+        commandStream.submit();
+        NullDeviceContext_submitQueries(resolvedQueries);
+
+        return Future<void>(std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullComputeContext::getCommandStream() -> NullCommandStream&
+    {
+        return commandStream;
+    }
+
+    NullCopyContext::NullCopyContext(uint64_t& fenceValue, BarrierCounters& barrierCounters,
+                                     RHICreateInfo const& rhiCreateInfo)
+        : fenceValue(&fenceValue), barrierBatcher(barrierCounters), stats{},
+          readbackBufferSize(rhiCreateInfo.readbackBufferSize > 0 ? rhiCreateInfo.readbackBufferSize
+                                                                  : ReadbackRing::DefaultBufferSize)
+    {
+    }
+
+    NullCopyContext::~NullCopyContext()
+    {
+        // Matches the device backends, results held by the user lose their data with the context
+        if (readbackRing)
+        {
+            readbackRing->releaseBuffer();
+        }
+    }
+
+    auto NullCopyContext::updateBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset,
+                                       std::span<uint8_t const> const dataBytes) -> Future<Buffer>
+    {
+        auto nullBuffer = static_cast<NullBuffer*>(buffer.get());
+
+        // Check for overflow destination buffer
+        if (offset > nullBuffer->getSize() || nullBuffer->getSize() - offset < dataBytes.size())
+        {
+            throw std::runtime_error("not enough memory to perform the operation");
+        }
+
+        std::memcpy(nullBuffer->getData().data() + offset, dataBytes.data(), dataBytes.size());
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::UpdateBuffer, nullBuffer, {offset, dataBytes.size()});
+        stats.uploadedBytes += dataBytes.size();
+
+        return Future<Buffer>(std::move(buffer), std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullCopyContext::updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
+                                        std::span<uint8_t const> const dataBytes) -> Future<Texture>
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::UpdateTexture, texture.get(), {resourceIndex, dataBytes.size()});
+        stats.uploadedBytes += dataBytes.size();
+
+        return Future<Texture>(std::move(texture), std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullCopyContext::allocateReadbackMemory(size_t const size) -> uint64_t
+    {
+        if (!readbackRing)
+        {
+            BufferCreateInfo const bufferCreateInfo{
+                .size = readbackBufferSize, .elementStride = 0, .flags = (BufferUsageFlags)(BufferUsage::MapRead)};
+            readbackRing = core::make_ref<ReadbackRing>(core::make_ref<NullBuffer>(0, bufferCreateInfo));
+        }
+
+        auto readbackOffset = readbackRing->allocate(size, 4, *fenceValue + 1, *fenceValue);
+        if (!readbackOffset.has_value())
+        {
+            throw std::runtime_error("not enough readback memory to perform the operation");
+        }
+        return readbackOffset.value();
+    }
+
+    auto NullCopyContext::readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+        -> Future<ReadbackData>
+    {
+        auto nullBuffer = static_cast<NullBuffer*>(buffer.get());
+
+        if (!(nullBuffer->getFlags() & BufferUsage::CopySource))
+        {
+            throw std::invalid_argument("buffer should be created with BufferUsage::CopySource");
+        }
+        if (size == 0 || offset > nullBuffer->getSize() || nullBuffer->getSize() - offset < size)
+        {
+            throw std::invalid_argument("range is out of the buffer");
+        }
+
+        uint64_t const readbackOffset = this->allocateReadbackMemory(size);
+        std::memcpy(readbackRing->getBuffer()->getMappedPointer() + readbackOffset,
+                    nullBuffer->getData().data() + offset, size);
+
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::ReadBuffer, nullBuffer, {offset, size, readbackOffset});
+        stats.readbackBytes += size;
+
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, readbackOffset, size, size),
+                                    std::make_unique<NullFutureImpl>(*fenceValue + 1));
+    }
+
+    auto NullCopyContext::readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+        -> Future<ReadbackData>
+    {
+        if (!(texture->getFlags() & TextureUsage::CopySource))
+        {
+            throw std::invalid_argument("texture should be created with TextureUsage::CopySource");
+        }
+
+        uint32_t const mipLevel = resourceIndex % texture->getMipLevels();
+        uint32_t const width = std::max(texture->getWidth() >> mipLevel, 1u);
+        uint32_t const height = std::max(texture->getHeight() >> mipLevel, 1u);
+
+        // Texels are not stored, formats without a known size are read as four bytes per texel
+        size_t const texelBytes = std::max<size_t>(sizeof_Format(texture->getFormat()), 4);
+        size_t const rowPitch = texelBytes * width;
+        size_t const size = rowPitch * height;
+
+        uint64_t const readbackOffset = this->allocateReadbackMemory(size);
+        std::memset(readbackRing->getBuffer()->getMappedPointer() + readbackOffset, 0, size);
+
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+        commandStream.record(NullCommandType::ReadTexture, texture.get(), {resourceIndex, size, readbackOffset});
+        stats.readbackBytes += size;
+
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, readbackOffset, size, rowPitch),
+                                    std::make_unique<NullFutureImpl>(*fenceValue + 1));
+    }
+
+    auto NullCopyContext::barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+        -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destBuffer, beforeState, afterState);
+    }
+
+    auto NullCopyContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                  ResourceState const afterState) -> void
+    {
+        NullDeviceContext_barrier(barrierBatcher, commandStream, destTexture, beforeState, afterState);
+    }
+
+    auto NullCopyContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        if (query->getQueryType() == QueryType::PipelineStatistics)
+        {
+            throw std::invalid_argument("pipeline statistics are not supported by copy contexts");
+        }
+
+        NullDeviceContext_beginQuery(commandStream, query, index);
+    }
+
+    auto NullCopyContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        NullDeviceContext_endQuery(commandStream, query, index);
+    }
+
+    auto NullCopyContext::resolveQuery(Query* query) -> void
+    {
+        NullDeviceContext_resolveQuery(commandStream, resolvedQueries, query);
+    }
+
+    auto NullCopyContext::execute() -> Future<void>
+    {
+        NullDeviceContext_flushBarriers(barrierBatcher, commandStream);
+
+        (*fenceValue)++;
+        commandStream.record(NullCommandType::Execute, nullptr, {*fenceValue});
+        commandStream.submit();
+        NullDeviceContext_submitQueries(resolvedQueries);
+        stats.submissionCount++;
+
+        return Future<void>(std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullCopyContext::getCommandStream() -> NullCommandStream&
+    {
+        return commandStream;
+    }
+
+    auto NullCopyContext::getStats() const -> UploadStats
+    {
+        return stats;
+    }
+
+    NullSwapchain::NullSwapchain(NullCommandStream& commandStream, uint32_t& descriptorOffset, uint64_t& fenceValue,
+                                 SwapchainCreateInfo const& createInfo)
+        : commandStream(&commandStream), descriptorOffset(&descriptorOffset), fenceValue(&fenceValue),
+          backBuffers(std::max(createInfo.frameCount, 1u)), backBufferIndex(0),
+          backBufferFlags((TextureUsageFlags)TextureUsage::RenderTarget)
+    {
+        if (createInfo.mode == SwapchainMode::Headless)
+        {
+            backBufferFlags = (TextureUsageFlags)(TextureUsage::RenderTarget | TextureUsage::CopySource);
+        }
+
+        // There is no window to query, so back buffers start with a common size until the first resize
+        createSwapchainBuffers(createInfo.width > 0 ? createInfo.width : 1280,
+                               createInfo.height > 0 ? createInfo.height : 720);
+    }
+
+    auto NullSwapchain::getBackBuffer() -> Texture*
+    {
+        return backBuffers[backBufferIndex].get();
+    }
+
+    auto NullSwapchain::presentBackBuffer() -> Future<void>
+    {
+        (*fenceValue)++;
+        commandStream->record(NullCommandType::Present, backBuffers[backBufferIndex].get(), {*fenceValue});
+
+        backBufferIndex = (backBufferIndex + 1) % static_cast<uint32_t>(backBuffers.size());
+        return Future<void>(std::make_unique<NullFutureImpl>(*fenceValue));
+    }
+
+    auto NullSwapchain::resizeBackBuffers(uint32_t const width, uint32_t const height) -> void
+    {
+        createSwapchainBuffers(width, height);
+        backBufferIndex = 0;
+    }
+
+    auto NullSwapchain::createSwapchainBuffers(uint32_t const width, uint32_t const height) -> void
+    {
+        TextureCreateInfo const textureCreateInfo{.width = width,
+                                                  .height = height,
+                                                  .depth = 1,
+                                                  .mipLevels = 1,
+                                                  .format = Format::RGBA8_UNORM,
+                                                  .dimension = TextureDimension::_2D,
+                                                  .flags = backBufferFlags};
+
+        for (auto& backBuffer : backBuffers)
+        {
+            backBuffer = core::make_ref<NullTexture>((*descriptorOffset)++, textureCreateInfo);
+        }
+    }
+
+    NullRHI::NullRHI(RHICreateInfo const& rhiCreateInfo, std::optional<SwapchainCreateInfo> const swapchainCreateInfo)
+        : descriptorOffset(0), fenceValue(0)
+    {
+        graphicsContext = std::make_unique<NullGraphicsContext>(fenceValue, barrierCounters, stateCounters);
+        copyContext = std::make_unique<NullCopyContext>(fenceValue, barrierCounters, rhiCreateInfo);
+        computeContext = std::make_unique<NullComputeContext>(fenceValue, barrierCounters);
+
+        if (swapchainCreateInfo.has_value())
+        {
+            swapchain = std::make_unique<NullSwapchain>(graphicsContext->getCommandStream(), descriptorOffset,
+                                                        fenceValue, swapchainCreateInfo.value());
+        }
+    }
+
+    auto NullRHI::createShader(ShaderCreateInfo const& createInfo) -> core::ref_ptr<Shader>
+    {
+        return core::make_ref<NullShader>(createInfo);
+    }
+
+    auto NullRHI::createTexture(TextureCreateInfo const& createInfo) -> core::ref_ptr<Texture>
+    {
+        return core::make_ref<NullTexture>(descriptorOffset++, createInfo);
+    }
+
+    auto NullRHI::createBuffer(BufferCreateInfo const& createInfo) -> core::ref_ptr<Buffer>
+    {
+        return core::make_ref<NullBuffer>(descriptorOffset++, createInfo);
+    }
+
+    auto NullRHI::createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler>
+    {
+        return core::make_ref<NullSampler>(descriptorOffset++, createInfo);
+    }
+
+    auto NullRHI::createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query>
+    {
+        return core::make_ref<NullQuery>(createInfo);
+    }
+
+    auto NullRHI::getSwapchain() -> Swapchain*
+    {
+        return swapchain.get();
+    }
+
+    auto NullRHI::getGraphicsContext() -> GraphicsContext*
+    {
+        return graphicsContext.get();
+    }
+
+    auto NullRHI::createGraphicsContext() -> std::unique_ptr<GraphicsContext>
+    {
+        return std::make_unique<NullGraphicsContext>(fenceValue, barrierCounters, stateCounters);
+    }
+
+    auto NullRHI::submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void>
+    {
+        fenceValue++;
+        for (auto const context : contexts)
+        {
+            static_cast<NullGraphicsContext*>(context)->submit(fenceValue);
+        }
+
+        return Future<void>(std::make_unique<NullFutureImpl>(fenceValue));
+    }
+
+    auto NullRHI::getCopyContext() -> CopyContext*
+    {
+        return copyContext.get();
+    }
+
+    auto NullRHI::getComputeContext() -> ComputeContext*
+    {
+        return computeContext.get();
+    }
+
+    auto NullRHI::prewarmPipelines(std::span<PipelinePrewarmInfo const> const) -> void
+    {
+    }
+
+    auto NullRHI::getPipelineCacheStats() const -> PipelineCacheStats
+    {
+        // Pipelines are never compiled here
+        return PipelineCacheStats{};
+    }
+
+    auto NullRHI::getUploadStats() const -> UploadStats
+    {
+        // Copies complete on submission, so nothing waits for them and they never overlap other work
+        return copyContext->getStats();
+    }
+
+    auto NullRHI::getBarrierStats() const -> BarrierStats
+    {
+        return barrierCounters.getStats();
+    }
+
+    auto NullRHI::getStateStats() const -> StateStats
+    {
+        return stateCounters.getStats();
+    }
+
+    auto NullRHI::getName() const -> std::string const&
+    {
+        return rhiName;
+    }
+} // namespace ionengine::rhi
@@ -0,0 +1,471 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "../barrier_batcher.hpp"
+#include "../readback_ring.hpp"
+#include "../rhi.hpp"
+#include "../state_cache.hpp"
+
+namespace ionengine::rhi
+{
+    enum class NullCommandType : uint8_t
+    {
+        Barrier,
+        SetGraphicsPipelineOptions,
+        SetComputePipelineOptions,
+        BindDescriptor,
+        BeginRenderPass,
+        EndRenderPass,
+        BindVertexBuffer,
+        BindIndexBuffer,
+        DrawIndexed,
+        Draw,
+        DrawIndirect,
+        DrawIndexedIndirect,
+        DrawIndirectCount,
+        DrawIndexedIndirectCount,
+        SetViewport,
+        SetScissor,
+        Dispatch,
+        DispatchIndirect,
+        UAVBarrier,
+        UpdateBuffer,
+        UpdateTexture,
+        ReadBuffer,
+        ReadTexture,
+        BeginQuery,
+        EndQuery,
+        ResolveQuery,
+        Execute,
+        Wait,
+        Present,
+        Count
+    };
+
+    /*!
+        \brief Command recorded by the null backend. Arguments keep the values passed to the context method
+    */
+    struct NullCommand
+    {
+        NullCommandType commandType;
+        void const* resource;
+        std::array<uint64_t, 4> arguments;
+    };
+
+    /*!
+        \brief Stream of commands recorded between two submissions with counters that live until reset
+    */
+    class NullCommandStream
+    {
+      public:
+        NullCommandStream();
+
+        auto record(NullCommandType const commandType, void const* resource = nullptr,
+                    std::array<uint64_t, 4> const& arguments = {}) -> void;
+
+        /*!
+            \brief Move recorded commands to the submitted list. Capacity of both lists is kept to avoid allocations
+        */
+        auto submit() -> void;
+
+        auto getCommands() const -> std::span<NullCommand const>;
+
+        auto getSubmittedCommands() const -> std::span<NullCommand const>;
+
+        auto getCommandCount(NullCommandType const commandType) const -> uint64_t;
+
+        auto getTotalCommandCount() const -> uint64_t;
+
+        auto resetCounters() -> void;
+
+      private:
+        std::vector<NullCommand> commands;
+        std::vector<NullCommand> submittedCommands;
+        std::array<uint64_t, static_cast<size_t>(NullCommandType::Count)> commandCounts;
+    };
+
+    // Barriers are kept as the commands they are recorded as on flush
+    using NullBarrierBatcher = BarrierBatcher<NullCommand, NullCommand>;
+
+    class NullBuffer final : public Buffer
+    {
+      public:
+        NullBuffer(uint32_t const descriptorOffset, BufferCreateInfo const& createInfo);
+
+        auto getSize() const -> size_t override;
+
+        auto getFlags() const -> BufferUsageFlags override;
+
+        auto getDescriptorOffset(BufferUsage const usage) const -> uint32_t override;
+
+        auto getMappedPointer() -> uint8_t* override;
+
+        auto flushMappedRange(uint64_t const offset, size_t const size) -> void override;
+
+        auto invalidateMappedRange(uint64_t const offset, size_t const size) -> void override;
+
+        /*!
+            \brief Get bytes written by CopyContext. Storage is allocated by the first update
+        */
+        auto getData() -> std::span<uint8_t>;
+
+      private:
+        std::vector<uint8_t> data;
+        size_t size;
+        BufferUsageFlags flags;
+        uint32_t descriptorOffset;
+    };
+
+    class NullTexture final : public Texture
+    {
+      public:
+        NullTexture(uint32_t const descriptorOffset, TextureCreateInfo const& createInfo);
+
+        auto getWidth() const -> uint32_t override;
+
+        auto getHeight() const -> uint32_t override;
+
+        auto getDepth() const -> uint32_t override;
+
+        auto getMipLevels() const -> uint32_t override;
+
+        auto getFormat() const -> Format override;
+
+        auto getFlags() const -> TextureUsageFlags override;
+
+        auto getDescriptorOffset(TextureUsage const usage) const -> uint32_t override;
+
+      private:
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint32_t mipLevels;
+        Format format;
+        TextureDimension dimension;
+        TextureUsageFlags flags;
+        uint32_t descriptorOffset;
+    };
+
+    class NullSampler final : public Sampler
+    {
+      public:
+        NullSampler(uint32_t const descriptorOffset, SamplerCreateInfo const& createInfo);
+
+        auto getDescriptorOffset() const -> uint32_t override;
+
+      private:
+        uint32_t descriptorOffset;
+    };
+
+    class NullShader final : public Shader
+    {
+      public:
+        NullShader(ShaderCreateInfo const& createInfo);
+
+        auto getShaderType() const -> ShaderType override;
+
+      private:
+        ShaderType shaderType;
+    };
+
+    /*!
+        \brief Query without a device. Timestamps are the number of commands recorded by the context, so a region
+        lasts a nanosecond per command recorded inside of it. Nothing is executed and pipeline statistics stay zero
+    */
+    class NullQuery final : public Query
+    {
+      public:
+        NullQuery(QueryCreateInfo const& createInfo);
+
+        auto getQueryType() const -> QueryType override;
+
+        auto getCount() const -> uint32_t override;
+
+        auto getResult() const -> bool override;
+
+        auto getElapsedTimes() -> std::span<uint64_t const> override;
+
+        auto getPipelineStatistics() -> std::span<PipelineStatistics const> override;
+
+        // Timestamps at the begin and the end of a region are kept at index * 2 and index * 2 + 1
+        auto writeTimestamp(uint32_t const timestampIndex, uint64_t const timestamp) -> void;
+
+        // Computes the results, which are readable once the submission of the context is made
+        auto resolve() -> void;
+
+        auto markSubmitted() -> void;
+
+      private:
+        QueryType queryType;
+        uint32_t count;
+        std::vector<uint64_t> timestamps;
+        std::vector<uint64_t> pendingTimes;
+        std::vector<uint64_t> elapsedTimes;
+        std::vector<PipelineStatistics> statistics;
+        bool isPending;
+    };
+
+    class NullFutureImpl final : public FutureImpl
+    {
+      public:
+        NullFutureImpl(uint64_t const fenceValue);
+
+        auto getResult() const -> bool override;
+
+        auto wait() -> void override;
+
+        auto waitOnContext(IDeviceContext* context) -> void override;
+
+      private:
+        uint64_t fenceValue;
+    };
+
+    class NullGraphicsContext final : public GraphicsContext
+    {
+      public:
+        NullGraphicsContext(uint64_t& fenceValue, BarrierCounters& barrierCounters, StateCounters& stateCounters);
+
+        auto setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
+                                        BlendColorInfo const& blendColor,
+                                        std::optional<DepthStencilStageInfo> const depthStencil) -> bool override;
+
+        auto setFallbackShader(Shader* shader) -> void override;
+
+        auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
+
+        auto beginRenderPass(std::span<RenderPassColorInfo const> const colors,
+                             std::optional<RenderPassDepthStencilInfo> depthStencil) -> void override;
+
+        auto endRenderPass() -> void override;
+
+        auto bindVertexBuffer(Buffer* buffer, uint64_t const offset, size_t const size) -> void override;
+
+        auto bindIndexBuffer(Buffer* buffer, uint64_t const offset, size_t const size, Format const format)
+            -> void override;
+
+        auto drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void override;
+
+        auto draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void override;
+
+        auto drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer, uint64_t const countOffset,
+                               uint32_t const maxDrawCount) -> void override;
+
+        auto drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                      uint64_t const countOffset, uint32_t const maxDrawCount) -> void override;
+
+        auto setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
+            -> void override;
+
+        auto setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
+            -> void override;
+
+        auto submitDraws(std::span<DrawPacket const> const packets) -> void override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
+        auto execute() -> Future<void> override;
+
+        auto getCommandStream() -> NullCommandStream&;
+
+        // Records the end of the list signaled with the fence value and submits it
+        auto submit(uint64_t const fenceValue) -> void;
+
+      private:
+        uint64_t* fenceValue;
+        NullCommandStream commandStream;
+        NullBarrierBatcher barrierBatcher;
+        GraphicsStateCache stateCache;
+        // Queries resolved since the last submission
+        std::vector<core::ref_ptr<NullQuery>> resolvedQueries;
+        bool isRenderPassOpened;
+    };
+
+    class NullComputeContext final : public ComputeContext
+    {
+      public:
+        NullComputeContext(uint64_t& fenceValue, BarrierCounters& barrierCounters);
+
+        auto setComputePipelineOptions(Shader* shader) -> bool override;
+
+        auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
+
+        auto dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                      uint32_t const threadGroupCountZ) -> void override;
+
+        auto dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void override;
+
+        auto uavBarrier(Buffer* destBuffer) -> void override;
+
+        auto uavBarrier(Texture* destTexture) -> void override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
+        auto execute() -> Future<void> override;
+
+        auto getCommandStream() -> NullCommandStream&;
+
+      private:
+        uint64_t* fenceValue;
+        NullCommandStream commandStream;
+        NullBarrierBatcher barrierBatcher;
+        // Queries resolved since the last submission
+        std::vector<core::ref_ptr<NullQuery>> resolvedQueries;
+    };
+
+    class NullCopyContext final : public CopyContext
+    {
+      public:
+        NullCopyContext(uint64_t& fenceValue, BarrierCounters& barrierCounters, RHICreateInfo const& rhiCreateInfo);
+
+        ~NullCopyContext();
+
+        auto updateBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, std::span<uint8_t const> const dataBytes)
+            -> Future<Buffer> override;
+
+        auto updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
+                           std::span<uint8_t const> const dataBytes) -> Future<Texture> override;
+
+        auto readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+            -> Future<ReadbackData> override;
+
+        auto readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+            -> Future<ReadbackData> override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
+        auto execute() -> Future<void> override;
+
+        auto getCommandStream() -> NullCommandStream&;
+
+        auto getStats() const -> UploadStats;
+
+      private:
+        uint64_t* fenceValue;
+        NullCommandStream commandStream;
+        NullBarrierBatcher barrierBatcher;
+        // Queries resolved since the last submission
+        std::vector<core::ref_ptr<NullQuery>> resolvedQueries;
+        UploadStats stats;
+        size_t readbackBufferSize;
+        // Created by the first readback
+        core::ref_ptr<ReadbackRing> readbackRing;
+
+        // Copies are made when they are recorded, the range is reused after the next submission like on a device
+        auto allocateReadbackMemory(size_t const size) -> uint64_t;
+    };
+
+    class NullSwapchain final : public Swapchain
+    {
+      public:
+        NullSwapchain(NullCommandStream& commandStream, uint32_t& descriptorOffset, uint64_t& fenceValue,
+                      SwapchainCreateInfo const& createInfo);
+
+        [[nodiscard]] auto getBackBuffer() -> Texture* override;
+
+        auto presentBackBuffer() -> Future<void> override;
+
+        auto resizeBackBuffers(uint32_t const width, uint32_t const height) -> void override;
+
+      private:
+        NullCommandStream* commandStream;
+        uint32_t* descriptorOffset;
+        uint64_t* fenceValue;
+        std::vector<core::ref_ptr<Texture>> backBuffers;
+        uint32_t backBufferIndex;
+        TextureUsageFlags backBufferFlags;
+
+        auto createSwapchainBuffers(uint32_t const width, uint32_t const height) -> void;
+    };
+
+    /*!
+        \brief Backend without a device. Resources are plain CPU objects and contexts only record commands,
+        so the CPU side of the renderer can be measured on machines without a GPU
+    */
+    class NullRHI final : public RHI
+    {
+      public:
+        NullRHI(RHICreateInfo const& rhiCreateInfo, std::optional<SwapchainCreateInfo> const swapchainCreateInfo);
+
+        auto createShader(ShaderCreateInfo const& createInfo) -> core::ref_ptr<Shader> override;
+
+        auto createTexture(TextureCreateInfo const& createInfo) -> core::ref_ptr<Texture> override;
+
+        auto createBuffer(BufferCreateInfo const& createInfo) -> core::ref_ptr<Buffer> override;
+
+        auto createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler> override;
+
+        auto createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query> override;
+
+        [[nodiscard]] auto getSwapchain() -> Swapchain* override;
+
+        [[nodiscard]] auto getGraphicsContext() -> GraphicsContext* override;
+
+        auto createGraphicsContext() -> std::unique_ptr<GraphicsContext> override;
+
+        auto submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void> override;
+
+        [[nodiscard]] auto getCopyContext() -> CopyContext* override;
+
+        [[nodiscard]] auto getComputeContext() -> ComputeContext* override;
+
+        auto prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void override;
+
+        auto getPipelineCacheStats() const -> PipelineCacheStats override;
+
+        auto getUploadStats() const -> UploadStats override;
+
+        auto getBarrierStats() const -> BarrierStats override;
+
+        auto getStateStats() const -> StateStats override;
+
+        auto getName() const -> std::string const& override;
+
+      private:
+        std::string const rhiName{"Null"};
+
+        uint32_t descriptorOffset;
+        uint64_t fenceValue;
+        BarrierCounters barrierCounters;
+        StateCounters stateCounters;
+
+        std::unique_ptr<NullGraphicsContext> graphicsContext;
+        std::unique_ptr<NullCopyContext> copyContext;
+        std::unique_ptr<NullComputeContext> computeContext;
+        std::unique_ptr<NullSwapchain> swapchain;
+    };
+} // namespace ionengine::rhi
@@ -0,0 +1,172 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "rhi.hpp"
+#include <xxhash.h>
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Pipeline state packed into plain bytes
+        \details Backend formats are stored as their 32-bit enum values. The key is hashed once on creation and the
+        hash is kept inside, so map lookups never hash it again and compare it as a whole
+    */
+    struct PipelineKey
+    {
+        uint64_t hash;
+        uint64_t shaderHash;
+        std::array<uint32_t, MaxColorAttachments> renderTargetFormats;
+        uint32_t depthStencilFormat;
+        uint8_t fillMode;
+        uint8_t cullMode;
+        uint8_t blendEnable;
+        uint8_t blendSrc;
+        uint8_t blendDst;
+        uint8_t blendOp;
+        uint8_t blendSrcAlpha;
+        uint8_t blendDstAlpha;
+        uint8_t blendOpAlpha;
+        uint8_t hasDepthStencil;
+        uint8_t depthFunc;
+        uint8_t depthWrite;
+        uint8_t stencilWrite;
+        std::array<uint8_t, 7> reserved;
+
+        template <typename FormatType>
+        static auto create(uint64_t const shaderHash, RasterizerStageInfo const& rasterizer,
+                           BlendColorInfo const& blendColor, std::optional<DepthStencilStageInfo> const& depthStencil,
+                           std::span<FormatType const> const renderTargetFormats, FormatType const depthStencilFormat)
+            -> PipelineKey
+        {
+            static_assert(sizeof(FormatType) == sizeof(uint32_t));
+            assert(renderTargetFormats.size() <= MaxColorAttachments && "too many render target formats");
+
+            PipelineKey key{.hash = 0,
+                            .shaderHash = shaderHash,
+                            .renderTargetFormats = {},
+                            .depthStencilFormat = static_cast<uint32_t>(depthStencilFormat),
+                            .fillMode = static_cast<uint8_t>(rasterizer.fillMode),
+                            .cullMode = static_cast<uint8_t>(rasterizer.cullMode),
+                            .blendEnable = blendColor.blendEnable,
+                            .blendSrc = static_cast<uint8_t>(blendColor.blendSrc),
+                            .blendDst = static_cast<uint8_t>(blendColor.blendDst),
+                            .blendOp = static_cast<uint8_t>(blendColor.blendOp),
+                            .blendSrcAlpha = static_cast<uint8_t>(blendColor.blendSrcAlpha),
+                            .blendDstAlpha = static_cast<uint8_t>(blendColor.blendDstAlpha),
+                            .blendOpAlpha = static_cast<uint8_t>(blendColor.blendOpAlpha),
+                            .hasDepthStencil = depthStencil.has_value(),
+                            .depthFunc = 0,
+                            .depthWrite = 0,
+                            .stencilWrite = 0,
+                            .reserved = {}};
+
+            for (uint32_t const i : std::views::iota(0u, renderTargetFormats.size()))
+            {
+                key.renderTargetFormats[i] = static_cast<uint32_t>(renderTargetFormats[i]);
+            }
+
+            if (depthStencil.has_value())
+            {
+                key.depthFunc = static_cast<uint8_t>(depthStencil->depthFunc);
+                key.depthWrite = depthStencil->depthWrite;
+                key.stencilWrite = depthStencil->stencilWrite;
+            }
+
+            key.hash = ::XXH64(&key.shaderHash, sizeof(PipelineKey) - offsetof(PipelineKey, shaderHash), 0);
+            return key;
+        }
+
+        auto operator==(PipelineKey const& other) const -> bool = default;
+    };
+
+    static_assert(std::has_unique_object_representations_v<PipelineKey>, "PipelineKey should not have padding");
+
+    struct PipelineKeyHasher
+    {
+        auto operator()(PipelineKey const& other) const -> std::size_t
+        {
+            return other.hash;
+        }
+    };
+
+    /*!
+        \brief Map of pipelines split into shards, each guarded by its own shared_mutex
+        \details Lookups of ready pipelines only take a shared lock of one shard, so recording threads do not
+        contend with each other. Inserts lock the shard exclusively
+    */
+    template <typename Type, size_t ShardCount = 16>
+    class ShardedPipelineMap
+    {
+        static_assert(ShardCount > 1 && std::has_single_bit(ShardCount), "ShardCount should be a power of two");
+
+      public:
+        auto find(PipelineKey const& key) const -> std::optional<Type>
+        {
+            auto& shard = this->getShard(key);
+
+            std::shared_lock lock(shard.mutex);
+            auto result = shard.entries.find(key);
+            if (result != shard.entries.end())
+            {
+                return result->second;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+
+        /*! \brief Inserts the value unless the key is already there
+            \return The value stored for the key
+        */
+        auto emplace(PipelineKey const& key, Type const& value) -> Type
+        {
+            auto& shard = this->getShard(key);
+
+            std::unique_lock lock(shard.mutex);
+            return shard.entries.try_emplace(key, value).first->second;
+        }
+
+        auto clear() -> void
+        {
+            for (auto& shard : shards)
+            {
+                std::unique_lock lock(shard.mutex);
+                shard.entries.clear();
+            }
+        }
+
+        auto size() const -> size_t
+        {
+            size_t count = 0;
+            for (auto const& shard : shards)
+            {
+                std::shared_lock lock(shard.mutex);
+                count += shard.entries.size();
+            }
+            return count;
+        }
+
+      private:
+        // Aligned to a cache line so locking one shard does not slow down its neighbours
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<PipelineKey, Type, PipelineKeyHasher> entries;
+        };
+
+        std::array<Shard, ShardCount> shards;
+
+        auto getShard(PipelineKey const& key) const -> Shard const&
+        {
+            // The low bits pick the bucket inside the shard, so the shard is picked by the high ones
+            return shards[key.hash >> (64 - std::countr_zero(ShardCount))];
+        }
+
+        auto getShard(PipelineKey const& key) -> Shard&
+        {
+            return shards[key.hash >> (64 - std::countr_zero(ShardCount))];
+        }
+    };
+} // namespace ionengine::rhi
@@ -0,0 +1,175 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "rhi.hpp"
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Ring of a persistently mapped buffer that copy contexts read resources back into
+        \details Ranges are handed out in order and released in any order by their results. The space of a range is
+        reused only when it and every range before it are released and the fence value of the copy into it has been
+        reached, so a result dropped before its copy is done is never overwritten by a later one. Releases are made
+        from the threads that drop the results, so the ring is guarded by a mutex. The context that owns the ring
+        releases the buffer when it is destroyed, results that are still held return no data after that
+    */
+    class ReadbackRing : public core::ref_counted_object
+    {
+      public:
+        // Used when RHICreateInfo::readbackBufferSize is zero
+        static size_t constexpr DefaultBufferSize = 16 * 1024 * 1024;
+
+        ReadbackRing(core::ref_ptr<Buffer> buffer)
+            : buffer(std::move(buffer)), mappedBytes(this->buffer->getMappedPointer()),
+              capacity(this->buffer->getSize()), head(0), tail(0)
+        {
+            assert(mappedBytes && "readback buffer should be created with BufferUsage::MapRead");
+        }
+
+        /*!
+            \brief Takes a range written by the copy signaled with the fence value, returns its offset in the buffer
+            \details Ranges never wrap around, the end of the buffer is skipped instead. Returns nothing when the
+            ring has no space until some of the results are released or the device reaches the completed value
+        */
+        auto allocate(size_t const size, size_t const alignment, uint64_t const fenceValue,
+                      uint64_t const completedValue) -> std::optional<uint64_t>
+        {
+            std::lock_guard lock(mutex);
+
+            this->retire(completedValue);
+
+            if (size > capacity)
+            {
+                return std::nullopt;
+            }
+
+            uint64_t const lapOffset = head % capacity;
+            uint64_t const alignedOffset = (lapOffset + alignment - 1) / alignment * alignment;
+            uint64_t const start = alignedOffset + size > capacity ? head - lapOffset + capacity
+                                                                   : head - lapOffset + alignedOffset;
+            if (start + size - tail > capacity)
+            {
+                return std::nullopt;
+            }
+
+            ranges.emplace_back(
+                Range{.start = start, .end = start + size, .fenceValue = fenceValue, .isReleased = false});
+            head = start + size;
+            return start % capacity;
+        }
+
+        auto deallocate(uint64_t const offset) -> void
+        {
+            std::lock_guard lock(mutex);
+
+            // Ranges are ordered by their positions and do not wrap, so the offset is unique among the held ones
+            auto it = std::find_if(ranges.begin(), ranges.end(),
+                                   [&](Range const& range) { return range.start % capacity == offset; });
+            assert(it != ranges.end() && "range is not allocated");
+            it->isReleased = true;
+        }
+
+        auto getData(uint64_t const offset, size_t const size) const -> std::span<uint8_t const>
+        {
+            std::lock_guard lock(mutex);
+
+            if (!buffer)
+            {
+                return std::span<uint8_t const>();
+            }
+
+            buffer->invalidateMappedRange(offset, size);
+            return std::span<uint8_t const>(mappedBytes + offset, size);
+        }
+
+        // Drops the buffer before the device that owns it is destroyed, results can outlive it
+        auto releaseBuffer() -> void
+        {
+            std::lock_guard lock(mutex);
+
+            buffer = nullptr;
+            mappedBytes = nullptr;
+        }
+
+        auto getBuffer() const -> Buffer*
+        {
+            return buffer.get();
+        }
+
+        // Bytes taken by the held ranges and the skipped ends of the buffer
+        auto getUsedSize() const -> uint64_t
+        {
+            std::lock_guard lock(mutex);
+            return head - tail;
+        }
+
+      private:
+        struct Range
+        {
+            uint64_t start;
+            uint64_t end;
+            uint64_t fenceValue;
+            bool isReleased;
+        };
+
+        mutable std::mutex mutex;
+        core::ref_ptr<Buffer> buffer;
+        uint8_t* mappedBytes;
+        uint64_t capacity;
+        // Positions grow monotonically and wrap by the capacity of the buffer
+        uint64_t head;
+        uint64_t tail;
+        std::deque<Range> ranges;
+
+        auto retire(uint64_t const completedValue) -> void
+        {
+            while (!ranges.empty() && ranges.front().isReleased && ranges.front().fenceValue <= completedValue)
+            {
+                tail = ranges.front().end;
+                ranges.pop_front();
+            }
+
+            if (ranges.empty())
+            {
+                // Nothing is held, the next range starts from the beginning of the buffer
+                head = (head + capacity - 1) / capacity * capacity;
+                tail = head;
+            }
+        }
+    };
+
+    /*!
+        \brief Result of a readback that holds its range of the ring until it is released
+    */
+    class ReadbackRange final : public ReadbackData
+    {
+      public:
+        ReadbackRange(core::ref_ptr<ReadbackRing> ring, uint64_t const offset, size_t const size,
+                      size_t const rowPitch)
+            : ring(std::move(ring)), offset(offset), size(size), rowPitch(rowPitch)
+        {
+        }
+
+        ~ReadbackRange()
+        {
+            ring->deallocate(offset);
+        }
+
+        auto getData() const -> std::span<uint8_t const> override
+        {
+            return ring->getData(offset, size);
+        }
+
+        auto getRowPitch() const -> size_t override
+        {
+            return rowPitch;
+        }
+
+      private:
+        core::ref_ptr<ReadbackRing> ring;
+        uint64_t offset;
+        size_t size;
+        size_t rowPitch;
+    };
+} // namespace ionengine::rhi
@@ -7,6 +7,8 @@
 #include "dx12/dx12.hpp"
 #elif IONENGINE_RHI_VULKAN
 #include "vulkan/vk.hpp"
+#elif IONENGINE_RHI_NULL
+#include "null/null.hpp"
 #endif
 
 namespace ionengine::rhi
@@ -50,7 +52,9 @@ namespace ionengine::rhi
 #ifdef IONENGINE_RHI_DIRECTX12
         return core::make_ref<DX12RHI>(rhiCreateInfo, swapchainCreateInfo);
 #elif IONENGINE_RHI_VULKAN
-        return core::make_ref<VKRHI>(createInfo, swapchainCreateInfo);
+        return core::make_ref<VKRHI>(rhiCreateInfo, swapchainCreateInfo);
+#elif IONENGINE_RHI_NULL
+        return core::make_ref<NullRHI>(rhiCreateInfo, swapchainCreateInfo);
 #else
 #error rhi backend is not defined
         return nullptr;
@@ -18,7 +18,9 @@ namespace ionengine::rhi
         MapWrite = 1 << 5,
         MapRead = 1 << 6,
         CopySource = 1 << 7,
-        CopyDest = 1 << 8
+        CopyDest = 1 << 8,
+        // Arguments and counts of indirect draws and dispatches
+        Indirect = 1 << 9
     };
 
     DECLARE_ENUM_CLASS_BIT_FLAG(BufferUsage)
@@ -33,6 +35,23 @@ namespace ionengine::rhi
         virtual auto getFlags() const -> BufferUsageFlags = 0;
 
         virtual auto getDescriptorOffset(BufferUsage const usage) const -> uint32_t = 0;
+
+        /*! \brief Memory of a buffer created with BufferUsage::MapWrite or BufferUsage::MapRead, null for others
+            \details The buffer is mapped when it is created and stays mapped, so per-frame data can be written in
+            place without a copy. The device should not use the written range until the work that wrote it last
+            time is finished, e.g. a buffer per frame in flight
+        */
+        virtual auto getMappedPointer() -> uint8_t* = 0;
+
+        /*! \brief Makes host writes to the range visible to the device
+            \details Needed only on memory that is not host coherent, does nothing on the others
+        */
+        virtual auto flushMappedRange(uint64_t const offset, size_t const size) -> void = 0;
+
+        /*! \brief Makes device writes to the range visible to the host
+            \details Needed only on memory that is not host coherent, does nothing on the others
+        */
+        virtual auto invalidateMappedRange(uint64_t const offset, size_t const size) -> void = 0;
     };
 
     enum class Format
@@ -186,7 +205,8 @@ namespace ionengine::rhi
         ShaderRead,
         UnorderedAccess,
         CopyDest,
-        CopySource
+        CopySource,
+        IndirectArgument
     };
 
     enum class Filter
@@ -239,17 +259,56 @@ namespace ionengine::rhi
         TextureUsageFlags flags;
     };
 
+    enum class SwapchainMode
+    {
+        // Back buffers are presented to the window
+        Window,
+        /*! \brief Back buffers are offscreen textures presented in turn, no window or display is required
+            \details They start in ResourceState::Common and are created with TextureUsage::CopySource, so a
+            presented frame can be read back by the copy context after it waits for the present result. The graphics
+            context should wait for such a readback before the back buffer comes around again. The RHI does not write
+            frames to disk itself, dumping them is left to the caller, e.g. from a thread that waits for the results
+        */
+        Headless
+    };
+
     struct SwapchainCreateInfo
     {
         void* window;
         void* instance;
         uint32_t frameCount;
+        SwapchainMode mode;
+        // Size of headless back buffers until the first resize, zero picks 1280x720
+        uint32_t width;
+        uint32_t height;
+    };
+
+    enum class PipelineCompileMode
+    {
+        // Pipelines that are not compiled yet are compiled on the calling thread
+        Blocking,
+        // Draws are dropped until the pipeline is compiled in the background, compute pipelines stay blocking
+        Skip,
+        // Draws use the fallback shader until the pipeline is compiled in the background, compute pipelines stay
+        // blocking
+        Fallback
     };
 
     struct RHICreateInfo
     {
         size_t stagingBufferSize;
         uint32_t numBuffering;
+        // Where compiled pipelines are kept between runs, an empty path keeps them in memory only
+        std::filesystem::path pipelineCachePath;
+        PipelineCompileMode pipelineCompileMode;
+        // Number of background compiler threads, zero picks it from the hardware concurrency
+        uint32_t pipelineCompileThreads;
+        // Maximum number of bindless buffer and texture descriptors, zero picks the backend default
+        uint32_t descriptorHeapSize;
+        // Maximum number of bindless sampler descriptors, zero picks the backend default
+        uint32_t samplerHeapSize;
+        // Size of the ring that copy contexts read resources back into, zero picks the default size
+        size_t readbackBufferSize;
 
         static auto Default() -> RHICreateInfo const&
         {
@@ -258,6 +317,59 @@ namespace ionengine::rhi
         }
     };
 
+    struct PipelineCacheStats
+    {
+        // Requests served by an already created pipeline
+        uint64_t hits;
+        // Requests that had to create a new pipeline
+        uint64_t misses;
+        // Misses the driver could build from previously compiled pipeline data
+        uint64_t driverCacheHits;
+        // Total time spent creating pipelines in nanoseconds
+        uint64_t creationTime;
+        // Size of the pipeline data loaded from the disk
+        size_t loadedSize;
+        // Pipelines queued or being compiled in the background
+        uint64_t pendingCompilations;
+    };
+
+    struct UploadStats
+    {
+        // Bytes written to resources by the copy context
+        uint64_t uploadedBytes;
+        // Submissions made to the copy queue
+        uint64_t submissionCount;
+        // Times the uploading thread waited for the device to free staging memory
+        uint64_t stagingWaitCount;
+        // Total time spent in those waits in nanoseconds
+        uint64_t stagingWaitTime;
+        // Times another queue was made to wait for uploads
+        uint64_t handoffCount;
+        // Handoffs made while the uploads were still executing, so the copies overlapped the work before the wait
+        uint64_t overlappedHandoffCount;
+        // Bytes copied from resources into the readback ring
+        uint64_t readbackBytes;
+    };
+
+    struct BarrierStats
+    {
+        // Barriers passed to the contexts
+        uint64_t barrierCount;
+        // Batches of barriers recorded, each one as a single barrier command of the backend
+        uint64_t flushCount;
+    };
+
+    struct StateStats
+    {
+        // Pipeline, buffer, descriptor, viewport and scissor sets that reached the backend
+        uint64_t issuedCount;
+        // Sets dropped since they repeated the state already set on the context
+        uint64_t elidedCount;
+    };
+
+    // Maximum number of color attachments bound to a single render pass
+    inline uint32_t constexpr MaxColorAttachments = 8;
+
     struct RenderPassColorInfo
     {
         Texture* texture;
@@ -277,6 +389,25 @@ namespace ionengine::rhi
         uint8_t clearStencil;
     };
 
+    // Layout of the arguments read by GraphicsContext::drawIndirect, the same for every backend
+    struct DrawIndirectArguments
+    {
+        uint32_t vertexCount;
+        uint32_t instanceCount;
+        uint32_t firstVertex;
+        uint32_t firstInstance;
+    };
+
+    // Layout of the arguments read by GraphicsContext::drawIndexedIndirect
+    struct DrawIndexedIndirectArguments
+    {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
+
     struct DepthStencilStageInfo
     {
         CompareOp depthFunc;
@@ -405,6 +536,64 @@ namespace ionengine::rhi
         }
     };
 
+    /*! \brief Describes a pipeline that is compiled ahead of its first use
+        \details Has to match the state and render targets the shader is used with, otherwise it is compiled again
+        on the first draw
+    */
+    struct PipelinePrewarmInfo
+    {
+        Shader* shader;
+        RasterizerStageInfo rasterizer;
+        BlendColorInfo blendColor;
+        std::optional<DepthStencilStageInfo> depthStencil;
+        std::span<Format const> renderTargetFormats;
+        Format depthStencilFormat;
+    };
+
+    // State set with GraphicsContext::setGraphicsPipelineOptions, shared by the draw packets that use it
+    struct DrawPipelineState
+    {
+        Shader* shader;
+        RasterizerStageInfo rasterizer;
+        BlendColorInfo blendColor;
+        std::optional<DepthStencilStageInfo> depthStencil;
+    };
+
+    struct VertexBufferView
+    {
+        Buffer* buffer;
+        uint64_t offset;
+        size_t size;
+    };
+
+    struct IndexBufferView
+    {
+        Buffer* buffer;
+        uint64_t offset;
+        size_t size;
+        Format format;
+    };
+
+    /*!
+        \brief Everything a single draw of GraphicsContext::submitDraws needs
+        \details The pipeline state is referenced, so packets with the same pointer skip the pipeline comparison.
+        Descriptors are bound to the first descriptorCount indices. A packet without an index buffer is drawn with
+        draw and count is the number of vertices, otherwise with drawIndexed. A packet without a vertex buffer keeps
+        the one bound before
+    */
+    struct DrawPacket
+    {
+        static uint32_t constexpr MaxDescriptors = 4;
+
+        DrawPipelineState const* pipeline;
+        std::array<uint32_t, MaxDescriptors> descriptors;
+        uint32_t descriptorCount;
+        VertexBufferView vertexBuffer;
+        IndexBufferView indexBuffer;
+        uint32_t count;
+        uint32_t instanceCount;
+    };
+
     class IDeviceContext;
 
     class FutureImpl
@@ -579,8 +768,58 @@ namespace ionengine::rhi
         std::unique_ptr<FutureImpl> impl;
     };
 
+    enum class QueryType
+    {
+        // Each region is bracketed by two timestamps, the results are the time elapsed between them
+        Timestamp,
+        PipelineStatistics
+    };
+
+    struct QueryCreateInfo
+    {
+        QueryType queryType;
+        // Number of regions, each one is begun and ended once between two resolves
+        uint32_t count;
+    };
+
+    struct PipelineStatistics
+    {
+        uint64_t inputVertices;
+        uint64_t inputPrimitives;
+        uint64_t vertexShaderInvocations;
+        // Primitives that reached the rasterizer after clipping
+        uint64_t rasterizedPrimitives;
+        uint64_t pixelShaderInvocations;
+        uint64_t computeShaderInvocations;
+    };
+
+    /*!
+        \brief Regions of device work measured by a context
+        \details The results of a resolve are copied to memory the CPU reads from, so they are checked with getResult
+        and read without waiting for the device. Queries of the frames in flight should be kept in a ring, a query is
+        resolved once per submission
+    */
     class Query : public core::ref_counted_object
     {
+      public:
+        virtual ~Query() = default;
+
+        virtual auto getQueryType() const -> QueryType = 0;
+
+        virtual auto getCount() const -> uint32_t = 0;
+
+        /*! \brief Whether the device has written the results of the last resolve, never waits for it
+            \details Also true for a query that was never resolved
+        */
+        virtual auto getResult() const -> bool = 0;
+
+        /*! \brief Elapsed device time of each region in nanoseconds
+            \details Valid while getResult is true, empty for pipeline statistics queries
+        */
+        virtual auto getElapsedTimes() -> std::span<uint64_t const> = 0;
+
+        /*! \brief Statistics of each region, empty for timestamp queries */
+        virtual auto getPipelineStatistics() -> std::span<PipelineStatistics const> = 0;
     };
 
     class IDeviceContext
@@ -588,21 +827,45 @@ namespace ionengine::rhi
       public:
         virtual ~IDeviceContext() = default;
 
+        /*! \brief Transitions the resource between the states
+            \details Barriers are batched until the next command that depends on them, so consecutive calls are
+            recorded as a single barrier command
+        */
         virtual auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
             -> void = 0;
 
         virtual auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
             -> void = 0;
 
+        /*! \brief Begins the region of the query at the index
+            \details Timestamp regions may span render passes. Pipeline statistics regions should begin and end in
+            the same render pass or both outside of one, and are not supported by copy contexts
+        */
+        virtual auto beginQuery(Query* query, uint32_t const index) -> void = 0;
+
+        virtual auto endQuery(Query* query, uint32_t const index) -> void = 0;
+
+        /*! \brief Copies the results of the ended regions to memory the CPU reads them from
+            \details Should be called outside of render passes. Query::getResult turns true once the device executes
+            the submission of the context
+        */
+        virtual auto resolveQuery(Query* query) -> void = 0;
+
         virtual auto execute() -> Future<void> = 0;
     };
 
     class GraphicsContext : public IDeviceContext
     {
       public:
+        /*! \brief Binds the pipeline for the shader and state
+            \return False when the pipeline is still compiling and draws are skipped or use the fallback shader
+        */
         virtual auto setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
                                                 BlendColorInfo const& blendColor,
-                                                std::optional<DepthStencilStageInfo> const depthStencil) -> void = 0;
+                                                std::optional<DepthStencilStageInfo> const depthStencil) -> bool = 0;
+
+        /*! \brief Sets the shader drawn with while pipelines compile in PipelineCompileMode::Fallback */
+        virtual auto setFallbackShader(Shader* shader) -> void = 0;
 
         virtual auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void = 0;
 
@@ -620,11 +883,86 @@ namespace ionengine::rhi
 
         virtual auto draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void = 0;
 
+        /*! \brief Draws drawCount times with the DrawIndirectArguments packed one after another from the offset
+            \details The buffer should be created with BufferUsage::Indirect and be in ResourceState::IndirectArgument.
+            The draws share the descriptors bound with bindDescriptor. Vulkan devices without multiDrawIndirect record
+            one draw per argument, and firstInstance has to stay zero on devices without drawIndirectFirstInstance
+        */
+        virtual auto drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void = 0;
+
+        /*! \brief Draws drawCount times with the DrawIndexedIndirectArguments packed from the offset */
+        virtual auto drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void = 0;
+
+        /*! \brief Same as drawIndirect, but the number of draws is read by the device from a uint32_t of countBuffer
+            \details The count is clamped to maxDrawCount, so culling shaders can write only the visible draws.
+            Throws std::runtime_error on Vulkan devices without drawIndirectCount
+        */
+        virtual auto drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                       uint64_t const countOffset, uint32_t const maxDrawCount) -> void = 0;
+
+        virtual auto drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                              uint64_t const countOffset, uint32_t const maxDrawCount) -> void = 0;
+
         virtual auto setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
             -> void = 0;
 
         virtual auto setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
             -> void = 0;
+
+        /*! \brief Records the packets in order inside the opened render pass
+            \details Gives the same commands as setting the state and drawing packet by packet, but the batch is
+            recorded in one loop of the backend without a virtual call per state. Sorting the packets by pipeline
+            state and buffers lets most of the state be filtered out
+        */
+        virtual auto submitDraws(std::span<DrawPacket const> const packets) -> void = 0;
+    };
+
+    /*!
+        \brief Records dispatches for the async compute queue
+        \details Work on the compute queue runs alongside the graphics queue. The order between them is set only with
+        Future::waitOnContext, e.g. graphics waits for the future of culling before drawing with its results
+    */
+    class ComputeContext : public IDeviceContext
+    {
+      public:
+        /*! \brief Binds the pipeline for the compute shader
+            \details Compute pipelines are compiled in place whatever the compile mode is, since a skipped dispatch
+            would leave its results unwritten
+            \return False when no pipeline is bound and dispatches are skipped
+        */
+        virtual auto setComputePipelineOptions(Shader* shader) -> bool = 0;
+
+        virtual auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void = 0;
+
+        virtual auto dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                              uint32_t const threadGroupCountZ) -> void = 0;
+
+        /*! \brief Dispatches with the thread group counts read by the device from three uint32_t at the offset
+            \details The buffer should be in ResourceState::IndirectArgument
+        */
+        virtual auto dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void = 0;
+
+        /*! \brief Makes the writes of the previous dispatches visible to the next ones, the state stays the same */
+        virtual auto uavBarrier(Buffer* destBuffer) -> void = 0;
+
+        virtual auto uavBarrier(Texture* destTexture) -> void = 0;
+    };
+
+    /*!
+        \brief Bytes of a resource copied back to the host by CopyContext
+        \details The data is a range of the readback ring, which is reused only after the last reference to the
+        result is released. Results should be released before the RHI
+    */
+    class ReadbackData : public core::ref_counted_object
+    {
+      public:
+        virtual ~ReadbackData() = default;
+
+        // Valid once the future of the readback is complete
+        virtual auto getData() const -> std::span<uint8_t const> = 0;
+
+        // Bytes between the starts of two rows of texel blocks, the size of the data for buffers
+        virtual auto getRowPitch() const -> size_t = 0;
     };
 
     class CopyContext : public IDeviceContext
@@ -636,12 +974,20 @@ namespace ionengine::rhi
         virtual auto updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
                                    std::span<uint8_t const> const dataBytes) -> Future<Texture> = 0;
 
-        /*
-        virtual auto readBuffer(core::ref_ptr<Buffer> dest, uint8_t* dataBytes) -> size_t = 0;
+        /*! \brief Copies a range of the buffer into the readback ring without waiting for the device
+            \details The buffer should be created with BufferUsage::CopySource, writes to it should be finished
+            before the copy like for updateBuffer. The future completes after the context is executed and the copy is
+            done. Throws when the range does not fit the ring with the results still held
+        */
+        virtual auto readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+            -> Future<ReadbackData> = 0;
 
-        virtual auto readTexture(core::ref_ptr<Texture> dest, uint32_t const mipLevel, uint8_t* dataBytes)
-            -> size_t = 0;
+        /*! \brief Copies a subresource of the texture into the readback ring without waiting for the device
+            \details The texture should be created with TextureUsage::CopySource and be in the common state, rows of
+            the result are placed by the row pitch of the backend
         */
+        virtual auto readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+            -> Future<ReadbackData> = 0;
     };
 
     class Swapchain
@@ -673,12 +1019,38 @@ namespace ionengine::rhi
 
         virtual auto createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler> = 0;
 
+        virtual auto createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query> = 0;
+
         virtual auto getSwapchain() -> Swapchain* = 0;
 
         virtual auto getGraphicsContext() -> GraphicsContext* = 0;
 
+        /*! \brief Creates a graphics context with its own command memory for recording on another thread
+            \details A context should be used by one thread at a time. Contexts recorded in parallel are submitted
+            together with submitGraphicsContexts
+        */
+        virtual auto createGraphicsContext() -> std::unique_ptr<GraphicsContext> = 0;
+
+        /*! \brief Submits the commands recorded by the contexts as one batch, in the order of the span
+            \details Should be called from one thread while none of the contexts is recording
+        */
+        virtual auto submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void> = 0;
+
         virtual auto getCopyContext() -> CopyContext* = 0;
 
+        virtual auto getComputeContext() -> ComputeContext* = 0;
+
+        /*! \brief Queues the pipelines for compilation on the background compiler threads */
+        virtual auto prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void = 0;
+
+        virtual auto getPipelineCacheStats() const -> PipelineCacheStats = 0;
+
+        virtual auto getUploadStats() const -> UploadStats = 0;
+
+        virtual auto getBarrierStats() const -> BarrierStats = 0;
+
+        virtual auto getStateStats() const -> StateStats = 0;
+
         virtual auto getName() const -> std::string const& = 0;
     };
 } // namespace ionengine::rhi
\ No newline at end of file
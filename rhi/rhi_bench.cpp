@@ -0,0 +1,568 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#include "precompiled.h"
+#include "rhi/buffer_allocator.hpp"
+#include "rhi/descriptor_allocator.hpp"
+#include "rhi/pipeline_cache.hpp"
+#include "rhi/rhi.hpp"
+#include <benchmark/benchmark.h>
+
+using namespace ionengine;
+
+// Records a frame with a number of render passes and draws to measure CPU cost of the backend
+static auto RHI_RecordFrame(benchmark::State& state) -> void
+{
+    uint32_t const drawCount = static_cast<uint32_t>(state.range(0));
+    uint32_t constexpr PassCount = 4;
+
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 1280,
+                                                   .height = 720,
+                                                   .depth = 1,
+                                                   .mipLevels = 1,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::RenderTarget};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    std::array<rhi::RenderPassColorInfo, 1> const colors{rhi::RenderPassColorInfo{
+        .texture = texture.get(), .loadOp = rhi::RenderPassLoadOp::Clear, .storeOp = rhi::RenderPassStoreOp::Store}};
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    for (auto _ : state)
+    {
+        for (uint32_t const i : std::views::iota(0u, PassCount))
+        {
+            graphicsContext->beginRenderPass(colors, std::nullopt);
+            graphicsContext->setViewport(0, 0, 1280, 720);
+            graphicsContext->setScissor(0, 0, 1280, 720);
+            for (uint32_t const j : std::views::iota(0u, drawCount))
+            {
+                graphicsContext->bindDescriptor(0, j);
+                graphicsContext->draw(3, 1);
+            }
+            graphicsContext->endRenderPass();
+        }
+        graphicsContext->execute().wait();
+    }
+    state.SetItemsProcessed(state.iterations() * PassCount * drawCount);
+}
+
+BENCHMARK(RHI_RecordFrame)->Arg(64)->Arg(1024);
+
+// Records the same frame split between a number of threads, each with its own context, and submits them together
+static auto RHI_RecordFrameParallel(benchmark::State& state) -> void
+{
+    uint32_t const threadCount = static_cast<uint32_t>(state.range(0));
+    uint32_t constexpr PassCount = 4;
+    uint32_t constexpr DrawCount = 4096;
+
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 1280,
+                                                   .height = 720,
+                                                   .depth = 1,
+                                                   .mipLevels = 1,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::RenderTarget};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    std::array<rhi::RenderPassColorInfo, 1> const colors{rhi::RenderPassColorInfo{
+        .texture = texture.get(), .loadOp = rhi::RenderPassLoadOp::Clear, .storeOp = rhi::RenderPassStoreOp::Store}};
+
+    std::vector<std::unique_ptr<rhi::GraphicsContext>> graphicsContexts;
+    std::vector<rhi::GraphicsContext*> submitContexts;
+    for (uint32_t const i : std::views::iota(0u, threadCount))
+    {
+        graphicsContexts.emplace_back(rhi->createGraphicsContext());
+        submitContexts.emplace_back(graphicsContexts.back().get());
+    }
+
+    // Workers are kept alive between frames, so thread start up is not measured
+    std::barrier frameBegin(threadCount + 1);
+    std::barrier frameEnd(threadCount + 1);
+    std::atomic<bool> isRunning = true;
+
+    std::vector<std::jthread> threads;
+    for (uint32_t const i : std::views::iota(0u, threadCount))
+    {
+        threads.emplace_back([&, i]() {
+            auto graphicsContext = graphicsContexts[i].get();
+            uint32_t const firstDraw = DrawCount * i / threadCount;
+            uint32_t const lastDraw = DrawCount * (i + 1) / threadCount;
+
+            while (true)
+            {
+                frameBegin.arrive_and_wait();
+                if (!isRunning.load())
+                {
+                    break;
+                }
+
+                for (uint32_t const j : std::views::iota(0u, PassCount))
+                {
+                    graphicsContext->beginRenderPass(colors, std::nullopt);
+                    graphicsContext->setViewport(0, 0, 1280, 720);
+                    graphicsContext->setScissor(0, 0, 1280, 720);
+                    for (uint32_t const k : std::views::iota(firstDraw, lastDraw))
+                    {
+                        graphicsContext->bindDescriptor(0, k);
+                        graphicsContext->draw(3, 1);
+                    }
+                    graphicsContext->endRenderPass();
+                }
+                frameEnd.arrive_and_wait();
+            }
+        });
+    }
+
+    for (auto _ : state)
+    {
+        frameBegin.arrive_and_wait();
+        frameEnd.arrive_and_wait();
+        rhi->submitGraphicsContexts(submitContexts).wait();
+    }
+    state.SetItemsProcessed(state.iterations() * PassCount * DrawCount);
+
+    isRunning.store(false);
+    frameBegin.arrive_and_wait();
+}
+
+BENCHMARK(RHI_RecordFrameParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Draw list shared by the draw submission benchmarks, sorted by shader and then by vertex buffer like a render queue
+struct DrawList
+{
+    static uint32_t constexpr DrawCount = 100000;
+    static uint32_t constexpr ShaderCount = 8;
+    static uint32_t constexpr BufferCount = 64;
+
+    std::vector<core::ref_ptr<rhi::Shader>> shaders;
+    std::vector<core::ref_ptr<rhi::Buffer>> buffers;
+    std::vector<rhi::DrawPipelineState> pipelines;
+    std::vector<rhi::DrawPacket> packets;
+
+    DrawList(rhi::RHI& rhi)
+    {
+        rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back};
+        for (uint32_t const i : std::views::iota(0u, ShaderCount))
+        {
+            shaders.emplace_back(rhi.createShader(rhi::ShaderCreateInfo{.shaderType = rhi::ShaderType::Graphics}));
+            pipelines.emplace_back(rhi::DrawPipelineState{
+                shaders.back().get(), rasterizer, rhi::BlendColorInfo::Opaque(), std::nullopt});
+        }
+        for (uint32_t const i : std::views::iota(0u, BufferCount))
+        {
+            buffers.emplace_back(rhi.createBuffer(rhi::BufferCreateInfo{
+                .size = 4096, .elementStride = 16, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex}));
+        }
+
+        for (uint32_t const i : std::views::iota(0u, DrawCount))
+        {
+            uint32_t const pipelineIndex = i * ShaderCount / DrawCount;
+            uint32_t const bufferIndex = i * BufferCount / DrawCount;
+            packets.emplace_back(rhi::DrawPacket{
+                &pipelines[pipelineIndex], {i, bufferIndex}, 2, {buffers[bufferIndex].get(), 0, 4096}, {}, 3, 1});
+        }
+    }
+};
+
+// Records the draw list with a virtual call per state and draw
+static auto RHI_DrawCalls(benchmark::State& state) -> void
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    DrawList const drawList(*rhi);
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    for (auto _ : state)
+    {
+        graphicsContext->beginRenderPass({}, std::nullopt);
+        for (auto const& packet : drawList.packets)
+        {
+            graphicsContext->setGraphicsPipelineOptions(packet.pipeline->shader, packet.pipeline->rasterizer,
+                                                        packet.pipeline->blendColor, packet.pipeline->depthStencil);
+            for (uint32_t const i : std::views::iota(0u, packet.descriptorCount))
+            {
+                graphicsContext->bindDescriptor(i, packet.descriptors[i]);
+            }
+            graphicsContext->bindVertexBuffer(packet.vertexBuffer.buffer, packet.vertexBuffer.offset,
+                                              packet.vertexBuffer.size);
+            graphicsContext->draw(packet.count, packet.instanceCount);
+        }
+        graphicsContext->endRenderPass();
+        graphicsContext->execute().wait();
+    }
+    state.SetItemsProcessed(state.iterations() * DrawList::DrawCount);
+}
+
+BENCHMARK(RHI_DrawCalls);
+
+// Records the same draw list with a single submitDraws call
+static auto RHI_SubmitDraws(benchmark::State& state) -> void
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    DrawList const drawList(*rhi);
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    for (auto _ : state)
+    {
+        graphicsContext->beginRenderPass({}, std::nullopt);
+        graphicsContext->submitDraws(drawList.packets);
+        graphicsContext->endRenderPass();
+        graphicsContext->execute().wait();
+    }
+    state.SetItemsProcessed(state.iterations() * DrawList::DrawCount);
+}
+
+BENCHMARK(RHI_SubmitDraws);
+
+// Records a chain of passes where each one samples the render targets of the previous one, like the passes of a
+// deferred renderer. Transitions of a pass are batched, so a frame flushes one barrier command per pass
+static auto RHI_BarrierBatch(benchmark::State& state) -> void
+{
+    uint32_t const targetCount = static_cast<uint32_t>(state.range(0));
+    uint32_t constexpr PassCount = 8;
+
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{
+        .width = 1280,
+        .height = 720,
+        .depth = 1,
+        .mipLevels = 1,
+        .format = rhi::Format::RGBA8_UNORM,
+        .dimension = rhi::TextureDimension::_2D,
+        .flags = (rhi::TextureUsageFlags)(rhi::TextureUsage::RenderTarget | rhi::TextureUsage::ShaderResource)};
+
+    // Two sets of targets, the pass writes one of them and reads the other
+    std::array<std::vector<core::ref_ptr<rhi::Texture>>, 2> targets;
+    std::array<std::vector<rhi::RenderPassColorInfo>, 2> colors;
+    for (uint32_t const i : std::views::iota(0u, 2u))
+    {
+        for (uint32_t const j : std::views::iota(0u, targetCount))
+        {
+            auto texture = rhi->createTexture(textureCreateInfo);
+            colors[i].emplace_back(rhi::RenderPassColorInfo{.texture = texture.get(),
+                                                            .loadOp = rhi::RenderPassLoadOp::Clear,
+                                                            .storeOp = rhi::RenderPassStoreOp::Store});
+            targets[i].emplace_back(std::move(texture));
+        }
+    }
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    for (auto& texture : targets[1])
+    {
+        graphicsContext->barrier(texture.get(), rhi::ResourceState::Common, rhi::ResourceState::RenderTarget);
+    }
+    for (auto& texture : targets[0])
+    {
+        graphicsContext->barrier(texture.get(), rhi::ResourceState::Common, rhi::ResourceState::ShaderRead);
+    }
+    graphicsContext->execute().wait();
+
+    rhi::BarrierStats const beginStats = rhi->getBarrierStats();
+    for (auto _ : state)
+    {
+        for (uint32_t const i : std::views::iota(0u, PassCount))
+        {
+            for (auto& texture : targets[i % 2])
+            {
+                graphicsContext->barrier(texture.get(), rhi::ResourceState::ShaderRead,
+                                         rhi::ResourceState::RenderTarget);
+            }
+            for (auto& texture : targets[(i + 1) % 2])
+            {
+                graphicsContext->barrier(texture.get(), rhi::ResourceState::RenderTarget,
+                                         rhi::ResourceState::ShaderRead);
+            }
+
+            graphicsContext->beginRenderPass(colors[i % 2], std::nullopt);
+            for (uint32_t const j : std::views::iota(0u, targetCount))
+            {
+                graphicsContext->bindDescriptor(j, targets[(i + 1) % 2][j]->getDescriptorOffset(
+                                                       rhi::TextureUsage::ShaderResource));
+            }
+            graphicsContext->draw(3, 1);
+            graphicsContext->endRenderPass();
+        }
+        graphicsContext->execute().wait();
+    }
+    rhi::BarrierStats const endStats = rhi->getBarrierStats();
+
+    double const frameCount = static_cast<double>(state.iterations());
+    state.counters["BarriersPerFrame"] = (endStats.barrierCount - beginStats.barrierCount) / frameCount;
+    state.counters["FlushesPerFrame"] = (endStats.flushCount - beginStats.flushCount) / frameCount;
+    state.SetItemsProcessed(state.iterations() * PassCount * targetCount * 2);
+}
+
+BENCHMARK(RHI_BarrierBatch)->Arg(1)->Arg(4)->Arg(8);
+
+namespace
+{
+    class BenchPipeline : public core::ref_counted_object
+    {
+    };
+
+    // Pipeline states a frame switches between, shared by all recording threads
+    struct PipelineLookupData
+    {
+        static uint32_t constexpr StateCount = 256;
+
+        std::vector<rhi::PipelineKey> keys;
+        rhi::ShardedPipelineMap<core::ref_ptr<BenchPipeline>> shardedPipelines;
+        std::mutex mutex;
+        std::unordered_map<rhi::PipelineKey, core::ref_ptr<BenchPipeline>, rhi::PipelineKeyHasher> pipelines;
+
+        PipelineLookupData()
+        {
+            std::array<uint32_t, 1> const renderTargetFormats{static_cast<uint32_t>(rhi::Format::RGBA8_UNORM)};
+            for (uint32_t const i : std::views::iota(0u, StateCount))
+            {
+                rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid,
+                                                          .cullMode = static_cast<rhi::CullMode>(i % 3)};
+                auto const key = rhi::PipelineKey::create(
+                    0x9e3779b97f4a7c15ull * (i / 3 + 1), rasterizer,
+                    i % 2 == 0 ? rhi::BlendColorInfo::Opaque() : rhi::BlendColorInfo::AlphaBlend(),
+                    rhi::DepthStencilStageInfo::Default(), std::span<uint32_t const>(renderTargetFormats),
+                    static_cast<uint32_t>(rhi::Format::D32_FLOAT));
+
+                auto pipeline = core::make_ref<BenchPipeline>();
+                shardedPipelines.emplace(key, pipeline);
+                pipelines.emplace(key, pipeline);
+                keys.emplace_back(key);
+            }
+        }
+
+        static auto get() -> PipelineLookupData&
+        {
+            static PipelineLookupData instance;
+            return instance;
+        }
+    };
+} // namespace
+
+// Pipeline lookups of draw recording behind the single mutex the caches used before
+static auto RHI_PipelineLookupSingleMutex(benchmark::State& state) -> void
+{
+    auto& lookupData = PipelineLookupData::get();
+    uint32_t stateIndex = static_cast<uint32_t>(state.thread_index()) * 31;
+    for (auto _ : state)
+    {
+        core::ref_ptr<BenchPipeline> pipeline;
+        {
+            std::lock_guard lock(lookupData.mutex);
+            pipeline = lookupData.pipelines.find(lookupData.keys[stateIndex % PipelineLookupData::StateCount])->second;
+        }
+        benchmark::DoNotOptimize(pipeline);
+        stateIndex += 7;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(RHI_PipelineLookupSingleMutex)->ThreadRange(1, 8)->UseRealTime();
+
+// The same lookups through ShardedPipelineMap, only a shared lock of one shard is taken
+static auto RHI_PipelineLookupSharded(benchmark::State& state) -> void
+{
+    auto& lookupData = PipelineLookupData::get();
+    uint32_t stateIndex = static_cast<uint32_t>(state.thread_index()) * 31;
+    for (auto _ : state)
+    {
+        auto pipeline = lookupData.shardedPipelines.find(lookupData.keys[stateIndex % PipelineLookupData::StateCount]);
+        benchmark::DoNotOptimize(pipeline);
+        stateIndex += 7;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(RHI_PipelineLookupSharded)->ThreadRange(1, 8)->UseRealTime();
+
+// Packing and hashing the state of a draw, done once per setGraphicsPipelineOptions
+static auto RHI_PipelineKeyCreate(benchmark::State& state) -> void
+{
+    std::array<uint32_t, 2> const renderTargetFormats{static_cast<uint32_t>(rhi::Format::RGBA8_UNORM),
+                                                      static_cast<uint32_t>(rhi::Format::RGBA16_FLOAT)};
+    rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back};
+    uint64_t shaderHash = 0;
+    for (auto _ : state)
+    {
+        auto const key = rhi::PipelineKey::create(
+            ++shaderHash, rasterizer, rhi::BlendColorInfo::Opaque(), rhi::DepthStencilStageInfo::Default(),
+            std::span<uint32_t const>(renderTargetFormats), static_cast<uint32_t>(rhi::Format::D32_FLOAT));
+        benchmark::DoNotOptimize(key.hash);
+    }
+}
+
+BENCHMARK(RHI_PipelineKeyCreate);
+
+// The byte per slot allocator the backends used before, kept here as the baseline
+class LinearDescriptorAllocator
+{
+  public:
+    LinearDescriptorAllocator(uint32_t const size) : free(size, 0x0), offset(0)
+    {
+    }
+
+    auto allocate() -> std::optional<uint32_t>
+    {
+        std::lock_guard lock(mutex);
+
+        for (uint32_t const i : std::views::iota(offset, static_cast<uint32_t>(free.size())))
+        {
+            if (free[i] == 0x0)
+            {
+                free[i] = 0x1;
+                offset = i + 1;
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    auto deallocate(uint32_t const slot) -> void
+    {
+        std::lock_guard lock(mutex);
+
+        free[slot] = 0x0;
+        offset = std::min(offset, slot);
+    }
+
+  private:
+    std::mutex mutex;
+    std::vector<uint8_t> free;
+    uint32_t offset;
+};
+
+/*
+    Streams textures in and out of a bindless heap that is kept 90% full, each iteration releases the descriptor of
+    a random live texture and allocates one for a new texture
+*/
+template <typename Allocator>
+static auto RHI_DescriptorChurn(benchmark::State& state, Allocator& allocator, uint32_t const heapSize) -> void
+{
+    std::vector<uint32_t> liveSlots;
+    for (uint32_t const i : std::views::iota(0u, heapSize / 10 * 9))
+    {
+        liveSlots.emplace_back(allocator.allocate().value());
+    }
+
+    std::minstd_rand random(42);
+    for (auto _ : state)
+    {
+        uint32_t& slot = liveSlots[random() % liveSlots.size()];
+        allocator.deallocate(slot);
+        slot = allocator.allocate().value();
+        benchmark::DoNotOptimize(slot);
+    }
+
+    for (uint32_t const slot : liveSlots)
+    {
+        allocator.deallocate(slot);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static auto RHI_DescriptorChurnLinear(benchmark::State& state) -> void
+{
+    uint32_t const heapSize = static_cast<uint32_t>(state.range(0));
+    LinearDescriptorAllocator allocator(heapSize);
+    RHI_DescriptorChurn(state, allocator, heapSize);
+}
+
+BENCHMARK(RHI_DescriptorChurnLinear)->Arg(16 * 1024)->Arg(256 * 1024)->Arg(1024 * 1024);
+
+static auto RHI_DescriptorChurnBitmap(benchmark::State& state) -> void
+{
+    uint32_t const heapSize = static_cast<uint32_t>(state.range(0));
+    rhi::DescriptorSlotAllocator allocator(4096, heapSize);
+    RHI_DescriptorChurn(state, allocator, heapSize);
+}
+
+BENCHMARK(RHI_DescriptorChurnBitmap)->Arg(16 * 1024)->Arg(256 * 1024)->Arg(1024 * 1024);
+
+// Loads and unloads groups of textures, e.g. a streamed level cell, with a batch call per group
+static auto RHI_DescriptorChurnBatch(benchmark::State& state) -> void
+{
+    uint32_t constexpr HeapSize = 256 * 1024;
+    uint32_t const batchSize = static_cast<uint32_t>(state.range(0));
+
+    rhi::DescriptorSlotAllocator allocator(4096, HeapSize);
+
+    std::vector<std::vector<uint32_t>> groups(HeapSize / 2 / batchSize, std::vector<uint32_t>(batchSize));
+    for (auto& group : groups)
+    {
+        allocator.allocate(group);
+    }
+
+    std::minstd_rand random(42);
+    for (auto _ : state)
+    {
+        auto& group = groups[random() % groups.size()];
+        allocator.deallocate(group);
+        allocator.allocate(group);
+        benchmark::DoNotOptimize(group.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+
+BENCHMARK(RHI_DescriptorChurnBatch)->Arg(16)->Arg(256);
+
+// Threads creating and releasing short lived descriptors in parallel
+static auto RHI_DescriptorChurnThreaded(benchmark::State& state) -> void
+{
+    static rhi::DescriptorSlotAllocator allocator(4096, 256 * 1024);
+
+    std::vector<uint32_t> slots(256);
+    for (auto _ : state)
+    {
+        for (auto& slot : slots)
+        {
+            slot = allocator.allocate().value();
+        }
+        for (uint32_t const slot : slots)
+        {
+            allocator.deallocate(slot);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * slots.size());
+}
+
+BENCHMARK(RHI_DescriptorChurnThreaded)->ThreadRange(1, 8)->UseRealTime();
+
+// Releases and creates small buffers of random sizes in pages kept mostly full, like constant buffers of materials
+// streamed in and out of a scene
+static auto RHI_BufferSubAllocate(benchmark::State& state) -> void
+{
+    rhi::BufferSubAllocator<uint32_t> allocator(4 * 1024 * 1024, 256);
+    uint32_t pageCount = 0;
+    auto const createPage = [&]() { return pageCount++; };
+
+    std::minstd_rand random(42);
+    std::vector<rhi::BufferSubAllocator<uint32_t>::Allocation> liveAllocations;
+    for (uint32_t const i : std::views::iota(0u, 16384u))
+    {
+        liveAllocations.emplace_back(allocator.allocate(256 << (random() % 4), createPage));
+    }
+
+    for (auto _ : state)
+    {
+        auto& allocation = liveAllocations[random() % liveAllocations.size()];
+        allocator.deallocate(allocation);
+        allocation = allocator.allocate(256 << (random() % 4), createPage);
+        benchmark::DoNotOptimize(allocation);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["pages"] = static_cast<double>(allocator.getPageCount());
+}
+
+BENCHMARK(RHI_BufferSubAllocate);
+
+auto main(int32_t argc, char** argv) -> int32_t
+{
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -1,7 +1,15 @@
 // Copyright � 2020-2025 Dmitriy Lukovenko. All rights reserved.
 
 #include "precompiled.h"
+#include "rhi/buffer_allocator.hpp"
+#include "rhi/descriptor_allocator.hpp"
+#include "rhi/pipeline_cache.hpp"
 #include "rhi/rhi.hpp"
+#ifdef IONENGINE_RHI_NULL
+#include "rhi/null/null.hpp"
+#elif defined(IONENGINE_RHI_VULKAN)
+#include "rhi/vulkan/vk.hpp"
+#endif
 #include <gtest/gtest.h>
 
 using namespace ionengine;
@@ -11,6 +19,933 @@ TEST(RHI, DeviceOnly_Test)
     auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
 }
 
+TEST(RHI, PipelineKey_Test)
+{
+    std::array<uint32_t, 2> const renderTargetFormats{1, 2};
+    rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back};
+
+    auto const key = rhi::PipelineKey::create(42, rasterizer, rhi::BlendColorInfo::Opaque(), std::nullopt,
+                                              std::span<uint32_t const>(renderTargetFormats), 0u);
+    auto const sameKey = rhi::PipelineKey::create(42, rasterizer, rhi::BlendColorInfo::Opaque(), std::nullopt,
+                                                  std::span<uint32_t const>(renderTargetFormats), 0u);
+    auto const depthKey =
+        rhi::PipelineKey::create(42, rasterizer, rhi::BlendColorInfo::Opaque(), rhi::DepthStencilStageInfo::Default(),
+                                 std::span<uint32_t const>(renderTargetFormats), 0u);
+    ASSERT_EQ(key, sameKey);
+    ASSERT_EQ(key.hash, sameKey.hash);
+    ASSERT_NE(key, depthKey);
+    ASSERT_NE(key.hash, depthKey.hash);
+
+    rhi::ShardedPipelineMap<uint32_t> pipelines;
+    ASSERT_FALSE(pipelines.find(key).has_value());
+    ASSERT_EQ(pipelines.emplace(key, 1), 1);
+    ASSERT_EQ(pipelines.emplace(sameKey, 2), 1);
+    ASSERT_EQ(pipelines.emplace(depthKey, 3), 3);
+    ASSERT_EQ(pipelines.find(sameKey).value(), 1);
+    ASSERT_EQ(pipelines.size(), 2);
+
+    pipelines.clear();
+    ASSERT_EQ(pipelines.size(), 0);
+}
+
+TEST(RHI, DescriptorSlotAllocator_Test)
+{
+    rhi::DescriptorSlotAllocator allocator(64, 1000);
+    ASSERT_EQ(allocator.getCapacity(), 64);
+
+    std::vector<uint32_t> slots(1000);
+    ASSERT_TRUE(allocator.allocate(slots));
+    ASSERT_EQ(allocator.getCapacity(), 1000);
+    ASSERT_EQ(allocator.getAllocatedCount(), 1000);
+    ASSERT_FALSE(allocator.allocate().has_value());
+
+    std::vector<uint32_t> sortedSlots = slots;
+    std::sort(sortedSlots.begin(), sortedSlots.end());
+    ASSERT_TRUE(std::adjacent_find(sortedSlots.begin(), sortedSlots.end()) == sortedSlots.end());
+    ASSERT_LT(sortedSlots.back(), 1000);
+
+    allocator.deallocate(slots[500]);
+    ASSERT_EQ(allocator.allocate().value(), slots[500]);
+
+    // A failed batch does not take any slot
+    allocator.deallocate(std::span<uint32_t const>(slots.data(), 10));
+    std::vector<uint32_t> batch(11);
+    ASSERT_FALSE(allocator.allocate(batch));
+    ASSERT_EQ(allocator.getAllocatedCount(), 990);
+    batch.resize(10);
+    ASSERT_TRUE(allocator.allocate(batch));
+
+    allocator.deallocate(slots);
+    ASSERT_EQ(allocator.getAllocatedCount(), 0);
+    ASSERT_TRUE(allocator.allocate(slots));
+}
+
+TEST(RHI, BuddyAllocator_Test)
+{
+    rhi::BuddyAllocator allocator(4096, 256);
+
+    // Sizes are rounded up to a power of two, offsets are aligned to them
+    auto const first = allocator.allocate(100).value();
+    auto const second = allocator.allocate(1000).value();
+    auto const third = allocator.allocate(256).value();
+    ASSERT_EQ(first.offset, 0);
+    ASSERT_EQ(second.offset, 1024);
+    ASSERT_EQ(third.offset, 256);
+    ASSERT_EQ(allocator.getFreeSize(), 4096 - 256 - 1024 - 256);
+
+    ASSERT_FALSE(allocator.allocate(4096).has_value());
+    auto const fourth = allocator.allocate(2048).value();
+    ASSERT_EQ(fourth.offset, 2048);
+    ASSERT_FALSE(allocator.allocate(1024).has_value());
+
+    // Freed buddies are merged back into the whole page
+    allocator.deallocate(first);
+    allocator.deallocate(third);
+    allocator.deallocate(second);
+    allocator.deallocate(fourth);
+    ASSERT_EQ(allocator.getFreeSize(), 4096);
+    ASSERT_EQ(allocator.allocate(4096).value().offset, 0);
+}
+
+TEST(RHI, BufferSubAllocator_Test)
+{
+    uint32_t pageCount = 0;
+    rhi::BufferSubAllocator<uint32_t> allocator(64 * 1024, 256);
+
+    std::vector<rhi::BufferSubAllocator<uint32_t>::Allocation> allocations;
+    for (uint32_t i = 0; i < 512; ++i)
+    {
+        allocations.emplace_back(allocator.allocate(256, [&]() { return pageCount++; }));
+    }
+    ASSERT_EQ(allocator.getPageCount(), 2);
+    ASSERT_EQ(allocator.getAllocatedCount(), 512);
+    ASSERT_EQ(*allocations.front().page, 0);
+    ASSERT_EQ(*allocations.back().page, 1);
+
+    // Released ranges are taken again before a new page is created
+    allocator.deallocate(allocations[10]);
+    auto const allocation = allocator.allocate(200, [&]() { return pageCount++; });
+    ASSERT_EQ(allocation.pageIndex, 0);
+    ASSERT_EQ(allocation.block.offset, allocations[10].block.offset);
+    ASSERT_EQ(pageCount, 2);
+}
+
+#ifdef IONENGINE_RHI_NULL
+TEST(RHI, NullRecording_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    ASSERT_EQ(rhi->getName(), "Null");
+
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 256,
+                                                   .height = 256,
+                                                   .depth = 1,
+                                                   .mipLevels = 1,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::RenderTarget};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    std::array<rhi::RenderPassColorInfo, 1> const colors{rhi::RenderPassColorInfo{
+        .texture = texture.get(), .loadOp = rhi::RenderPassLoadOp::Clear, .storeOp = rhi::RenderPassStoreOp::Store}};
+
+    graphicsContext->barrier(texture.get(), rhi::ResourceState::Common, rhi::ResourceState::RenderTarget);
+    graphicsContext->beginRenderPass(colors, std::nullopt);
+    graphicsContext->setViewport(0, 0, 256, 256);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        graphicsContext->draw(3, 1);
+    }
+    graphicsContext->endRenderPass();
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    ASSERT_EQ(commandStream.getCommands().size(), 7);
+
+    graphicsContext->execute().wait();
+    ASSERT_TRUE(commandStream.getCommands().empty());
+
+    auto commands = commandStream.getSubmittedCommands();
+    ASSERT_EQ(commands.size(), 8);
+    ASSERT_EQ(commands[0].commandType, rhi::NullCommandType::Barrier);
+    ASSERT_EQ(commands[0].resource, texture.get());
+    ASSERT_EQ(commands[1].commandType, rhi::NullCommandType::BeginRenderPass);
+    ASSERT_EQ(commands[1].arguments[0], 1);
+    ASSERT_EQ(commands[3].commandType, rhi::NullCommandType::Draw);
+    ASSERT_EQ(commands[3].arguments[0], 3);
+    ASSERT_EQ(commands[7].commandType, rhi::NullCommandType::Execute);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::Draw), 3);
+    ASSERT_EQ(commandStream.getTotalCommandCount(), 8);
+
+    commandStream.resetCounters();
+    ASSERT_EQ(commandStream.getTotalCommandCount(), 0);
+}
+
+TEST(RHI, NullCopy_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 16, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::ConstantBuffer});
+
+    std::array<uint8_t, 4> const dataBytes{1, 2, 3, 4};
+    auto result = rhi->getCopyContext()->updateBuffer(buffer, 4, dataBytes).get();
+    ASSERT_EQ(result.get(), buffer.get());
+
+    auto bufferData = static_cast<rhi::NullBuffer*>(buffer.get())->getData();
+    ASSERT_TRUE(std::ranges::equal(bufferData.subspan(4, 4), dataBytes));
+
+    ASSERT_THROW(rhi->getCopyContext()->updateBuffer(buffer, 14, dataBytes), std::runtime_error);
+
+    auto& commandStream = static_cast<rhi::NullCopyContext*>(rhi->getCopyContext())->getCommandStream();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::UpdateBuffer), 1);
+
+    rhi->getCopyContext()->execute();
+    auto const uploadStats = rhi->getUploadStats();
+    ASSERT_EQ(uploadStats.uploadedBytes, dataBytes.size());
+    ASSERT_EQ(uploadStats.submissionCount, 1);
+}
+
+TEST(RHI, NullMappedBuffer_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 256,
+        .elementStride = 4,
+        .flags = (rhi::BufferUsageFlags)(rhi::BufferUsage::ConstantBuffer | rhi::BufferUsage::MapWrite)});
+    auto deviceBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 256, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::ConstantBuffer});
+
+    // Mapped on creation, so per-frame data is written without going through the copy context
+    uint8_t* mappedBytes = buffer->getMappedPointer();
+    ASSERT_NE(mappedBytes, nullptr);
+    ASSERT_EQ(deviceBuffer->getMappedPointer(), nullptr);
+
+    std::array<uint8_t, 4> const dataBytes{1, 2, 3, 4};
+    std::memcpy(mappedBytes + 8, dataBytes.data(), dataBytes.size());
+    buffer->flushMappedRange(8, dataBytes.size());
+
+    auto bufferData = static_cast<rhi::NullBuffer*>(buffer.get())->getData();
+    ASSERT_TRUE(std::ranges::equal(bufferData.subspan(8, 4), dataBytes));
+
+    // The pointer stays the same for the whole life of the buffer
+    rhi->getCopyContext()->updateBuffer(buffer, 0, dataBytes).wait();
+    ASSERT_EQ(buffer->getMappedPointer(), mappedBytes);
+    ASSERT_TRUE(std::ranges::equal(std::span<uint8_t const>(mappedBytes, 4), dataBytes));
+}
+
+TEST(RHI, NullReadback_Test)
+{
+    rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = 64 * 1024, .numBuffering = 1, .readbackBufferSize = 64};
+    auto rhi = rhi::RHI::create(rhiCreateInfo);
+
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 32,
+        .elementStride = 4,
+        .flags = (rhi::BufferUsageFlags)(rhi::BufferUsage::ConstantBuffer | rhi::BufferUsage::CopySource)});
+    std::array<uint8_t, 4> const dataBytes{1, 2, 3, 4};
+    rhi->getCopyContext()->updateBuffer(buffer, 8, dataBytes).wait();
+
+    auto firstResult = rhi->getCopyContext()->readBuffer(buffer, 8, 16).get();
+    ASSERT_EQ(firstResult->getData().size(), 16);
+    ASSERT_EQ(firstResult->getRowPitch(), 16);
+    ASSERT_TRUE(std::ranges::equal(firstResult->getData().subspan(0, 4), dataBytes));
+
+    // Ranges are held by the results, so the ring is full until they are released and the copies are submitted
+    auto secondResult = rhi->getCopyContext()->readBuffer(buffer, 0, 32).get();
+    ASSERT_THROW(rhi->getCopyContext()->readBuffer(buffer, 0, 32), std::runtime_error);
+    firstResult = nullptr;
+    ASSERT_THROW(rhi->getCopyContext()->readBuffer(buffer, 0, 32), std::runtime_error);
+    rhi->getCopyContext()->execute();
+    secondResult = nullptr;
+    auto thirdResult = rhi->getCopyContext()->readBuffer(buffer, 0, 32).get();
+    ASSERT_TRUE(std::ranges::equal(thirdResult->getData().subspan(8, 4), dataBytes));
+
+    auto texture = rhi->createTexture(rhi::TextureCreateInfo{
+        .width = 4,
+        .height = 2,
+        .depth = 1,
+        .mipLevels = 1,
+        .format = rhi::Format::R32_FLOAT,
+        .dimension = rhi::TextureDimension::_2D,
+        .flags = (rhi::TextureUsageFlags)(rhi::TextureUsage::ShaderResource | rhi::TextureUsage::CopySource)});
+    rhi->getCopyContext()->execute();
+    thirdResult = nullptr;
+    auto textureResult = rhi->getCopyContext()->readTexture(texture, 0).get();
+    ASSERT_EQ(textureResult->getRowPitch(), 16);
+    ASSERT_EQ(textureResult->getData().size(), 32);
+
+    auto deviceBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 16, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::ConstantBuffer});
+    ASSERT_THROW(rhi->getCopyContext()->readBuffer(deviceBuffer, 0, 16), std::invalid_argument);
+    ASSERT_THROW(rhi->getCopyContext()->readBuffer(buffer, 16, 32), std::invalid_argument);
+
+    auto& commandStream = static_cast<rhi::NullCopyContext*>(rhi->getCopyContext())->getCommandStream();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::ReadBuffer), 3);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::ReadTexture), 1);
+    ASSERT_EQ(rhi->getUploadStats().readbackBytes, 16 + 32 + 32 + 32);
+
+    // Results can outlive the RHI, they return no data after it
+    rhi = nullptr;
+    ASSERT_TRUE(textureResult->getData().empty());
+}
+
+TEST(RHI, NullSwapchain_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default(),
+                                rhi::SwapchainCreateInfo{.window = nullptr, .instance = nullptr, .frameCount = 2});
+
+    auto swapchain = rhi->getSwapchain();
+    ASSERT_NE(swapchain, nullptr);
+
+    rhi::Texture* firstBackBuffer = swapchain->getBackBuffer();
+    swapchain->presentBackBuffer().wait();
+    ASSERT_NE(swapchain->getBackBuffer(), firstBackBuffer);
+    swapchain->presentBackBuffer().wait();
+    ASSERT_EQ(swapchain->getBackBuffer(), firstBackBuffer);
+
+    swapchain->resizeBackBuffers(640, 480);
+    ASSERT_EQ(swapchain->getBackBuffer()->getWidth(), 640);
+    ASSERT_EQ(swapchain->getBackBuffer()->getHeight(), 480);
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(rhi->getGraphicsContext())->getCommandStream();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::Present), 2);
+}
+
+TEST(RHI, NullHeadlessSwapchain_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default(),
+                                rhi::SwapchainCreateInfo{.window = nullptr,
+                                                         .instance = nullptr,
+                                                         .frameCount = 2,
+                                                         .mode = rhi::SwapchainMode::Headless,
+                                                         .width = 320,
+                                                         .height = 240});
+
+    auto swapchain = rhi->getSwapchain();
+    rhi::Texture* backBuffer = swapchain->getBackBuffer();
+    ASSERT_EQ(backBuffer->getWidth(), 320);
+    ASSERT_EQ(backBuffer->getHeight(), 240);
+    ASSERT_TRUE(backBuffer->getFlags() & rhi::TextureUsage::CopySource);
+
+    // Presented frames are read back without waiting on the CPU
+    auto copyContext = rhi->getCopyContext();
+    swapchain->presentBackBuffer().waitOnContext(copyContext);
+    auto readbackResult = copyContext->readTexture(core::ref_ptr<rhi::Texture>(backBuffer), 0);
+    copyContext->execute();
+
+    auto readbackData = readbackResult.get();
+    ASSERT_EQ(readbackData->getData().size(), readbackData->getRowPitch() * 240);
+    ASSERT_NE(swapchain->getBackBuffer(), backBuffer);
+}
+
+TEST(RHI, NullParallelRecording_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 256,
+                                                   .height = 256,
+                                                   .depth = 1,
+                                                   .mipLevels = 1,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::RenderTarget};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    std::array<rhi::RenderPassColorInfo, 1> const colors{rhi::RenderPassColorInfo{
+        .texture = texture.get(), .loadOp = rhi::RenderPassLoadOp::Load, .storeOp = rhi::RenderPassStoreOp::Store}};
+
+    std::array<std::unique_ptr<rhi::GraphicsContext>, 4> graphicsContexts;
+    std::array<rhi::GraphicsContext*, 4> submitContexts;
+    for (uint32_t const i : std::views::iota(0u, 4u))
+    {
+        graphicsContexts[i] = rhi->createGraphicsContext();
+        submitContexts[i] = graphicsContexts[i].get();
+    }
+
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t const i : std::views::iota(0u, 4u))
+        {
+            threads.emplace_back([&, i]() {
+                graphicsContexts[i]->beginRenderPass(colors, std::nullopt);
+                graphicsContexts[i]->setViewport(0, 0, 256, 256);
+                for (uint32_t j = 0; j <= i; ++j)
+                {
+                    graphicsContexts[i]->draw(3, 1);
+                }
+                graphicsContexts[i]->endRenderPass();
+            });
+        }
+    }
+
+    rhi->submitGraphicsContexts(submitContexts).wait();
+
+    for (uint32_t const i : std::views::iota(0u, 4u))
+    {
+        auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContexts[i].get())->getCommandStream();
+        ASSERT_TRUE(commandStream.getCommands().empty());
+        ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::Draw), i + 1);
+
+        // All the contexts are signaled with the same fence value
+        auto commands = commandStream.getSubmittedCommands();
+        ASSERT_EQ(commands.back().commandType, rhi::NullCommandType::Execute);
+        ASSERT_EQ(commands.back().arguments[0], 1);
+    }
+}
+
+TEST(RHI, NullCompute_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 64, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::UnorderedAccess});
+
+    auto computeContext = rhi->getComputeContext();
+    computeContext->bindDescriptor(0, buffer->getDescriptorOffset(rhi::BufferUsage::UnorderedAccess));
+    computeContext->dispatch(8, 4, 1);
+    computeContext->uavBarrier(buffer.get());
+    computeContext->barrier(buffer.get(), rhi::ResourceState::UnorderedAccess, rhi::ResourceState::IndirectArgument);
+    computeContext->dispatchIndirect(buffer.get(), 16);
+    auto computeFuture = computeContext->execute();
+
+    // Graphics work that consumes the results is ordered after the compute queue
+    auto graphicsContext = rhi->getGraphicsContext();
+    computeFuture.waitOnContext(graphicsContext);
+    graphicsContext->execute().wait();
+
+    auto& computeStream = static_cast<rhi::NullComputeContext*>(computeContext)->getCommandStream();
+    auto computeCommands = computeStream.getSubmittedCommands();
+    ASSERT_EQ(computeCommands.size(), 6);
+    ASSERT_EQ(computeCommands[1].commandType, rhi::NullCommandType::Dispatch);
+    ASSERT_EQ(computeCommands[1].arguments[1], 4);
+    ASSERT_EQ(computeCommands[2].commandType, rhi::NullCommandType::UAVBarrier);
+    ASSERT_EQ(computeCommands[2].resource, buffer.get());
+    ASSERT_EQ(computeCommands[4].commandType, rhi::NullCommandType::DispatchIndirect);
+    ASSERT_EQ(computeCommands[4].arguments[0], 16);
+    ASSERT_EQ(computeCommands[5].arguments[0], 1);
+
+    auto& graphicsStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    auto graphicsCommands = graphicsStream.getSubmittedCommands();
+    ASSERT_EQ(graphicsCommands[0].commandType, rhi::NullCommandType::Wait);
+    ASSERT_EQ(graphicsCommands[0].arguments[0], 1);
+    ASSERT_EQ(graphicsCommands[1].arguments[0], 2);
+}
+
+TEST(RHI, NullBarrierBatch_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{
+        .width = 64,
+        .height = 64,
+        .depth = 1,
+        .mipLevels = 1,
+        .format = rhi::Format::RGBA8_UNORM,
+        .dimension = rhi::TextureDimension::_2D,
+        .flags = (rhi::TextureUsageFlags)(rhi::TextureUsage::RenderTarget | rhi::TextureUsage::ShaderResource)};
+    auto colorTexture = rhi->createTexture(textureCreateInfo);
+    auto normalTexture = rhi->createTexture(textureCreateInfo);
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    std::array<rhi::RenderPassColorInfo, 2> const colors{
+        rhi::RenderPassColorInfo{.texture = colorTexture.get(),
+                                 .loadOp = rhi::RenderPassLoadOp::Clear,
+                                 .storeOp = rhi::RenderPassStoreOp::Store},
+        rhi::RenderPassColorInfo{.texture = normalTexture.get(),
+                                 .loadOp = rhi::RenderPassLoadOp::Clear,
+                                 .storeOp = rhi::RenderPassStoreOp::Store}};
+
+    graphicsContext->barrier(colorTexture.get(), rhi::ResourceState::Common, rhi::ResourceState::ShaderRead);
+    // The same texture again, so the pending batch is flushed first
+    graphicsContext->barrier(colorTexture.get(), rhi::ResourceState::ShaderRead, rhi::ResourceState::RenderTarget);
+    graphicsContext->barrier(normalTexture.get(), rhi::ResourceState::Common, rhi::ResourceState::RenderTarget);
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    ASSERT_EQ(commandStream.getCommands().size(), 1);
+
+    graphicsContext->beginRenderPass(colors, std::nullopt);
+    graphicsContext->endRenderPass();
+    graphicsContext->execute().wait();
+
+    auto commands = commandStream.getSubmittedCommands();
+    ASSERT_EQ(commands.size(), 6);
+    ASSERT_EQ(commands[0].arguments[1], static_cast<uint64_t>(rhi::ResourceState::ShaderRead));
+    ASSERT_EQ(commands[1].resource, colorTexture.get());
+    ASSERT_EQ(commands[2].resource, normalTexture.get());
+    ASSERT_EQ(commands[3].commandType, rhi::NullCommandType::BeginRenderPass);
+
+    auto const barrierStats = rhi->getBarrierStats();
+    ASSERT_EQ(barrierStats.barrierCount, 3);
+    ASSERT_EQ(barrierStats.flushCount, 2);
+}
+
+TEST(RHI, NullQuery_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto query = rhi->createQuery(rhi::QueryCreateInfo{.queryType = rhi::QueryType::Timestamp, .count = 2});
+    ASSERT_TRUE(query->getResult());
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->beginQuery(query.get(), 0);
+    graphicsContext->setViewport(0, 0, 64, 64);
+    graphicsContext->setScissor(0, 0, 64, 64);
+    graphicsContext->endQuery(query.get(), 0);
+    graphicsContext->beginQuery(query.get(), 1);
+    graphicsContext->endQuery(query.get(), 1);
+    graphicsContext->resolveQuery(query.get());
+
+    // Results are readable only after the submission
+    ASSERT_FALSE(query->getResult());
+    graphicsContext->execute();
+    ASSERT_TRUE(query->getResult());
+
+    // A null timestamp advances by one per recorded command
+    auto const elapsedTimes = query->getElapsedTimes();
+    ASSERT_EQ(elapsedTimes.size(), 2);
+    ASSERT_EQ(elapsedTimes[0], 3);
+    ASSERT_EQ(elapsedTimes[1], 1);
+    ASSERT_TRUE(query->getPipelineStatistics().empty());
+
+    auto statisticsQuery =
+        rhi->createQuery(rhi::QueryCreateInfo{.queryType = rhi::QueryType::PipelineStatistics, .count = 1});
+    ASSERT_EQ(statisticsQuery->getPipelineStatistics().size(), 1);
+    ASSERT_THROW(rhi->getCopyContext()->beginQuery(statisticsQuery.get(), 0), std::invalid_argument);
+}
+
+TEST(RHI, NullIndirectDraw_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    uint32_t const maxDrawCount = 64;
+    auto argumentBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = sizeof(rhi::DrawIndexedIndirectArguments) * maxDrawCount,
+        .elementStride = sizeof(rhi::DrawIndexedIndirectArguments),
+        .flags = (rhi::BufferUsageFlags)(rhi::BufferUsage::UnorderedAccess | rhi::BufferUsage::Indirect)});
+    auto countBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 16,
+        .elementStride = 4,
+        .flags = (rhi::BufferUsageFlags)(rhi::BufferUsage::UnorderedAccess | rhi::BufferUsage::Indirect)});
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->barrier(argumentBuffer.get(), rhi::ResourceState::UnorderedAccess,
+                             rhi::ResourceState::IndirectArgument);
+    graphicsContext->barrier(countBuffer.get(), rhi::ResourceState::UnorderedAccess,
+                             rhi::ResourceState::IndirectArgument);
+    graphicsContext->beginRenderPass({}, std::nullopt);
+    graphicsContext->drawIndexedIndirect(argumentBuffer.get(), 0, maxDrawCount);
+    graphicsContext->drawIndexedIndirectCount(argumentBuffer.get(), 0, countBuffer.get(), 4, maxDrawCount);
+    graphicsContext->drawIndirect(argumentBuffer.get(), sizeof(rhi::DrawIndirectArguments), 2);
+    graphicsContext->endRenderPass();
+    graphicsContext->execute().wait();
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    auto commands = commandStream.getSubmittedCommands();
+    ASSERT_EQ(commands.size(), 8);
+    ASSERT_EQ(commands[3].commandType, rhi::NullCommandType::DrawIndexedIndirect);
+    ASSERT_EQ(commands[3].resource, argumentBuffer.get());
+    ASSERT_EQ(commands[3].arguments[1], maxDrawCount);
+    ASSERT_EQ(commands[4].commandType, rhi::NullCommandType::DrawIndexedIndirectCount);
+    ASSERT_EQ(commands[4].arguments[1], 4);
+    ASSERT_EQ(commands[4].arguments[2], maxDrawCount);
+    ASSERT_EQ(commands[5].commandType, rhi::NullCommandType::DrawIndirect);
+    ASSERT_EQ(commands[5].arguments[0], sizeof(rhi::DrawIndirectArguments));
+}
+
+TEST(RHI, NullStateFilter_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto shader = rhi->createShader(rhi::ShaderCreateInfo{.shaderType = rhi::ShaderType::Graphics});
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 256, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex});
+
+    rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back};
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->beginRenderPass({}, std::nullopt);
+    for (uint32_t const i : std::views::iota(0u, 4u))
+    {
+        // A sorted draw list sets the same state for neighbouring draws
+        graphicsContext->setGraphicsPipelineOptions(shader.get(), rasterizer, rhi::BlendColorInfo::Opaque(),
+                                                    std::nullopt);
+        graphicsContext->bindVertexBuffer(buffer.get(), 0, 128);
+        graphicsContext->setViewport(0, 0, 64, 64);
+        graphicsContext->setScissor(0, 0, 64, 64);
+        graphicsContext->bindDescriptor(0, i / 2);
+        graphicsContext->draw(3, 1);
+    }
+    graphicsContext->bindVertexBuffer(buffer.get(), 128, 128);
+    graphicsContext->endRenderPass();
+    graphicsContext->execute().wait();
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::SetGraphicsPipelineOptions), 1);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::BindVertexBuffer), 2);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::SetViewport), 1);
+    // The first descriptor matches the initial binding data, so only the change to 1 is recorded
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::BindDescriptor), 1);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::Draw), 4);
+
+    rhi::StateStats const stats = rhi->getStateStats();
+    ASSERT_EQ(stats.issuedCount, 6);
+    ASSERT_EQ(stats.elidedCount, 15);
+
+    // The state is forgotten with the command list, so the next one sets it again
+    graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->setViewport(0, 0, 64, 64);
+    graphicsContext->execute().wait();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::SetViewport), 2);
+}
+
+TEST(RHI, NullSubmitDraws_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto shader = rhi->createShader(rhi::ShaderCreateInfo{.shaderType = rhi::ShaderType::Graphics});
+    auto otherShader = rhi->createShader(rhi::ShaderCreateInfo{.shaderType = rhi::ShaderType::Graphics});
+    auto vertexBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 256, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex});
+    auto indexBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 64, .elementStride = 4, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Index});
+
+    rhi::RasterizerStageInfo const rasterizer{.fillMode = rhi::FillMode::Solid, .cullMode = rhi::CullMode::Back};
+    std::array<rhi::DrawPipelineState, 2> const pipelines{
+        rhi::DrawPipelineState{shader.get(), rasterizer, rhi::BlendColorInfo::Opaque(), std::nullopt},
+        rhi::DrawPipelineState{otherShader.get(), rasterizer, rhi::BlendColorInfo::Opaque(), std::nullopt}};
+
+    rhi::VertexBufferView const vertexBufferView{.buffer = vertexBuffer.get(), .offset = 0, .size = 128};
+    rhi::IndexBufferView const indexBufferView{
+        .buffer = indexBuffer.get(), .offset = 0, .size = 64, .format = rhi::Format::R32_UINT};
+
+    std::array<rhi::DrawPacket, 4> const packets{
+        rhi::DrawPacket{&pipelines[0], {0}, 1, vertexBufferView, {}, 3, 1},
+        rhi::DrawPacket{&pipelines[0], {1}, 1, vertexBufferView, {}, 3, 1},
+        rhi::DrawPacket{&pipelines[1], {1}, 1, vertexBufferView, indexBufferView, 6, 1},
+        rhi::DrawPacket{&pipelines[1], {2}, 1, {}, indexBufferView, 6, 1}};
+
+    auto graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->beginRenderPass({}, std::nullopt);
+    graphicsContext->submitDraws(packets);
+    graphicsContext->endRenderPass();
+    graphicsContext->execute().wait();
+
+    auto& commandStream = static_cast<rhi::NullGraphicsContext*>(graphicsContext)->getCommandStream();
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::SetGraphicsPipelineOptions), 2);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::BindVertexBuffer), 1);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::BindIndexBuffer), 1);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::BindDescriptor), 2);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::Draw), 2);
+    ASSERT_EQ(commandStream.getCommandCount(rhi::NullCommandType::DrawIndexed), 2);
+
+    // Packets with the same pipeline state pointer do not reach the cache for the pipeline
+    rhi::StateStats const stats = rhi->getStateStats();
+    ASSERT_EQ(stats.issuedCount, 6);
+    ASSERT_EQ(stats.elidedCount, 5);
+}
+#endif
+
+#ifdef IONENGINE_RHI_VULKAN
+// Runs on a software driver as well, e.g. VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+TEST(RHI, VulkanStagingUpload_Test)
+{
+    rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = 64 * 1024, .numBuffering = 1};
+    auto rhi = rhi::RHI::create(rhiCreateInfo);
+    auto copyContext = rhi->getCopyContext();
+
+    // Larger than the staging buffer, so the upload is split into chunks and the ring wraps around
+    std::vector<uint8_t> dataBytes(rhiCreateInfo.stagingBufferSize * 3 + 123);
+    for (size_t const i : std::views::iota(size_t{0}, dataBytes.size()))
+    {
+        dataBytes[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = dataBytes.size(), .elementStride = 1, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::MapRead});
+    auto bufferResult = copyContext->updateBuffer(buffer, 0, dataBytes);
+
+    // Small uploads share one submission
+    std::vector<core::ref_ptr<rhi::Buffer>> smallBuffers;
+    std::vector<rhi::Future<rhi::Buffer>> smallResults;
+    for (uint32_t const i : std::views::iota(0u, 16u))
+    {
+        auto smallBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+            .size = 256, .elementStride = 1, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::MapRead});
+        smallResults.emplace_back(
+            copyContext->updateBuffer(smallBuffer, 0, std::span<uint8_t const>(dataBytes).subspan(i * 256, 256)));
+        smallBuffers.emplace_back(std::move(smallBuffer));
+    }
+
+    copyContext->execute().wait();
+    ASSERT_TRUE(bufferResult.getResult());
+    ASSERT_TRUE(std::ranges::all_of(smallResults, [](auto const& result) { return result.getResult(); }));
+
+    auto vkBuffer = static_cast<rhi::VKBuffer*>(buffer.get());
+    ASSERT_TRUE(std::equal(dataBytes.begin(), dataBytes.end(), vkBuffer->getMappedPointer()));
+
+    for (uint32_t const i : std::views::iota(0u, 16u))
+    {
+        auto vkSmallBuffer = static_cast<rhi::VKBuffer*>(smallBuffers[i].get());
+        ASSERT_TRUE(std::equal(dataBytes.begin() + i * 256, dataBytes.begin() + (i + 1) * 256,
+                               vkSmallBuffer->getMappedPointer()));
+    }
+
+    ASSERT_THROW(copyContext->updateBuffer(buffer, dataBytes.size() - 4, std::span<uint8_t const>(dataBytes)),
+                 std::runtime_error);
+}
+
+TEST(RHI, VulkanTextureUpload_Test)
+{
+    rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = 64 * 1024, .numBuffering = 1};
+    auto rhi = rhi::RHI::create(rhiCreateInfo);
+
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 256,
+                                                   .height = 256,
+                                                   .depth = 1,
+                                                   .mipLevels = 2,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags = (rhi::TextureUsageFlags)rhi::TextureUsage::CopyDest};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    // The first mip level takes 256 KB and goes through the ring in several submissions
+    std::vector<uint8_t> const mip0Bytes(256 * 256 * 4, 0xff);
+    std::vector<uint8_t> const mip1Bytes(128 * 128 * 4, 0x7f);
+
+    auto copyContext = rhi->getCopyContext();
+    auto mip0Result = copyContext->updateTexture(texture, 0, mip0Bytes);
+    auto mip1Result = copyContext->updateTexture(texture, 1, mip1Bytes);
+    copyContext->execute().wait();
+
+    ASSERT_TRUE(mip0Result.getResult());
+    ASSERT_TRUE(mip1Result.getResult());
+    ASSERT_THROW(copyContext->updateTexture(texture, 1, std::span<uint8_t const>(mip1Bytes).subspan(4)),
+                 std::invalid_argument);
+}
+
+TEST(RHI, VulkanTransferHandoff_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+
+    rhi::TextureCreateInfo const textureCreateInfo{
+        .width = 64,
+        .height = 64,
+        .depth = 1,
+        .mipLevels = 1,
+        .format = rhi::Format::RGBA8_UNORM,
+        .dimension = rhi::TextureDimension::_2D,
+        .flags = (rhi::TextureUsageFlags)(rhi::TextureUsage::CopyDest | rhi::TextureUsage::ShaderResource)};
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    std::vector<uint8_t> const dataBytes(64 * 64 * 4, 0x3f);
+    rhi->getCopyContext()->updateTexture(texture, 0, dataBytes);
+
+    // The graphics queue acquires the texture released by the copy queue and waits for it on the device only
+    auto copyResult = rhi->getCopyContext()->execute();
+    copyResult.waitOnContext(rhi->getGraphicsContext());
+    rhi->getGraphicsContext()->barrier(texture.get(), rhi::ResourceState::Common, rhi::ResourceState::ShaderRead);
+    rhi->getGraphicsContext()->execute().wait();
+
+    ASSERT_TRUE(copyResult.getResult());
+
+    auto const uploadStats = rhi->getUploadStats();
+    ASSERT_EQ(uploadStats.uploadedBytes, dataBytes.size());
+    ASSERT_EQ(uploadStats.submissionCount, 1);
+    ASSERT_EQ(uploadStats.handoffCount, 1);
+    ASSERT_LE(uploadStats.overlappedHandoffCount, uploadStats.handoffCount);
+}
+
+TEST(RHI, VulkanDeferredDestruction_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto destructionQueue = dynamic_cast<rhi::VKRHI*>(rhi.get())->getDestructionQueue();
+
+    rhi::BufferCreateInfo const bufferCreateInfo{.size = 1024,
+                                                 .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex};
+    rhi::TextureCreateInfo const textureCreateInfo{.width = 64,
+                                                   .height = 64,
+                                                   .depth = 1,
+                                                   .mipLevels = 1,
+                                                   .format = rhi::Format::RGBA8_UNORM,
+                                                   .dimension = rhi::TextureDimension::_2D,
+                                                   .flags =
+                                                       (rhi::TextureUsageFlags)rhi::TextureUsage::ShaderResource};
+    auto buffer = rhi->createBuffer(bufferCreateInfo);
+    auto texture = rhi->createTexture(textureCreateInfo);
+
+    // Objects released while a command buffer is recorded outlive its submission
+    auto graphicsContext = rhi->getGraphicsContext();
+    graphicsContext->setViewport(0, 0, 64, 64);
+    buffer = nullptr;
+    texture = nullptr;
+    ASSERT_EQ(destructionQueue->getPendingCount(), 3);
+
+    graphicsContext->execute().wait();
+    destructionQueue->collect();
+    ASSERT_EQ(destructionQueue->getPendingCount(), 0);
+}
+
+TEST(RHI, VulkanParallelDeferredDestruction_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto destructionQueue = dynamic_cast<rhi::VKRHI*>(rhi.get())->getDestructionQueue();
+
+    auto buffer = rhi->createBuffer(
+        rhi::BufferCreateInfo{.size = 1024, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex});
+
+    // Both contexts reference the buffer and are submitted one after the other, each with its own fence value
+    auto firstContext = rhi->createGraphicsContext();
+    auto secondContext = rhi->createGraphicsContext();
+    firstContext->bindVertexBuffer(buffer.get(), 0, 1024);
+    secondContext->bindVertexBuffer(buffer.get(), 0, 1024);
+    buffer = nullptr;
+    size_t const pendingCount = destructionQueue->getPendingCount();
+    ASSERT_GT(pendingCount, 0);
+
+    firstContext->execute().wait();
+    destructionQueue->collect();
+    ASSERT_EQ(destructionQueue->getPendingCount(), pendingCount);
+
+    secondContext->execute().wait();
+    destructionQueue->collect();
+    ASSERT_EQ(destructionQueue->getPendingCount(), 0);
+}
+
+TEST(RHI, VulkanBufferSubAllocation_Test)
+{
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default());
+    auto vkRHI = dynamic_cast<rhi::VKRHI*>(rhi.get());
+
+    // Constant buffers of materials share pages, so creating thousands of them takes a few VkBuffers
+    std::vector<core::ref_ptr<rhi::Buffer>> buffers;
+    for (uint32_t i = 0; i < 4096; ++i)
+    {
+        buffers.emplace_back(rhi->createBuffer(rhi::BufferCreateInfo{
+            .size = 256,
+            .flags = (rhi::BufferUsageFlags)(rhi::BufferUsage::ConstantBuffer | rhi::BufferUsage::CopyDest)}));
+    }
+    ASSERT_EQ(vkRHI->getBufferPageCount(), 1);
+
+    auto first = static_cast<rhi::VKBuffer*>(buffers[0].get());
+    auto second = static_cast<rhi::VKBuffer*>(buffers[1].get());
+    ASSERT_EQ(first->getBuffer(), second->getBuffer());
+    ASSERT_NE(first->getOffset(), second->getOffset());
+
+    // Each of them gets its own descriptor over its range of the page
+    ASSERT_NE(first->getDescriptorOffset(rhi::BufferUsage::ConstantBuffer),
+              second->getDescriptorOffset(rhi::BufferUsage::ConstantBuffer));
+
+    // Updates land at the offset of the buffer in its page
+    auto readBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 256, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::MapRead});
+    std::vector<uint8_t> dataBytes(256);
+    std::iota(dataBytes.begin(), dataBytes.end(), uint8_t{0});
+    auto copyContext = rhi->getCopyContext();
+    auto result = copyContext->updateBuffer(readBuffer, 0, dataBytes);
+    copyContext->execute().wait();
+    ASSERT_TRUE(result.getResult());
+
+    auto vkReadBuffer = static_cast<rhi::VKBuffer*>(readBuffer.get());
+    ASSERT_TRUE(std::equal(dataBytes.begin(), dataBytes.end(), vkReadBuffer->getMappedPointer()));
+
+    // Large buffers keep their own allocation
+    auto largeBuffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = 1024 * 1024, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::Vertex});
+    ASSERT_EQ(static_cast<rhi::VKBuffer*>(largeBuffer.get())->getOffset(), 0);
+    ASSERT_NE(static_cast<rhi::VKBuffer*>(largeBuffer.get())->getBuffer(), first->getBuffer());
+}
+
+TEST(RHI, VulkanReadback_Test)
+{
+    rhi::RHICreateInfo const rhiCreateInfo{.stagingBufferSize = 64 * 1024, .numBuffering = 1};
+    auto rhi = rhi::RHI::create(rhiCreateInfo);
+    auto copyContext = rhi->getCopyContext();
+
+    std::vector<uint8_t> dataBytes(1024);
+    for (size_t const i : std::views::iota(size_t{0}, dataBytes.size()))
+    {
+        dataBytes[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    // Device local, so the data can only come back through the readback ring
+    auto buffer = rhi->createBuffer(rhi::BufferCreateInfo{
+        .size = dataBytes.size(), .elementStride = 1, .flags = (rhi::BufferUsageFlags)rhi::BufferUsage::CopySource});
+    copyContext->updateBuffer(buffer, 0, dataBytes);
+    copyContext->execute().wait();
+
+    auto readbackResult = copyContext->readBuffer(buffer, 256, 512);
+    copyContext->execute();
+
+    auto readbackData = readbackResult.get();
+    ASSERT_EQ(readbackData->getRowPitch(), 512);
+    ASSERT_TRUE(std::ranges::equal(readbackData->getData(), std::span<uint8_t const>(dataBytes).subspan(256, 512)));
+    ASSERT_EQ(rhi->getUploadStats().readbackBytes, 512);
+
+    // Results can outlive the RHI, the ring buffer is released with the copy context instead of the last result
+    buffer = nullptr;
+    rhi = nullptr;
+    ASSERT_TRUE(readbackData->getData().empty());
+}
+
+TEST(RHI, VulkanHeadlessSwapchain_Test)
+{
+    // Surface extensions are not enabled, so it runs without a display
+    auto rhi = rhi::RHI::create(rhi::RHICreateInfo::Default(),
+                                rhi::SwapchainCreateInfo{.window = nullptr,
+                                                         .instance = nullptr,
+                                                         .frameCount = 2,
+                                                         .mode = rhi::SwapchainMode::Headless,
+                                                         .width = 64,
+                                                         .height = 32});
+
+    auto swapchain = rhi->getSwapchain();
+    rhi::Texture* firstBackBuffer = swapchain->getBackBuffer();
+    ASSERT_EQ(firstBackBuffer->getWidth(), 64);
+
+    auto copyContext = rhi->getCopyContext();
+    swapchain->presentBackBuffer().waitOnContext(copyContext);
+    auto readbackResult = copyContext->readTexture(core::ref_ptr<rhi::Texture>(firstBackBuffer), 0);
+    copyContext->execute();
+    ASSERT_EQ(readbackResult.get()->getData().size(), 64 * 4 * 32);
+
+    ASSERT_NE(swapchain->getBackBuffer(), firstBackBuffer);
+    swapchain->presentBackBuffer().wait();
+    ASSERT_EQ(swapchain->getBackBuffer(), firstBackBuffer);
+
+    swapchain->resizeBackBuffers(128, 128);
+    ASSERT_EQ(swapchain->getBackBuffer()->getHeight(), 128);
+}
+
+TEST(RHI, VulkanPipelineCache_Test)
+{
+    auto const cachePath = std::filesystem::temp_directory_path() / "ionengine_rhi_test" / "pipelines.cache";
+    std::filesystem::create_directories(cachePath.parent_path());
+    std::filesystem::remove(cachePath);
+
+    rhi::RHICreateInfo rhiCreateInfo = rhi::RHICreateInfo::Default();
+    rhiCreateInfo.pipelineCachePath = cachePath;
+    {
+        auto rhi = rhi::RHI::create(rhiCreateInfo);
+        auto stats = rhi->getPipelineCacheStats();
+        ASSERT_EQ(stats.misses, 0);
+        ASSERT_EQ(stats.loadedSize, 0);
+    }
+
+    // Nothing was compiled, so there is nothing to save
+    ASSERT_FALSE(std::filesystem::exists(cachePath));
+
+    // Data written for another device or driver must be ignored
+    {
+        std::ofstream stream(cachePath, std::ios::binary);
+        std::vector<uint8_t> const garbageBytes(4096, 0xcd);
+        stream.write(reinterpret_cast<char const*>(garbageBytes.data()), garbageBytes.size());
+    }
+    {
+        auto rhi = rhi::RHI::create(rhiCreateInfo);
+        ASSERT_EQ(rhi->getPipelineCacheStats().loadedSize, 0);
+    }
+    std::filesystem::remove(cachePath);
+}
+#endif
+
 auto main(int32_t argc, char** argv) -> int32_t
 {
     testing::InitGoogleTest(&argc, argv);
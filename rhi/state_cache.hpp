@@ -0,0 +1,247 @@
+// Copyright © 2020-2025 Dmitriy Lukovenko. All rights reserved.
+
+#pragma once
+
+#include "rhi.hpp"
+
+namespace ionengine::rhi
+{
+    /*!
+        \brief Counters shared by the graphics contexts of a device, contexts created by the user are counted as well
+    */
+    struct StateCounters
+    {
+        std::atomic<uint64_t> issuedCount{0};
+        std::atomic<uint64_t> elidedCount{0};
+
+        auto getStats() const -> StateStats
+        {
+            return StateStats{.issuedCount = issuedCount.load(std::memory_order_relaxed),
+                              .elidedCount = elidedCount.load(std::memory_order_relaxed)};
+        }
+    };
+
+    /*!
+        \brief Remembers the state last set on a graphics context, so setting the same state again is skipped
+        \details Each set method returns true when the state differs and the call has to reach the backend. The state
+        is forgotten on reset, when the command list is closed, since the next one starts with nothing bound. Bound
+        shaders and buffers are kept alive until then, so a new object at the address of a freed one is never taken
+        for it. Counts are kept in the cache and added to the shared counters on reset, so recording threads do not
+        contend on them
+    */
+    class GraphicsStateCache
+    {
+      public:
+        // Descriptors bound with bindDescriptor
+        static uint32_t constexpr BindingCount = 16;
+
+        GraphicsStateCache(StateCounters& counters)
+            : counters(&counters), issuedCount(0), elidedCount(0), isBindingsDirty(true)
+        {
+            descriptors.fill(0);
+        }
+
+        auto setPipeline(Shader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
+                         std::optional<DepthStencilStageInfo> const& depthStencil) -> bool
+        {
+            bool const isChanged = !this->shader || this->shader.get() != shader || !pipelineOptions.has_value() ||
+                                   pipelineOptions->rasterizer != rasterizer ||
+                                   pipelineOptions->blendColor != blendColor ||
+                                   pipelineOptions->depthStencil != depthStencil;
+            if (isChanged)
+            {
+                this->shader = shader;
+                pipelineOptions = PipelineOptions{
+                    .rasterizer = rasterizer, .blendColor = blendColor, .depthStencil = depthStencil};
+            }
+            return this->filter(isChanged);
+        }
+
+        // Makes the next setPipeline reach the backend, e.g. when the pipeline is still compiling or the render
+        // target formats have changed
+        auto invalidatePipeline() -> void
+        {
+            shader = nullptr;
+            pipelineOptions = std::nullopt;
+        }
+
+        auto setVertexBuffer(Buffer* buffer, uint64_t const offset, size_t const size) -> bool
+        {
+            bool const isChanged = !vertexBuffer || vertexBuffer.get() != buffer ||
+                                   vertexBufferRange != std::make_tuple(offset, size);
+            if (isChanged)
+            {
+                vertexBuffer = buffer;
+                vertexBufferRange = std::make_tuple(offset, size);
+            }
+            return this->filter(isChanged);
+        }
+
+        auto invalidateVertexBuffer() -> void
+        {
+            vertexBuffer = nullptr;
+            vertexBufferRange = std::nullopt;
+        }
+
+        auto setIndexBuffer(Buffer* buffer, uint64_t const offset, size_t const size, Format const format) -> bool
+        {
+            bool const isChanged = !indexBuffer || indexBuffer.get() != buffer ||
+                                   indexBufferRange != std::make_tuple(offset, size, format);
+            if (isChanged)
+            {
+                indexBuffer = buffer;
+                indexBufferRange = std::make_tuple(offset, size, format);
+            }
+            return this->filter(isChanged);
+        }
+
+        // Descriptors live in the binding data of the context, so they are kept over reset and only pushed again
+        auto setDescriptor(uint32_t const index, uint32_t const descriptor) -> bool
+        {
+            assert(index < BindingCount && "binding index is out of range");
+
+            bool const isChanged = descriptors[index] != descriptor;
+            if (isChanged)
+            {
+                descriptors[index] = descriptor;
+                isBindingsDirty = true;
+            }
+            return this->filter(isChanged);
+        }
+
+        // Returns true once after the descriptors have changed, the binding data is pushed before the draw then
+        auto takeDirtyBindings() -> bool
+        {
+            bool const isDirty = isBindingsDirty;
+            isBindingsDirty = false;
+            return isDirty;
+        }
+
+        // The binding data has to be pushed again, e.g. after the root signature is set
+        auto invalidateBindings() -> void
+        {
+            isBindingsDirty = true;
+        }
+
+        auto setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height) -> bool
+        {
+            auto const newViewport = std::make_tuple(x, y, width, height);
+
+            bool const isChanged = viewport != newViewport;
+            viewport = newViewport;
+            return this->filter(isChanged);
+        }
+
+        auto setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom) -> bool
+        {
+            auto const newScissor = std::make_tuple(left, top, right, bottom);
+
+            bool const isChanged = scissor != newScissor;
+            scissor = newScissor;
+            return this->filter(isChanged);
+        }
+
+        /*!
+            \brief Forgets the state and adds the counts to the shared counters
+            \details Should be called when the command list is closed
+        */
+        auto reset() -> void
+        {
+            this->invalidatePipeline();
+            this->invalidateVertexBuffer();
+            indexBuffer = nullptr;
+            indexBufferRange = std::nullopt;
+            viewport = std::nullopt;
+            scissor = std::nullopt;
+            isBindingsDirty = true;
+
+            counters->issuedCount.fetch_add(issuedCount, std::memory_order_relaxed);
+            counters->elidedCount.fetch_add(elidedCount, std::memory_order_relaxed);
+            issuedCount = 0;
+            elidedCount = 0;
+        }
+
+      private:
+        struct PipelineOptions
+        {
+            RasterizerStageInfo rasterizer;
+            BlendColorInfo blendColor;
+            std::optional<DepthStencilStageInfo> depthStencil;
+        };
+
+        StateCounters* counters;
+        uint64_t issuedCount;
+        uint64_t elidedCount;
+        core::ref_ptr<Shader> shader;
+        std::optional<PipelineOptions> pipelineOptions;
+        core::ref_ptr<Buffer> vertexBuffer;
+        std::optional<std::tuple<uint64_t, size_t>> vertexBufferRange;
+        core::ref_ptr<Buffer> indexBuffer;
+        std::optional<std::tuple<uint64_t, size_t, Format>> indexBufferRange;
+        std::array<uint32_t, BindingCount> descriptors;
+        bool isBindingsDirty;
+        std::optional<std::tuple<int32_t, int32_t, uint32_t, uint32_t>> viewport;
+        std::optional<std::tuple<int32_t, int32_t, int32_t, int32_t>> scissor;
+
+        auto filter(bool const isChanged) -> bool
+        {
+            if (isChanged)
+            {
+                issuedCount++;
+            }
+            else
+            {
+                elidedCount++;
+            }
+            return isChanged;
+        }
+    };
+
+    /*!
+        \brief Records draw packets with the methods of a backend graphics context
+        \details The context type should be final, so the calls are bound statically and inlined into the loop. The
+        pipeline is set again only when the packet references another state or the previous one was not ready
+    */
+    template <typename GraphicsContextType>
+    auto recordDrawPackets(GraphicsContextType& context, std::span<DrawPacket const> const packets) -> void
+    {
+        static_assert(std::is_final_v<GraphicsContextType>, "context calls would go through the vtable");
+
+        DrawPipelineState const* pipeline = nullptr;
+        bool isPipelineReady = false;
+        for (auto const& packet : packets)
+        {
+            assert(packet.pipeline && "pipeline state should be valid");
+            assert(packet.descriptorCount <= DrawPacket::MaxDescriptors && "too many descriptors");
+
+            if (packet.pipeline != pipeline || !isPipelineReady)
+            {
+                pipeline = packet.pipeline;
+                isPipelineReady = context.setGraphicsPipelineOptions(pipeline->shader, pipeline->rasterizer,
+                                                                     pipeline->blendColor, pipeline->depthStencil);
+            }
+
+            for (uint32_t const i : std::views::iota(0u, packet.descriptorCount))
+            {
+                context.bindDescriptor(i, packet.descriptors[i]);
+            }
+
+            if (packet.vertexBuffer.buffer)
+            {
+                context.bindVertexBuffer(packet.vertexBuffer.buffer, packet.vertexBuffer.offset,
+                                         packet.vertexBuffer.size);
+            }
+
+            if (packet.indexBuffer.buffer)
+            {
+                context.bindIndexBuffer(packet.indexBuffer.buffer, packet.indexBuffer.offset, packet.indexBuffer.size,
+                                        packet.indexBuffer.format);
+                context.drawIndexed(packet.count, packet.instanceCount);
+            }
+            else
+            {
+                context.draw(packet.count, packet.instanceCount);
+            }
+        }
+    }
+} // namespace ionengine::rhi
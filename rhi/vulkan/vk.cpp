@@ -35,32 +35,58 @@ namespace ionengine::rhi
         }
     }
 
-    auto TextureFormat_to_VkFormat(TextureFormat const format) -> VkFormat
+    auto Format_to_VkFormat(Format const format) -> VkFormat
     {
         switch (format)
         {
-            case TextureFormat::Unknown:
+            case Format::Unknown:
                 return VK_FORMAT_UNDEFINED;
-            case TextureFormat::RGBA8_UNORM:
+            case Format::RGBA8_UNORM:
                 return VK_FORMAT_R8G8B8A8_UNORM;
-            case TextureFormat::BGRA8_UNORM:
+            case Format::BGRA8_UNORM:
                 return VK_FORMAT_B8G8R8A8_UNORM;
-            case TextureFormat::BGR8_UNORM:
+            case Format::BGR8_UNORM:
                 return VK_FORMAT_B8G8R8_UNORM;
-            case TextureFormat::R8_UNORM:
+            case Format::R8_UNORM:
                 return VK_FORMAT_R8_UNORM;
-            case TextureFormat::BC1:
+            case Format::BC1:
                 return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
-            case TextureFormat::BC3:
+            case Format::BC3:
                 return VK_FORMAT_BC3_UNORM_BLOCK;
-            case TextureFormat::BC4:
+            case Format::BC4:
                 return VK_FORMAT_BC4_UNORM_BLOCK;
-            case TextureFormat::BC5:
+            case Format::BC5:
                 return VK_FORMAT_BC5_UNORM_BLOCK;
-            case TextureFormat::D32_FLOAT:
+            case Format::D32_FLOAT:
                 return VK_FORMAT_D32_SFLOAT;
-            case TextureFormat::RGBA16_FLOAT:
+            case Format::RGBA16_FLOAT:
                 return VK_FORMAT_R16G16B16A16_SFLOAT;
+            case Format::R16_UINT:
+                return VK_FORMAT_R16_UINT;
+            case Format::RGBA32_FLOAT:
+                return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case Format::RGBA32_SINT:
+                return VK_FORMAT_R32G32B32A32_SINT;
+            case Format::RGBA32_UINT:
+                return VK_FORMAT_R32G32B32A32_UINT;
+            case Format::RGB32_FLOAT:
+                return VK_FORMAT_R32G32B32_SFLOAT;
+            case Format::RGB32_SINT:
+                return VK_FORMAT_R32G32B32_SINT;
+            case Format::RGB32_UINT:
+                return VK_FORMAT_R32G32B32_UINT;
+            case Format::RG32_FLOAT:
+                return VK_FORMAT_R32G32_SFLOAT;
+            case Format::RG32_SINT:
+                return VK_FORMAT_R32G32_SINT;
+            case Format::RG32_UINT:
+                return VK_FORMAT_R32G32_UINT;
+            case Format::R32_FLOAT:
+                return VK_FORMAT_R32_SFLOAT;
+            case Format::R32_SINT:
+                return VK_FORMAT_R32_SINT;
+            case Format::R32_UINT:
+                return VK_FORMAT_R32_UINT;
             default:
                 return VK_FORMAT_UNDEFINED;
         }
@@ -124,7 +150,7 @@ namespace ionengine::rhi
             case ResourceState::RenderTarget:
                 return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             case ResourceState::UnorderedAccess:
-                return VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+                return VK_IMAGE_LAYOUT_GENERAL;
             case ResourceState::ShaderRead:
                 return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
             case ResourceState::CopySource:
@@ -136,63 +162,89 @@ namespace ionengine::rhi
         }
     }
 
-    auto VkImageLayout_to_VkAccessFlags(VkImageLayout const layout) -> VkAccessFlags
-    {
-        switch (layout)
-        {
-            case VK_IMAGE_LAYOUT_UNDEFINED:
-            case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-                return VK_ACCESS_NONE;
-            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
-                return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-                return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-                return VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            case VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL:
-                return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-                return VK_ACCESS_SHADER_READ_BIT;
-            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-                return VK_ACCESS_TRANSFER_READ_BIT;
-            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-                return VK_ACCESS_TRANSFER_WRITE_BIT;
-            default:
-                throw std::invalid_argument("unknown VkAccessFlags for passed argument");
-        }
-    }
+    // Pipeline stages that use a resource in some state and the memory accesses they make
+    struct VKStageAccess
+    {
+        VkPipelineStageFlags2 stageMask;
+        VkAccessFlags2 accessMask;
+    };
 
-    auto VertexFormat_to_VkFormat(VertexFormat const format) -> VkFormat
+    auto ResourceState_to_VKStageAccess(ResourceState const state, VkPipelineStageFlags2 const queueStages)
+        -> VKStageAccess
     {
-        switch (format)
+        VkPipelineStageFlags2 constexpr shaderStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        VkPipelineStageFlags2 constexpr depthStencilStages =
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+        VKStageAccess stageAccess{};
+
+        // Stages the queue can't execute never touch the resource there, so their accesses are dropped with them
+        auto addUsage = [&](VkPipelineStageFlags2 const stageMask, VkAccessFlags2 const accessMask) {
+            if (stageMask & queueStages)
+            {
+                stageAccess.stageMask |= stageMask & queueStages;
+                stageAccess.accessMask |= accessMask;
+            }
+        };
+
+        switch (state)
         {
-            case VertexFormat::RGBA32_FLOAT:
-                return VK_FORMAT_R32G32B32A32_SFLOAT;
-            case VertexFormat::RGBA32_SINT:
-                return VK_FORMAT_R32G32B32A32_SINT;
-            case VertexFormat::RGBA32_UINT:
-                return VK_FORMAT_R32G32B32A32_UINT;
-            case VertexFormat::RGB32_FLOAT:
-                return VK_FORMAT_R32G32B32_SFLOAT;
-            case VertexFormat::RGB32_SINT:
-                return VK_FORMAT_R32G32B32_SINT;
-            case VertexFormat::RGB32_UINT:
-                return VK_FORMAT_R32G32B32_UINT;
-            case VertexFormat::RG32_FLOAT:
-                return VK_FORMAT_R32G32_SFLOAT;
-            case VertexFormat::RG32_SINT:
-                return VK_FORMAT_R32G32_SINT;
-            case VertexFormat::RG32_UINT:
-                return VK_FORMAT_R32G32_UINT;
-            case VertexFormat::R32_FLOAT:
-                return VK_FORMAT_R32_SFLOAT;
-            case VertexFormat::R32_SINT:
-                return VK_FORMAT_R32_SINT;
-            case VertexFormat::R32_UINT:
-                return VK_FORMAT_R32_UINT;
+            case ResourceState::Common: {
+                addUsage(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                         VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT);
+                break;
+            }
+            case ResourceState::RenderTarget: {
+                addUsage(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+                break;
+            }
+            case ResourceState::DepthStencilRead: {
+                addUsage(depthStencilStages, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT);
+                addUsage(shaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+                break;
+            }
+            case ResourceState::DepthStencilWrite: {
+                addUsage(depthStencilStages, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                 VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+                break;
+            }
+            case ResourceState::ShaderRead: {
+                addUsage(VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+                addUsage(VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT);
+                addUsage(shaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                           VK_ACCESS_2_UNIFORM_READ_BIT);
+                break;
+            }
+            case ResourceState::UnorderedAccess: {
+                addUsage(shaderStages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+                break;
+            }
+            case ResourceState::CopySource: {
+                addUsage(VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+                break;
+            }
+            case ResourceState::CopyDest: {
+                addUsage(VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+                break;
+            }
+            case ResourceState::IndirectArgument: {
+                addUsage(VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+                break;
+            }
             default:
-                return VK_FORMAT_UNDEFINED;
+                throw std::invalid_argument("unknown VkPipelineStageFlags2 for passed argument");
         }
+
+        if (stageAccess.stageMask == 0)
+        {
+            // The state is never used on this queue, the barrier falls back to waiting for everything
+            return VKStageAccess{.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                 .accessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT};
+        }
+        return stageAccess;
     }
 
     auto CullMode_to_VkCullModeFlags(CullMode const cullMode) -> VkCullModeFlags
@@ -308,16 +360,20 @@ namespace ionengine::rhi
         return VK_FALSE;
     }
 
-    DescriptorAllocator::DescriptorAllocator(VkDevice device) : device(device)
+    DescriptorAllocator::DescriptorAllocator(VkDevice device, RHICreateInfo const& createInfo) : device(device)
     {
         std::array<VkDescriptorType, 4> const descriptorTypes{
             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
             VK_DESCRIPTOR_TYPE_SAMPLER};
         // std::array<VkDescriptorBindingFlags, 4> bindingFlags{};
-        std::array<uint32_t, 4> const descriptorLimits{std::to_underlying(DescriptorAllocatorLimits::Uniform),
-                                                       std::to_underlying(DescriptorAllocatorLimits::Storage),
-                                                       std::to_underlying(DescriptorAllocatorLimits::SampledImage),
-                                                       std::to_underlying(DescriptorAllocatorLimits::Sampler)};
+        uint32_t const descriptorHeapSize = createInfo.descriptorHeapSize > 0
+                                                ? createInfo.descriptorHeapSize
+                                                : std::to_underlying(DescriptorAllocatorLimits::SampledImage);
+        uint32_t const samplerHeapSize = createInfo.samplerHeapSize > 0
+                                             ? createInfo.samplerHeapSize
+                                             : std::to_underlying(DescriptorAllocatorLimits::Sampler);
+        std::array<uint32_t, 4> const descriptorLimits{descriptorHeapSize, descriptorHeapSize, descriptorHeapSize,
+                                                       samplerHeapSize};
 
         std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
 
@@ -391,16 +447,11 @@ namespace ionengine::rhi
     auto DescriptorAllocator::createChunk(VkDescriptorSetLayout descriptorSetLayout,
                                           VkDescriptorType const descriptorType, uint32_t const descriptorCount) -> void
     {
-        std::vector<uint8_t> free(descriptorCount);
-        std::fill(free.begin(), free.end(), 0x0);
-
-        std::vector<DescriptorAllocation_T> allocations(descriptorCount);
-
-        Chunk chunk{.descriptorSetLayout = descriptorSetLayout,
-                    .binding = 0,
-                    .free = std::move(free),
-                    .size = descriptorCount,
-                    .allocations = std::move(allocations)};
+        // The descriptor set is created at its full size, only the slot bitmap grows with the use
+        Chunk chunk{.descriptorType = descriptorType,
+                    .descriptorSetLayout = descriptorSetLayout,
+                    .slots = std::make_unique<DescriptorSlotAllocator>(std::min(descriptorCount, 4096u),
+                                                                       descriptorCount)};
 
         VkDescriptorSetAllocateInfo const descriptorSetAllocateInfo{.sType =
                                                                         VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
@@ -416,82 +467,272 @@ namespace ionengine::rhi
     {
         ::vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 
-        for (auto const [descriptorType, chunkData] : chunks)
+        for (auto const& [descriptorType, chunkData] : chunks)
         {
             ::vkDestroyDescriptorSetLayout(device, chunkData.descriptorSetLayout, nullptr);
         }
     }
 
+    auto DescriptorAllocator::getChunk(VkDescriptorType const descriptorType) -> Chunk&
+    {
+        // Every descriptor type except samplers lives in the mutable descriptor set
+        return chunks.at(descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ? VK_DESCRIPTOR_TYPE_SAMPLER
+                                                                     : VK_DESCRIPTOR_TYPE_MUTABLE_EXT);
+    }
+
     auto DescriptorAllocator::allocate(VkDescriptorType const descriptorType, DescriptorAllocation* allocation)
         -> VkResult
     {
-        std::lock_guard lock(mutex);
+        Chunk& chunk = this->getChunk(descriptorType);
 
-        VkDescriptorType mutableDescriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-        if (descriptorType != VK_DESCRIPTOR_TYPE_SAMPLER)
+        auto slot = chunk.slots->allocate();
+        if (!slot.has_value())
         {
-            mutableDescriptorType = VK_DESCRIPTOR_TYPE_MUTABLE_EXT;
+            return VK_ERROR_OUT_OF_POOL_MEMORY;
         }
 
-        Chunk& chunk = chunks[mutableDescriptorType];
-        if (1 > chunk.size - chunk.offset)
+        (*allocation) = {.descriptorType = chunk.descriptorType, .arrayElement = slot.value()};
+        return VK_SUCCESS;
+    }
+
+    auto DescriptorAllocator::allocate(VkDescriptorType const descriptorType,
+                                       std::span<DescriptorAllocation> const allocations) -> VkResult
+    {
+        Chunk& chunk = this->getChunk(descriptorType);
+
+        std::vector<uint32_t> slots(allocations.size());
+        if (!chunk.slots->allocate(slots))
         {
             return VK_ERROR_OUT_OF_POOL_MEMORY;
         }
 
-        bool success = false;
-        uint32_t allocOffset = 0;
+        for (size_t const i : std::views::iota(size_t{0}, allocations.size()))
+        {
+            allocations[i] = {.descriptorType = chunk.descriptorType, .arrayElement = slots[i]};
+        }
+        return VK_SUCCESS;
+    }
+
+    auto DescriptorAllocator::deallocate(DescriptorAllocation const& allocation) -> void
+    {
+        this->getChunk(allocation.descriptorType).slots->deallocate(allocation.arrayElement);
+    }
 
-        for (uint32_t const i : std::views::iota(chunk.offset, chunk.size))
+    auto DescriptorAllocator::deallocate(std::span<DescriptorAllocation const> const allocations) -> void
+    {
+        if (allocations.empty())
         {
-            if (chunk.free[i] == 0x1)
-            {
-                continue;
-            }
-            else
-            {
-                allocOffset = i;
-                success = true;
-                break;
-            }
+            return;
         }
 
-        if (success)
+        std::vector<uint32_t> slots(allocations.size());
+        for (size_t const i : std::views::iota(size_t{0}, allocations.size()))
         {
-            chunk.free[allocOffset] = 0x1;
-            chunk.offset = allocOffset + 1;
+            assert(allocations[i].descriptorType == allocations[0].descriptorType &&
+                   "allocations of a batch should have the same descriptor type");
+            slots[i] = allocations[i].arrayElement;
+        }
+
+        this->getChunk(allocations[0].descriptorType).slots->deallocate(slots);
+    }
+
+    auto DescriptorAllocator::getDescriptorSet(VkDescriptorType const descriptorType) const -> VkDescriptorSet
+    {
+        return chunks.at(descriptorType).descriptorSet;
+    }
+
+    auto DescriptorAllocator::getDescriptorSetLayout(VkDescriptorType const descriptorType) const
+        -> VkDescriptorSetLayout
+    {
+        return chunks.at(descriptorType).descriptorSetLayout;
+    }
+
+    VKBufferPool::VKBufferPool(VmaAllocator memoryAllocator, std::span<uint32_t const> const queueFamilies,
+                               VmaAllocationCreateFlags const allocationFlags)
+        : memoryAllocator(memoryAllocator), queueFamilies(queueFamilies.begin(), queueFamilies.end()),
+          allocationFlags(allocationFlags), subAllocator(PageSize, MinBlockSize)
+    {
+    }
+
+    VKBufferPool::~VKBufferPool()
+    {
+        subAllocator.forEachPage([&](VKBufferPage const& page) {
+            ::vmaDestroyBuffer(memoryAllocator, page.buffer, page.memoryAllocation);
+        });
+    }
+
+    auto VKBufferPool::allocate(size_t const size) -> Allocation
+    {
+        return subAllocator.allocate(size, [this]() { return this->createPage(); });
+    }
+
+    auto VKBufferPool::deallocate(Allocation const& allocation) -> void
+    {
+        subAllocator.deallocate(allocation);
+    }
 
-            chunk.allocations[allocOffset] = {.descriptorType = mutableDescriptorType,
-                                              .descriptorSet = chunk.descriptorSet,
-                                              .binding = chunk.binding,
-                                              .arrayElement = allocOffset};
+    auto VKBufferPool::getPageCount() const -> size_t
+    {
+        return subAllocator.getPageCount();
+    }
 
-            (*allocation) = &chunk.allocations[allocOffset];
-            return VK_SUCCESS;
+    auto VKBufferPool::createPage() -> VKBufferPage
+    {
+        VkBufferCreateInfo bufferCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = PageSize,
+            .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+
+        if (queueFamilies.size() > 1)
+        {
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            bufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
         }
-        else
+
+        VmaAllocationCreateInfo const allocationCreateInfo{.flags = allocationFlags, .usage = VMA_MEMORY_USAGE_AUTO};
+
+        VKBufferPage page{};
+        VmaAllocationInfo allocationInfo;
+        throwIfFailed(::vmaCreateBuffer(memoryAllocator, &bufferCreateInfo, &allocationCreateInfo, &page.buffer,
+                                        &page.memoryAllocation, &allocationInfo));
+        page.mappedBytes = static_cast<uint8_t*>(allocationInfo.pMappedData);
+        return page;
+    }
+
+    DestructionQueue::DestructionQueue(VkDevice device, VmaAllocator memoryAllocator,
+                                       DescriptorAllocator* descriptorAllocator,
+                                       std::array<DeviceQueueData*, 3> const& deviceQueues)
+        : device(device), memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator),
+          deviceQueues(deviceQueues)
+    {
+    }
+
+    DestructionQueue::~DestructionQueue()
+    {
+        for (auto const& entry : entries)
         {
-            return VK_ERROR_OUT_OF_POOL_MEMORY;
+            this->destroy(entry);
+        }
+    }
+
+    auto DestructionQueue::releaseBuffer(VkBuffer buffer, VmaAllocation memoryAllocation) -> void
+    {
+        this->enqueue({.buffer = buffer, .memoryAllocation = memoryAllocation});
+    }
+
+    auto DestructionQueue::releaseBuffer(VKBufferPool* bufferPool, VKBufferPool::Allocation const& allocation) -> void
+    {
+        this->enqueue({.bufferPool = bufferPool, .bufferAllocation = allocation});
+    }
+
+    auto DestructionQueue::releaseImage(VkImage image, VkImageView imageView, VmaAllocation memoryAllocation) -> void
+    {
+        this->enqueue({.image = image, .imageView = imageView, .memoryAllocation = memoryAllocation});
+    }
+
+    auto DestructionQueue::releaseSampler(VkSampler sampler) -> void
+    {
+        this->enqueue({.sampler = sampler});
+    }
+
+    auto DestructionQueue::releaseDescriptor(DescriptorAllocation const& descriptorAllocation) -> void
+    {
+        this->enqueue({.descriptorAllocation = descriptorAllocation});
+    }
+
+    auto DestructionQueue::releaseQueryPool(VkQueryPool queryPool) -> void
+    {
+        this->enqueue({.queryPool = queryPool});
+    }
+
+    auto DestructionQueue::enqueue(Entry&& entry) -> void
+    {
+        std::lock_guard lock(mutex);
+
+        for (uint32_t const i : std::views::iota(0u, 3u))
+        {
+            // Every command list being recorded right now may reference the object and takes its own value when it
+            // is submitted. A submit publishes its value and closes its lists under the mutex, so both are read under
+            // it too. Lists opened later can't reference an object that is already released
+            std::lock_guard submitLock(*deviceQueues[i]->submitMutex);
+            entry.fenceValues[i] = deviceQueues[i]->fenceValue + deviceQueues[i]->openCommandLists;
         }
+        entries.emplace_back(std::move(entry));
     }
 
-    auto DescriptorAllocator::deallocate(DescriptorAllocation allocation) -> void
+    auto DestructionQueue::collect() -> void
     {
         std::lock_guard lock(mutex);
 
-        Chunk& chunk = chunks[allocation->descriptorType];
-        chunk.free[allocation->arrayElement] = 0x0;
-        chunk.offset = std::min(chunk.offset, allocation->arrayElement);
+        if (entries.empty())
+        {
+            return;
+        }
+
+        std::array<uint64_t, 3> counterValues;
+        for (uint32_t const i : std::views::iota(0u, 3u))
+        {
+            throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueues[i]->semaphore, &counterValues[i]));
+        }
+
+        // Fence values only grow, so the entries are retired in the order they were released
+        while (!entries.empty())
+        {
+            auto const& entry = entries.front();
+            bool const isRetired = std::ranges::all_of(std::views::iota(0u, 3u), [&](uint32_t const i) {
+                return entry.fenceValues[i] <= counterValues[i];
+            });
+            if (!isRetired)
+            {
+                break;
+            }
+
+            this->destroy(entry);
+            entries.pop_front();
+        }
     }
 
-    auto DescriptorAllocator::getDescriptorSet(VkDescriptorType const descriptorType) -> VkDescriptorSet
+    auto DestructionQueue::getPendingCount() const -> size_t
     {
-        return chunks[descriptorType].descriptorSet;
+        std::lock_guard lock(mutex);
+        return entries.size();
     }
 
-    auto DescriptorAllocator::getDescriptorSetLayout(VkDescriptorType const descriptorType) -> VkDescriptorSetLayout
+    auto DestructionQueue::destroy(Entry const& entry) -> void
     {
-        return chunks[descriptorType].descriptorSetLayout;
+        if (entry.buffer)
+        {
+            ::vmaDestroyBuffer(memoryAllocator, entry.buffer, entry.memoryAllocation);
+        }
+        if (entry.bufferAllocation.has_value())
+        {
+            entry.bufferPool->deallocate(entry.bufferAllocation.value());
+        }
+        if (entry.imageView)
+        {
+            ::vkDestroyImageView(device, entry.imageView, nullptr);
+        }
+        if (entry.image && entry.memoryAllocation)
+        {
+            ::vmaDestroyImage(memoryAllocator, entry.image, entry.memoryAllocation);
+        }
+        if (entry.sampler)
+        {
+            ::vkDestroySampler(device, entry.sampler, nullptr);
+        }
+        if (entry.queryPool)
+        {
+            ::vkDestroyQueryPool(device, entry.queryPool, nullptr);
+        }
+        if (entry.descriptorAllocation.has_value())
+        {
+            descriptorAllocator->deallocate(entry.descriptorAllocation.value());
+        }
     }
 
     VKVertexInput::VKVertexInput(std::span<VertexDeclarationInfo const> const vertexDeclarations)
@@ -505,11 +746,11 @@ namespace ionengine::rhi
             VkVertexInputAttributeDescription const vertexInputAttributeDescription{
                 .location = location,
                 .binding = 0,
-                .format = VertexFormat_to_VkFormat(vertexDeclaration.format),
+                .format = Format_to_VkFormat(vertexDeclaration.format),
                 .offset = offset};
 
             location++;
-            offset += sizeof_VertexFormat(vertexDeclaration.format);
+            offset += static_cast<uint32_t>(sizeof_Format(vertexDeclaration.format));
 
             inputAttributes.emplace_back(std::move(vertexInputAttributeDescription));
         }
@@ -533,7 +774,8 @@ namespace ionengine::rhi
         return vertexInputStateCreateInfo;
     }
 
-    VKShader::VKShader(VkDevice device, ShaderCreateInfo const& createInfo) : device(device)
+    VKShader::VKShader(VkDevice device, ShaderCreateInfo const& createInfo)
+        : device(device), shaderType(createInfo.shaderType)
     {
         if (createInfo.shaderType == rhi::ShaderType::Graphics)
         {
@@ -629,8 +871,35 @@ namespace ionengine::rhi
                        std::optional<DepthStencilStageInfo> const depthStencil,
                        std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat,
                        VkPipelineCache pipelineCache)
-        : device(device), pipelineType(VK_PIPELINE_BIND_POINT_GRAPHICS)
+        : device(device), pipelineType(VK_PIPELINE_BIND_POINT_GRAPHICS), creationFeedback{}
     {
+        VkPipelineCreationFeedbackCreateInfo const creationFeedbackCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+            .pPipelineCreationFeedback = &creationFeedback};
+
+        if (shader->getShaderType() == ShaderType::Compute)
+        {
+            // The graphics state is not part of compute pipelines
+            auto const& shaderStage = shader->getStages().at(VK_SHADER_STAGE_COMPUTE_BIT);
+
+            VkComputePipelineCreateInfo const pipelineCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                .pNext = &creationFeedbackCreateInfo,
+                .stage = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                          .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                          .module = shaderStage.shaderModule,
+                          .pName = shaderStage.entryPoint.c_str()},
+                .layout = pipelineLayout};
+            pipelineType = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+            auto result = ::vkCreateComputePipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+            if (result != VK_SUCCESS)
+            {
+                throwIfFailed(::vkCreateComputePipelines(device, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline));
+            }
+            return;
+        }
+
         std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos;
         for (auto const& [stageFlags, shaderStage] : shader->getStages())
         {
@@ -715,6 +984,7 @@ namespace ionengine::rhi
 
         VkPipelineRenderingCreateInfoKHR const renderingCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+            .pNext = &creationFeedbackCreateInfo,
             .colorAttachmentCount = static_cast<uint32_t>(colorBlendAttachmentStates.size()),
             .pColorAttachmentFormats = renderTargetFormats.data(),
             .depthAttachmentFormat = depthStencilFormat,
@@ -761,9 +1031,16 @@ namespace ionengine::rhi
         return pipeline;
     }
 
-    PipelineCache::PipelineCache(VkDevice device, DescriptorAllocator* descriptorAllocator,
-                                 RHICreateInfo const& createInfo)
-        : device(device)
+    auto Pipeline::isDriverCacheHit() const -> bool
+    {
+        return (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) &&
+               (creationFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT);
+    }
+
+    PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device,
+                                 DescriptorAllocator* descriptorAllocator, RHICreateInfo const& createInfo)
+        : device(device), pipelineCache(nullptr), compileMode(createInfo.pipelineCompileMode),
+          cachePath(createInfo.pipelineCachePath), loadedSize(0), savedMisses(0)
     {
         VkPushConstantRange const pushConstantRange{.stageFlags = VK_SHADER_STAGE_ALL, .offset = 0, .size = 4 * 16};
 
@@ -777,91 +1054,576 @@ namespace ionengine::rhi
             .pushConstantRangeCount = 1,
             .pPushConstantRanges = &pushConstantRange};
         throwIfFailed(::vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
+
+        VkPhysicalDeviceIDProperties deviceIDProperties{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES};
+        VkPhysicalDeviceProperties2 deviceProperties{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                                                     .pNext = &deviceIDProperties};
+        ::vkGetPhysicalDeviceProperties2(physicalDevice, &deviceProperties);
+
+        deviceHeader = FileHeader{.magic = FileMagic,
+                                  .version = FileVersion,
+                                  .vendorID = deviceProperties.properties.vendorID,
+                                  .deviceID = deviceProperties.properties.deviceID,
+                                  .driverVersion = deviceProperties.properties.driverVersion};
+        std::memcpy(deviceHeader.driverUUID.data(), deviceIDProperties.driverUUID, VK_UUID_SIZE);
+        std::memcpy(deviceHeader.pipelineCacheUUID.data(), deviceProperties.properties.pipelineCacheUUID,
+                    VK_UUID_SIZE);
+
+        std::vector<uint8_t> const initialData = this->loadFromFile();
+        loadedSize = initialData.size();
+
+        VkPipelineCacheCreateInfo const pipelineCacheCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                                                .initialDataSize = initialData.size(),
+                                                                .pInitialData = initialData.data()};
+        auto result = ::vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+        if (result != VK_SUCCESS)
+        {
+            // Drivers may still reject data that passed the header checks, start from scratch then
+            VkPipelineCacheCreateInfo const emptyCacheCreateInfo{.sType =
+                                                                     VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+            throwIfFailed(::vkCreatePipelineCache(device, &emptyCacheCreateInfo, nullptr, &pipelineCache));
+            loadedSize = 0;
+        }
+
+        uint32_t numCompilerThreads = createInfo.pipelineCompileThreads;
+        if (numCompilerThreads == 0)
+        {
+            numCompilerThreads = std::max(std::thread::hardware_concurrency() / 2, 1u);
+        }
+
+        for (uint32_t i = 0; i < numCompilerThreads; ++i)
+        {
+            compilerThreads.emplace_back([this](std::stop_token stopToken) { this->compileLoop(stopToken); });
+        }
     }
 
-    auto PipelineCache::get(VKShader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
-                            std::optional<DepthStencilStageInfo> const depthStencil,
-                            std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat)
-        -> core::ref_ptr<Pipeline>
+    auto PipelineCache::loadFromFile() -> std::vector<uint8_t>
     {
-        Entry const entry{.shaderHash = shader->getHash(),
-                          .rasterizer = rasterizer,
-                          .blendColor = blendColor,
-                          .depthStencil = depthStencil,
-                          .renderTargetFormats = renderTargetFormats,
-                          .depthStencilFormat = depthStencilFormat};
+        if (cachePath.empty())
+        {
+            return {};
+        }
 
-        std::unique_lock lock(mutex);
-        auto result = entries.find(entry);
-        if (result != entries.end())
+        std::ifstream stream(cachePath, std::ios::binary);
+        if (!stream.is_open())
         {
-            return result->second;
+            return {};
         }
-        else
+
+        FileHeader fileHeader;
+        if (!stream.read(reinterpret_cast<char*>(&fileHeader), sizeof(FileHeader)))
         {
-            lock.unlock();
-            auto pipeline = core::make_ref<Pipeline>(device, pipelineLayout, shader, rasterizer, blendColor,
-                                                     depthStencil, renderTargetFormats, depthStencilFormat, nullptr);
+            return {};
+        }
 
-            lock.lock();
-            entries.emplace(entry, pipeline);
-            return pipeline;
+        if (std::make_tuple(fileHeader.magic, fileHeader.version, fileHeader.vendorID, fileHeader.deviceID,
+                            fileHeader.driverVersion, fileHeader.driverUUID, fileHeader.pipelineCacheUUID) !=
+            std::make_tuple(deviceHeader.magic, deviceHeader.version, deviceHeader.vendorID, deviceHeader.deviceID,
+                            deviceHeader.driverVersion, deviceHeader.driverUUID, deviceHeader.pipelineCacheUUID))
+        {
+            return {};
         }
-    }
 
-    PipelineCache::~PipelineCache()
-    {
-        ::vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        if (fileHeader.dataSize < sizeof(VkPipelineCacheHeaderVersionOne))
+        {
+            return {};
+        }
+
+        std::vector<uint8_t> dataBytes(fileHeader.dataSize);
+        if (!stream.read(reinterpret_cast<char*>(dataBytes.data()), dataBytes.size()) ||
+            ::XXH64(dataBytes.data(), dataBytes.size(), 0) != fileHeader.dataHash)
+        {
+            return {};
+        }
+
+        // The driver header has to describe the same device as well
+        VkPipelineCacheHeaderVersionOne cacheHeader;
+        std::memcpy(&cacheHeader, dataBytes.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+        if (cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            cacheHeader.vendorID != deviceHeader.vendorID || cacheHeader.deviceID != deviceHeader.deviceID ||
+            std::memcmp(cacheHeader.pipelineCacheUUID, deviceHeader.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+        {
+            return {};
+        }
+        return dataBytes;
     }
 
-    auto PipelineCache::reset() -> void
+    auto PipelineCache::save() -> void
     {
         std::lock_guard lock(mutex);
-        entries.clear();
-    }
 
-    auto PipelineCache::getPipelineLayout() -> VkPipelineLayout
-    {
-        return pipelineLayout;
-    }
+        uint64_t const currentMisses = misses.load(std::memory_order_relaxed);
+        if (cachePath.empty() || currentMisses == savedMisses)
+        {
+            return;
+        }
 
-    VKBuffer::VKBuffer(VkDevice device, VmaAllocator memoryAllocator, BufferCreateInfo const& createInfo)
-        : device(device), memoryAllocator(memoryAllocator), size(createInfo.size), flags(createInfo.flags)
-    {
-        VkBufferCreateInfo bufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-    }
+        size_t dataSize = 0;
+        if (::vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+        {
+            return;
+        }
 
-    VKBuffer::~VKBuffer()
-    {
-        if (memoryAllocator && memoryAllocation)
+        std::vector<uint8_t> dataBytes(dataSize);
+        if (::vkGetPipelineCacheData(device, pipelineCache, &dataSize, dataBytes.data()) != VK_SUCCESS)
         {
-            ::vmaDestroyBuffer(memoryAllocator, buffer, memoryAllocation);
+            return;
         }
-    }
+        dataBytes.resize(dataSize);
 
-    auto VKBuffer::getSize() const -> size_t
-    {
-        return size;
-    }
+        FileHeader fileHeader = deviceHeader;
+        fileHeader.dataSize = dataBytes.size();
+        fileHeader.dataHash = ::XXH64(dataBytes.data(), dataBytes.size(), 0);
 
-    auto VKBuffer::getFlags() const -> BufferUsageFlags
-    {
-        return flags;
-    }
+        // Write next to the old file and swap, so a crash while saving never leaves a torn cache behind
+        std::error_code errorCode;
+        if (cachePath.has_parent_path())
+        {
+            std::filesystem::create_directories(cachePath.parent_path(), errorCode);
+        }
 
-    auto VKBuffer::mapMemory() -> uint8_t*
-    {
-        uint8_t* mappedBytes;
-        if (flags & BufferUsage::MapWrite || flags & BufferUsage::MapRead)
+        std::filesystem::path tempPath = cachePath;
+        tempPath += ".tmp";
         {
-            throwIfFailed(::vmaMapMemory(memoryAllocator, memoryAllocation, reinterpret_cast<void**>(&mappedBytes)));
+            std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+            {
+                return;
+            }
+            stream.write(reinterpret_cast<char const*>(&fileHeader), sizeof(FileHeader));
+            stream.write(reinterpret_cast<char const*>(dataBytes.data()), dataBytes.size());
+            if (!stream.flush())
+            {
+                return;
+            }
+        }
+
+        std::filesystem::rename(tempPath, cachePath, errorCode);
+        if (!errorCode)
+        {
+            savedMisses = currentMisses;
         }
-        return mappedBytes;
     }
 
-    auto VKBuffer::unmapMemory() -> void
+    auto PipelineCache::getStats() const -> PipelineCacheStats
     {
-        ::vmaUnmapMemory(memoryAllocator, memoryAllocation);
+        uint64_t pendingCount;
+        {
+            std::lock_guard lock(mutex);
+            pendingCount = pendingEntries.size();
+        }
+
+        return PipelineCacheStats{.hits = hits.load(std::memory_order_relaxed),
+                                  .misses = misses.load(std::memory_order_relaxed),
+                                  .driverCacheHits = driverCacheHits.load(std::memory_order_relaxed),
+                                  .creationTime = creationTime.load(std::memory_order_relaxed),
+                                  .loadedSize = loadedSize,
+                                  .pendingCompilations = pendingCount};
+    }
+
+    auto PipelineCache::get(VKShader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
+                            std::optional<DepthStencilStageInfo> const depthStencil,
+                            std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat,
+                            PipelineCompileMode const mode) -> core::ref_ptr<Pipeline>
+    {
+        PipelineKey const key =
+            PipelineKey::create(shader->getHash(), rasterizer, blendColor, depthStencil,
+                                std::span<VkFormat const>(renderTargetFormats), depthStencilFormat);
+
+        if (auto result = entries.find(key))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return std::move(result.value());
+        }
+
+        std::unique_lock lock(mutex);
+        // Could have been finished while the lock was taken
+        if (auto result = entries.find(key))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return std::move(result.value());
+        }
+
+        auto pendingResult = pendingEntries.find(key);
+        if (pendingResult == pendingEntries.end())
+        {
+            CompileRequest compileRequest{.key = key,
+                                          .shader = shader,
+                                          .rasterizer = rasterizer,
+                                          .blendColor = blendColor,
+                                          .depthStencil = depthStencil,
+                                          .renderTargetFormats = renderTargetFormats,
+                                          .depthStencilFormat = depthStencilFormat};
+
+            if (mode != PipelineCompileMode::Blocking)
+            {
+                this->queueRequest(std::move(compileRequest));
+                return nullptr;
+            }
+
+            pendingEntries.emplace(key, compileRequest.promise.get_future().share());
+            lock.unlock();
+            return this->compilePipeline(compileRequest);
+        }
+
+        if (mode != PipelineCompileMode::Blocking)
+        {
+            return nullptr;
+        }
+
+        // Not picked up by a compiler thread yet, compiling it here is faster than waiting behind the queue
+        auto request = std::ranges::find_if(compileRequests, [&](auto const& other) { return other.key == key; });
+        if (request != compileRequests.end())
+        {
+            CompileRequest compileRequest = std::move(*request);
+            compileRequests.erase(request);
+            lock.unlock();
+            return this->compilePipeline(compileRequest);
+        }
+
+        auto pendingFuture = pendingResult->second;
+        lock.unlock();
+        return pendingFuture.get();
+    }
+
+    auto PipelineCache::prewarm(VKShader* shader, RasterizerStageInfo const& rasterizer,
+                                BlendColorInfo const& blendColor,
+                                std::optional<DepthStencilStageInfo> const depthStencil,
+                                std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat)
+        -> void
+    {
+        PipelineKey const key =
+            PipelineKey::create(shader->getHash(), rasterizer, blendColor, depthStencil,
+                                std::span<VkFormat const>(renderTargetFormats), depthStencilFormat);
+
+        std::lock_guard lock(mutex);
+        if (entries.find(key).has_value() || pendingEntries.contains(key))
+        {
+            return;
+        }
+
+        this->queueRequest(CompileRequest{.key = key,
+                                          .shader = shader,
+                                          .rasterizer = rasterizer,
+                                          .blendColor = blendColor,
+                                          .depthStencil = depthStencil,
+                                          .renderTargetFormats = renderTargetFormats,
+                                          .depthStencilFormat = depthStencilFormat});
+    }
+
+    auto PipelineCache::queueRequest(CompileRequest&& compileRequest) -> void
+    {
+        pendingEntries.emplace(compileRequest.key, compileRequest.promise.get_future().share());
+        compileRequests.emplace_back(std::move(compileRequest));
+        compileCondition.notify_one();
+    }
+
+    auto PipelineCache::compilePipeline(CompileRequest& compileRequest) -> core::ref_ptr<Pipeline>
+    {
+        core::ref_ptr<Pipeline> pipeline;
+        try
+        {
+            auto const beginTime = std::chrono::steady_clock::now();
+            pipeline = core::make_ref<Pipeline>(
+                device, pipelineLayout, compileRequest.shader.get(), compileRequest.rasterizer,
+                compileRequest.blendColor, compileRequest.depthStencil, compileRequest.renderTargetFormats,
+                compileRequest.depthStencilFormat, pipelineCache);
+            auto const creationDuration = std::chrono::steady_clock::now() - beginTime;
+
+            misses.fetch_add(1, std::memory_order_relaxed);
+            creationTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(creationDuration).count(),
+                                   std::memory_order_relaxed);
+            if (pipeline->isDriverCacheHit())
+            {
+                driverCacheHits.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard lock(mutex);
+            pendingEntries.erase(compileRequest.key);
+            compileRequest.promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        std::lock_guard lock(mutex);
+        entries.emplace(compileRequest.key, pipeline);
+        pendingEntries.erase(compileRequest.key);
+        compileRequest.promise.set_value(pipeline);
+        return pipeline;
+    }
+
+    auto PipelineCache::compileLoop(std::stop_token stopToken) -> void
+    {
+        while (true)
+        {
+            std::unique_lock lock(mutex);
+            if (!compileCondition.wait(lock, stopToken, [this]() { return !compileRequests.empty(); }))
+            {
+                return;
+            }
+
+            CompileRequest compileRequest = std::move(compileRequests.front());
+            compileRequests.pop_front();
+            lock.unlock();
+
+            try
+            {
+                this->compilePipeline(compileRequest);
+            }
+            catch (std::exception const&)
+            {
+                // Whoever waits for the pipeline gets the error from the future, the next request compiles it again
+            }
+        }
+    }
+
+    auto PipelineCache::getCompileMode() const -> PipelineCompileMode
+    {
+        return compileMode;
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        compilerThreads.clear();
+
+        // Never picked up by a compiler thread, whoever still holds the future gets no pipeline like in the queued
+        // modes instead of a broken promise
+        for (auto& compileRequest : compileRequests)
+        {
+            compileRequest.promise.set_value(nullptr);
+        }
+        compileRequests.clear();
+        pendingEntries.clear();
+
+        this->save();
+        entries.clear();
+        ::vkDestroyPipelineCache(device, pipelineCache, nullptr);
+        ::vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    auto PipelineCache::reset() -> void
+    {
+        entries.clear();
+    }
+
+    auto PipelineCache::getPipelineLayout() -> VkPipelineLayout
+    {
+        return pipelineLayout;
+    }
+
+    VKBuffer::VKBuffer(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                       DestructionQueue* destructionQueue, std::span<uint32_t const> const queueFamilies,
+                       BufferCreateInfo const& createInfo)
+        : device(device), memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator),
+          destructionQueue(destructionQueue), bufferPool(nullptr), memoryAllocation(nullptr), mappedBytes(nullptr),
+          offset(0), size(createInfo.size), flags(createInfo.flags)
+    {
+        VkBufferCreateInfo bufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                            .size = size,
+                                            .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+
+        if (flags & BufferUsage::Vertex)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        }
+        if (flags & BufferUsage::Index)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        }
+        if (flags & BufferUsage::ConstantBuffer)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        }
+        if (flags & BufferUsage::ShaderResource || flags & BufferUsage::UnorderedAccess)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        }
+        if (flags & BufferUsage::UnorderedAccess || flags & BufferUsage::Indirect)
+        {
+            // Arguments of indirect dispatches are written by compute shaders, so storage buffers keep the usage too
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        }
+        if (queueFamilies.size() > 1)
+        {
+            // Buffers are updated in parts, which ownership transfers can't carry without the rest of the contents
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            bufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+        }
+        if (flags & BufferUsage::CopySource)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        }
+        if (flags & BufferUsage::CopyDest)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        }
+
+        VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO};
+
+        if (flags & BufferUsage::MapWrite)
+        {
+            // Upload buffers are the source of staging copies
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            allocationCreateInfo.flags =
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
+        else if (flags & BufferUsage::MapRead)
+        {
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            allocationCreateInfo.flags =
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
+        else
+        {
+            // Device local buffers are filled by CopyContext
+            bufferCreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        }
+
+        // Host visible buffers are mapped for their whole life
+        VmaAllocationInfo allocationInfo;
+        throwIfFailed(::vmaCreateBuffer(memoryAllocator, &bufferCreateInfo, &allocationCreateInfo, &buffer,
+                                        &memoryAllocation, &allocationInfo));
+        mappedBytes = static_cast<uint8_t*>(allocationInfo.pMappedData);
+
+        this->createDescriptors();
+    }
+
+    VKBuffer::VKBuffer(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                       VKBufferPool* bufferPool, DestructionQueue* destructionQueue, BufferCreateInfo const& createInfo)
+        : device(device), memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator),
+          destructionQueue(destructionQueue), bufferPool(bufferPool),
+          bufferAllocation(bufferPool->allocate(createInfo.size)), buffer(bufferAllocation->page->buffer),
+          memoryAllocation(nullptr), mappedBytes(nullptr), offset(bufferAllocation->block.offset),
+          size(createInfo.size), flags(createInfo.flags)
+    {
+        if (bufferAllocation->page->mappedBytes)
+        {
+            mappedBytes = bufferAllocation->page->mappedBytes + offset;
+        }
+
+        this->createDescriptors();
+    }
+
+    auto VKBuffer::createDescriptors() -> void
+    {
+        std::array<std::pair<BufferUsage, VkDescriptorType>, 3> constexpr descriptorUsages{
+            std::make_pair(BufferUsage::ConstantBuffer, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),
+            std::make_pair(BufferUsage::ShaderResource, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER),
+            std::make_pair(BufferUsage::UnorderedAccess, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)};
+
+        for (auto const& [usage, descriptorType] : descriptorUsages)
+        {
+            if (!(flags & usage))
+            {
+                continue;
+            }
+
+            assert(descriptorAllocator && "to create a buffer with views, you need to pass the allocator descriptor");
+
+            DescriptorAllocation descriptorAllocation;
+            throwIfFailed(descriptorAllocator->allocate(VK_DESCRIPTOR_TYPE_MUTABLE_EXT, &descriptorAllocation));
+            descriptorAllocations.emplace(usage, descriptorAllocation);
+
+            // Pool blocks are aligned to VKBufferPool::MinBlockSize, which covers the offset alignment every device
+            // is allowed to require for uniform and storage buffers
+            VkDescriptorBufferInfo const descriptorBufferInfo{.buffer = buffer, .offset = offset, .range = size};
+            VkWriteDescriptorSet const writeDescriptorSet{
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorAllocator->getDescriptorSet(VK_DESCRIPTOR_TYPE_MUTABLE_EXT),
+                .dstBinding = 0,
+                .dstArrayElement = descriptorAllocation.arrayElement,
+                .descriptorCount = 1,
+                .descriptorType = descriptorType,
+                .pBufferInfo = &descriptorBufferInfo};
+            ::vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+        }
+    }
+
+    VKBuffer::~VKBuffer()
+    {
+        for (auto const& [usage, descriptorAllocation] : descriptorAllocations)
+        {
+            if (destructionQueue)
+            {
+                destructionQueue->releaseDescriptor(descriptorAllocation);
+            }
+            else
+            {
+                descriptorAllocator->deallocate(descriptorAllocation);
+            }
+        }
+
+        if (bufferAllocation.has_value())
+        {
+            if (destructionQueue)
+            {
+                destructionQueue->releaseBuffer(bufferPool, bufferAllocation.value());
+            }
+            else
+            {
+                bufferPool->deallocate(bufferAllocation.value());
+            }
+            return;
+        }
+
+        if (!memoryAllocator || !memoryAllocation)
+        {
+            return;
+        }
+
+        if (destructionQueue)
+        {
+            destructionQueue->releaseBuffer(buffer, memoryAllocation);
+        }
+        else
+        {
+            ::vmaDestroyBuffer(memoryAllocator, buffer, memoryAllocation);
+        }
+    }
+
+    auto VKBuffer::getSize() const -> size_t
+    {
+        return size;
+    }
+
+    auto VKBuffer::getFlags() const -> BufferUsageFlags
+    {
+        return flags;
+    }
+
+    auto VKBuffer::getMappedPointer() -> uint8_t*
+    {
+        return mappedBytes;
+    }
+
+    auto VKBuffer::flushMappedRange(uint64_t const offset, size_t const size) -> void
+    {
+        // VMA skips the flush on host coherent memory
+        if (bufferAllocation.has_value())
+        {
+            throwIfFailed(::vmaFlushAllocation(memoryAllocator, bufferAllocation->page->memoryAllocation,
+                                               this->offset + offset, size));
+        }
+        else
+        {
+            throwIfFailed(::vmaFlushAllocation(memoryAllocator, memoryAllocation, offset, size));
+        }
+    }
+
+    auto VKBuffer::invalidateMappedRange(uint64_t const offset, size_t const size) -> void
+    {
+        // VMA skips the invalidation on host coherent memory
+        if (bufferAllocation.has_value())
+        {
+            throwIfFailed(::vmaInvalidateAllocation(memoryAllocator, bufferAllocation->page->memoryAllocation,
+                                                    this->offset + offset, size));
+        }
+        else
+        {
+            throwIfFailed(::vmaInvalidateAllocation(memoryAllocator, memoryAllocation, offset, size));
+        }
     }
 
     auto VKBuffer::getBuffer() -> VkBuffer
@@ -869,25 +1631,38 @@ namespace ionengine::rhi
         return buffer;
     }
 
+    auto VKBuffer::getOffset() const -> uint64_t
+    {
+        return offset;
+    }
+
     auto VKBuffer::getDescriptorOffset(BufferUsage const usage) const -> uint32_t
     {
-        return 0;
+        auto result = descriptorAllocations.find(usage);
+        assert(result != descriptorAllocations.end() && "buffer was not created with the passed usage");
+        return result->second.arrayElement;
     }
 
     VKTexture::VKTexture(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                         DestructionQueue* destructionQueue, std::span<uint32_t const> const queueFamilies,
                          TextureCreateInfo const& createInfo)
         : device(device), memoryAllocator(memoryAllocator), descriptorAllocator(descriptorAllocator),
-          memoryAllocation(nullptr), width(createInfo.width), height(createInfo.height), depth(createInfo.depth),
-          mipLevels(createInfo.mipLevels), format(createInfo.format), dimension(createInfo.dimension),
-          flags(createInfo.flags), initialLayout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+          destructionQueue(destructionQueue), memoryAllocation(nullptr), initialLayout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR),
+          sharingMode(VK_SHARING_MODE_EXCLUSIVE), width(createInfo.width), height(createInfo.height),
+          depth(createInfo.depth), mipLevels(createInfo.mipLevels), format(createInfo.format),
+          dimension(createInfo.dimension), flags(createInfo.flags)
     {
         VkImageCreateInfo imageCreateInfo{.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
                                           .imageType = TextureDimension_to_VkImageType(createInfo.dimension),
-                                          .format = TextureFormat_to_VkFormat(createInfo.format),
+                                          .format = Format_to_VkFormat(createInfo.format),
                                           .extent = {.width = width, .height = height, .depth = depth},
                                           .mipLevels = mipLevels,
                                           .arrayLayers = depth,
-                                          .samples = VK_SAMPLE_COUNT_1_BIT};
+                                          .samples = VK_SAMPLE_COUNT_1_BIT,
+                                          .tiling = VK_IMAGE_TILING_OPTIMAL,
+                                          // CopyContext can upload into any texture like the other backends
+                                          .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                          .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
 
         if (flags & TextureUsage::DepthStencil)
         {
@@ -901,6 +1676,15 @@ namespace ionengine::rhi
         if (flags & TextureUsage::UnorderedAccess)
         {
             imageCreateInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+            if (queueFamilies.size() > 1)
+            {
+                // Written and read by several queues without ownership transfers
+                sharingMode = VK_SHARING_MODE_CONCURRENT;
+                imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+                imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+                imageCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+            }
         }
         if (flags & TextureUsage::ShaderResource)
         {
@@ -914,6 +1698,15 @@ namespace ionengine::rhi
         if (flags & TextureUsage::CopySource)
         {
             imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+            if (queueFamilies.size() > 1)
+            {
+                // Read back by the copy queue after the graphics queue writes it
+                sharingMode = VK_SHARING_MODE_CONCURRENT;
+                imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+                imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+                imageCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+            }
         }
 
         VmaAllocationCreateInfo allocationCreateInfo{.usage = VMA_MEMORY_USAGE_AUTO};
@@ -923,7 +1716,7 @@ namespace ionengine::rhi
         VkImageViewCreateInfo const imageViewCreateInfo{.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
                                                         .image = image,
                                                         .viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-                                                        .format = TextureFormat_to_VkFormat(format),
+                                                        .format = Format_to_VkFormat(format),
                                                         .components = {.r = VK_COMPONENT_SWIZZLE_IDENTITY,
                                                                        .g = VK_COMPONENT_SWIZZLE_IDENTITY,
                                                                        .b = VK_COMPONENT_SWIZZLE_IDENTITY,
@@ -948,14 +1741,16 @@ namespace ionengine::rhi
     }
 
     VKTexture::VKTexture(VkDevice device, VkImage image, uint32_t const width, uint32_t const height)
-        : device(device), memoryAllocator(nullptr), image(image), initialLayout(VK_IMAGE_LAYOUT_UNDEFINED),
-          width(width), height(height), depth(1), mipLevels(1), format(TextureFormat::BGRA8_UNORM),
-          dimension(TextureDimension::_2D), flags((TextureUsageFlags)TextureUsage::RenderTarget)
+        : device(device), memoryAllocator(nullptr), descriptorAllocator(nullptr), destructionQueue(nullptr),
+          image(image), initialLayout(VK_IMAGE_LAYOUT_UNDEFINED), sharingMode(VK_SHARING_MODE_EXCLUSIVE), width(width),
+          height(height), depth(1),
+          mipLevels(1), format(Format::BGRA8_UNORM), dimension(TextureDimension::_2D),
+          flags((TextureUsageFlags)TextureUsage::RenderTarget)
     {
         VkImageViewCreateInfo const imageViewCreateInfo{.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
                                                         .image = image,
                                                         .viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-                                                        .format = TextureFormat_to_VkFormat(format),
+                                                        .format = Format_to_VkFormat(format),
                                                         .components = {.r = VK_COMPONENT_SWIZZLE_IDENTITY,
                                                                        .g = VK_COMPONENT_SWIZZLE_IDENTITY,
                                                                        .b = VK_COMPONENT_SWIZZLE_IDENTITY,
@@ -970,6 +1765,22 @@ namespace ionengine::rhi
 
     VKTexture::~VKTexture()
     {
+        if (destructionQueue)
+        {
+            for (auto const& [usage, descriptorAllocation] : descriptorAllocations)
+            {
+                destructionQueue->releaseDescriptor(descriptorAllocation);
+            }
+
+            destructionQueue->releaseImage(image, imageView, memoryAllocation);
+            return;
+        }
+
+        for (auto const& [usage, descriptorAllocation] : descriptorAllocations)
+        {
+            descriptorAllocator->deallocate(descriptorAllocation);
+        }
+
         ::vkDestroyImageView(device, imageView, nullptr);
         if (memoryAllocator && memoryAllocation)
         {
@@ -997,7 +1808,7 @@ namespace ionengine::rhi
         return mipLevels;
     }
 
-    auto VKTexture::getFormat() const -> TextureFormat
+    auto VKTexture::getFormat() const -> Format
     {
         return format;
     }
@@ -1009,7 +1820,9 @@ namespace ionengine::rhi
 
     auto VKTexture::getDescriptorOffset(TextureUsage const usage) const -> uint32_t
     {
-        return 0;
+        auto result = descriptorAllocations.find(usage);
+        assert(result != descriptorAllocations.end() && "texture was not created with the passed usage");
+        return result->second.arrayElement;
     }
 
     auto VKTexture::getImage() -> VkImage
@@ -1027,7 +1840,13 @@ namespace ionengine::rhi
         return initialLayout;
     }
 
-    VKSampler::VKSampler(VkDevice device, SamplerCreateInfo const& createInfo) : device(device)
+    auto VKTexture::getSharingMode() const -> VkSharingMode
+    {
+        return sharingMode;
+    }
+
+    VKSampler::VKSampler(VkDevice device, DestructionQueue* destructionQueue, SamplerCreateInfo const& createInfo)
+        : device(device), destructionQueue(destructionQueue)
     {
         VkSamplerCreateInfo const samplerCreateInfo{
             .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
@@ -1048,7 +1867,14 @@ namespace ionengine::rhi
 
     VKSampler::~VKSampler()
     {
-        ::vkDestroySampler(device, sampler, nullptr);
+        if (destructionQueue)
+        {
+            destructionQueue->releaseSampler(sampler);
+        }
+        else
+        {
+            ::vkDestroySampler(device, sampler, nullptr);
+        }
     }
 
     auto VKSampler::getDescriptorOffset() const -> uint32_t
@@ -1056,38 +1882,436 @@ namespace ionengine::rhi
         return 0;
     }
 
-    VKFutureImpl::VKFutureImpl(VkDevice device, VkQueue queue, VkSemaphore semaphore, uint64_t const fenceValue)
-        : device(device), queue(queue), semaphore(semaphore), fenceValue(fenceValue)
+    // Written in the order of PipelineStatistics, the results of a query follow the order of the bits
+    VkQueryPipelineStatisticFlags constexpr GraphicsPipelineStatistics =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+    VKQuery::VKQuery(VkDevice device, VmaAllocator memoryAllocator, DestructionQueue* destructionQueue,
+                     float const timestampPeriod, QueryCreateInfo const& createInfo)
+        : device(device), memoryAllocator(memoryAllocator), destructionQueue(destructionQueue),
+          computeQueryPool(nullptr), queryType(createInfo.queryType), count(createInfo.count),
+          timestampPeriod(timestampPeriod), timestampMask(~uint64_t(0)), isPending(false), isResolvedOnHost(false),
+          isHostResult(false), semaphore(nullptr), fenceValue(0)
     {
+        size_t resultSize;
+        if (queryType == QueryType::Timestamp)
+        {
+            VkQueryPoolCreateInfo const queryPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                                            .queryCount = count * 2};
+            throwIfFailed(::vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool));
+            ::vkResetQueryPool(device, queryPool, 0, count * 2);
+
+            resultSize = sizeof(uint64_t) * 2;
+            elapsedTimes.resize(count, 0);
+        }
+        else
+        {
+            VkQueryPoolCreateInfo queryPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                      .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                                                      .queryCount = count,
+                                                      .pipelineStatistics = GraphicsPipelineStatistics};
+            throwIfFailed(::vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool));
+            ::vkResetQueryPool(device, queryPool, 0, count);
+
+            queryPoolCreateInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+            throwIfFailed(::vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &computeQueryPool));
+            ::vkResetQueryPool(device, computeQueryPool, 0, count);
+
+            resultSize = sizeof(PipelineStatistics);
+            statistics.resize(count, PipelineStatistics{});
+        }
+
+        VkBufferCreateInfo const bufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                  .size = resultSize * count,
+                                                  .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                  .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+        VmaAllocationCreateInfo const allocationCreateInfo{
+            .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_AUTO};
+        VmaAllocationInfo allocationInfo;
+        throwIfFailed(::vmaCreateBuffer(memoryAllocator, &bufferCreateInfo, &allocationCreateInfo, &buffer,
+                                        &memoryAllocation, &allocationInfo));
+        mappedData = reinterpret_cast<uint64_t const*>(allocationInfo.pMappedData);
     }
 
-    auto VKFutureImpl::getResult() const -> bool
+    VKQuery::~VKQuery()
     {
-        uint64_t counterValue;
-        throwIfFailed(::vkGetSemaphoreCounterValue(device, semaphore, &counterValue));
-        return counterValue >= fenceValue;
+        // A submission that resolves the query may still be executing
+        destructionQueue->releaseQueryPool(queryPool);
+        if (computeQueryPool)
+        {
+            destructionQueue->releaseQueryPool(computeQueryPool);
+        }
+        destructionQueue->releaseBuffer(buffer, memoryAllocation);
     }
 
-    auto VKFutureImpl::wait() -> void
+    auto VKQuery::getQueryType() const -> QueryType
     {
-        VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
-                                                    .semaphoreCount = 1,
-                                                    .pSemaphores = &semaphore,
-                                                    .pValues = &fenceValue};
-        throwIfFailed(::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max()));
+        return queryType;
     }
 
-    auto VKDeviceContext_barrier(VkCommandBuffer commandBuffer, core::ref_ptr<Buffer> dest, ResourceState const before,
-                                 ResourceState const after) -> void
+    auto VKQuery::getCount() const -> uint32_t
     {
+        return count;
     }
 
-    auto VKDeviceContext_barrier(VkCommandBuffer commandBuffer, core::ref_ptr<Texture> dest, ResourceState const before,
-                                 ResourceState const after) -> void
+    auto VKQuery::getResult() const -> bool
     {
-        auto vkDestTexture = static_cast<VKTexture*>(dest.get());
-
-        auto oldLayout = [&](ResourceState const state) -> VkImageLayout {
+        if (isPending)
+        {
+            return false;
+        }
+        if (!semaphore)
+        {
+            return true;
+        }
+
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, semaphore, &counterValue));
+        return counterValue >= fenceValue;
+    }
+
+    auto VKQuery::getElapsedTimes() -> std::span<uint64_t const>
+    {
+        if (queryType != QueryType::Timestamp)
+        {
+            return {};
+        }
+
+        if (this->getResult())
+        {
+            this->readHostResults();
+        }
+
+        throwIfFailed(::vmaInvalidateAllocation(memoryAllocator, memoryAllocation, 0, VK_WHOLE_SIZE));
+        uint64_t const* results = isHostResult ? hostResults.data() : mappedData;
+        for (uint32_t const i : std::views::iota(0u, count))
+        {
+            uint64_t const ticks = (results[i * 2 + 1] - results[i * 2]) & timestampMask;
+            elapsedTimes[i] = static_cast<uint64_t>(static_cast<double>(ticks) * timestampPeriod);
+        }
+        return elapsedTimes;
+    }
+
+    auto VKQuery::getPipelineStatistics() -> std::span<PipelineStatistics const>
+    {
+        if (queryType != QueryType::PipelineStatistics)
+        {
+            return {};
+        }
+
+        throwIfFailed(::vmaInvalidateAllocation(memoryAllocator, memoryAllocation, 0, VK_WHOLE_SIZE));
+        std::memcpy(statistics.data(), mappedData, sizeof(PipelineStatistics) * count);
+        return statistics;
+    }
+
+    auto VKQuery::getQueryPool(bool const isGraphicsQueue) -> VkQueryPool
+    {
+        return computeQueryPool && !isGraphicsQueue ? computeQueryPool : queryPool;
+    }
+
+    auto VKQuery::resolve(VkCommandBuffer commandBuffer, bool const isGraphicsQueue,
+                          uint32_t const timestampValidBits) -> void
+    {
+        VkQueryPool const resolvedPool = this->getQueryPool(isGraphicsQueue);
+        uint32_t const queryCount = queryType == QueryType::Timestamp ? count * 2 : count;
+        VkQueryResultFlags const resultFlags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT;
+
+        if (resolvedPool == computeQueryPool)
+        {
+            // Only compute invocations are counted, the other statistics of the results are cleared
+            ::vkCmdFillBuffer(commandBuffer, buffer, 0, VK_WHOLE_SIZE, 0);
+
+            VkMemoryBarrier2 const memoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                                 .srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+                                                 .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                                 .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                                 .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT};
+            VkDependencyInfo const dependencyInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                  .memoryBarrierCount = 1,
+                                                  .pMemoryBarriers = &memoryBarrier};
+            ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+            ::vkCmdCopyQueryPoolResults(commandBuffer, resolvedPool, 0, queryCount, buffer,
+                                        offsetof(PipelineStatistics, computeShaderInvocations),
+                                        sizeof(PipelineStatistics), resultFlags);
+        }
+        else
+        {
+            VkDeviceSize const resultStride =
+                queryType == QueryType::Timestamp ? sizeof(uint64_t) : sizeof(PipelineStatistics);
+            ::vkCmdCopyQueryPoolResults(commandBuffer, resolvedPool, 0, queryCount, buffer, 0, resultStride,
+                                        resultFlags);
+        }
+        ::vkCmdResetQueryPool(commandBuffer, resolvedPool, 0, queryCount);
+
+        // The copied results are read by the host once the submission completes
+        VkMemoryBarrier2 const memoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                             .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                             .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                             .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+                                             .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT};
+        VkDependencyInfo const dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .memoryBarrierCount = 1, .pMemoryBarriers = &memoryBarrier};
+        ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+        timestampMask = timestampValidBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << timestampValidBits) - 1;
+        isPending = true;
+        isHostResult = false;
+    }
+
+    auto VKQuery::resolveOnHost(uint32_t const timestampValidBits) -> void
+    {
+        assert(queryType == QueryType::Timestamp && "only timestamps are resolved on the host");
+
+        timestampMask = timestampValidBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << timestampValidBits) - 1;
+        isPending = true;
+        isResolvedOnHost = true;
+    }
+
+    auto VKQuery::readHostResults() -> void
+    {
+        if (!isResolvedOnHost)
+        {
+            return;
+        }
+
+        hostResults.resize(count * 2);
+        throwIfFailed(::vkGetQueryPoolResults(device, queryPool, 0, count * 2, sizeof(uint64_t) * hostResults.size(),
+                                              hostResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+        ::vkResetQueryPool(device, queryPool, 0, count * 2);
+
+        isResolvedOnHost = false;
+        isHostResult = true;
+    }
+
+    auto VKQuery::markSubmitted(VkSemaphore semaphore, uint64_t const fenceValue) -> void
+    {
+        this->semaphore = semaphore;
+        this->fenceValue = fenceValue;
+        isPending = false;
+    }
+
+    VKFutureImpl::VKFutureImpl(VkDevice device, VkQueue queue, VkSemaphore semaphore, uint64_t const fenceValue)
+        : device(device), queue(queue), semaphore(semaphore), fenceValue(fenceValue), copyContext(nullptr)
+    {
+    }
+
+    VKFutureImpl::VKFutureImpl(VkDevice device, VkQueue queue, VkSemaphore semaphore, uint64_t const fenceValue,
+                               VKCopyContext* copyContext)
+        : device(device), queue(queue), semaphore(semaphore), fenceValue(fenceValue), copyContext(copyContext)
+    {
+    }
+
+    auto VKFutureImpl::getResult() const -> bool
+    {
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, semaphore, &counterValue));
+        return counterValue >= fenceValue;
+    }
+
+    auto VKFutureImpl::wait() -> void
+    {
+        VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                    .semaphoreCount = 1,
+                                                    .pSemaphores = &semaphore,
+                                                    .pValues = &fenceValue};
+        throwIfFailed(::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max()));
+    }
+
+    auto VKFutureImpl::waitOnContext(IDeviceContext* context) -> void
+    {
+        if (auto graphicsContext = dynamic_cast<VKGraphicsContext*>(context))
+        {
+            graphicsContext->waitSemaphore(semaphore, fenceValue);
+
+            if (copyContext)
+            {
+                copyContext->handOff(fenceValue, graphicsContext);
+            }
+        }
+        else if (auto computeContext = dynamic_cast<VKComputeContext*>(context))
+        {
+            computeContext->waitSemaphore(semaphore, fenceValue);
+        }
+        else if (auto copyContext = dynamic_cast<VKCopyContext*>(context))
+        {
+            copyContext->waitSemaphore(semaphore, fenceValue);
+        }
+    }
+
+    auto VKDeviceContext_submit(DeviceQueueData& deviceQueue, std::span<VkCommandBuffer const> const commandBuffers,
+                                uint32_t const commandListCount, std::vector<VkSemaphore>& waitSemaphores,
+                                std::vector<uint64_t>& waitValues) -> uint64_t
+    {
+        std::vector<VkPipelineStageFlags> const waitDstStageMasks(waitSemaphores.size(),
+                                                                  VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        // Values have to reach the queue in the order they are taken
+        std::lock_guard lock(*deviceQueue.submitMutex);
+
+        uint64_t const signalValue = deviceQueue.fenceValue + 1;
+        VkTimelineSemaphoreSubmitInfo const semaphoreSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+            .waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+            .pWaitSemaphoreValues = waitValues.data(),
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &signalValue};
+        VkSubmitInfo const submitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                      .pNext = &semaphoreSubmitInfo,
+                                      .waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+                                      .pWaitSemaphores = waitSemaphores.data(),
+                                      .pWaitDstStageMask = waitDstStageMasks.data(),
+                                      .commandBufferCount = static_cast<uint32_t>(commandBuffers.size()),
+                                      .pCommandBuffers = commandBuffers.data(),
+                                      .signalSemaphoreCount = 1,
+                                      .pSignalSemaphores = &deviceQueue.semaphore};
+        throwIfFailed(::vkQueueSubmit(deviceQueue.queue, 1, &submitInfo, nullptr));
+        deviceQueue.fenceValue = signalValue;
+        // Contexts can add command buffers of their own, e.g. for acquires, so the closed lists are counted by them
+        deviceQueue.openCommandLists -= commandListCount;
+
+        waitSemaphores.clear();
+        waitValues.clear();
+        return signalValue;
+    }
+
+    auto VKDeviceContext_uavBarrier(VkCommandBuffer commandBuffer) -> void
+    {
+        // A global barrier is cheaper than one per resource and covers images in the general layout as well
+        VkMemoryBarrier2 const memoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                             .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                             .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                             .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                             .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                              VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT};
+        VkDependencyInfo const dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .memoryBarrierCount = 1, .pMemoryBarriers = &memoryBarrier};
+        ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+
+    auto VKDeviceContext_beginQuery(VkCommandBuffer commandBuffer, DeviceQueueData const& deviceQueue,
+                                    bool const isGraphicsQueue, Query* query, uint32_t const index) -> void
+    {
+        assert(index < query->getCount() && "query index is out of range");
+
+        auto vkQuery = static_cast<VKQuery*>(query);
+        if (query->getQueryType() == QueryType::Timestamp)
+        {
+            if (deviceQueue.timestampValidBits == 0)
+            {
+                throw std::runtime_error("queue does not support timestamps");
+            }
+            ::vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+                                   vkQuery->getQueryPool(isGraphicsQueue), index * 2);
+        }
+        else
+        {
+            ::vkCmdBeginQuery(commandBuffer, vkQuery->getQueryPool(isGraphicsQueue), index, 0);
+        }
+    }
+
+    auto VKDeviceContext_endQuery(VkCommandBuffer commandBuffer, bool const isGraphicsQueue, Query* query,
+                                  uint32_t const index) -> void
+    {
+        assert(index < query->getCount() && "query index is out of range");
+
+        auto vkQuery = static_cast<VKQuery*>(query);
+        if (query->getQueryType() == QueryType::Timestamp)
+        {
+            ::vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+                                   vkQuery->getQueryPool(isGraphicsQueue), index * 2 + 1);
+        }
+        else
+        {
+            ::vkCmdEndQuery(commandBuffer, vkQuery->getQueryPool(isGraphicsQueue), index);
+        }
+    }
+
+    auto VKDeviceContext_resolveQuery(VkCommandBuffer commandBuffer, DeviceQueueData const& deviceQueue,
+                                      bool const isGraphicsQueue, std::vector<core::ref_ptr<VKQuery>>& resolvedQueries,
+                                      Query* query) -> void
+    {
+        auto vkQuery = static_cast<VKQuery*>(query);
+        vkQuery->resolve(commandBuffer, isGraphicsQueue, deviceQueue.timestampValidBits);
+        resolvedQueries.emplace_back(vkQuery);
+    }
+
+    auto VKDeviceContext_submitQueries(DeviceQueueData const& deviceQueue, uint64_t const fenceValue,
+                                       std::vector<core::ref_ptr<VKQuery>>& resolvedQueries) -> void
+    {
+        for (auto const& query : resolvedQueries)
+        {
+            query->markSubmitted(deviceQueue.semaphore, fenceValue);
+        }
+        resolvedQueries.clear();
+    }
+
+    auto VKDeviceContext_subresourceBarrier(VkImage image, uint32_t const mipLevel, uint32_t const arrayLayer,
+                                            VkImageLayout const oldLayout, VkImageLayout const newLayout,
+                                            VKStageAccess const& srcStageAccess, VKStageAccess const& dstStageAccess)
+        -> VkImageMemoryBarrier2
+    {
+        return VkImageMemoryBarrier2{.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                     .srcStageMask = srcStageAccess.stageMask,
+                                     .srcAccessMask = srcStageAccess.accessMask,
+                                     .dstStageMask = dstStageAccess.stageMask,
+                                     .dstAccessMask = dstStageAccess.accessMask,
+                                     .oldLayout = oldLayout,
+                                     .newLayout = newLayout,
+                                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .image = image,
+                                     .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                                          .baseMipLevel = mipLevel,
+                                                          .levelCount = 1,
+                                                          .baseArrayLayer = arrayLayer,
+                                                          .layerCount = 1}};
+    }
+
+    VKBarrierBatcher::VKBarrierBatcher(BarrierCounters& counters, VkPipelineStageFlags2 const queueStages)
+        : barrierBatcher(counters), queueStages(queueStages)
+    {
+    }
+
+    auto VKBarrierBatcher::barrier(VkCommandBuffer commandBuffer, Buffer* destBuffer, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
+    {
+        auto vkDestBuffer = static_cast<VKBuffer*>(destBuffer);
+
+        VKStageAccess const srcStageAccess = ResourceState_to_VKStageAccess(beforeState, queueStages);
+        VKStageAccess const dstStageAccess = ResourceState_to_VKStageAccess(afterState, queueStages);
+
+        VkBufferMemoryBarrier2 const bufferMemoryBarrier{.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                                                         .srcStageMask = srcStageAccess.stageMask,
+                                                         .srcAccessMask = srcStageAccess.accessMask,
+                                                         .dstStageMask = dstStageAccess.stageMask,
+                                                         .dstAccessMask = dstStageAccess.accessMask,
+                                                         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                                         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                                         .buffer = vkDestBuffer->getBuffer(),
+                                                         .offset = vkDestBuffer->getOffset(),
+                                                         .size = vkDestBuffer->getSize()};
+
+        if (barrierBatcher.contains(destBuffer))
+        {
+            this->flush(commandBuffer);
+        }
+        barrierBatcher.addBufferBarrier(destBuffer, bufferMemoryBarrier);
+    }
+
+    auto VKBarrierBatcher::barrier(VkCommandBuffer commandBuffer, Texture* destTexture,
+                                   ResourceState const beforeState, ResourceState const afterState) -> void
+    {
+        auto vkDestTexture = static_cast<VKTexture*>(destTexture);
+
+        auto oldLayout = [&](ResourceState const state) -> VkImageLayout {
             VkImageLayout const initialLayout = vkDestTexture->getInitialLayout();
             return state == ResourceState::Common && initialLayout == VK_IMAGE_LAYOUT_UNDEFINED
                        ? initialLayout
@@ -1101,40 +2325,98 @@ namespace ionengine::rhi
                        : ResourceState_to_VkImageLayout(state);
         };
 
-        VkImageMemoryBarrier const imageMemoryBarrier{.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                                      .srcAccessMask =
-                                                          VkImageLayout_to_VkAccessFlags(oldLayout(before)),
-                                                      .dstAccessMask = VkImageLayout_to_VkAccessFlags(newLayout(after)),
-                                                      .oldLayout = oldLayout(before),
-                                                      .newLayout = newLayout(after),
-                                                      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                                      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                                      .image = static_cast<VKTexture*>(dest.get())->getImage(),
-                                                      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                                                           .baseMipLevel = 0,
-                                                                           .levelCount = dest->getMipLevels(),
-                                                                           .baseArrayLayer = 0,
-                                                                           .layerCount = dest->getDepth()}};
-        ::vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                               VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+        VKStageAccess const srcStageAccess = ResourceState_to_VKStageAccess(beforeState, queueStages);
+        VKStageAccess const dstStageAccess = ResourceState_to_VKStageAccess(afterState, queueStages);
+
+        VkImageMemoryBarrier2 const imageMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = srcStageAccess.stageMask,
+            .srcAccessMask = srcStageAccess.accessMask,
+            .dstStageMask = dstStageAccess.stageMask,
+            .dstAccessMask = dstStageAccess.accessMask,
+            .oldLayout = oldLayout(beforeState),
+            .newLayout = newLayout(afterState),
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = vkDestTexture->getImage(),
+            .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                 .baseMipLevel = 0,
+                                 .levelCount = destTexture->getMipLevels(),
+                                 .baseArrayLayer = 0,
+                                 .layerCount = destTexture->getDepth()}};
+        this->barrier(commandBuffer, destTexture, imageMemoryBarrier);
+    }
+
+    auto VKBarrierBatcher::barrier(VkCommandBuffer commandBuffer, Texture* destTexture,
+                                   VkImageMemoryBarrier2 const& imageMemoryBarrier) -> void
+    {
+        if (barrierBatcher.contains(destTexture))
+        {
+            this->flush(commandBuffer);
+        }
+        barrierBatcher.addImageBarrier(destTexture, imageMemoryBarrier);
+    }
+
+    auto VKBarrierBatcher::flush(VkCommandBuffer commandBuffer) -> void
+    {
+        barrierBatcher.flush([&](std::span<VkBufferMemoryBarrier2 const> const bufferBarriers,
+                                 std::span<VkImageMemoryBarrier2 const> const imageBarriers) {
+            VkDependencyInfo const dependencyInfo{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size()),
+                .pBufferMemoryBarriers = bufferBarriers.data(),
+                .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+                .pImageMemoryBarriers = imageBarriers.data()};
+            ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        });
     }
 
+    // Stages each kind of queue executes, barriers recorded for a queue leave out the other ones
+    VkPipelineStageFlags2 constexpr GraphicsQueueStages = ~VkPipelineStageFlags2(0);
+    VkPipelineStageFlags2 constexpr ComputeQueueStages =
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COPY_BIT;
+    VkPipelineStageFlags2 constexpr TransferQueueStages =
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COPY_BIT;
+
     VKGraphicsContext::VKGraphicsContext(VkDevice device, PipelineCache* pipelineCache,
-                                         DescriptorAllocator* descriptorAllocator, DeviceQueueData& deviceQueue)
+                                         DescriptorAllocator* descriptorAllocator, DestructionQueue* destructionQueue,
+                                         DeviceQueueData& deviceQueue, BarrierCounters& barrierCounters,
+                                         StateCounters& stateCounters, VKCopyContext* copyContext,
+                                         DeviceFeatureData const& deviceFeatures)
         : device(device), pipelineCache(pipelineCache), descriptorAllocator(descriptorAllocator),
-          deviceQueue(&deviceQueue), isCommandListOpened(false)
+          destructionQueue(destructionQueue), deviceQueue(&deviceQueue), copyContext(copyContext),
+          deviceFeatures(deviceFeatures),
+          barrierBatcher(barrierCounters, GraphicsQueueStages), stateCache(stateCounters), commandPool(nullptr),
+          commandBuffer(nullptr), acquireCommandBuffer(nullptr), isCommandListOpened(false), isPipelineBound(false)
     {
-        VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                                                            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-                                                            .queueFamilyIndex = deviceQueue.familyIndex};
-        throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
-
         bindingData.resize(sizeof(uint32_t) * 4 * 16);
     }
 
     VKGraphicsContext::~VKGraphicsContext()
     {
-        ::vkDestroyCommandPool(device, commandPool, nullptr);
+        if (!submittedPools.empty())
+        {
+            VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                        .semaphoreCount = 1,
+                                                        .pSemaphores = &deviceQueue->semaphore,
+                                                        .pValues = &submittedPools.back().fenceValue};
+            ::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max());
+        }
+
+        if (isCommandListOpened)
+        {
+            deviceQueue->openCommandLists--;
+            ::vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+        for (auto const& poolData : submittedPools)
+        {
+            ::vkDestroyCommandPool(device, poolData.commandPool, nullptr);
+        }
+        for (auto const& poolData : freePools)
+        {
+            ::vkDestroyCommandPool(device, poolData.commandPool, nullptr);
+        }
     }
 
     auto VKGraphicsContext::tryAllocateCommandBuffer() -> void
@@ -1144,14 +2426,41 @@ namespace ionengine::rhi
             return;
         }
 
-        throwIfFailed(::vkResetCommandPool(device, commandPool, 0));
+        if (!submittedPools.empty())
+        {
+            uint64_t counterValue;
+            throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
 
-        VkCommandBufferAllocateInfo const commandBufferAllocInfo{.sType =
-                                                                     VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                                                 .commandPool = commandPool,
-                                                                 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                                                 .commandBufferCount = 1};
-        throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+            while (!submittedPools.empty() && submittedPools.front().fenceValue <= counterValue)
+            {
+                freePools.emplace_back(submittedPools.front());
+                submittedPools.pop_front();
+            }
+        }
+
+        if (freePools.empty())
+        {
+            VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                                .queueFamilyIndex = deviceQueue->familyIndex};
+            throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+
+            VkCommandBufferAllocateInfo const commandBufferAllocInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = commandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1};
+            throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+            acquireCommandBuffer = nullptr;
+        }
+        else
+        {
+            commandPool = freePools.back().commandPool;
+            commandBuffer = freePools.back().commandBuffer;
+            acquireCommandBuffer = freePools.back().acquireCommandBuffer;
+            freePools.pop_back();
+            throwIfFailed(::vkResetCommandPool(device, commandPool, 0));
+        }
 
         VkCommandBufferBeginInfo const commandBufferBeginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
                                                               .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
@@ -1164,89 +2473,230 @@ namespace ionengine::rhi
                                   2, descriptorSets.data(), 0, nullptr);
 
         isCommandListOpened = true;
+        deviceQueue->openCommandLists++;
         renderArea = {};
     }
 
-    auto VKGraphicsContext::execute() -> Future<void>
+    auto VKGraphicsContext::beginQuery(Query* query, uint32_t const index) -> void
     {
-        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
-        isCommandListOpened = false;
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
 
-        deviceQueue->fenceValue++;
-        VkTimelineSemaphoreSubmitInfo const semaphoreSubmitInfo{
-            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
-            .signalSemaphoreValueCount = 1,
-            .pSignalSemaphoreValues = &deviceQueue->fenceValue};
-        VkSubmitInfo const submitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                                      .pNext = &semaphoreSubmitInfo,
-                                      .commandBufferCount = 1,
-                                      .pCommandBuffers = &commandBuffer,
-                                      .signalSemaphoreCount = 1,
-                                      .pSignalSemaphores = &deviceQueue->semaphore};
-        throwIfFailed(::vkQueueSubmit(deviceQueue->queue, 1, &submitInfo, nullptr));
+        VKDeviceContext_beginQuery(commandBuffer, *deviceQueue, true, query, index);
+    }
 
-        auto futureImpl =
-            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, deviceQueue->fenceValue);
-        return Future<void>(std::move(futureImpl));
+    auto VKGraphicsContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_endQuery(commandBuffer, true, query, index);
     }
 
-    auto VKGraphicsContext::setGraphicsPipelineOptions(core::ref_ptr<Shader> shader,
-                                                       RasterizerStageInfo const& rasterizer,
-                                                       BlendColorInfo const& blendColor,
-                                                       std::optional<DepthStencilStageInfo> const depthStencil) -> void
+    auto VKGraphicsContext::resolveQuery(Query* query) -> void
     {
         this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
 
-        auto vkShader = dynamic_cast<VKShader*>(shader.get());
+        VKDeviceContext_resolveQuery(commandBuffer, *deviceQueue, true, resolvedQueries, query);
+    }
+
+    auto VKGraphicsContext::execute() -> Future<void>
+    {
+        std::vector<VkCommandBuffer> commandBuffers;
+        this->close(commandBuffers);
+        uint64_t const fenceValue =
+            VKDeviceContext_submit(*deviceQueue, commandBuffers, 1, waitSemaphores, waitValues);
+        this->markSubmitted(fenceValue);
 
-        auto pipeline =
-            pipelineCache->get(vkShader, rasterizer, blendColor, depthStencil, renderTargetFormats, depthStencilFormat);
+        destructionQueue->collect();
 
-        ::vkCmdBindPipeline(commandBuffer, pipeline->getPipelineType(), pipeline->getPipeline());
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, fenceValue);
+        return Future<void>(std::move(futureImpl));
     }
 
-    auto VKGraphicsContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    auto VKGraphicsContext::waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void
     {
-        std::memcpy(bindingData.data() + index * sizeof(uint32_t) * 4, &descriptor, sizeof(uint32_t));
+        waitSemaphores.emplace_back(semaphore);
+        waitValues.emplace_back(value);
     }
 
-    auto VKGraphicsContext::beginRenderPass(std::span<RenderPassColorInfo const> const colors,
-                                            std::optional<RenderPassDepthStencilInfo> depthStencil) -> void
+    auto VKGraphicsContext::takeWaitSemaphores(std::vector<VkSemaphore>& semaphores, std::vector<uint64_t>& values)
+        -> void
+    {
+        semaphores.insert(semaphores.end(), waitSemaphores.begin(), waitSemaphores.end());
+        values.insert(values.end(), waitValues.begin(), waitValues.end());
+        waitSemaphores.clear();
+        waitValues.clear();
+    }
+
+    auto VKGraphicsContext::acquireOwnership(Texture* texture, VkImageMemoryBarrier2 const& imageBarrier) -> void
     {
         this->tryAllocateCommandBuffer();
 
-        renderTargetFormats.fill(VK_FORMAT_UNDEFINED);
-        depthStencilFormat = VK_FORMAT_UNDEFINED;
+        barrierBatcher.barrier(commandBuffer, texture, imageBarrier);
+    }
 
-        std::array<VkRenderingAttachmentInfo, 8> colorAttachmentInfos;
-        for (uint32_t const i : std::views::iota(0u, colors.size()))
+    auto VKGraphicsContext::close(std::vector<VkCommandBuffer>& commandBuffers) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
+        isCommandListOpened = false;
+        isPipelineBound = false;
+        stateCache.reset();
+
+        std::vector<VkImageMemoryBarrier2> acquireBarriers;
+        if (copyContext)
         {
-            auto vkTexture = dynamic_cast<VKTexture*>(colors[i].texture.get());
-            renderTargetFormats[i] = TextureFormat_to_VkFormat(vkTexture->getFormat());
+            copyContext->handOffSubmitted(acquireBarriers, waitSemaphores, waitValues);
+        }
 
-            VkRenderingAttachmentInfo const renderingAttachmentInfo{
-                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-                .imageView = vkTexture->getImageView(),
-                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                .loadOp = RenderPassLoadOp_to_VkAttachmentLoadOp(colors[i].loadOp),
-                .storeOp = RenderPassStoreOp_to_VkAttachmentStoreOp(colors[i].storeOp),
-                .clearValue = {.color = {.float32 = {colors[i].clearColor.r, colors[i].clearColor.g,
-                                                     colors[i].clearColor.b, colors[i].clearColor.a}}}};
-            colorAttachmentInfos[i] = std::move(renderingAttachmentInfo);
+        if (!acquireBarriers.empty())
+        {
+            if (!acquireCommandBuffer)
+            {
+                VkCommandBufferAllocateInfo const commandBufferAllocInfo{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = commandPool,
+                    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    .commandBufferCount = 1};
+                throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &acquireCommandBuffer));
+            }
+
+            VkCommandBufferBeginInfo const commandBufferBeginInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+            throwIfFailed(::vkBeginCommandBuffer(acquireCommandBuffer, &commandBufferBeginInfo));
+
+            VkDependencyInfo const dependencyInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                  .imageMemoryBarrierCount =
+                                                      static_cast<uint32_t>(acquireBarriers.size()),
+                                                  .pImageMemoryBarriers = acquireBarriers.data()};
+            ::vkCmdPipelineBarrier2(acquireCommandBuffer, &dependencyInfo);
+
+            throwIfFailed(::vkEndCommandBuffer(acquireCommandBuffer));
+            commandBuffers.emplace_back(acquireCommandBuffer);
         }
+        commandBuffers.emplace_back(commandBuffer);
+    }
 
-        VkRenderingInfo renderingInfo{.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
-                                      .renderArea = renderArea,
-                                      .layerCount = 1,
-                                      .colorAttachmentCount = static_cast<uint32_t>(colors.size()),
-                                      .pColorAttachments = colorAttachmentInfos.data()};
+    auto VKGraphicsContext::markSubmitted(uint64_t const fenceValue) -> void
+    {
+        submittedPools.emplace_back(CommandPoolData{.commandPool = commandPool,
+                                                    .commandBuffer = commandBuffer,
+                                                    .acquireCommandBuffer = acquireCommandBuffer,
+                                                    .fenceValue = fenceValue});
+        VKDeviceContext_submitQueries(*deviceQueue, fenceValue, resolvedQueries);
+    }
 
-        if (depthStencil.has_value())
+    auto VKGraphicsContext::setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
+                                                       BlendColorInfo const& blendColor,
+                                                       std::optional<DepthStencilStageInfo> const depthStencil) -> bool
+    {
+        this->tryAllocateCommandBuffer();
+
+        // The same options give the same pipeline, which is still bound since it was ready when it was set
+        if (!stateCache.setPipeline(shader, rasterizer, blendColor, depthStencil))
         {
-            auto value = depthStencil.value();
+            return true;
+        }
 
-            auto vkTexture = dynamic_cast<VKTexture*>(value.texture.get());
-            depthStencilFormat = TextureFormat_to_VkFormat(vkTexture->getFormat());
+        auto vkShader = dynamic_cast<VKShader*>(shader);
+
+        PipelineCompileMode const compileMode = pipelineCache->getCompileMode();
+        auto pipeline = pipelineCache->get(vkShader, rasterizer, blendColor, depthStencil, renderTargetFormats,
+                                           depthStencilFormat, compileMode);
+        bool const isPipelineReady = static_cast<bool>(pipeline);
+
+        if (!isPipelineReady && compileMode == PipelineCompileMode::Fallback && fallbackShader)
+        {
+            // A single simple shader per render target layout, cheap enough to compile in place
+            pipeline = pipelineCache->get(fallbackShader.get(), rasterizer, blendColor, depthStencil,
+                                          renderTargetFormats, depthStencilFormat, PipelineCompileMode::Blocking);
+        }
+
+        isPipelineBound = static_cast<bool>(pipeline);
+        if (isPipelineBound)
+        {
+            ::vkCmdBindPipeline(commandBuffer, pipeline->getPipelineType(), pipeline->getPipeline());
+        }
+        if (!isPipelineReady)
+        {
+            // Looked up again on the next set until the compilation finishes
+            stateCache.invalidatePipeline();
+        }
+        return isPipelineReady;
+    }
+
+    auto VKGraphicsContext::setFallbackShader(Shader* shader) -> void
+    {
+        fallbackShader = dynamic_cast<VKShader*>(shader);
+    }
+
+    auto VKGraphicsContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    {
+        if (!stateCache.setDescriptor(index, descriptor))
+        {
+            return;
+        }
+
+        std::memcpy(bindingData.data() + index * sizeof(uint32_t) * 4, &descriptor, sizeof(uint32_t));
+    }
+
+    auto VKGraphicsContext::beginRenderPass(std::span<RenderPassColorInfo const> const colors,
+                                            std::optional<RenderPassDepthStencilInfo> depthStencil) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        auto const previousRenderTargetFormats = renderTargetFormats;
+        VkFormat const previousDepthStencilFormat = depthStencilFormat;
+
+        renderTargetFormats.fill(VK_FORMAT_UNDEFINED);
+        depthStencilFormat = VK_FORMAT_UNDEFINED;
+
+        std::array<VkRenderingAttachmentInfo, 8> colorAttachmentInfos;
+        for (uint32_t const i : std::views::iota(0u, colors.size()))
+        {
+            auto vkTexture = dynamic_cast<VKTexture*>(colors[i].texture);
+            renderTargetFormats[i] = Format_to_VkFormat(vkTexture->getFormat());
+
+            VkRenderingAttachmentInfo const renderingAttachmentInfo{
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .imageView = vkTexture->getImageView(),
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .loadOp = RenderPassLoadOp_to_VkAttachmentLoadOp(colors[i].loadOp),
+                .storeOp = RenderPassStoreOp_to_VkAttachmentStoreOp(colors[i].storeOp),
+                .clearValue = {.color = {.float32 = {colors[i].clearColor.r, colors[i].clearColor.g,
+                                                     colors[i].clearColor.b, colors[i].clearColor.a}}}};
+            colorAttachmentInfos[i] = std::move(renderingAttachmentInfo);
+        }
+
+        VkRenderingInfo renderingInfo{.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                                      .renderArea = renderArea,
+                                      .layerCount = 1,
+                                      .colorAttachmentCount = static_cast<uint32_t>(colors.size()),
+                                      .pColorAttachments = colorAttachmentInfos.data()};
+
+        if (depthStencil.has_value())
+        {
+            depthStencilFormat = Format_to_VkFormat(depthStencil.value().texture->getFormat());
+        }
+
+        // Pipelines are compiled for the formats, so the cached one can't be kept for other ones
+        if (renderTargetFormats != previousRenderTargetFormats || depthStencilFormat != previousDepthStencilFormat)
+        {
+            stateCache.invalidatePipeline();
+        }
+
+        if (depthStencil.has_value())
+        {
+            auto value = depthStencil.value();
+
+            auto vkTexture = dynamic_cast<VKTexture*>(value.texture);
 
             VkRenderingAttachmentInfo const depthAttachmentInfo{
                 .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
@@ -1279,181 +2729,1194 @@ namespace ionengine::rhi
         ::vkCmdEndRendering(commandBuffer);
     }
 
-    auto VKGraphicsContext::bindVertexBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
-        -> void
+    auto VKGraphicsContext::bindVertexBuffer(Buffer* buffer, uint64_t const offset, size_t const size) -> void
     {
-        auto vkBuffer = dynamic_cast<VKBuffer*>(buffer.get());
+        if (!stateCache.setVertexBuffer(buffer, offset, size))
+        {
+            return;
+        }
+
+        auto vkBuffer = dynamic_cast<VKBuffer*>(buffer);
 
         std::array<VkBuffer, 1> const buffers{vkBuffer->getBuffer()};
-        ::vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers.data(), &offset);
+        std::array<VkDeviceSize, 1> const offsets{vkBuffer->getOffset() + offset};
+        ::vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers.data(), offsets.data());
     }
 
-    auto VKGraphicsContext::bindIndexBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size,
-                                            IndexFormat const format) -> void
+    auto VKGraphicsContext::bindIndexBuffer(Buffer* buffer, uint64_t const offset, size_t const size,
+                                            Format const format) -> void
     {
-        auto vkBuffer = dynamic_cast<VKBuffer*>(buffer.get());
+        if (!stateCache.setIndexBuffer(buffer, offset, size, format))
+        {
+            return;
+        }
+
+        auto vkBuffer = dynamic_cast<VKBuffer*>(buffer);
 
         VkIndexType indexType;
         switch (format)
         {
-            case IndexFormat::Uint32: {
+            case Format::R32_UINT: {
                 indexType = VkIndexType::VK_INDEX_TYPE_UINT32;
                 break;
             }
-            case IndexFormat::Uint16: {
+            case Format::R16_UINT: {
                 indexType = VkIndexType::VK_INDEX_TYPE_UINT16;
                 break;
             }
+            default:
+                throw std::invalid_argument("unknown VkIndexType for passed argument");
+        }
+
+        ::vkCmdBindIndexBuffer(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset, indexType);
+    }
+
+    auto VKGraphicsContext::drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        ::vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
+    }
+
+    auto VKGraphicsContext::draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        ::vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
+    }
+
+    static_assert(sizeof(DrawIndirectArguments) == sizeof(VkDrawIndirectCommand));
+    static_assert(sizeof(DrawIndexedIndirectArguments) == sizeof(VkDrawIndexedIndirectCommand));
+
+    auto VKGraphicsContext::drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        auto vkBuffer = static_cast<VKBuffer*>(buffer);
+        if (deviceFeatures.isMultiDrawIndirectSupported || drawCount <= 1)
+        {
+            ::vkCmdDrawIndirect(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset, drawCount,
+                                sizeof(DrawIndirectArguments));
+        }
+        else
+        {
+            // A single draw is always allowed, so the arguments are walked one command at a time
+            for (uint32_t i = 0; i < drawCount; ++i)
+            {
+                ::vkCmdDrawIndirect(commandBuffer, vkBuffer->getBuffer(),
+                                    vkBuffer->getOffset() + offset + i * sizeof(DrawIndirectArguments), 1,
+                                    sizeof(DrawIndirectArguments));
+            }
+        }
+    }
+
+    auto VKGraphicsContext::drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount)
+        -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        auto vkBuffer = static_cast<VKBuffer*>(buffer);
+        if (deviceFeatures.isMultiDrawIndirectSupported || drawCount <= 1)
+        {
+            ::vkCmdDrawIndexedIndirect(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset,
+                                       drawCount, sizeof(DrawIndexedIndirectArguments));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < drawCount; ++i)
+            {
+                ::vkCmdDrawIndexedIndirect(commandBuffer, vkBuffer->getBuffer(),
+                                           vkBuffer->getOffset() + offset + i * sizeof(DrawIndexedIndirectArguments),
+                                           1, sizeof(DrawIndexedIndirectArguments));
+            }
+        }
+    }
+
+    auto VKGraphicsContext::drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                              uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        if (!deviceFeatures.isDrawIndirectCountSupported)
+        {
+            // The count is only known by the device, so there is nothing to fall back to on the host
+            throw std::runtime_error("device does not support drawIndirectCount");
+        }
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        auto vkBuffer = static_cast<VKBuffer*>(buffer);
+        auto vkCountBuffer = static_cast<VKBuffer*>(countBuffer);
+        ::vkCmdDrawIndirectCount(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset,
+                                 vkCountBuffer->getBuffer(), vkCountBuffer->getOffset() + countOffset, maxDrawCount,
+                                 sizeof(DrawIndirectArguments));
+    }
+
+    auto VKGraphicsContext::drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                                     uint64_t const countOffset, uint32_t const maxDrawCount) -> void
+    {
+        if (!deviceFeatures.isDrawIndirectCountSupported)
+        {
+            throw std::runtime_error("device does not support drawIndirectCount");
+        }
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        if (stateCache.takeDirtyBindings())
+        {
+            ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                                 bindingData.data());
+        }
+        auto vkBuffer = static_cast<VKBuffer*>(buffer);
+        auto vkCountBuffer = static_cast<VKBuffer*>(countBuffer);
+        ::vkCmdDrawIndexedIndirectCount(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset,
+                                        vkCountBuffer->getBuffer(), vkCountBuffer->getOffset() + countOffset,
+                                        maxDrawCount, sizeof(DrawIndexedIndirectArguments));
+    }
+
+    auto VKGraphicsContext::setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
+        -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        if (!stateCache.setViewport(x, y, width, height))
+        {
+            return;
+        }
+
+        VkViewport const viewport{.x = static_cast<float>(x),
+                                  .y = static_cast<float>(y),
+                                  .width = static_cast<float>(width),
+                                  .height = static_cast<float>(height),
+                                  .minDepth = 0.0f,
+                                  .maxDepth = 1.0f};
+        ::vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    }
+
+    auto VKGraphicsContext::setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
+        -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        if (!stateCache.setScissor(left, top, right, bottom))
+        {
+            return;
+        }
+
+        VkRect2D const rect{.offset = {.x = left, .y = top},
+                            .extent = {.width = static_cast<uint32_t>(right), .height = static_cast<uint32_t>(bottom)}};
+        ::vkCmdSetScissor(commandBuffer, 0, 1, &rect);
+
+        renderArea = rect;
+    }
+
+    auto VKGraphicsContext::submitDraws(std::span<DrawPacket const> const packets) -> void
+    {
+        recordDrawPackets(*this, packets);
+    }
+
+    auto VKGraphicsContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
+                                    ResourceState const afterState) -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        barrierBatcher.barrier(commandBuffer, destBuffer, beforeState, afterState);
+    }
+
+    auto VKGraphicsContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                    ResourceState const afterState) -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        barrierBatcher.barrier(commandBuffer, destTexture, beforeState, afterState);
+    }
+
+    VKComputeContext::VKComputeContext(VkDevice device, PipelineCache* pipelineCache,
+                                       DescriptorAllocator* descriptorAllocator, DestructionQueue* destructionQueue,
+                                       DeviceQueueData& deviceQueue, BarrierCounters& barrierCounters)
+        : device(device), pipelineCache(pipelineCache), descriptorAllocator(descriptorAllocator),
+          destructionQueue(destructionQueue), deviceQueue(&deviceQueue),
+          barrierBatcher(barrierCounters, ComputeQueueStages), commandPool(nullptr), commandBuffer(nullptr),
+          isCommandListOpened(false), isPipelineBound(false)
+    {
+        bindingData.resize(sizeof(uint32_t) * 4 * 16);
+    }
+
+    VKComputeContext::~VKComputeContext()
+    {
+        if (!submittedPools.empty())
+        {
+            VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                        .semaphoreCount = 1,
+                                                        .pSemaphores = &deviceQueue->semaphore,
+                                                        .pValues = &submittedPools.back().fenceValue};
+            ::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max());
+        }
+
+        if (isCommandListOpened)
+        {
+            deviceQueue->openCommandLists--;
+            ::vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+        for (auto const& poolData : submittedPools)
+        {
+            ::vkDestroyCommandPool(device, poolData.commandPool, nullptr);
+        }
+        for (auto const& poolData : freePools)
+        {
+            ::vkDestroyCommandPool(device, poolData.commandPool, nullptr);
+        }
+    }
+
+    auto VKComputeContext::tryAllocateCommandBuffer() -> void
+    {
+        if (isCommandListOpened)
+        {
+            return;
+        }
+
+        if (!submittedPools.empty())
+        {
+            uint64_t counterValue;
+            throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
+
+            while (!submittedPools.empty() && submittedPools.front().fenceValue <= counterValue)
+            {
+                freePools.emplace_back(submittedPools.front());
+                submittedPools.pop_front();
+            }
+        }
+
+        if (freePools.empty())
+        {
+            VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                                .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                                .queueFamilyIndex = deviceQueue->familyIndex};
+            throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+
+            VkCommandBufferAllocateInfo const commandBufferAllocInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = commandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1};
+            throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+        }
+        else
+        {
+            commandPool = freePools.back().commandPool;
+            commandBuffer = freePools.back().commandBuffer;
+            freePools.pop_back();
+            throwIfFailed(::vkResetCommandPool(device, commandPool, 0));
         }
 
-        ::vkCmdBindIndexBuffer(commandBuffer, vkBuffer->getBuffer(), offset, indexType);
+        VkCommandBufferBeginInfo const commandBufferBeginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                              .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        throwIfFailed(::vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+
+        std::array<VkDescriptorSet, 2> const descriptorSets{
+            descriptorAllocator->getDescriptorSet(VK_DESCRIPTOR_TYPE_MUTABLE_EXT),
+            descriptorAllocator->getDescriptorSet(VK_DESCRIPTOR_TYPE_SAMPLER)};
+        ::vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineCache->getPipelineLayout(), 0,
+                                  2, descriptorSets.data(), 0, nullptr);
+
+        isCommandListOpened = true;
+        deviceQueue->openCommandLists++;
+    }
+
+    auto VKComputeContext::setComputePipelineOptions(Shader* shader) -> bool
+    {
+        this->tryAllocateCommandBuffer();
+
+        auto vkShader = dynamic_cast<VKShader*>(shader);
+        assert(vkShader->getShaderType() == ShaderType::Compute && "shader should be a compute one");
+
+        // Compute pipelines are keyed by the shader only, the rest of the key stays the same. There is no fallback
+        // for a dispatch, so they are always compiled in place instead of skipping the work
+        std::array<VkFormat, 8> const renderTargetFormats{};
+        auto pipeline = pipelineCache->get(vkShader, RasterizerStageInfo{}, BlendColorInfo::Opaque(), std::nullopt,
+                                           renderTargetFormats, VK_FORMAT_UNDEFINED, PipelineCompileMode::Blocking);
+
+        isPipelineBound = static_cast<bool>(pipeline);
+        if (isPipelineBound)
+        {
+            ::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getPipeline());
+        }
+        return isPipelineBound;
+    }
+
+    auto VKComputeContext::bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void
+    {
+        std::memcpy(bindingData.data() + index * sizeof(uint32_t) * 4, &descriptor, sizeof(uint32_t));
+    }
+
+    auto VKComputeContext::dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                                    uint32_t const threadGroupCountZ) -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        barrierBatcher.flush(commandBuffer);
+        ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                             bindingData.data());
+        ::vkCmdDispatch(commandBuffer, threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+    }
+
+    auto VKComputeContext::dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void
+    {
+        if (!isPipelineBound)
+        {
+            return;
+        }
+
+        auto vkBuffer = static_cast<VKBuffer*>(buffer);
+
+        barrierBatcher.flush(commandBuffer);
+        ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
+                             bindingData.data());
+        ::vkCmdDispatchIndirect(commandBuffer, vkBuffer->getBuffer(), vkBuffer->getOffset() + offset);
+    }
+
+    auto VKComputeContext::uavBarrier(Buffer*) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_uavBarrier(commandBuffer);
+    }
+
+    auto VKComputeContext::uavBarrier(Texture*) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_uavBarrier(commandBuffer);
+    }
+
+    auto VKComputeContext::barrier(Buffer* destBuffer, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        barrierBatcher.barrier(commandBuffer, destBuffer, beforeState, afterState);
+    }
+
+    auto VKComputeContext::barrier(Texture* destTexture, ResourceState const beforeState,
+                                   ResourceState const afterState) -> void
+    {
+        this->tryAllocateCommandBuffer();
+
+        barrierBatcher.barrier(commandBuffer, destTexture, beforeState, afterState);
+    }
+
+    auto VKComputeContext::beginQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_beginQuery(commandBuffer, *deviceQueue, false, query, index);
+    }
+
+    auto VKComputeContext::endQuery(Query* query, uint32_t const index) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_endQuery(commandBuffer, false, query, index);
+    }
+
+    auto VKComputeContext::resolveQuery(Query* query) -> void
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_resolveQuery(commandBuffer, *deviceQueue, false, resolvedQueries, query);
+    }
+
+    auto VKComputeContext::execute() -> Future<void>
+    {
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
+        isCommandListOpened = false;
+        isPipelineBound = false;
+
+        uint64_t const fenceValue = VKDeviceContext_submit(
+            *deviceQueue, std::span<VkCommandBuffer const>(&commandBuffer, 1), 1, waitSemaphores, waitValues);
+        submittedPools.emplace_back(CommandPoolData{.commandPool = commandPool,
+                                                    .commandBuffer = commandBuffer,
+                                                    .acquireCommandBuffer = nullptr,
+                                                    .fenceValue = fenceValue});
+        VKDeviceContext_submitQueries(*deviceQueue, fenceValue, resolvedQueries);
+
+        destructionQueue->collect();
+
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, fenceValue);
+        return Future<void>(std::move(futureImpl));
+    }
+
+    auto VKComputeContext::waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void
+    {
+        waitSemaphores.emplace_back(semaphore);
+        waitValues.emplace_back(value);
+    }
+
+    VKCopyContext::VKCopyContext(VkDevice device, VmaAllocator memoryAllocator, DestructionQueue* destructionQueue,
+                                 DeviceQueueData& deviceQueue, uint32_t const graphicsQueueFamily,
+                                 BarrierCounters& barrierCounters, RHICreateInfo const& rhiCreateInfo)
+        : device(device), memoryAllocator(memoryAllocator), destructionQueue(destructionQueue),
+          deviceQueue(&deviceQueue), graphicsQueueFamily(graphicsQueueFamily),
+          barrierBatcher(barrierCounters, TransferQueueStages), isCommandListOpened(false), stagingHead(0),
+          stagingTail(0), stagingSubmitted(0), stats{},
+          readbackBufferSize(rhiCreateInfo.readbackBufferSize > 0 ? rhiCreateInfo.readbackBufferSize
+                                                                  : ReadbackRing::DefaultBufferSize),
+          isReadbackRecorded(false)
+    {
+        VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                                            .queueFamilyIndex = deviceQueue.familyIndex};
+        throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+
+        BufferCreateInfo const bufferCreateInfo{.size = rhiCreateInfo.stagingBufferSize,
+                                                .flags = (BufferUsageFlags)(BufferUsage::MapWrite)};
+        // Released only after the context has waited for its submissions
+        stagingBuffer = core::make_ref<VKBuffer>(device, memoryAllocator, nullptr, nullptr, std::span<uint32_t const>(),
+                                                 bufferCreateInfo);
+
+        stagingBytes = stagingBuffer->getMappedPointer();
+    }
+
+    VKCopyContext::~VKCopyContext()
+    {
+        if (!submissions.empty())
+        {
+            VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                        .semaphoreCount = 1,
+                                                        .pSemaphores = &deviceQueue->semaphore,
+                                                        .pValues = &submissions.back().fenceValue};
+            ::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max());
+        }
+
+        // Results held by the user can outlive the RHI, they lose their data instead of the allocator
+        if (readbackRing)
+        {
+            readbackRing->releaseBuffer();
+        }
+
+        ::vkDestroyCommandPool(device, commandPool, nullptr);
+    }
+
+    auto VKCopyContext::getSurfaceData(Format const format, uint32_t const width, uint32_t const height,
+                                       size_t& rowBytes, uint32_t& rowCount, uint32_t& blockBytes,
+                                       uint32_t& blockHeight) -> void
+    {
+        blockHeight = 1;
+
+        switch (format)
+        {
+            case Format::BC1:
+            case Format::BC4: {
+                blockBytes = 8;
+                blockHeight = 4;
+                break;
+            }
+            case Format::BC3:
+            case Format::BC5: {
+                blockBytes = 16;
+                blockHeight = 4;
+                break;
+            }
+            case Format::R8_UNORM: {
+                blockBytes = 1;
+                break;
+            }
+            case Format::R16_UINT: {
+                blockBytes = 2;
+                break;
+            }
+            case Format::BGR8_UNORM: {
+                blockBytes = 3;
+                break;
+            }
+            case Format::RGBA8_UNORM:
+            case Format::BGRA8_UNORM:
+            case Format::D32_FLOAT: {
+                blockBytes = 4;
+                break;
+            }
+            case Format::RGBA16_FLOAT: {
+                blockBytes = 8;
+                break;
+            }
+            default: {
+                blockBytes = static_cast<uint32_t>(sizeof_Format(format));
+                break;
+            }
+        }
+
+        if (blockBytes == 0)
+        {
+            throw std::invalid_argument("texture format can't be uploaded");
+        }
+
+        // Compressed blocks are square so the same edge is used for both dimensions
+        uint32_t const blockWide = (width + blockHeight - 1) / blockHeight;
+        rowBytes = static_cast<size_t>(blockWide) * blockBytes;
+        rowCount = (height + blockHeight - 1) / blockHeight;
+    }
+
+    auto VKCopyContext::tryAllocateCommandBuffer() -> void
+    {
+        if (isCommandListOpened)
+        {
+            return;
+        }
+
+        this->retireSubmissions(false);
+
+        if (freeCommandBuffers.empty())
+        {
+            VkCommandBufferAllocateInfo const commandBufferAllocInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = commandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1};
+            throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+        }
+        else
+        {
+            commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+            throwIfFailed(::vkResetCommandBuffer(commandBuffer, 0));
+        }
+
+        VkCommandBufferBeginInfo const commandBufferBeginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                              .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        throwIfFailed(::vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+
+        isCommandListOpened = true;
+        deviceQueue->openCommandLists++;
+    }
+
+    auto VKCopyContext::submit() -> void
+    {
+        if (stagingHead > stagingSubmitted)
+        {
+            // Host writes to the ring must be visible before the copies are executed
+            stagingBuffer->flushMappedRange(0, VK_WHOLE_SIZE);
+        }
+
+        barrierBatcher.flush(commandBuffer);
+
+        if (isReadbackRecorded)
+        {
+            // Makes the copies into the readback ring visible to the host once the semaphore is signaled
+            VkMemoryBarrier2 const memoryBarrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                                 .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                                 .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                                 .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+                                                 .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT};
+            VkDependencyInfo const dependencyInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                                  .memoryBarrierCount = 1,
+                                                  .pMemoryBarriers = &memoryBarrier};
+            ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+            isReadbackRecorded = false;
+        }
+
+        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
+        isCommandListOpened = false;
+
+        uint64_t const fenceValue = VKDeviceContext_submit(
+            *deviceQueue, std::span<VkCommandBuffer const>(&commandBuffer, 1), 1, waitSemaphores, waitValues);
+
+        submissions.emplace_back(
+            SubmissionData{.commandBuffer = commandBuffer, .fenceValue = fenceValue, .stagingEnd = stagingHead});
+        stagingSubmitted = stagingHead;
+        stats.submissionCount++;
+        VKDeviceContext_submitQueries(*deviceQueue, fenceValue, resolvedQueries);
+
+        {
+            // Textures nobody else holds are never drawn with, so their acquires are dropped instead of kept until
+            // the next graphics submission
+            std::lock_guard lock(releaseMutex);
+            std::erase_if(releasedTextures,
+                          [](OwnershipTransferData const& transfer) { return transfer.texture->use_count() == 1; });
+        }
+
+        destructionQueue->collect();
+    }
+
+    auto VKCopyContext::retireSubmissions(bool const waitOldest) -> void
+    {
+        if (submissions.empty())
+        {
+            return;
+        }
+
+        if (waitOldest)
+        {
+            auto const beginTime = std::chrono::steady_clock::now();
+
+            VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                        .semaphoreCount = 1,
+                                                        .pSemaphores = &deviceQueue->semaphore,
+                                                        .pValues = &submissions.front().fenceValue};
+            throwIfFailed(::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max()));
+
+            auto const waitDuration = std::chrono::steady_clock::now() - beginTime;
+            stats.stagingWaitCount++;
+            stats.stagingWaitTime += std::chrono::duration_cast<std::chrono::nanoseconds>(waitDuration).count();
+        }
+
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
+
+        while (!submissions.empty() && submissions.front().fenceValue <= counterValue)
+        {
+            stagingTail = submissions.front().stagingEnd;
+            freeCommandBuffers.emplace_back(submissions.front().commandBuffer);
+            submissions.pop_front();
+        }
+    }
+
+    auto VKCopyContext::allocateStagingMemory(size_t const size, size_t const alignment) -> uint64_t
+    {
+        uint64_t const capacity = stagingBuffer->getSize();
+        if (size > capacity)
+        {
+            throw std::runtime_error("not enough staging memory to perform the operation");
+        }
+
+        while (true)
+        {
+            uint64_t const lapOffset = stagingHead % capacity;
+            uint64_t const alignedOffset = (lapOffset + alignment - 1) / alignment * alignment;
+
+            // Regions never wrap around, the end of the ring is skipped instead
+            uint64_t const offset = alignedOffset + size > capacity ? stagingHead - lapOffset + capacity
+                                                                    : stagingHead - lapOffset + alignedOffset;
+
+            if (offset + size - stagingTail <= capacity)
+            {
+                stagingHead = offset + size;
+                return offset % capacity;
+            }
+
+            if (stagingHead > stagingSubmitted)
+            {
+                // Copies recorded in the open command buffer still read the ring
+                this->submit();
+            }
+            else if (!submissions.empty())
+            {
+                this->retireSubmissions(true);
+            }
+            else
+            {
+                // Nothing reads the ring, start the next lap from the beginning of the buffer
+                stagingHead = stagingHead - lapOffset + capacity;
+                stagingTail = stagingHead;
+                stagingSubmitted = stagingHead;
+            }
+        }
+    }
+
+    auto VKCopyContext::tryFlushStagingMemory() -> void
+    {
+        // Half of the ring is submitted at once so the device copies it while the other half is written
+        if (stagingHead - stagingSubmitted >= stagingBuffer->getSize() / 2)
+        {
+            this->submit();
+        }
+    }
+
+    auto VKCopyContext::updateBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset,
+                                     std::span<uint8_t const> const dataBytes) -> Future<Buffer>
+    {
+        auto vkDestBuffer = static_cast<VKBuffer*>(buffer.get());
+
+        // Check for overflow destination buffer
+        if (offset > vkDestBuffer->getSize() || vkDestBuffer->getSize() - offset < dataBytes.size())
+        {
+            throw std::runtime_error("not enough memory to perform the operation");
+        }
+
+        if (vkDestBuffer->getFlags() & BufferUsage::MapWrite)
+        {
+            std::memcpy(vkDestBuffer->getMappedPointer() + offset, dataBytes.data(), dataBytes.size());
+            vkDestBuffer->flushMappedRange(offset, dataBytes.size());
+            stats.uploadedBytes += dataBytes.size();
+
+            auto futureImpl = std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore,
+                                                             deviceQueue->fenceValue);
+            return Future<Buffer>(std::move(buffer), std::move(futureImpl));
+        }
+
+        // Large uploads are split so that a single chunk never takes more than half of the ring
+        size_t const maxChunkSize = std::max<size_t>(stagingBuffer->getSize() / 2, 1);
+
+        for (size_t chunkOffset = 0; chunkOffset < dataBytes.size();)
+        {
+            size_t const chunkSize = std::min(dataBytes.size() - chunkOffset, maxChunkSize);
+
+            uint64_t const stagingOffset = this->allocateStagingMemory(chunkSize, 4);
+            this->tryAllocateCommandBuffer();
+
+            std::memcpy(stagingBytes + stagingOffset, dataBytes.data() + chunkOffset, chunkSize);
+
+            VkBufferCopy const bufferCopy{.srcOffset = stagingOffset,
+                                          .dstOffset = vkDestBuffer->getOffset() + offset + chunkOffset,
+                                          .size = chunkSize};
+            barrierBatcher.flush(commandBuffer);
+            ::vkCmdCopyBuffer(commandBuffer, stagingBuffer->getBuffer(), vkDestBuffer->getBuffer(), 1, &bufferCopy);
+
+            chunkOffset += chunkSize;
+            this->tryFlushStagingMemory();
+        }
+
+        stats.uploadedBytes += dataBytes.size();
+
+        // Copies left in the open command buffer complete with the next execute
+        uint64_t const fenceValue = deviceQueue->fenceValue + (isCommandListOpened ? 1 : 0);
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, fenceValue, this);
+        return Future<Buffer>(std::move(buffer), std::move(futureImpl));
+    }
+
+    auto VKCopyContext::updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
+                                      std::span<uint8_t const> const dataBytes) -> Future<Texture>
+    {
+        auto vkDestTexture = static_cast<VKTexture*>(texture.get());
+
+        uint32_t const mipLevel = resourceIndex % vkDestTexture->getMipLevels();
+        uint32_t const arrayLayer = resourceIndex / vkDestTexture->getMipLevels();
+        uint32_t const width = std::max(vkDestTexture->getWidth() >> mipLevel, 1u);
+        uint32_t const height = std::max(vkDestTexture->getHeight() >> mipLevel, 1u);
+
+        size_t rowBytes = 0;
+        uint32_t rowCount = 0;
+        uint32_t blockBytes = 0;
+        uint32_t blockHeight = 0;
+        this->getSurfaceData(vkDestTexture->getFormat(), width, height, rowBytes, rowCount, blockBytes, blockHeight);
+
+        if (dataBytes.size() < rowBytes * rowCount)
+        {
+            throw std::invalid_argument("data is smaller than the texture subresource");
+        }
+
+        size_t const maxChunkSize = stagingBuffer->getSize() / 2;
+        if (rowBytes > maxChunkSize)
+        {
+            throw std::runtime_error("not enough staging memory to perform the operation");
+        }
+
+        // Large subresources are split by rows of texel blocks
+        uint32_t const maxChunkRows = static_cast<uint32_t>(maxChunkSize / rowBytes);
+        // Buffer offset of an image copy should be a multiple of both the texel block size and 4
+        size_t const alignment = std::lcm<size_t>(blockBytes, 4);
+
+        this->tryAllocateCommandBuffer();
+
+        VKStageAccess const copyStageAccess{.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                            .accessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT};
+
+        // The whole subresource is overwritten so its previous content is discarded, only earlier copies to it are
+        // waited for
+        barrierBatcher.barrier(commandBuffer, texture.get(),
+                               VKDeviceContext_subresourceBarrier(
+                                   vkDestTexture->getImage(), mipLevel, arrayLayer, VK_IMAGE_LAYOUT_UNDEFINED,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   VKStageAccess{.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT}, copyStageAccess));
+
+        for (uint32_t row = 0; row < rowCount;)
+        {
+            uint32_t const chunkRows = std::min(rowCount - row, maxChunkRows);
+            size_t const chunkSize = rowBytes * chunkRows;
+
+            uint64_t const stagingOffset = this->allocateStagingMemory(chunkSize, alignment);
+            this->tryAllocateCommandBuffer();
+
+            std::memcpy(stagingBytes + stagingOffset, dataBytes.data() + rowBytes * row, chunkSize);
+
+            VkBufferImageCopy const bufferImageCopy{
+                .bufferOffset = stagingOffset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                     .mipLevel = mipLevel,
+                                     .baseArrayLayer = arrayLayer,
+                                     .layerCount = 1},
+                .imageOffset = {.x = 0, .y = static_cast<int32_t>(row * blockHeight), .z = 0},
+                .imageExtent = {.width = width,
+                                .height = std::min(chunkRows * blockHeight, height - row * blockHeight),
+                                .depth = 1}};
+            barrierBatcher.flush(commandBuffer);
+            ::vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->getBuffer(), vkDestTexture->getImage(),
+                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopy);
+
+            row += chunkRows;
+            this->tryFlushStagingMemory();
+        }
+
+        this->tryAllocateCommandBuffer();
+
+        // Uploaded textures are left in the common state like on the copy queue of DirectX 12
+        VkImageLayout const commonLayout = ResourceState_to_VkImageLayout(ResourceState::Common);
+
+        if (vkDestTexture->getSharingMode() == VK_SHARING_MODE_EXCLUSIVE &&
+            deviceQueue->familyIndex != graphicsQueueFamily)
+        {
+            // Released to the graphics queue family, the matching acquire is recorded by handOff or by the next
+            // graphics submission after this one
+            VkImageMemoryBarrier2 imageMemoryBarrier =
+                VKDeviceContext_subresourceBarrier(vkDestTexture->getImage(), mipLevel, arrayLayer,
+                                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commonLayout,
+                                                   copyStageAccess, VKStageAccess{});
+            imageMemoryBarrier.srcQueueFamilyIndex = deviceQueue->familyIndex;
+            imageMemoryBarrier.dstQueueFamilyIndex = graphicsQueueFamily;
+            barrierBatcher.barrier(commandBuffer, texture.get(), imageMemoryBarrier);
+
+            VKStageAccess const acquireStageAccess =
+                ResourceState_to_VKStageAccess(ResourceState::Common, GraphicsQueueStages);
+            imageMemoryBarrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+            imageMemoryBarrier.dstStageMask = acquireStageAccess.stageMask;
+            imageMemoryBarrier.dstAccessMask = acquireStageAccess.accessMask;
+            std::lock_guard lock(releaseMutex);
+            releasedTextures.emplace_back(OwnershipTransferData{
+                .texture = texture, .acquireBarrier = imageMemoryBarrier, .fenceValue = deviceQueue->fenceValue + 1});
+        }
+        else
+        {
+            barrierBatcher.barrier(commandBuffer, texture.get(),
+                                   VKDeviceContext_subresourceBarrier(
+                                       vkDestTexture->getImage(), mipLevel, arrayLayer,
+                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commonLayout, copyStageAccess,
+                                       ResourceState_to_VKStageAccess(ResourceState::Common, TransferQueueStages)));
+        }
+
+        stats.uploadedBytes += rowBytes * rowCount;
+
+        auto futureImpl = std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore,
+                                                         deviceQueue->fenceValue + 1, this);
+        return Future<Texture>(std::move(texture), std::move(futureImpl));
+    }
+
+    auto VKCopyContext::allocateReadbackMemory(size_t const size, size_t const alignment) -> uint64_t
+    {
+        if (!readbackRing)
+        {
+            BufferCreateInfo const bufferCreateInfo{
+                .size = readbackBufferSize, .elementStride = 0, .flags = (BufferUsageFlags)(BufferUsage::MapRead)};
+            // Released by the context on destruction at the latest, while the destruction queue is still alive
+            readbackRing = core::make_ref<ReadbackRing>(core::make_ref<VKBuffer>(
+                device, memoryAllocator, nullptr, destructionQueue, std::span<uint32_t const>(), bufferCreateInfo));
+        }
+
+        // Copies are recorded into the open command buffer, which is signaled with the next value
+        uint64_t const fenceValue = deviceQueue->fenceValue + 1;
+
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
+
+        auto readbackOffset = readbackRing->allocate(size, alignment, fenceValue, counterValue);
+        uint64_t const submittedValue = deviceQueue->fenceValue;
+        if (!readbackOffset.has_value() && counterValue < submittedValue)
+        {
+            // Released ranges can still be waiting for the copies into them
+            VkSemaphoreWaitInfo const semaphoreWaitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                                        .semaphoreCount = 1,
+                                                        .pSemaphores = &deviceQueue->semaphore,
+                                                        .pValues = &submittedValue};
+            throwIfFailed(::vkWaitSemaphores(device, &semaphoreWaitInfo, std::numeric_limits<uint64_t>::max()));
+
+            readbackOffset = readbackRing->allocate(size, alignment, fenceValue, submittedValue);
+        }
+
+        if (!readbackOffset.has_value())
+        {
+            throw std::runtime_error("not enough readback memory to perform the operation");
+        }
+        return readbackOffset.value();
     }
 
-    auto VKGraphicsContext::drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void
+    auto VKCopyContext::readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+        -> Future<ReadbackData>
     {
-        ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
-                             bindingData.data());
-        ::vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
-    }
+        auto vkSourceBuffer = static_cast<VKBuffer*>(buffer.get());
 
-    auto VKGraphicsContext::draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void
-    {
-        ::vkCmdPushConstants(commandBuffer, pipelineCache->getPipelineLayout(), VK_SHADER_STAGE_ALL, 0, 16,
-                             bindingData.data());
-        ::vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
-    }
+        if (!(vkSourceBuffer->getFlags() & BufferUsage::CopySource))
+        {
+            throw std::invalid_argument("buffer should be created with BufferUsage::CopySource");
+        }
+        if (size == 0 || offset > vkSourceBuffer->getSize() || vkSourceBuffer->getSize() - offset < size)
+        {
+            throw std::invalid_argument("range is out of the buffer");
+        }
 
-    auto VKGraphicsContext::setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
-        -> void
-    {
         this->tryAllocateCommandBuffer();
-
-        VkViewport const viewport{.x = static_cast<float>(x),
-                                  .y = static_cast<float>(y),
-                                  .width = static_cast<float>(width),
-                                  .height = static_cast<float>(height),
-                                  .minDepth = 0.0f,
-                                  .maxDepth = 1.0f};
-        ::vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        uint64_t const readbackOffset = this->allocateReadbackMemory(size, 4);
+
+        VkBufferCopy const bufferCopy{
+            .srcOffset = vkSourceBuffer->getOffset() + offset, .dstOffset = readbackOffset, .size = size};
+        barrierBatcher.flush(commandBuffer);
+        ::vkCmdCopyBuffer(commandBuffer, vkSourceBuffer->getBuffer(),
+                          static_cast<VKBuffer*>(readbackRing->getBuffer())->getBuffer(), 1, &bufferCopy);
+        isReadbackRecorded = true;
+        stats.readbackBytes += size;
+
+        auto futureImpl = std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore,
+                                                         deviceQueue->fenceValue + 1);
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, readbackOffset, size, size),
+                                    std::move(futureImpl));
     }
 
-    auto VKGraphicsContext::setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
-        -> void
+    auto VKCopyContext::readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+        -> Future<ReadbackData>
     {
-        this->tryAllocateCommandBuffer();
+        auto vkSourceTexture = static_cast<VKTexture*>(texture.get());
 
-        VkRect2D const rect{.offset = {.x = left, .y = top},
-                            .extent = {.width = static_cast<uint32_t>(right), .height = static_cast<uint32_t>(bottom)}};
-        ::vkCmdSetScissor(commandBuffer, 0, 1, &rect);
+        if (!(vkSourceTexture->getFlags() & TextureUsage::CopySource))
+        {
+            throw std::invalid_argument("texture should be created with TextureUsage::CopySource");
+        }
+        if (vkSourceTexture->getSharingMode() == VK_SHARING_MODE_EXCLUSIVE &&
+            deviceQueue->familyIndex != graphicsQueueFamily)
+        {
+            // Its content would need a release recorded on the graphics queue before the copy
+            throw std::invalid_argument("texture is owned by the graphics queue family and can't be read back");
+        }
 
-        renderArea = rect;
+        uint32_t const mipLevel = resourceIndex % vkSourceTexture->getMipLevels();
+        uint32_t const arrayLayer = resourceIndex / vkSourceTexture->getMipLevels();
+        uint32_t const width = std::max(vkSourceTexture->getWidth() >> mipLevel, 1u);
+        uint32_t const height = std::max(vkSourceTexture->getHeight() >> mipLevel, 1u);
+
+        size_t rowBytes = 0;
+        uint32_t rowCount = 0;
+        uint32_t blockBytes = 0;
+        uint32_t blockHeight = 0;
+        this->getSurfaceData(vkSourceTexture->getFormat(), width, height, rowBytes, rowCount, blockBytes,
+                             blockHeight);
+
+        // Rows are tightly packed, the buffer offset should be a multiple of both the texel block size and 4
+        size_t const size = rowBytes * rowCount;
+        this->tryAllocateCommandBuffer();
+        uint64_t const readbackOffset = this->allocateReadbackMemory(size, std::lcm<size_t>(blockBytes, 4));
+
+        VkImageLayout const commonLayout = ResourceState_to_VkImageLayout(ResourceState::Common);
+        VKStageAccess const commonStageAccess =
+            ResourceState_to_VKStageAccess(ResourceState::Common, TransferQueueStages);
+        VKStageAccess const copyStageAccess{.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                            .accessMask = VK_ACCESS_2_TRANSFER_READ_BIT};
+
+        barrierBatcher.barrier(commandBuffer, texture.get(),
+                               VKDeviceContext_subresourceBarrier(vkSourceTexture->getImage(), mipLevel, arrayLayer,
+                                                                  commonLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                                  commonStageAccess, copyStageAccess));
+
+        VkBufferImageCopy const bufferImageCopy{.bufferOffset = readbackOffset,
+                                                .bufferRowLength = 0,
+                                                .bufferImageHeight = 0,
+                                                .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                                                     .mipLevel = mipLevel,
+                                                                     .baseArrayLayer = arrayLayer,
+                                                                     .layerCount = 1},
+                                                .imageOffset = {.x = 0, .y = 0, .z = 0},
+                                                .imageExtent = {.width = width, .height = height, .depth = 1}};
+        barrierBatcher.flush(commandBuffer);
+        ::vkCmdCopyImageToBuffer(commandBuffer, vkSourceTexture->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                 static_cast<VKBuffer*>(readbackRing->getBuffer())->getBuffer(), 1,
+                                 &bufferImageCopy);
+
+        // The texture is left in the common state it was read in
+        barrierBatcher.barrier(commandBuffer, texture.get(),
+                               VKDeviceContext_subresourceBarrier(vkSourceTexture->getImage(), mipLevel, arrayLayer,
+                                                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, commonLayout,
+                                                                  copyStageAccess, commonStageAccess));
+        isReadbackRecorded = true;
+        stats.readbackBytes += size;
+
+        auto futureImpl = std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore,
+                                                         deviceQueue->fenceValue + 1);
+        return Future<ReadbackData>(core::make_ref<ReadbackRange>(readbackRing, readbackOffset, size, rowBytes),
+                                    std::move(futureImpl));
     }
 
-    auto VKGraphicsContext::barrier(core::ref_ptr<Buffer> dest, ResourceState const before, ResourceState const after)
+    auto VKCopyContext::barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
         -> void
     {
         this->tryAllocateCommandBuffer();
 
-        VKDeviceContext_barrier(commandBuffer, dest, before, after);
+        barrierBatcher.barrier(commandBuffer, destBuffer, beforeState, afterState);
     }
 
-    auto VKGraphicsContext::barrier(core::ref_ptr<Texture> dest, ResourceState const before, ResourceState const after)
+    auto VKCopyContext::barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
         -> void
     {
         this->tryAllocateCommandBuffer();
 
-        VKDeviceContext_barrier(commandBuffer, dest, before, after);
+        barrierBatcher.barrier(commandBuffer, destTexture, beforeState, afterState);
     }
 
-    auto VKCopyContext::tryAllocateCommandBuffer() -> void
+    auto VKCopyContext::beginQuery(Query* query, uint32_t const index) -> void
     {
-        if (isCommandListOpened)
+        if (query->getQueryType() == QueryType::PipelineStatistics)
         {
-            return;
+            throw std::invalid_argument("pipeline statistics are not supported by copy contexts");
         }
 
-        throwIfFailed(::vkResetCommandPool(device, commandPool, 0));
-
-        VkCommandBufferAllocateInfo const commandBufferAllocInfo{.sType =
-                                                                     VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                                                 .commandPool = commandPool,
-                                                                 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                                                 .commandBufferCount = 1};
-        throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+        // The pool is reset on the host, which can only be done after the previous resolve has completed
+        auto vkQuery = static_cast<VKQuery*>(query);
+        if (!vkQuery->getResult())
+        {
+            throw std::runtime_error("query is still in flight");
+        }
+        vkQuery->readHostResults();
 
-        VkCommandBufferBeginInfo const commandBufferBeginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                                                              .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-        throwIfFailed(::vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
 
-        isCommandListOpened = true;
+        VKDeviceContext_beginQuery(commandBuffer, *deviceQueue, false, query, index);
     }
 
-    VKCopyContext::VKCopyContext(VkDevice device, VmaAllocator memoryAllocator, DeviceQueueData& deviceQueue,
-                                 RHICreateInfo const& rhiCreateInfo)
-        : device(device), deviceQueue(&deviceQueue), isCommandListOpened(false)
+    auto VKCopyContext::endQuery(Query* query, uint32_t const index) -> void
     {
-        VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                                                            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-                                                            .queueFamilyIndex = deviceQueue.familyIndex};
-        throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+        this->tryAllocateCommandBuffer();
+        barrierBatcher.flush(commandBuffer);
+
+        VKDeviceContext_endQuery(commandBuffer, false, query, index);
     }
 
-    VKCopyContext::~VKCopyContext()
+    auto VKCopyContext::resolveQuery(Query* query) -> void
     {
-        ::vkDestroyCommandPool(device, commandPool, nullptr);
+        this->tryAllocateCommandBuffer();
+
+        auto vkQuery = static_cast<VKQuery*>(query);
+        vkQuery->resolveOnHost(deviceQueue->timestampValidBits);
+        resolvedQueries.emplace_back(vkQuery);
     }
 
-    auto VKCopyContext::updateBuffer(core::ref_ptr<Buffer> dest, uint64_t const offset,
-                                     std::span<uint8_t const> const dataBytes) -> Future<Buffer>
+    auto VKCopyContext::execute() -> Future<void>
     {
-        return Future<Buffer>();
+        this->tryAllocateCommandBuffer();
+        this->submit();
+
+        auto futureImpl = std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore,
+                                                         deviceQueue->fenceValue, this);
+        return Future<void>(std::move(futureImpl));
     }
 
-    auto VKCopyContext::updateTexture(core::ref_ptr<Texture> dest, uint32_t const resourceIndex,
-                                      std::span<uint8_t const> const dataBytes) -> Future<Texture>
+    auto VKCopyContext::waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void
     {
-        return Future<Texture>();
+        waitSemaphores.emplace_back(semaphore);
+        waitValues.emplace_back(value);
     }
 
-    auto VKCopyContext::barrier(core::ref_ptr<Buffer> dest, ResourceState const before, ResourceState const after)
-        -> void
+    auto VKCopyContext::handOff(uint64_t const fenceValue, VKGraphicsContext* graphicsContext) -> void
     {
-        this->tryAllocateCommandBuffer();
+        std::lock_guard lock(releaseMutex);
 
-        VKDeviceContext_barrier(commandBuffer, dest, before, after);
-    }
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
 
-    auto VKCopyContext::barrier(core::ref_ptr<Texture> dest, ResourceState const before, ResourceState const after)
-        -> void
-    {
-        this->tryAllocateCommandBuffer();
+        stats.handoffCount++;
+        if (counterValue < fenceValue)
+        {
+            stats.overlappedHandoffCount++;
+        }
 
-        VKDeviceContext_barrier(commandBuffer, dest, before, after);
+        auto acquiredEnd = std::stable_partition(
+            releasedTextures.begin(), releasedTextures.end(),
+            [&](OwnershipTransferData const& transfer) { return transfer.fenceValue > fenceValue; });
+        // Acquires are batched by the graphics context with the barriers recorded after them
+        for (auto it = acquiredEnd; it != releasedTextures.end(); ++it)
+        {
+            graphicsContext->acquireOwnership(it->texture.get(), it->acquireBarrier);
+        }
+        releasedTextures.erase(acquiredEnd, releasedTextures.end());
     }
 
-    auto VKCopyContext::execute() -> Future<void>
+    auto VKCopyContext::handOffSubmitted(std::vector<VkImageMemoryBarrier2>& acquireBarriers,
+                                         std::vector<VkSemaphore>& semaphores, std::vector<uint64_t>& values) -> void
     {
-        writeStagingBuffer.offset = 0;
+        std::lock_guard lock(releaseMutex);
 
-        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
-        isCommandListOpened = false;
+        uint64_t const submittedValue = deviceQueue->fenceValue;
+        auto acquiredEnd = std::stable_partition(
+            releasedTextures.begin(), releasedTextures.end(),
+            [&](OwnershipTransferData const& transfer) { return transfer.fenceValue > submittedValue; });
+        if (acquiredEnd == releasedTextures.end())
+        {
+            return;
+        }
 
-        deviceQueue->fenceValue++;
-        VkTimelineSemaphoreSubmitInfo const semaphoreSubmitInfo{
-            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
-            .signalSemaphoreValueCount = 1,
-            .pSignalSemaphoreValues = &deviceQueue->fenceValue};
-        VkSubmitInfo const submitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                                      .pNext = &semaphoreSubmitInfo,
-                                      .commandBufferCount = 1,
-                                      .pCommandBuffers = &commandBuffer,
-                                      .signalSemaphoreCount = 1,
-                                      .pSignalSemaphores = &deviceQueue->semaphore};
-        throwIfFailed(::vkQueueSubmit(deviceQueue->queue, 1, &submitInfo, nullptr));
+        uint64_t waitValue = 0;
+        for (auto it = acquiredEnd; it != releasedTextures.end(); ++it)
+        {
+            acquireBarriers.emplace_back(it->acquireBarrier);
+            waitValue = std::max(waitValue, it->fenceValue);
+        }
+        releasedTextures.erase(acquiredEnd, releasedTextures.end());
 
-        auto futureImpl =
-            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, deviceQueue->fenceValue);
-        return Future<void>(std::move(futureImpl));
+        uint64_t counterValue;
+        throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue->semaphore, &counterValue));
+
+        stats.handoffCount++;
+        if (counterValue < waitValue)
+        {
+            stats.overlappedHandoffCount++;
+        }
+
+        semaphores.emplace_back(deviceQueue->semaphore);
+        values.emplace_back(waitValue);
+    }
+
+    auto VKCopyContext::getStats() const -> UploadStats
+    {
+        return stats;
     }
 
     VKSwapchain::VKSwapchain(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device,
@@ -1477,10 +3940,10 @@ namespace ionengine::rhi
         throwIfFailed(::vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &acquireSemaphore));
         throwIfFailed(::vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &presentSemaphore));
 
-        RECT rect{};
-        ::GetClientRect(reinterpret_cast<HWND>(createInfo.window), &rect);
+        VkSurfaceCapabilitiesKHR surfaceCapabilities;
+        throwIfFailed(::vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities));
 
-        this->createSwapchainBuffers(rect.right, rect.bottom);
+        this->createSwapchainBuffers(surfaceCapabilities.currentExtent.width, surfaceCapabilities.currentExtent.height);
     }
 
     VKSwapchain::~VKSwapchain()
@@ -1493,7 +3956,7 @@ namespace ionengine::rhi
         ::vkDestroySurfaceKHR(instance, surface, nullptr);
     }
 
-    auto VKSwapchain::getBackBuffer() -> core::weak_ptr<Texture>
+    auto VKSwapchain::getBackBuffer() -> Texture*
     {
         VkPipelineStageFlags const waitDstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
         auto result = ::vkAcquireNextImageKHR(device, swapchain, std::numeric_limits<uint32_t>::max(), acquireSemaphore,
@@ -1504,18 +3967,22 @@ namespace ionengine::rhi
                                           .waitSemaphoreCount = 1,
                                           .pWaitSemaphores = &acquireSemaphore,
                                           .pWaitDstStageMask = &waitDstStageMask};
+            std::lock_guard lock(*deviceQueue->submitMutex);
             throwIfFailed(::vkQueueSubmit(deviceQueue->queue, 1, &submitInfo, nullptr));
         }
-        return backBuffers[imageIndex];
+        return backBuffers[imageIndex].get();
     }
 
-    auto VKSwapchain::presentBackBuffer() -> void
+    auto VKSwapchain::presentBackBuffer() -> Future<void>
     {
+        std::lock_guard lock(*deviceQueue->submitMutex);
+
+        uint64_t const fenceValue = deviceQueue->fenceValue;
         VkPipelineStageFlags const waitDstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
         VkTimelineSemaphoreSubmitInfo const semaphoreSubmitInfo{
             .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
             .waitSemaphoreValueCount = 1,
-            .pWaitSemaphoreValues = &deviceQueue->fenceValue};
+            .pWaitSemaphoreValues = &fenceValue};
         VkSubmitInfo const submitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
                                       .pNext = &semaphoreSubmitInfo,
                                       .waitSemaphoreCount = 1,
@@ -1532,6 +3999,10 @@ namespace ionengine::rhi
                                            .pSwapchains = &swapchain,
                                            .pImageIndices = &imageIndex};
         ::vkQueuePresentKHR(deviceQueue->queue, &presentInfo);
+
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, fenceValue);
+        return Future<void>(std::move(futureImpl));
     }
 
     auto VKSwapchain::resizeBackBuffers(uint32_t const width, uint32_t const height) -> void
@@ -1575,7 +4046,110 @@ namespace ionengine::rhi
         }
     }
 
-    VKRHI::VKRHI(RHICreateInfo const& createInfo)
+    VKHeadlessSwapchain::VKHeadlessSwapchain(VkDevice device, VmaAllocator memoryAllocator,
+                                             DestructionQueue* destructionQueue,
+                                             std::span<uint32_t const> const queueFamilies,
+                                             DeviceQueueData& deviceQueue, SwapchainCreateInfo const& createInfo)
+        : device(device), memoryAllocator(memoryAllocator), destructionQueue(destructionQueue),
+          queueFamilies(queueFamilies.begin(), queueFamilies.end()), deviceQueue(&deviceQueue), imageIndex(0),
+          backBuffers(std::max(createInfo.frameCount, 1u))
+    {
+        this->createSwapchainBuffers(createInfo.width > 0 ? createInfo.width : 1280,
+                                     createInfo.height > 0 ? createInfo.height : 720);
+    }
+
+    auto VKHeadlessSwapchain::getBackBuffer() -> Texture*
+    {
+        // Frames are rendered on a single queue, so the commands of the previous frames are already ordered before
+        // the ones that render into the back buffer again
+        return backBuffers[imageIndex].get();
+    }
+
+    auto VKHeadlessSwapchain::presentBackBuffer() -> Future<void>
+    {
+        // There is no presentation engine, the frame is presented once the graphics queue reaches its last submit
+        imageIndex = (imageIndex + 1) % static_cast<uint32_t>(backBuffers.size());
+
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, deviceQueue->queue, deviceQueue->semaphore, deviceQueue->fenceValue);
+        return Future<void>(std::move(futureImpl));
+    }
+
+    auto VKHeadlessSwapchain::resizeBackBuffers(uint32_t const width, uint32_t const height) -> void
+    {
+        // Old back buffers are released through the destruction queue, so frames in flight can still use them
+        this->createSwapchainBuffers(width, height);
+        imageIndex = 0;
+    }
+
+    auto VKHeadlessSwapchain::createSwapchainBuffers(uint32_t const width, uint32_t const height) -> void
+    {
+        TextureCreateInfo const textureCreateInfo{
+            .width = width,
+            .height = height,
+            .depth = 1,
+            .mipLevels = 1,
+            .format = Format::BGRA8_UNORM,
+            .dimension = TextureDimension::_2D,
+            .flags = (TextureUsageFlags)(TextureUsage::RenderTarget | TextureUsage::CopySource)};
+
+        for (auto& backBuffer : backBuffers)
+        {
+            backBuffer = core::make_ref<VKTexture>(device, memoryAllocator, nullptr, destructionQueue, queueFamilies,
+                                                   textureCreateInfo);
+        }
+
+        // Images are created in the undefined layout, they are moved once to the layout of ResourceState::Common.
+        // Barriers of the contexts then start from it, so the content of a presented frame is kept for a readback
+        VkCommandPoolCreateInfo const commandPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                            .queueFamilyIndex = deviceQueue->familyIndex};
+        VkCommandPool commandPool;
+        throwIfFailed(::vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool));
+
+        VkCommandBufferAllocateInfo const commandBufferAllocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1};
+        VkCommandBuffer commandBuffer;
+        throwIfFailed(::vkAllocateCommandBuffers(device, &commandBufferAllocInfo, &commandBuffer));
+
+        VkCommandBufferBeginInfo const commandBufferBeginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                                              .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        throwIfFailed(::vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+
+        VKStageAccess const srcStageAccess{.stageMask = VK_PIPELINE_STAGE_2_NONE, .accessMask = VK_ACCESS_2_NONE};
+        VKStageAccess const dstStageAccess{.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                           .accessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT};
+        std::vector<VkImageMemoryBarrier2> imageMemoryBarriers;
+        for (auto const& backBuffer : backBuffers)
+        {
+            imageMemoryBarriers.emplace_back(VKDeviceContext_subresourceBarrier(
+                static_cast<VKTexture*>(backBuffer.get())->getImage(), 0, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                ResourceState_to_VkImageLayout(ResourceState::Common), srcStageAccess, dstStageAccess));
+        }
+        VkDependencyInfo const dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBarriers.size()),
+            .pImageMemoryBarriers = imageMemoryBarriers.data()};
+        ::vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        throwIfFailed(::vkEndCommandBuffer(commandBuffer));
+
+        // Signals no fence value, so the values the contexts expect for their open command buffers stay the same.
+        // Back buffers are created only with the swapchain or on resize, so waiting for the queue here is cheap
+        VkSubmitInfo const submitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .commandBufferCount = 1, .pCommandBuffers = &commandBuffer};
+        {
+            std::lock_guard lock(*deviceQueue->submitMutex);
+            throwIfFailed(::vkQueueSubmit(deviceQueue->queue, 1, &submitInfo, nullptr));
+            throwIfFailed(::vkQueueWaitIdle(deviceQueue->queue));
+        }
+
+        ::vkDestroyCommandPool(device, commandPool, nullptr);
+    }
+
+    VKRHI::VKRHI(RHICreateInfo const& rhiCreateInfo, std::optional<SwapchainCreateInfo> const swapchainCreateInfo)
     {
         VkApplicationInfo const applicationInfo{.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
                                                 .pApplicationName = "RHI",
@@ -1587,26 +4161,47 @@ namespace ionengine::rhi
         VkInstanceCreateInfo instanceCreateInfo{.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
                                                 .pApplicationInfo = &applicationInfo};
 
-        std::vector<char const*> instanceExtensions{VK_KHR_SURFACE_EXTENSION_NAME};
+        std::vector<char const*> instanceExtensions;
 
+        bool const isWindowSwapchain =
+            swapchainCreateInfo.has_value() && swapchainCreateInfo->mode == SwapchainMode::Window;
+
+        // Surface extensions are not required without a window, e.g. on a software driver in tests
+        if (isWindowSwapchain)
+        {
+            instanceExtensions.emplace_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef IONENGINE_PLATFORM_WIN32
-        instanceExtensions.emplace_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+            instanceExtensions.emplace_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #elif IONENGINE_PLATFORM_X11
-        instanceExtensions.emplace_back{VK_KHR_XLIB_SURFACE_EXTENSION_NAME};
+            instanceExtensions.emplace_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
 #endif
+        }
 
 #ifndef NDEBUG
         instanceExtensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-        std::vector<char const*> instanceLayers{"VK_LAYER_KHRONOS_validation"};
+        std::vector<char const*> instanceLayers;
+
+        uint32_t numInstanceLayers;
+        throwIfFailed(::vkEnumerateInstanceLayerProperties(&numInstanceLayers, nullptr));
+
+        std::vector<VkLayerProperties> layerProperties(numInstanceLayers);
+        throwIfFailed(::vkEnumerateInstanceLayerProperties(&numInstanceLayers, layerProperties.data()));
+
+        // Validation is enabled only when the layer is installed
+        for (auto const& layerProperty : layerProperties)
+        {
+            if (std::string_view(layerProperty.layerName) == "VK_LAYER_KHRONOS_validation")
+            {
+                instanceLayers.emplace_back("VK_LAYER_KHRONOS_validation");
+                break;
+            }
+        }
 
         instanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(instanceLayers.size());
         instanceCreateInfo.ppEnabledLayerNames = instanceLayers.data();
+#endif
         instanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
         instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
-#else
-        instanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
-        instanceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
-#endif
         throwIfFailed(::vkCreateInstance(&instanceCreateInfo, nullptr, &instance));
 
 #ifndef NDEBUG
@@ -1651,47 +4246,106 @@ namespace ionengine::rhi
         std::vector<VkQueueFamilyProperties> queueFamilies(numQueueFamilies);
         ::vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilies, queueFamilies.data());
 
-        float queuePriority = 0.0f;
-        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-
         int32_t graphicsQueueFamily = -1;
         int32_t transferQueueFamily = -1;
         int32_t computeQueueFamily = -1;
 
         for (uint32_t const i : std::views::iota(0u, queueFamilies.size()))
         {
-            if (graphicsQueueFamily == -1 && queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            VkQueueFlags const queueFlags = queueFamilies[i].queueFlags;
+
+            if (graphicsQueueFamily == -1 && queueFlags & VK_QUEUE_GRAPHICS_BIT)
             {
                 graphicsQueueFamily = i;
             }
-            if (transferQueueFamily == -1 && queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT)
+            // A family without graphics runs its work asynchronously to the graphics queue
+            if (computeQueueFamily == -1 && queueFlags & VK_QUEUE_COMPUTE_BIT && !(queueFlags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                computeQueueFamily = i;
+            }
+            // Copy engines of discrete GPUs are exposed as transfer only families
+            if (transferQueueFamily == -1 && queueFlags & VK_QUEUE_TRANSFER_BIT &&
+                !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
             {
                 transferQueueFamily = i;
             }
-            if (computeQueueFamily == -1 && queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+        }
+
+        // Queues missing a dedicated family take the next queue of the graphics family, or share its last one
+        std::vector<uint32_t> familyQueueCounts(queueFamilies.size(), 0);
+        auto reserveQueue = [&](int32_t const queueFamily) -> uint32_t {
+            uint32_t const queueIndex =
+                std::min(familyQueueCounts[queueFamily], queueFamilies[queueFamily].queueCount - 1);
+            familyQueueCounts[queueFamily] = std::max(familyQueueCounts[queueFamily], queueIndex + 1);
+            return queueIndex;
+        };
+
+        computeQueueFamily = computeQueueFamily == -1 ? graphicsQueueFamily : computeQueueFamily;
+        transferQueueFamily = transferQueueFamily == -1 ? graphicsQueueFamily : transferQueueFamily;
+
+        uint32_t const graphicsQueueIndex = reserveQueue(graphicsQueueFamily);
+        uint32_t const computeQueueIndex = reserveQueue(computeQueueFamily);
+        uint32_t const transferQueueIndex = reserveQueue(transferQueueFamily);
+
+        std::array<float, 3> const queuePriorities{0.0f, 0.0f, 0.0f};
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+
+        for (uint32_t const i : std::views::iota(0u, queueFamilies.size()))
+        {
+            if (familyQueueCounts[i] == 0)
             {
-                computeQueueFamily = i;
+                continue;
             }
 
             VkDeviceQueueCreateInfo const queueCreateInfo{.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
                                                           .queueFamilyIndex = i,
-                                                          .queueCount = 1,
-                                                          .pQueuePriorities = &queuePriority};
+                                                          .queueCount = familyQueueCounts[i],
+                                                          .pQueuePriorities = queuePriorities.data()};
             queueCreateInfos.emplace_back(std::move(queueCreateInfo));
         }
 
-        std::vector<char const*> const deviceExtensions{
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
-            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_EXT_MUTABLE_DESCRIPTOR_TYPE_EXTENSION_NAME,
-            VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME};
+        // Buffers and storage textures are shared by the queues without ownership transfers
+        for (int32_t const queueFamily : {graphicsQueueFamily, computeQueueFamily, transferQueueFamily})
+        {
+            if (std::ranges::find(concurrentQueueFamilies, static_cast<uint32_t>(queueFamily)) ==
+                concurrentQueueFamilies.end())
+            {
+                concurrentQueueFamilies.emplace_back(queueFamily);
+            }
+        }
+
+        std::vector<char const*> deviceExtensions{
+            VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+            VK_EXT_MUTABLE_DESCRIPTOR_TYPE_EXTENSION_NAME, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME};
+
+        if (isWindowSwapchain)
+        {
+            deviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
 
         VkPhysicalDeviceMutableDescriptorTypeFeaturesEXT deviceMutableFeatures{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MUTABLE_DESCRIPTOR_TYPE_FEATURES_EXT,
             .mutableDescriptorType = true};
-        VkPhysicalDeviceFeatures const deviceFeatures{.samplerAnisotropy = true};
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{.sType =
+                                                                 VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+        VkPhysicalDeviceFeatures2 supportedFeatures{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                                                    .pNext = &supportedFeatures12};
+        ::vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+        isPipelineStatisticsSupported = supportedFeatures.features.pipelineStatisticsQuery;
+        deviceFeatures = DeviceFeatureData{
+            .isMultiDrawIndirectSupported = static_cast<bool>(supportedFeatures.features.multiDrawIndirect),
+            .isDrawIndirectCountSupported = static_cast<bool>(supportedFeatures12.drawIndirectCount)};
+
+        // Indirect features are only enabled where they exist, the contexts work around the missing ones
+        VkPhysicalDeviceFeatures const enabledFeatures{
+            .multiDrawIndirect = supportedFeatures.features.multiDrawIndirect,
+            .drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance,
+            .samplerAnisotropy = true,
+            .pipelineStatisticsQuery = isPipelineStatisticsSupported};
         VkPhysicalDeviceVulkan12Features deviceFeatures12{.sType =
                                                               VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
                                                           .pNext = &deviceMutableFeatures,
+                                                          .drawIndirectCount = supportedFeatures12.drawIndirectCount,
                                                           .descriptorIndexing = true,
                                                           .descriptorBindingUniformBufferUpdateAfterBind = true,
                                                           .descriptorBindingSampledImageUpdateAfterBind = true,
@@ -1699,10 +4353,12 @@ namespace ionengine::rhi
                                                           .descriptorBindingStorageBufferUpdateAfterBind = true,
                                                           .descriptorBindingPartiallyBound = true,
                                                           .runtimeDescriptorArray = true,
+                                                          .hostQueryReset = true,
                                                           .timelineSemaphore = true};
         VkPhysicalDeviceVulkan13Features deviceFeatures13{.sType =
                                                               VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
                                                           .pNext = &deviceFeatures12,
+                                                          .synchronization2 = true,
                                                           .dynamicRendering = true};
         VkDeviceCreateInfo const deviceCreateInfo{
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -1711,33 +4367,78 @@ namespace ionengine::rhi
             .pQueueCreateInfos = queueCreateInfos.data(),
             .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
             .ppEnabledExtensionNames = deviceExtensions.data(),
-            .pEnabledFeatures = &deviceFeatures};
+            .pEnabledFeatures = &enabledFeatures};
         throwIfFailed(::vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device));
 
-        this->createDeviceQueue(graphicsQueueFamily, graphicsQueue);
-        this->createDeviceQueue(transferQueueFamily, transferQueue);
-        this->createDeviceQueue(computeQueueFamily, computeQueue);
-
-        descriptorAllocator = core::make_ref<DescriptorAllocator>(device);
-
-        VmaAllocatorCreateInfo const memoryAllocatorCreateInfo{
-            .physicalDevice = physicalDevice, .device = device, .instance = instance};
-        ::vmaCreateAllocator(&memoryAllocatorCreateInfo, &memoryAllocator);
-
-        pipelineCache = core::make_ref<PipelineCache>(device, descriptorAllocator.get(), createInfo);
-
-        graphicsContext =
-            core::make_ref<VKGraphicsContext>(device, pipelineCache.get(), descriptorAllocator.get(), graphicsQueue);
-        copyContext = core::make_ref<VKCopyContext>(device, memoryAllocator, transferQueue, createInfo);
+        this->createDeviceQueue(graphicsQueueFamily, graphicsQueueIndex, graphicsQueue);
+        this->createDeviceQueue(transferQueueFamily, transferQueueIndex, transferQueue);
+        this->createDeviceQueue(computeQueueFamily, computeQueueIndex, computeQueue);
+
+        graphicsQueue.timestampValidBits = queueFamilies[graphicsQueueFamily].timestampValidBits;
+        transferQueue.timestampValidBits = queueFamilies[transferQueueFamily].timestampValidBits;
+        computeQueue.timestampValidBits = queueFamilies[computeQueueFamily].timestampValidBits;
+
+        VkPhysicalDeviceProperties deviceProperties;
+        ::vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+        timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+        descriptorAllocator = std::make_unique<DescriptorAllocator>(device, rhiCreateInfo);
+
+        VmaAllocatorCreateInfo const memoryAllocatorCreateInfo{.physicalDevice = physicalDevice,
+                                                               .device = device,
+                                                               .instance = instance,
+                                                               .vulkanApiVersion = VK_API_VERSION_1_3};
+        throwIfFailed(::vmaCreateAllocator(&memoryAllocatorCreateInfo, &memoryAllocator));
+
+        bufferPools[0] = std::make_unique<VKBufferPool>(memoryAllocator, concurrentQueueFamilies, 0);
+        bufferPools[1] = std::make_unique<VKBufferPool>(
+            memoryAllocator, concurrentQueueFamilies,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        bufferPools[2] = std::make_unique<VKBufferPool>(
+            memoryAllocator, concurrentQueueFamilies,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+        destructionQueue = std::make_unique<DestructionQueue>(
+            device, memoryAllocator, descriptorAllocator.get(),
+            std::array<DeviceQueueData*, 3>{&graphicsQueue, &transferQueue, &computeQueue});
+
+        pipelineCache =
+            std::make_unique<PipelineCache>(physicalDevice, device, descriptorAllocator.get(), rhiCreateInfo);
+
+        copyContext = std::make_unique<VKCopyContext>(device, memoryAllocator, destructionQueue.get(), transferQueue,
+                                                      graphicsQueueFamily, barrierCounters, rhiCreateInfo);
+        graphicsContext = std::make_unique<VKGraphicsContext>(device, pipelineCache.get(), descriptorAllocator.get(),
+                                                              destructionQueue.get(), graphicsQueue, barrierCounters,
+                                                              stateCounters, copyContext.get(), deviceFeatures);
+        computeContext = std::make_unique<VKComputeContext>(device, pipelineCache.get(), descriptorAllocator.get(),
+                                                            destructionQueue.get(), computeQueue, barrierCounters);
+
+        if (isWindowSwapchain)
+        {
+            swapchain = std::make_unique<VKSwapchain>(instance, physicalDevice, device, graphicsQueue,
+                                                      swapchainCreateInfo.value());
+        }
+        else if (swapchainCreateInfo.has_value())
+        {
+            swapchain = std::make_unique<VKHeadlessSwapchain>(device, memoryAllocator, destructionQueue.get(),
+                                                              concurrentQueueFamilies, graphicsQueue,
+                                                              swapchainCreateInfo.value());
+        }
     }
 
     VKRHI::~VKRHI()
     {
         ::vkDeviceWaitIdle(device);
         swapchain = nullptr;
+        computeContext = nullptr;
         copyContext = nullptr;
         graphicsContext = nullptr;
         pipelineCache = nullptr;
+        destructionQueue = nullptr;
+        for (auto& bufferPool : bufferPools)
+        {
+            bufferPool = nullptr;
+        }
         ::vmaDestroyAllocator(memoryAllocator);
         descriptorAllocator = nullptr;
         ::vkDestroySemaphore(device, graphicsQueue.semaphore, nullptr);
@@ -1757,25 +4458,48 @@ namespace ionengine::rhi
 
     auto VKRHI::createTexture(TextureCreateInfo const& createInfo) -> core::ref_ptr<Texture>
     {
-        return core::make_ref<VKTexture>(device, memoryAllocator, descriptorAllocator.get(), createInfo);
+        return core::make_ref<VKTexture>(device, memoryAllocator, descriptorAllocator.get(), destructionQueue.get(),
+                                         concurrentQueueFamilies, createInfo);
     }
 
     auto VKRHI::createBuffer(BufferCreateInfo const& createInfo) -> core::ref_ptr<Buffer>
     {
-        return core::make_ref<VKBuffer>(device, memoryAllocator, createInfo);
+        // Small buffers, e.g. constant buffers of materials, share pages instead of taking a VkBuffer each
+        if (createInfo.size > 0 && createInfo.size <= VKBufferPool::MaxSubAllocationSize)
+        {
+            uint32_t poolIndex = 0;
+            if (createInfo.flags & BufferUsage::MapWrite)
+            {
+                poolIndex = 1;
+            }
+            else if (createInfo.flags & BufferUsage::MapRead)
+            {
+                poolIndex = 2;
+            }
+            return core::make_ref<VKBuffer>(device, memoryAllocator, descriptorAllocator.get(),
+                                            bufferPools[poolIndex].get(), destructionQueue.get(), createInfo);
+        }
+
+        return core::make_ref<VKBuffer>(device, memoryAllocator, descriptorAllocator.get(), destructionQueue.get(),
+                                        concurrentQueueFamilies, createInfo);
     }
 
     auto VKRHI::createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler>
     {
-        return core::make_ref<VKSampler>(device, createInfo);
+        return core::make_ref<VKSampler>(device, destructionQueue.get(), createInfo);
     }
 
-    auto VKRHI::tryGetSwapchain(SwapchainCreateInfo const& createInfo) -> Swapchain*
+    auto VKRHI::createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query>
     {
-        if (!swapchain)
+        if (createInfo.queryType == QueryType::PipelineStatistics && !isPipelineStatisticsSupported)
         {
-            swapchain = core::make_ref<VKSwapchain>(instance, physicalDevice, device, graphicsQueue, createInfo);
+            throw std::runtime_error("device does not support pipeline statistics queries");
         }
+        return core::make_ref<VKQuery>(device, memoryAllocator, destructionQueue.get(), timestampPeriod, createInfo);
+    }
+
+    auto VKRHI::getSwapchain() -> Swapchain*
+    {
         return swapchain.get();
     }
 
@@ -1784,20 +4508,114 @@ namespace ionengine::rhi
         return graphicsContext.get();
     }
 
+    auto VKRHI::createGraphicsContext() -> std::unique_ptr<GraphicsContext>
+    {
+        return std::make_unique<VKGraphicsContext>(device, pipelineCache.get(), descriptorAllocator.get(),
+                                                   destructionQueue.get(), graphicsQueue, barrierCounters,
+                                                   stateCounters, copyContext.get(), deviceFeatures);
+    }
+
+    auto VKRHI::submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void>
+    {
+        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+
+        for (auto const context : contexts)
+        {
+            auto vkContext = static_cast<VKGraphicsContext*>(context);
+            // Closing can add the wait for copies whose textures it acquires
+            vkContext->close(commandBuffers);
+            vkContext->takeWaitSemaphores(waitSemaphores, waitValues);
+        }
+
+        // One submission keeps the command buffers in the order of the contexts
+        uint64_t const fenceValue = VKDeviceContext_submit(
+            graphicsQueue, commandBuffers, static_cast<uint32_t>(contexts.size()), waitSemaphores, waitValues);
+
+        for (auto const context : contexts)
+        {
+            static_cast<VKGraphicsContext*>(context)->markSubmitted(fenceValue);
+        }
+
+        destructionQueue->collect();
+
+        auto futureImpl =
+            std::make_unique<VKFutureImpl>(device, graphicsQueue.queue, graphicsQueue.semaphore, fenceValue);
+        return Future<void>(std::move(futureImpl));
+    }
+
     auto VKRHI::getCopyContext() -> CopyContext*
     {
         return copyContext.get();
     }
 
+    auto VKRHI::getComputeContext() -> ComputeContext*
+    {
+        return computeContext.get();
+    }
+
+    auto VKRHI::prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void
+    {
+        for (auto const& pipeline : pipelines)
+        {
+            std::array<VkFormat, 8> renderTargetFormats;
+            renderTargetFormats.fill(VK_FORMAT_UNDEFINED);
+            for (uint32_t const i : std::views::iota(0u, pipeline.renderTargetFormats.size()))
+            {
+                renderTargetFormats[i] = Format_to_VkFormat(pipeline.renderTargetFormats[i]);
+            }
+
+            pipelineCache->prewarm(dynamic_cast<VKShader*>(pipeline.shader), pipeline.rasterizer, pipeline.blendColor,
+                                   pipeline.depthStencil, renderTargetFormats,
+                                   Format_to_VkFormat(pipeline.depthStencilFormat));
+        }
+    }
+
+    auto VKRHI::getPipelineCacheStats() const -> PipelineCacheStats
+    {
+        return pipelineCache->getStats();
+    }
+
+    auto VKRHI::getUploadStats() const -> UploadStats
+    {
+        return copyContext->getStats();
+    }
+
+    auto VKRHI::getBarrierStats() const -> BarrierStats
+    {
+        return barrierCounters.getStats();
+    }
+
+    auto VKRHI::getStateStats() const -> StateStats
+    {
+        return stateCounters.getStats();
+    }
+
     auto VKRHI::getName() const -> std::string const&
     {
         return rhiName;
     }
 
-    auto VKRHI::createDeviceQueue(uint32_t const queueFamily, DeviceQueueData& deviceQueue) -> void
+    auto VKRHI::getDestructionQueue() -> DestructionQueue*
+    {
+        return destructionQueue.get();
+    }
+
+    auto VKRHI::getBufferPageCount() const -> size_t
+    {
+        return std::accumulate(bufferPools.begin(), bufferPools.end(), size_t{0},
+                               [](size_t const count, auto const& bufferPool) {
+                                   return count + bufferPool->getPageCount();
+                               });
+    }
+
+    auto VKRHI::createDeviceQueue(uint32_t const queueFamily, uint32_t const queueIndex, DeviceQueueData& deviceQueue)
+        -> void
     {
-        ::vkGetDeviceQueue(device, queueFamily, 0, &deviceQueue.queue);
+        ::vkGetDeviceQueue(device, queueFamily, queueIndex, &deviceQueue.queue);
         deviceQueue.familyIndex = queueFamily;
+        deviceQueue.submitMutex = &submitMutexes[deviceQueue.queue];
 
         VkSemaphoreTypeCreateInfo const semaphoreTypeCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
                                                                 .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE};
@@ -1808,5 +4626,6 @@ namespace ionengine::rhi
         uint64_t counterValue;
         throwIfFailed(::vkGetSemaphoreCounterValue(device, deviceQueue.semaphore, &counterValue));
         deviceQueue.fenceValue = counterValue;
+        deviceQueue.openCommandLists = 0;
     }
 } // namespace ionengine::rhi
\ No newline at end of file
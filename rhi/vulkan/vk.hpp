@@ -2,6 +2,12 @@
 
 #pragma once
 
+#include "../barrier_batcher.hpp"
+#include "../buffer_allocator.hpp"
+#include "../descriptor_allocator.hpp"
+#include "../state_cache.hpp"
+#include "../pipeline_cache.hpp"
+#include "../readback_ring.hpp"
 #include "../rhi.hpp"
 #include <xxhash.h>
 #ifdef IONENGINE_PLATFORM_WIN32
@@ -18,6 +24,7 @@
 
 namespace ionengine::rhi
 {
+    // Heap sizes used when RHICreateInfo leaves them as zero
     enum class DescriptorAllocatorLimits : uint32_t
     {
         Uniform = 16 * 1024,
@@ -26,53 +33,179 @@ namespace ionengine::rhi
         Sampler = 128
     };
 
-    VK_DEFINE_HANDLE(DescriptorAllocation);
-
-    class DescriptorAllocator;
-
-    struct DescriptorAllocation_T
+    struct DescriptorAllocation
     {
         VkDescriptorType descriptorType;
-        VkDescriptorSet descriptorSet;
-        uint32_t binding;
         uint32_t arrayElement;
     };
 
     class DescriptorAllocator
     {
       public:
-        DescriptorAllocator(VkDevice device);
+        DescriptorAllocator(VkDevice device, RHICreateInfo const& createInfo);
 
         ~DescriptorAllocator();
 
         auto allocate(VkDescriptorType const descriptorType, DescriptorAllocation* allocation) -> VkResult;
 
-        auto deallocate(DescriptorAllocation allocation) -> void;
+        /*! \brief Allocates descriptors for the whole span at once
+            \details Either every allocation succeeds or none of them is made
+        */
+        auto allocate(VkDescriptorType const descriptorType, std::span<DescriptorAllocation> const allocations)
+            -> VkResult;
+
+        auto deallocate(DescriptorAllocation const& allocation) -> void;
+
+        auto deallocate(std::span<DescriptorAllocation const> const allocations) -> void;
 
-        auto getDescriptorSet(VkDescriptorType const descriptorType) -> VkDescriptorSet;
+        auto getDescriptorSet(VkDescriptorType const descriptorType) const -> VkDescriptorSet;
 
-        auto getDescriptorSetLayout(VkDescriptorType const descriptorType) -> VkDescriptorSetLayout;
+        auto getDescriptorSetLayout(VkDescriptorType const descriptorType) const -> VkDescriptorSetLayout;
 
       private:
-        std::mutex mutex;
         VkDevice device;
         VkDescriptorPool descriptorPool;
 
         struct Chunk
         {
+            VkDescriptorType descriptorType;
             VkDescriptorSetLayout descriptorSetLayout;
             VkDescriptorSet descriptorSet;
-            uint32_t binding;
-            std::vector<uint8_t> free;
-            uint32_t offset;
-            uint32_t size;
-            std::vector<DescriptorAllocation_T> allocations;
+            std::unique_ptr<DescriptorSlotAllocator> slots;
         };
 
         std::unordered_map<VkDescriptorType, Chunk> chunks;
 
         auto createChunk(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorType const descriptorType,
                          uint32_t const descriptorCount) -> void;
+
+        auto getChunk(VkDescriptorType const descriptorType) -> Chunk&;
+    };
+
+    // Optional device features the contexts check before recording the commands that need them
+    struct DeviceFeatureData
+    {
+        bool isMultiDrawIndirectSupported;
+        bool isDrawIndirectCountSupported;
+    };
+
+    struct DeviceQueueData
+    {
+        VkQueue queue;
+        VkSemaphore semaphore;
+        uint32_t familyIndex;
+        // Last value signaled by a submission, only changed under submitMutex so values are signaled in order
+        std::atomic<uint64_t> fenceValue;
+        // Shared by the device queues that alias one VkQueue, submissions to it have to be externally synchronized
+        std::mutex* submitMutex;
+        // Command lists being recorded for the queue, each one can be submitted on its own and take the next value
+        std::atomic<uint32_t> openCommandLists;
+        // Meaningful bits of the timestamps written on the queue, zero when it can't write them
+        uint32_t timestampValidBits;
+    };
+
+    struct VKBufferPage
+    {
+        VkBuffer buffer;
+        VmaAllocation memoryAllocation;
+        // Pages of host visible memory stay mapped, null for device local ones
+        uint8_t* mappedBytes;
+    };
+
+    /*!
+        \brief Places small buffers of one memory type in shared VkBuffers
+        \details Every page is created with all the buffer usages, so buffers with different flags share it.
+        Offsets are aligned to the block size, which covers the offset alignment of uniform and storage buffers
+    */
+    class VKBufferPool
+    {
+      public:
+        static size_t constexpr PageSize = 4 * 1024 * 1024;
+        static size_t constexpr MinBlockSize = 256;
+        // Larger buffers get their own allocation
+        static size_t constexpr MaxSubAllocationSize = 64 * 1024;
+
+        using Allocation = BufferSubAllocator<VKBufferPage>::Allocation;
+
+        VKBufferPool(VmaAllocator memoryAllocator, std::span<uint32_t const> const queueFamilies,
+                     VmaAllocationCreateFlags const allocationFlags);
+
+        ~VKBufferPool();
+
+        auto allocate(size_t const size) -> Allocation;
+
+        auto deallocate(Allocation const& allocation) -> void;
+
+        auto getPageCount() const -> size_t;
+
+      private:
+        VmaAllocator memoryAllocator;
+        std::vector<uint32_t> queueFamilies;
+        VmaAllocationCreateFlags allocationFlags;
+        BufferSubAllocator<VKBufferPage> subAllocator;
+
+        auto createPage() -> VKBufferPage;
+    };
+
+    /*!
+        \brief Destroys Vulkan objects once the GPU can no longer use them
+        \details A released object keeps the fence value each device queue reaches after the last submission that
+        may reference it. collect() is called by the contexts after they submit and frees the objects whose values
+        every timeline semaphore has passed, so dropping a resource never waits for the device
+    */
+    class DestructionQueue
+    {
+      public:
+        DestructionQueue(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                         std::array<DeviceQueueData*, 3> const& deviceQueues);
+
+        /*!
+            \brief Frees every object left in the queue, the device should be idle
+        */
+        ~DestructionQueue();
+
+        auto releaseBuffer(VkBuffer buffer, VmaAllocation memoryAllocation) -> void;
+
+        auto releaseBuffer(VKBufferPool* bufferPool, VKBufferPool::Allocation const& allocation) -> void;
+
+        auto releaseImage(VkImage image, VkImageView imageView, VmaAllocation memoryAllocation) -> void;
+
+        auto releaseSampler(VkSampler sampler) -> void;
+
+        auto releaseDescriptor(DescriptorAllocation const& descriptorAllocation) -> void;
+
+        auto releaseQueryPool(VkQueryPool queryPool) -> void;
+
+        auto collect() -> void;
+
+        auto getPendingCount() const -> size_t;
+
+      private:
+        VkDevice device;
+        VmaAllocator memoryAllocator;
+        DescriptorAllocator* descriptorAllocator;
+        std::array<DeviceQueueData*, 3> deviceQueues;
+
+        struct Entry
+        {
+            std::array<uint64_t, 3> fenceValues;
+            VkBuffer buffer;
+            VkImage image;
+            VkImageView imageView;
+            VkSampler sampler;
+            VkQueryPool queryPool;
+            VmaAllocation memoryAllocation;
+            std::optional<DescriptorAllocation> descriptorAllocation;
+            VKBufferPool* bufferPool;
+            std::optional<VKBufferPool::Allocation> bufferAllocation;
+        };
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;
+
+        auto enqueue(Entry&& entry) -> void;
+
+        auto destroy(Entry const& entry) -> void;
     };
 
     class VKVertexInput
@@ -132,81 +265,129 @@ namespace ionengine::rhi
 
         auto getPipeline() -> VkPipeline;
 
+        /*! \brief Whether the driver built the pipeline from the pipeline cache without compiling it */
+        auto isDriverCacheHit() const -> bool;
+
       private:
         VkDevice device;
         VkPipeline pipeline;
         VkPipelineBindPoint pipelineType;
+        VkPipelineCreationFeedback creationFeedback;
     };
 
     class PipelineCache
     {
       public:
-        struct Entry
-        {
-            uint64_t shaderHash;
-            RasterizerStageInfo rasterizer;
-            BlendColorInfo blendColor;
-            std::optional<DepthStencilStageInfo> depthStencil;
-            std::array<VkFormat, 8> renderTargetFormats;
-            VkFormat depthStencilFormat;
-
-            auto operator==(Entry const& other) const -> bool
-            {
-                return std::make_tuple(shaderHash, rasterizer, blendColor,
-                                       depthStencil.value_or(DepthStencilStageInfo::Default()), renderTargetFormats,
-                                       depthStencilFormat) ==
-                       std::make_tuple(other.shaderHash, other.rasterizer, other.blendColor,
-                                       other.depthStencil.value_or(DepthStencilStageInfo::Default()),
-                                       other.renderTargetFormats, other.depthStencilFormat);
-            }
-        };
-
-        struct EntryHasher
-        {
-            auto operator()(const Entry& other) const -> std::size_t
-            {
-                auto depthStencil = other.depthStencil.value_or(DepthStencilStageInfo::Default());
-                return other.shaderHash ^ ::XXH64(&other.rasterizer.fillMode, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.rasterizer.cullMode, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendDst, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendDstAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendEnable, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendOp, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendOpAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendSrc, sizeof(uint32_t), 0) ^
-                       ::XXH64(&other.blendColor.blendSrcAlpha, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.depthFunc, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.depthWrite, sizeof(uint32_t), 0) ^
-                       ::XXH64(&depthStencil.stencilWrite, sizeof(uint32_t), 0) ^
-                       ::XXH64(other.renderTargetFormats.data(), other.renderTargetFormats.size(), 0) ^
-                       ::XXH64(&other.depthStencilFormat, sizeof(VkFormat), 0);
-            }
-        };
-
-        PipelineCache(VkDevice device, DescriptorAllocator* descriptorAllocator, RHICreateInfo const& createInfo);
+        PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, DescriptorAllocator* descriptorAllocator,
+                      RHICreateInfo const& createInfo);
 
         ~PipelineCache();
 
+        /*! \brief Returns the pipeline for the shader and state
+            \details In blocking mode a missing pipeline is compiled on the calling thread, or waited for if a
+            compiler thread is already working on it. Other modes queue the compilation and return nullptr until the
+            pipeline is ready
+        */
         auto get(VKShader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
                  std::optional<DepthStencilStageInfo> const depthStencil,
-                 std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat)
-            -> core::ref_ptr<Pipeline>;
+                 std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat,
+                 PipelineCompileMode const mode) -> core::ref_ptr<Pipeline>;
+
+        /*! \brief Queues the pipeline for the compiler threads unless it is ready or already queued */
+        auto prewarm(VKShader* shader, RasterizerStageInfo const& rasterizer, BlendColorInfo const& blendColor,
+                     std::optional<DepthStencilStageInfo> const depthStencil,
+                     std::array<VkFormat, 8> const& renderTargetFormats, VkFormat const depthStencilFormat) -> void;
+
+        auto getCompileMode() const -> PipelineCompileMode;
 
         auto reset() -> void;
 
         auto getPipelineLayout() -> VkPipelineLayout;
 
+        /*! \brief Writes the driver pipeline cache to the disk if it changed since the last save
+            \details Called on destruction, can be called earlier to keep the data of long sessions
+        */
+        auto save() -> void;
+
+        auto getStats() const -> PipelineCacheStats;
+
       private:
-        std::mutex mutex;
+        /*! \brief Precedes the driver data in the cache file
+            \details The file is only used by the same device with the same driver build, anything else starts with
+            an empty cache
+        */
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint32_t driverVersion;
+            uint32_t reserved;
+            std::array<uint8_t, VK_UUID_SIZE> driverUUID;
+            std::array<uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+            uint64_t dataSize;
+            uint64_t dataHash;
+        };
+
+        struct CompileRequest
+        {
+            PipelineKey key;
+            core::ref_ptr<VKShader> shader;
+            RasterizerStageInfo rasterizer;
+            BlendColorInfo blendColor;
+            std::optional<DepthStencilStageInfo> depthStencil;
+            std::array<VkFormat, 8> renderTargetFormats;
+            VkFormat depthStencilFormat;
+            std::promise<core::ref_ptr<Pipeline>> promise;
+        };
+
+        static uint32_t constexpr FileMagic = 0x43505649;
+        static uint32_t constexpr FileVersion = 1;
+
         VkDevice device;
         VkPipelineLayout pipelineLayout;
-        std::unordered_map<Entry, core::ref_ptr<Pipeline>, EntryHasher> entries;
+        VkPipelineCache pipelineCache;
+        ShardedPipelineMap<core::ref_ptr<Pipeline>> entries;
+        // Guards compilation only, ready pipelines are found without it
+        mutable std::mutex mutex;
+        // Pipelines being compiled, so the same entry is never compiled twice at the same time
+        std::unordered_map<PipelineKey, std::shared_future<core::ref_ptr<Pipeline>>, PipelineKeyHasher> pendingEntries;
+        std::deque<CompileRequest> compileRequests;
+        std::condition_variable_any compileCondition;
+        std::vector<std::jthread> compilerThreads;
+        PipelineCompileMode compileMode;
+        std::filesystem::path cachePath;
+        FileHeader deviceHeader;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> driverCacheHits{0};
+        std::atomic<uint64_t> creationTime{0};
+        size_t loadedSize;
+        uint64_t savedMisses;
+
+        auto loadFromFile() -> std::vector<uint8_t>;
+
+        auto queueRequest(CompileRequest&& compileRequest) -> void;
+
+        auto compilePipeline(CompileRequest& compileRequest) -> core::ref_ptr<Pipeline>;
+
+        auto compileLoop(std::stop_token stopToken) -> void;
     };
 
     class VKBuffer final : public Buffer
     {
       public:
-        VKBuffer(VkDevice device, VmaAllocator memoryAllocator, BufferCreateInfo const& createInfo);
+        VKBuffer(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                 DestructionQueue* destructionQueue, std::span<uint32_t const> const queueFamilies,
+                 BufferCreateInfo const& createInfo);
+
+        /*!
+            \brief Constructor for a buffer placed in a page of the pool
+            \details Its descriptors cover only its own range of the page
+        */
+        VKBuffer(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                 VKBufferPool* bufferPool, DestructionQueue* destructionQueue, BufferCreateInfo const& createInfo);
 
         ~VKBuffer();
 
@@ -214,27 +395,45 @@ namespace ionengine::rhi
 
         auto getFlags() const -> BufferUsageFlags override;
 
-        auto mapMemory() -> uint8_t*;
+        auto getMappedPointer() -> uint8_t* override;
 
-        auto unmapMemory() -> void;
+        auto flushMappedRange(uint64_t const offset, size_t const size) -> void override;
+
+        auto invalidateMappedRange(uint64_t const offset, size_t const size) -> void override;
 
         auto getBuffer() -> VkBuffer;
 
+        /*!
+            \brief Offset of the buffer in getBuffer(), which is shared with other buffers when it is placed in a pool
+            \details Offsets passed to the commands that take the buffer are added to it
+        */
+        auto getOffset() const -> uint64_t;
+
         auto getDescriptorOffset(BufferUsage const usage) const -> uint32_t override;
 
       private:
         VkDevice device;
         VmaAllocator memoryAllocator;
+        DescriptorAllocator* descriptorAllocator;
+        DestructionQueue* destructionQueue;
+        VKBufferPool* bufferPool;
+        std::optional<VKBufferPool::Allocation> bufferAllocation;
         VkBuffer buffer;
         VmaAllocation memoryAllocation;
+        uint8_t* mappedBytes;
+        uint64_t offset;
         size_t size;
         BufferUsageFlags flags;
+        std::unordered_map<BufferUsage, DescriptorAllocation> descriptorAllocations;
+
+        auto createDescriptors() -> void;
     };
 
     class VKTexture final : public Texture
     {
       public:
         VKTexture(VkDevice device, VmaAllocator memoryAllocator, DescriptorAllocator* descriptorAllocator,
+                  DestructionQueue* destructionQueue, std::span<uint32_t const> const queueFamilies,
                   TextureCreateInfo const& createInfo);
 
         /*!
@@ -264,15 +463,19 @@ namespace ionengine::rhi
 
         auto getInitialLayout() const -> VkImageLayout;
 
+        auto getSharingMode() const -> VkSharingMode;
+
       private:
         VkDevice device;
         VmaAllocator memoryAllocator;
         DescriptorAllocator* descriptorAllocator;
+        DestructionQueue* destructionQueue;
         VkImage image;
         VmaAllocation memoryAllocation;
         std::unordered_map<TextureUsage, DescriptorAllocation> descriptorAllocations;
         VkImageView imageView;
         VkImageLayout initialLayout;
+        VkSharingMode sharingMode;
         uint32_t width;
         uint32_t height;
         uint32_t depth;
@@ -285,7 +488,7 @@ namespace ionengine::rhi
     class VKSampler final : public Sampler
     {
       public:
-        VKSampler(VkDevice device, SamplerCreateInfo const& createInfo);
+        VKSampler(VkDevice device, DestructionQueue* destructionQueue, SamplerCreateInfo const& createInfo);
 
         ~VKSampler();
 
@@ -293,44 +496,156 @@ namespace ionengine::rhi
 
       private:
         VkDevice device;
+        DestructionQueue* destructionQueue;
         VkSampler sampler;
     };
 
+    /*!
+        \brief Query pool with a mapped buffer the results are copied to on resolve
+        \details The pool is reset on the device right after the copy, so the regions of the next resolve are begun
+        without a host reset. Transfer queues can neither copy nor reset queries, so timestamps of copy contexts are
+        read and reset on the host once their submission completes. Pipeline statistics recorded on the compute queue
+        go to a pool of their own that counts compute invocations only, as graphics statistics can't be used there
+    */
+    class VKQuery final : public Query
+    {
+      public:
+        VKQuery(VkDevice device, VmaAllocator memoryAllocator, DestructionQueue* destructionQueue,
+                float const timestampPeriod, QueryCreateInfo const& createInfo);
+
+        ~VKQuery();
+
+        auto getQueryType() const -> QueryType override;
+
+        auto getCount() const -> uint32_t override;
+
+        auto getResult() const -> bool override;
+
+        auto getElapsedTimes() -> std::span<uint64_t const> override;
+
+        auto getPipelineStatistics() -> std::span<PipelineStatistics const> override;
+
+        auto getQueryPool(bool const isGraphicsQueue) -> VkQueryPool;
+
+        // Records the copy of the results to the mapped buffer and the reset of the pool
+        auto resolve(VkCommandBuffer commandBuffer, bool const isGraphicsQueue, uint32_t const timestampValidBits)
+            -> void;
+
+        // Leaves the results in the pool until readHostResults, for queues without query copies
+        auto resolveOnHost(uint32_t const timestampValidBits) -> void;
+
+        /*! \brief Reads the results left in the pool by resolveOnHost and resets it
+            \details Should be called after the submission completes, does nothing for results copied by the device
+        */
+        auto readHostResults() -> void;
+
+        // The results are written once the semaphore reaches the fence value
+        auto markSubmitted(VkSemaphore semaphore, uint64_t const fenceValue) -> void;
+
+      private:
+        VkDevice device;
+        VmaAllocator memoryAllocator;
+        DestructionQueue* destructionQueue;
+        VkQueryPool queryPool;
+        VkQueryPool computeQueryPool;
+        VkBuffer buffer;
+        VmaAllocation memoryAllocation;
+        uint64_t const* mappedData;
+        QueryType queryType;
+        uint32_t count;
+        float timestampPeriod;
+        uint64_t timestampMask;
+        // Resolved but not submitted yet
+        bool isPending;
+        // The results of the last resolve are still in the pool
+        bool isResolvedOnHost;
+        // The results of the last resolve were read from the pool to hostResults instead of the mapped buffer
+        bool isHostResult;
+        std::vector<uint64_t> hostResults;
+        VkSemaphore semaphore;
+        uint64_t fenceValue;
+        std::vector<uint64_t> elapsedTimes;
+        std::vector<PipelineStatistics> statistics;
+    };
+
+    class VKCopyContext;
+
     class VKFutureImpl final : public FutureImpl
     {
       public:
         VKFutureImpl(VkDevice device, VkQueue queue, VkSemaphore semaphore, uint64_t const fenceValue);
 
+        /*!
+            \brief Future of uploads, a graphics context waiting for it also acquires the textures they released
+        */
+        VKFutureImpl(VkDevice device, VkQueue queue, VkSemaphore semaphore, uint64_t const fenceValue,
+                     VKCopyContext* copyContext);
+
         auto getResult() const -> bool override;
 
         auto wait() -> void override;
 
+        auto waitOnContext(IDeviceContext* context) -> void override;
+
       private:
         VkDevice device;
         VkQueue queue;
         VkSemaphore semaphore;
         uint64_t fenceValue;
+        VKCopyContext* copyContext;
     };
 
-    struct DeviceQueueData
+    struct CommandPoolData
     {
-        VkQueue queue;
-        VkSemaphore semaphore;
-        uint32_t familyIndex;
+        VkCommandPool commandPool;
+        VkCommandBuffer commandBuffer;
+        // Allocated from the same pool by the first submission that acquires released textures, null until then
+        VkCommandBuffer acquireCommandBuffer;
         uint64_t fenceValue;
     };
 
+    /*!
+        \brief Batches the barriers of a context into single vkCmdPipelineBarrier2 commands
+        \details Stage and access masks are derived from the resource states and limited to the stages the queue of
+        the context executes. The batch should be flushed before commands that access the resources
+    */
+    class VKBarrierBatcher
+    {
+      public:
+        VKBarrierBatcher(BarrierCounters& counters, VkPipelineStageFlags2 const queueStages);
+
+        auto barrier(VkCommandBuffer commandBuffer, Buffer* destBuffer, ResourceState const beforeState,
+                     ResourceState const afterState) -> void;
+
+        auto barrier(VkCommandBuffer commandBuffer, Texture* destTexture, ResourceState const beforeState,
+                     ResourceState const afterState) -> void;
+
+        // Adds a barrier built by the backend, e.g. for a single subresource or a queue family ownership transfer
+        auto barrier(VkCommandBuffer commandBuffer, Texture* destTexture,
+                     VkImageMemoryBarrier2 const& imageMemoryBarrier) -> void;
+
+        auto flush(VkCommandBuffer commandBuffer) -> void;
+
+      private:
+        BarrierBatcher<VkBufferMemoryBarrier2, VkImageMemoryBarrier2> barrierBatcher;
+        VkPipelineStageFlags2 queueStages;
+    };
+
     class VKGraphicsContext final : public GraphicsContext
     {
       public:
         VKGraphicsContext(VkDevice device, PipelineCache* pipelineCache, DescriptorAllocator* descriptorAllocator,
-                          DeviceQueueData& deviceQueue);
+                          DestructionQueue* destructionQueue, DeviceQueueData& deviceQueue,
+                          BarrierCounters& barrierCounters, StateCounters& stateCounters, VKCopyContext* copyContext,
+                          DeviceFeatureData const& deviceFeatures);
 
         ~VKGraphicsContext();
 
-        auto setGraphicsPipelineOptions(core::ref_ptr<Shader> shader, RasterizerStageInfo const& rasterizer,
+        auto setGraphicsPipelineOptions(Shader* shader, RasterizerStageInfo const& rasterizer,
                                         BlendColorInfo const& blendColor,
-                                        std::optional<DepthStencilStageInfo> const depthStencil) -> void override;
+                                        std::optional<DepthStencilStageInfo> const depthStencil) -> bool override;
+
+        auto setFallbackShader(Shader* shader) -> void override;
 
         auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
 
@@ -339,87 +654,296 @@ namespace ionengine::rhi
 
         auto endRenderPass() -> void override;
 
-        auto bindVertexBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size) -> void override;
+        auto bindVertexBuffer(Buffer* buffer, uint64_t const offset, size_t const size) -> void override;
 
-        auto bindIndexBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size,
-                             Format const format) -> void override;
+        auto bindIndexBuffer(Buffer* buffer, uint64_t const offset, size_t const size, Format const format)
+            -> void override;
 
         auto drawIndexed(uint32_t const indexCount, uint32_t const instanceCount) -> void override;
 
         auto draw(uint32_t const vertexCount, uint32_t const instanceCount) -> void override;
 
+        auto drawIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndexedIndirect(Buffer* buffer, uint64_t const offset, uint32_t const drawCount) -> void override;
+
+        auto drawIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer, uint64_t const countOffset,
+                               uint32_t const maxDrawCount) -> void override;
+
+        auto drawIndexedIndirectCount(Buffer* buffer, uint64_t const offset, Buffer* countBuffer,
+                                      uint64_t const countOffset, uint32_t const maxDrawCount) -> void override;
+
         auto setViewport(int32_t const x, int32_t const y, uint32_t const width, uint32_t const height)
             -> void override;
 
         auto setScissor(int32_t const left, int32_t const top, int32_t const right, int32_t const bottom)
             -> void override;
 
-        auto barrier(core::ref_ptr<Buffer> dest, ResourceState const before, ResourceState const after)
+        auto submitDraws(std::span<DrawPacket const> const packets) -> void override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
-        auto barrier(core::ref_ptr<Texture> dest, ResourceState const before, ResourceState const after)
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
         auto execute() -> Future<void> override;
 
+        /*!
+            \brief Make the next submission wait until the semaphore reaches the value
+        */
+        auto waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void;
+
+        /*!
+            \brief Moves the semaphores the next submission should wait for to the passed lists
+        */
+        auto takeWaitSemaphores(std::vector<VkSemaphore>& semaphores, std::vector<uint64_t>& values) -> void;
+
+        /*!
+            \brief Records the acquire half of a queue family ownership transfer
+            \details Should be called outside of a render pass, before the texture is used
+        */
+        auto acquireOwnership(Texture* texture, VkImageMemoryBarrier2 const& imageBarrier) -> void;
+
+        /*!
+            \brief Ends the recording and appends the command buffers to submit
+            \details Textures released by copies that are already submitted are acquired by a command buffer put
+            before the recorded one, however their futures were waited for
+        */
+        auto close(std::vector<VkCommandBuffer>& commandBuffers) -> void;
+
+        /*!
+            \brief Keeps the closed command buffer until the queue reaches the fence value of its submission
+        */
+        auto markSubmitted(uint64_t const fenceValue) -> void;
+
       private:
         VkDevice device;
         PipelineCache* pipelineCache;
         DescriptorAllocator* descriptorAllocator;
+        DestructionQueue* destructionQueue;
         DeviceQueueData* deviceQueue;
+        VKCopyContext* copyContext;
+        DeviceFeatureData deviceFeatures;
+        VKBarrierBatcher barrierBatcher;
+        GraphicsStateCache stateCache;
+        // Queries resolved by the command buffer being recorded
+        std::vector<core::ref_ptr<VKQuery>> resolvedQueries;
+
+        // Pools stay in flight until the queue passes their submission, then they are reset and reused
+        std::deque<CommandPoolData> submittedPools;
+        std::vector<CommandPoolData> freePools;
         VkCommandPool commandPool;
         VkCommandBuffer commandBuffer;
+        VkCommandBuffer acquireCommandBuffer;
         VkRect2D renderArea;
         bool isCommandListOpened;
+        // Draws are dropped while the requested pipeline is still compiling and nothing is bound instead
+        bool isPipelineBound;
+        core::ref_ptr<VKShader> fallbackShader;
         std::array<VkFormat, 8> renderTargetFormats;
         VkFormat depthStencilFormat;
         std::vector<uint8_t> bindingData;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+
+        auto tryAllocateCommandBuffer() -> void;
+    };
+
+    class VKComputeContext final : public ComputeContext
+    {
+      public:
+        VKComputeContext(VkDevice device, PipelineCache* pipelineCache, DescriptorAllocator* descriptorAllocator,
+                         DestructionQueue* destructionQueue, DeviceQueueData& deviceQueue,
+                         BarrierCounters& barrierCounters);
+
+        ~VKComputeContext();
+
+        auto setComputePipelineOptions(Shader* shader) -> bool override;
+
+        auto bindDescriptor(uint32_t const index, uint32_t const descriptor) -> void override;
+
+        auto dispatch(uint32_t const threadGroupCountX, uint32_t const threadGroupCountY,
+                      uint32_t const threadGroupCountZ) -> void override;
+
+        auto dispatchIndirect(Buffer* buffer, uint64_t const offset) -> void override;
+
+        auto uavBarrier(Buffer* destBuffer) -> void override;
+
+        auto uavBarrier(Texture* destTexture) -> void override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
+            -> void override;
+
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
+        auto execute() -> Future<void> override;
+
+        /*!
+            \brief Make the next submission wait until the semaphore reaches the value
+        */
+        auto waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void;
+
+      private:
+        VkDevice device;
+        PipelineCache* pipelineCache;
+        DescriptorAllocator* descriptorAllocator;
+        DestructionQueue* destructionQueue;
+        DeviceQueueData* deviceQueue;
+        VKBarrierBatcher barrierBatcher;
+        // Queries resolved by the command buffer being recorded
+        std::vector<core::ref_ptr<VKQuery>> resolvedQueries;
+        std::deque<CommandPoolData> submittedPools;
+        std::vector<CommandPoolData> freePools;
+        VkCommandPool commandPool;
+        VkCommandBuffer commandBuffer;
+        bool isCommandListOpened;
+        // Dispatches are dropped while the requested pipeline is still compiling
+        bool isPipelineBound;
+        std::vector<uint8_t> bindingData;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
 
         auto tryAllocateCommandBuffer() -> void;
     };
 
+    /*!
+        \brief Uploads data through a persistently mapped ring staging buffer. Copies are recorded into one command
+        buffer until execute() or until half of the ring is pending, and ring regions are reclaimed once the timeline
+        semaphore passes the value of the submission that used them
+    */
     class VKCopyContext final : public CopyContext
     {
       public:
-        VKCopyContext(VkDevice device, VmaAllocator memoryAllocator, DeviceQueueData& deviceQueue,
-                      RHICreateInfo const& rhiCreateInfo);
+        VKCopyContext(VkDevice device, VmaAllocator memoryAllocator, DestructionQueue* destructionQueue,
+                      DeviceQueueData& deviceQueue, uint32_t const graphicsQueueFamily,
+                      BarrierCounters& barrierCounters, RHICreateInfo const& rhiCreateInfo);
 
         ~VKCopyContext();
 
-        auto updateBuffer(core::ref_ptr<Buffer> dest, uint64_t const offset, std::span<uint8_t const> const dataBytes)
+        auto updateBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, std::span<uint8_t const> const dataBytes)
             -> Future<Buffer> override;
 
-        auto updateTexture(core::ref_ptr<Texture> dest, uint32_t const resourceIndex,
+        auto updateTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex,
                            std::span<uint8_t const> const dataBytes) -> Future<Texture> override;
 
-        auto barrier(core::ref_ptr<Buffer> dest, ResourceState const before, ResourceState const after)
+        auto readBuffer(core::ref_ptr<Buffer> buffer, uint64_t const offset, size_t const size)
+            -> Future<ReadbackData> override;
+
+        auto readTexture(core::ref_ptr<Texture> texture, uint32_t const resourceIndex)
+            -> Future<ReadbackData> override;
+
+        auto barrier(Buffer* destBuffer, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
-        auto barrier(core::ref_ptr<Texture> dest, ResourceState const before, ResourceState const after)
+        auto barrier(Texture* destTexture, ResourceState const beforeState, ResourceState const afterState)
             -> void override;
 
+        auto beginQuery(Query* query, uint32_t const index) -> void override;
+
+        auto endQuery(Query* query, uint32_t const index) -> void override;
+
+        auto resolveQuery(Query* query) -> void override;
+
         auto execute() -> Future<void> override;
 
+        /*!
+            \brief Make the next submission wait until the semaphore reaches the value
+        */
+        auto waitSemaphore(VkSemaphore semaphore, uint64_t const value) -> void;
+
+        /*!
+            \brief Makes the graphics context acquire the textures released by the submissions up to the fence value
+        */
+        auto handOff(uint64_t const fenceValue, VKGraphicsContext* graphicsContext) -> void;
+
+        /*!
+            \brief Moves the acquires of the textures released by submitted copies to the passed list
+            \details Adds the wait for those copies to the passed semaphore lists when anything is acquired
+        */
+        auto handOffSubmitted(std::vector<VkImageMemoryBarrier2>& acquireBarriers,
+                              std::vector<VkSemaphore>& semaphores, std::vector<uint64_t>& values) -> void;
+
+        auto getStats() const -> UploadStats;
+
       private:
         VkDevice device;
+        VmaAllocator memoryAllocator;
+        DestructionQueue* destructionQueue;
         DeviceQueueData* deviceQueue;
+        uint32_t graphicsQueueFamily;
+        VKBarrierBatcher barrierBatcher;
+        // Queries resolved by the command buffer being recorded
+        std::vector<core::ref_ptr<VKQuery>> resolvedQueries;
         VkCommandPool commandPool;
         VkCommandBuffer commandBuffer;
         bool isCommandListOpened;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<uint64_t> waitValues;
+
+        struct SubmissionData
+        {
+            VkCommandBuffer commandBuffer;
+            uint64_t fenceValue;
+            uint64_t stagingEnd;
+        };
+
+        std::deque<SubmissionData> submissions;
+        std::vector<VkCommandBuffer> freeCommandBuffers;
 
-        struct StagingBufferData
+        core::ref_ptr<VKBuffer> stagingBuffer;
+        uint8_t* stagingBytes;
+        // Ring offsets grow monotonically and wrap by the size of the staging buffer
+        uint64_t stagingHead;
+        uint64_t stagingTail;
+        uint64_t stagingSubmitted;
+
+        // Textures written on the copy queue family and released to the graphics one
+        struct OwnershipTransferData
         {
-            core::ref_ptr<VKBuffer> buffer;
-            uint64_t offset;
+            core::ref_ptr<Texture> texture;
+            VkImageMemoryBarrier2 acquireBarrier;
+            uint64_t fenceValue;
         };
 
-        StagingBufferData readStagingBuffer;
-        StagingBufferData writeStagingBuffer;
+        // Taken by the threads that submit graphics contexts as well
+        std::mutex releaseMutex;
+        std::vector<OwnershipTransferData> releasedTextures;
+        UploadStats stats;
+
+        size_t readbackBufferSize;
+        // Created by the first readback
+        core::ref_ptr<ReadbackRing> readbackRing;
+        // The open command buffer copies into the ring, so the host has to see the writes after the submission
+        bool isReadbackRecorded;
 
-        /*auto getSurfaceData(DXGI_FORMAT const format, uint32_t const width, uint32_t const height, size_t& rowBytes,
-                            uint32_t& rowCount) -> void;*/
+        auto getSurfaceData(Format const format, uint32_t const width, uint32_t const height, size_t& rowBytes,
+                            uint32_t& rowCount, uint32_t& blockBytes, uint32_t& blockHeight) -> void;
 
         auto tryAllocateCommandBuffer() -> void;
+
+        auto submit() -> void;
+
+        auto retireSubmissions(bool const waitOldest) -> void;
+
+        auto allocateStagingMemory(size_t const size, size_t const alignment) -> uint64_t;
+
+        auto tryFlushStagingMemory() -> void;
+
+        auto allocateReadbackMemory(size_t const size, size_t const alignment) -> uint64_t;
     };
 
     class VKSwapchain final : public Swapchain
@@ -430,9 +954,9 @@ namespace ionengine::rhi
 
         ~VKSwapchain();
 
-        auto getBackBuffer() -> core::weak_ptr<Texture> override;
+        [[nodiscard]] auto getBackBuffer() -> Texture* override;
 
-        auto presentBackBuffer() -> void override;
+        auto presentBackBuffer() -> Future<void> override;
 
         auto resizeBackBuffers(uint32_t const width, uint32_t const height) -> void override;
 
@@ -451,10 +975,40 @@ namespace ionengine::rhi
         auto createSwapchainBuffers(uint32_t const width, uint32_t const height) -> void;
     };
 
+    /*!
+        \brief Swapchain of offscreen textures with the acquire and present order of a window swapchain
+        \details Needs no surface or swapchain extensions, so it runs on software drivers on servers without a
+        display. Back buffers are rendered in turn on the graphics queue and keep their content after present
+    */
+    class VKHeadlessSwapchain final : public Swapchain
+    {
+      public:
+        VKHeadlessSwapchain(VkDevice device, VmaAllocator memoryAllocator, DestructionQueue* destructionQueue,
+                            std::span<uint32_t const> const queueFamilies, DeviceQueueData& deviceQueue,
+                            SwapchainCreateInfo const& createInfo);
+
+        [[nodiscard]] auto getBackBuffer() -> Texture* override;
+
+        auto presentBackBuffer() -> Future<void> override;
+
+        auto resizeBackBuffers(uint32_t const width, uint32_t const height) -> void override;
+
+      private:
+        VkDevice device;
+        VmaAllocator memoryAllocator;
+        DestructionQueue* destructionQueue;
+        std::vector<uint32_t> queueFamilies;
+        DeviceQueueData* deviceQueue;
+        uint32_t imageIndex;
+        std::vector<core::ref_ptr<Texture>> backBuffers;
+
+        auto createSwapchainBuffers(uint32_t const width, uint32_t const height) -> void;
+    };
+
     class VKRHI final : public RHI
     {
       public:
-        VKRHI(RHICreateInfo const& createInfo);
+        VKRHI(RHICreateInfo const& rhiCreateInfo, std::optional<SwapchainCreateInfo> const swapchainCreateInfo);
 
         ~VKRHI();
 
@@ -466,14 +1020,37 @@ namespace ionengine::rhi
 
         auto createSampler(SamplerCreateInfo const& createInfo) -> core::ref_ptr<Sampler> override;
 
-        auto getSwapchain() -> Swapchain* override;
+        auto createQuery(QueryCreateInfo const& createInfo) -> core::ref_ptr<Query> override;
+
+        [[nodiscard]] auto getSwapchain() -> Swapchain* override;
+
+        [[nodiscard]] auto getGraphicsContext() -> GraphicsContext* override;
+
+        auto createGraphicsContext() -> std::unique_ptr<GraphicsContext> override;
 
-        auto getGraphicsContext() -> GraphicsContext* override;
+        auto submitGraphicsContexts(std::span<GraphicsContext* const> const contexts) -> Future<void> override;
 
-        auto getCopyContext() -> CopyContext* override;
+        [[nodiscard]] auto getCopyContext() -> CopyContext* override;
+
+        [[nodiscard]] auto getComputeContext() -> ComputeContext* override;
+
+        auto prewarmPipelines(std::span<PipelinePrewarmInfo const> const pipelines) -> void override;
+
+        auto getPipelineCacheStats() const -> PipelineCacheStats override;
+
+        auto getUploadStats() const -> UploadStats override;
+
+        auto getBarrierStats() const -> BarrierStats override;
+
+        auto getStateStats() const -> StateStats override;
 
         auto getName() const -> std::string const& override;
 
+        auto getDestructionQueue() -> DestructionQueue*;
+
+        // Pages of the buffer pools, each of them a VkBuffer shared by small buffers
+        auto getBufferPageCount() const -> size_t;
+
       private:
         VkInstance instance;
 #ifndef NDEBUG
@@ -486,19 +1063,34 @@ namespace ionengine::rhi
         VkDevice device;
         VmaAllocator memoryAllocator;
 
+        // One per distinct VkQueue, queues of the same family can be shared when the family has too few of them
+        std::unordered_map<VkQueue, std::mutex> submitMutexes;
         DeviceQueueData graphicsQueue;
         DeviceQueueData transferQueue;
         DeviceQueueData computeQueue;
+        // Distinct families of the device queues, buffers and storage textures are shared by all of them
+        std::vector<uint32_t> concurrentQueueFamilies;
+        BarrierCounters barrierCounters;
+        StateCounters stateCounters;
+        // Nanoseconds per timestamp tick
+        float timestampPeriod;
+        bool isPipelineStatisticsSupported;
+        DeviceFeatureData deviceFeatures;
 
         std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+        // Pools of device local, upload and readback memory, ranges are returned to them by the destruction queue
+        std::array<std::unique_ptr<VKBufferPool>, 3> bufferPools;
+        std::unique_ptr<DestructionQueue> destructionQueue;
         std::unique_ptr<PipelineCache> pipelineCache;
 
-        std::unique_ptr<VKSwapchain> swapchain;
+        std::unique_ptr<Swapchain> swapchain;
         std::unique_ptr<VKGraphicsContext> graphicsContext;
         std::unique_ptr<VKCopyContext> copyContext;
+        std::unique_ptr<VKComputeContext> computeContext;
 
         std::string const rhiName{"Vulkan"};
 
-        auto createDeviceQueue(uint32_t const queueFamily, DeviceQueueData& deviceQueue) -> void;
+        auto createDeviceQueue(uint32_t const queueFamily, uint32_t const queueIndex, DeviceQueueData& deviceQueue)
+            -> void;
     };
 } // namespace ionengine::rhi
\ No newline at end of file
@@ -246,9 +246,9 @@ namespace ionengine::shadersys
 
         ShaderParseData const shaderParseData = std::move(parserResult.value());
 
-        std::unordered_map<uint32_t, asset::fx::PermutationData> shaderPermutations;
-        std::vector<asset::fx::StageData> shaderStages;
-        std::vector<asset::fx::BufferData> shaderBuffers;
+        std::pmr::unordered_map<uint32_t, asset::fx::PermutationData> shaderPermutations;
+        std::pmr::vector<asset::fx::StageData> shaderStages;
+        std::pmr::vector<asset::fx::BufferData> shaderBuffers;
         std::basic_stringstream<uint8_t> shaderBlob;
 
         std::unordered_map<uint32_t, std::string> permutationNames;
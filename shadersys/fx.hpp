@@ -166,9 +166,9 @@ namespace ionengine::asset
         struct ShaderData
         {
             HeaderData header;
-            std::unordered_map<uint32_t, PermutationData> permutations;
-            std::vector<StageData> stages;
-            std::vector<BufferData> buffers;
+            std::pmr::unordered_map<uint32_t, PermutationData> permutations;
+            std::pmr::vector<StageData> stages;
+            std::pmr::vector<BufferData> buffers;
 
             template <typename Archive>
             auto operator()(Archive& archive)
@@ -186,7 +186,7 @@ namespace ionengine::asset
         std::array<uint8_t, fx::Magic.size()> magic;
         fx::ShaderFormat shaderFormat;
         fx::ShaderData shaderData;
-        std::vector<uint8_t> shaderBlob;
+        std::pmr::vector<uint8_t> shaderBlob;
 
         template <typename Archive>
         auto operator()(Archive& archive)
@@ -20,7 +20,7 @@ namespace ionengine::asset
             return std::unexpected(core::error("Failed to open file"));
         }
 
-        std::vector<asset::txe::BufferData> textureBuffers;
+        std::pmr::vector<asset::txe::BufferData> textureBuffers;
         std::basic_stringstream<uint8_t> textureBlob;
 
         if (srcMipSet.m_nMipLevels <= 1 && _generateMipMaps)
@@ -41,7 +41,7 @@ namespace ionengine::asset
             uint32_t width;
             uint32_t height;
             uint32_t mipLevelCount;
-            std::vector<BufferData> buffers;
+            std::pmr::vector<BufferData> buffers;
 
             template <typename Archive>
             auto operator()(Archive& archive)
@@ -60,7 +60,7 @@ namespace ionengine::asset
     {
         std::array<uint8_t, txe::Magic.size()> magic;
         txe::TextureData textureData;
-        std::vector<uint8_t> textureBlob;
+        std::pmr::vector<uint8_t> textureBlob;
 
         template <typename Archive>
         auto operator()(Archive& archive)